@@ -3,12 +3,27 @@
 //
 
 #import "AccountsAndAddressesNavigationController.h"
+#import "addrcodec.h"
 #import "Assets.h"
+#import "BCAddressIndex.h"
+#import "BCAmountFormat.h"
+#import "BCBridgeTrace.h"
+#import "bip32.h"
+#import "eckey.h"
+#import "JSContext+BridgeTrace.h"
 #import "KeychainItemWrapper.h"
 #import "KeychainItemWrapper+Credentials.h"
+#import "keyhash.h"
 #import "Reachability.h"
+#import "secbuf.h"
+#import "signmsg.h"
 #import "UIApplication+Suspend.h"
 #import "UIDevice+Hardware.h"
 #import "Wallet.h"
+#import "WalletCredentialStore.h"
+#import "WalletJSIntegrity.h"
+#import "WalletJSONDocument.h"
+#import "WalletJSTimerScheduler.h"
+#import "WalletPayloadKeyCache.h"
 #import "Sift/Sift.h"
 #import <recaptcha/recaptcha.h>
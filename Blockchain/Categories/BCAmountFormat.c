@@ -0,0 +1,215 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include "BCAmountFormat.h"
+
+#include <string.h>
+
+typedef unsigned __int128 BCAmountUInt128;
+
+// 10^38 is the largest power of ten below 2^128.
+#define BC_AMOUNT_MAX_POWER_OF_TEN 38
+// Digits of 2^128 - 1.
+#define BC_AMOUNT_MAX_DIGITS 39
+
+static BCAmountUInt128
+BCAmountPowerOfTen(unsigned exponent)
+{
+    BCAmountUInt128 value = 1;
+    while (exponent-- > 0) {
+        value *= 10;
+    }
+    return value;
+}
+
+static size_t
+BCAmountAppend(char *buffer, size_t capacity, size_t length, const char *string, size_t stringLength)
+{
+    if (length + stringLength >= capacity) {
+        return SIZE_MAX;
+    }
+    memcpy(buffer + length, string, stringLength);
+    return length + stringLength;
+}
+
+/*
+ * Writes `units / 10^exponent` with the grouping, separators and affixes of `style`.
+ * Fraction digits past the style's maximum are truncated, trailing zeros are dropped down to its minimum.
+ */
+static size_t
+BCAmountFormatFixed(BCAmountUInt128 units, unsigned exponent, const BCAmountFormatStyle *style, char *buffer, size_t capacity)
+{
+    if (buffer == NULL || capacity == 0 || exponent > BC_AMOUNT_MAX_POWER_OF_TEN) {
+        return 0;
+    }
+
+    BCAmountUInt128 scale = BCAmountPowerOfTen(exponent);
+    BCAmountUInt128 integer = units / scale;
+    BCAmountUInt128 fraction = units % scale;
+
+    // Fraction digits, most significant first, padded with zeros up to the minimum.
+    char fractionDigits[BC_AMOUNT_MAX_DIGITS + UINT8_MAX];
+    unsigned fractionCount = exponent;
+    for (unsigned i = exponent; i-- > 0;) {
+        fractionDigits[i] = (char)('0' + (unsigned)(fraction % 10));
+        fraction /= 10;
+    }
+    if (fractionCount > style->maximumFractionDigits) {
+        fractionCount = style->maximumFractionDigits;
+    }
+    while (fractionCount < style->minimumFractionDigits) {
+        fractionDigits[fractionCount++] = '0';
+    }
+    while (fractionCount > style->minimumFractionDigits && fractionDigits[fractionCount - 1] == '0') {
+        fractionCount--;
+    }
+
+    // Integer digits, least significant first.
+    char integerDigits[BC_AMOUNT_MAX_DIGITS];
+    unsigned integerCount = 0;
+    do {
+        integerDigits[integerCount++] = (char)('0' + (unsigned)(integer % 10));
+        integer /= 10;
+    } while (integer > 0);
+
+    size_t groupingLength = strlen(style->groupingSeparator);
+    size_t length = 0;
+    length = BCAmountAppend(buffer, capacity, length, style->prefix, strlen(style->prefix));
+
+    // Walking from the most significant digit, a separator goes before every digit that starts a group.
+    unsigned primary = style->primaryGroupingSize;
+    unsigned secondary = style->secondaryGroupingSize ? style->secondaryGroupingSize : primary;
+    for (unsigned i = integerCount; i-- > 0 && length != SIZE_MAX;) {
+        length = BCAmountAppend(buffer, capacity, length, &integerDigits[i], 1);
+        if (primary > 0 && i > 0 && i >= primary && (i - primary) % secondary == 0) {
+            length = BCAmountAppend(buffer, capacity, length, style->groupingSeparator, groupingLength);
+        }
+    }
+
+    if (fractionCount > 0 && length != SIZE_MAX) {
+        length = BCAmountAppend(buffer, capacity, length, style->decimalSeparator, strlen(style->decimalSeparator));
+        if (length != SIZE_MAX) {
+            length = BCAmountAppend(buffer, capacity, length, fractionDigits, fractionCount);
+        }
+    }
+    if (length != SIZE_MAX) {
+        length = BCAmountAppend(buffer, capacity, length, style->suffix, strlen(style->suffix));
+    }
+
+    if (length == SIZE_MAX) {
+        buffer[0] = '\0';
+        return 0;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+bool
+BCAmountRateFromDecimalString(const char *string, BCAmountRate *rate)
+{
+    if (string == NULL || rate == NULL) {
+        return false;
+    }
+
+    uint64_t mantissa = 0;
+    unsigned scale = 0;
+    unsigned significantDigits = 0;
+    bool hasDigits = false;
+    bool hasSeparator = false;
+
+    for (const char *c = string; *c != '\0'; c++) {
+        if (*c == '.' && !hasSeparator) {
+            hasSeparator = true;
+            continue;
+        }
+        if (*c < '0' || *c > '9') {
+            return false;
+        }
+        hasDigits = true;
+        if (mantissa > 0 || *c != '0') {
+            significantDigits++;
+        }
+        if (significantDigits > 19 || scale == UINT8_MAX) {
+            return false;
+        }
+        mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+        if (hasSeparator) {
+            scale++;
+        }
+    }
+    if (!hasDigits) {
+        return false;
+    }
+
+    // Drop trailing fraction zeros to keep the divisor small.
+    while (scale > 0 && mantissa % 10 == 0 && mantissa > 0) {
+        mantissa /= 10;
+        scale--;
+    }
+
+    rate->mantissa = mantissa;
+    rate->scale = (uint8_t)scale;
+    return true;
+}
+
+bool
+BCAmountFormatStyleSetString(char *field, size_t capacity, const char *string)
+{
+    size_t length = string ? strlen(string) : 0;
+    if (length >= capacity) {
+        return false;
+    }
+    memcpy(field, string ? string : "", length);
+    field[length] = '\0';
+    return true;
+}
+
+size_t
+BCAmountFormatCrypto(uint64_t satoshi, const BCAmountFormatStyle *style, char *buffer, size_t capacity)
+{
+    return BCAmountFormatFixed(satoshi, BC_AMOUNT_FORMAT_SATOSHI_EXPONENT, style, buffer, capacity);
+}
+
+size_t
+BCAmountFormatFiat(uint64_t satoshi, BCAmountRate rate, const BCAmountFormatStyle *style, char *buffer, size_t capacity)
+{
+    // fiat = satoshi * mantissa / 10^(scale + 8), kept in units of 10^-maximumFractionDigits.
+    // The product of two 64 bit values always fits in 128 bits.
+    BCAmountUInt128 product = (BCAmountUInt128)satoshi * rate.mantissa;
+    unsigned fractionDigits = style->maximumFractionDigits;
+    unsigned denominatorExponent = rate.scale + BC_AMOUNT_FORMAT_SATOSHI_EXPONENT;
+
+    BCAmountUInt128 units;
+    if (fractionDigits <= denominatorExponent) {
+        unsigned exponent = denominatorExponent - fractionDigits;
+        units = exponent > BC_AMOUNT_MAX_POWER_OF_TEN ? 0 : product / BCAmountPowerOfTen(exponent);
+    } else {
+        unsigned exponent = fractionDigits - denominatorExponent;
+        if (exponent > BC_AMOUNT_MAX_POWER_OF_TEN) {
+            return 0;
+        }
+        if (__builtin_mul_overflow(product, BCAmountPowerOfTen(exponent), &units)) {
+            return 0;
+        }
+    }
+    return BCAmountFormatFixed(units, fractionDigits, style, buffer, capacity);
+}
+
+size_t
+BCAmountFormatBulk(const uint64_t *amounts, size_t count, const BCAmountRate *rate, const BCAmountFormatStyle *style, char *buffer, size_t capacity, size_t *lengths)
+{
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (used >= capacity) {
+            return 0;
+        }
+        size_t length = rate
+            ? BCAmountFormatFiat(amounts[i], *rate, style, buffer + used, capacity - used)
+            : BCAmountFormatCrypto(amounts[i], style, buffer + used, capacity - used);
+        if (length == 0) {
+            return 0;
+        }
+        lengths[i] = length;
+        used += length + 1;
+    }
+    return used;
+}
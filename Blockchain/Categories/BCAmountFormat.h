@@ -0,0 +1,69 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef BCAmountFormat_h
+#define BCAmountFormat_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Upper bound, NUL included, of a single formatted amount.
+#define BC_AMOUNT_FORMAT_MAX_LENGTH 256
+
+/// Capacity, NUL included, of the separator and affix fields of `BCAmountFormatStyle`.
+#define BC_AMOUNT_FORMAT_SEPARATOR_CAPACITY 8
+#define BC_AMOUNT_FORMAT_AFFIX_CAPACITY 40
+
+/// Satoshi per BTC / BCH, as a power of ten.
+#define BC_AMOUNT_FORMAT_SATOSHI_EXPONENT 8
+
+/// Grouping, separators and fraction digits of a decimal number style, plus a prefix and a suffix
+/// (e.g. a currency symbol). Strings are NUL terminated UTF-8.
+typedef struct {
+    char decimalSeparator[BC_AMOUNT_FORMAT_SEPARATOR_CAPACITY];
+    char groupingSeparator[BC_AMOUNT_FORMAT_SEPARATOR_CAPACITY];
+    /// Size of the rightmost group of integer digits, 0 disables grouping.
+    uint8_t primaryGroupingSize;
+    /// Size of the other groups, 0 to use `primaryGroupingSize` (e.g. 2 for 12,34,567).
+    uint8_t secondaryGroupingSize;
+    uint8_t minimumFractionDigits;
+    uint8_t maximumFractionDigits;
+    char prefix[BC_AMOUNT_FORMAT_AFFIX_CAPACITY];
+    char suffix[BC_AMOUNT_FORMAT_AFFIX_CAPACITY];
+} BCAmountFormatStyle;
+
+/// An exchange rate of `mantissa / 10^scale` units of fiat per whole coin.
+typedef struct {
+    uint64_t mantissa;
+    uint8_t scale;
+} BCAmountRate;
+
+/// Parses a plain decimal string ("1234.5678") into `rate`.
+/// Returns false for anything else, or if the value does not fit in 19 significant digits.
+bool BCAmountRateFromDecimalString(const char *string, BCAmountRate *rate);
+
+/// Copies `string` into one of the fixed size style fields. Returns false if it does not fit.
+bool BCAmountFormatStyleSetString(char *field, size_t capacity, const char *string);
+
+/// Formats `satoshi` as a coin amount, truncating to the style's maximum fraction digits.
+/// Writes a NUL terminated string into `buffer` and returns its length, or 0 if it does not fit.
+size_t BCAmountFormatCrypto(uint64_t satoshi, const BCAmountFormatStyle *style, char *buffer, size_t capacity);
+
+/// Formats the fiat value of `satoshi` at `rate`, rounded down to the style's maximum fraction digits.
+/// The conversion is exact. Returns the length written to `buffer`, or 0 if it does not fit.
+size_t BCAmountFormatFiat(uint64_t satoshi, BCAmountRate rate, const BCAmountFormatStyle *style, char *buffer, size_t capacity);
+
+/// Formats `count` amounts back to back into `buffer`, each one NUL terminated, storing the length of
+/// each in `lengths`. Amounts are formatted as fiat when `rate` is non-NULL and as coins otherwise.
+/// Returns the number of bytes used, or 0 if `buffer` is too small.
+size_t BCAmountFormatBulk(const uint64_t *amounts, size_t count, const BCAmountRate *rate, const BCAmountFormatStyle *style, char *buffer, size_t capacity, size_t *lengths);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BCAmountFormat_h */
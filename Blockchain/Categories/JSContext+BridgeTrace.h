@@ -0,0 +1,15 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <JavaScriptCore/JavaScriptCore.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Script evaluations recorded in the bridge trace, under the name of the function the script calls.
+@interface JSContext (BridgeTrace)
+
+/// `evaluateScriptCheckIsOnMainQueue:`, timed.
+- (nullable JSValue *)tracedEvaluateScriptCheckIsOnMainQueue:(NSString *)script;
+
+@end
+
+NS_ASSUME_NONNULL_END
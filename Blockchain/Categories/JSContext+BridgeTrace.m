@@ -0,0 +1,37 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@import ToolKit;
+#import "JSContext+BridgeTrace.h"
+#import "BCBridgeTrace.h"
+
+/// Enough of a script to name it; see BCBridgeTraceSiteForScript.
+static const NSUInteger JSContextBridgeTraceNameLength = 128;
+
+@implementation JSContext (BridgeTrace)
+
+- (JSValue *)tracedEvaluateScriptCheckIsOnMainQueue:(NSString *)script
+{
+#if BC_BRIDGE_TRACE
+    if (BCBridgeTraceIsEnabled()) {
+        // Only the head of the script is converted for the name; the rest is just counted.
+        char head[JSContextBridgeTraceNameLength];
+        NSUInteger headLength = 0;
+        [script getBytes:head
+               maxLength:sizeof(head)
+              usedLength:&headLength
+                encoding:NSUTF8StringEncoding
+                 options:0
+                   range:NSMakeRange(0, MIN(script.length, JSContextBridgeTraceNameLength))
+          remainingRange:NULL];
+        BCBridgeTraceSite site = BCBridgeTraceSiteForScript(head, headLength);
+        uint64_t bytes = [script lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        uint64_t start = BCBridgeTraceNow();
+        JSValue *result = [self evaluateScriptCheckIsOnMainQueue:script];
+        BCBridgeTraceRecord(site, start, BCBridgeTraceNow(), bytes);
+        return result;
+    }
+#endif
+    return [self evaluateScriptCheckIsOnMainQueue:script];
+}
+
+@end
@@ -1,6 +1,34 @@
 // Copyright © Blockchain Luxembourg S.A. All rights reserved.
 
 #import "KeychainItemWrapper+Credentials.h"
+#import "WalletCredentialStore.h"
+
+/// The credential stored for `identifier` as a string; nil if there is none or it is empty.
+static NSString *CredentialString(NSString *identifier)
+{
+    NSData *data = [[WalletCredentialStore sharedStore] dataForIdentifier:identifier];
+    if (data.length == 0) {
+        return nil;
+    }
+    NSString *string = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+    return string.length == 0 ? nil : string;
+}
+
+static void SetCredentialString(NSString *identifier, NSString *string)
+{
+    NSData *data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    if (data) {
+        [[WalletCredentialStore sharedStore] setData:data forIdentifier:identifier];
+    }
+}
+
+/// Deletes the credential for `identifier` from the keychain before returning.
+static void RemoveCredential(NSString *identifier)
+{
+    if (![[WalletCredentialStore sharedStore] removeDataForIdentifier:identifier]) {
+        DLog(@"failed to remove %@ from keychain", identifier);
+    }
+}
 
 @implementation KeychainItemWrapper (Credentials)
 
@@ -13,7 +41,7 @@
     if (guidFromUserDefaults) {
         [self setGuidInKeychain:guidFromUserDefaults];
 
-        if ([self guidFromKeychain]) {
+        if ([[WalletCredentialStore sharedStore] flush] && [self guidFromKeychain]) {
             [[NSUserDefaults standardUserDefaults] removeObjectForKey:USER_DEFAULTS_KEY_GUID];
             [[NSUserDefaults standardUserDefaults] synchronize];
 
@@ -30,28 +58,16 @@
 
 + (void)setGuidInKeychain:(NSString *)guid
 {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_GUID accessGroup:nil];
-    [keychain setObject:(__bridge id)kSecAttrAccessibleWhenUnlockedThisDeviceOnly forKey:(__bridge id)kSecAttrAccessible];
-
-    [keychain setObject:KEYCHAIN_KEY_GUID forKey:(__bridge id)kSecAttrAccount];
-    [keychain setObject:[guid dataUsingEncoding:NSUTF8StringEncoding] forKey:(__bridge id)kSecValueData];
+    SetCredentialString(KEYCHAIN_KEY_GUID, guid);
 }
 
 + (NSString *)guidFromKeychain {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_GUID accessGroup:nil];
-    NSData *guidData = [keychain objectForKey:(__bridge id)kSecValueData];
-    if (guidData == nil || guidData.length == 0) {
-        return nil;
-    }
-    NSString *guid = [[NSString alloc] initWithData:guidData encoding:NSUTF8StringEncoding];
-    return guid.length == 0 ? nil : guid;
+    return CredentialString(KEYCHAIN_KEY_GUID);
 }
 
 + (void)removeGuidFromKeychain
 {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_GUID accessGroup:nil];
-
-    [keychain resetKeychainItem];
+    RemoveCredential(KEYCHAIN_KEY_GUID);
 }
 
 #pragma mark - SharedKey
@@ -63,7 +79,7 @@
     if (sharedKeyFromUserDefaults) {
         [self setSharedKeyInKeychain:sharedKeyFromUserDefaults];
 
-        if ([self sharedKeyFromKeychain]) {
+        if ([[WalletCredentialStore sharedStore] flush] && [self sharedKeyFromKeychain]) {
             [[NSUserDefaults standardUserDefaults] removeObjectForKey:USER_DEFAULTS_KEY_SHARED_KEY];
             [[NSUserDefaults standardUserDefaults] synchronize];
         } else {
@@ -76,56 +92,34 @@
 }
 
 + (NSString *)sharedKeyFromKeychain {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_SHARED_KEY accessGroup:nil];
-    NSData *sharedKeyData = [keychain objectForKey:(__bridge id)kSecValueData];
-    if (sharedKeyData == nil || sharedKeyData.length == 0) {
-        return nil;
-    }
-    NSString *sharedKey = [[NSString alloc] initWithData:sharedKeyData encoding:NSUTF8StringEncoding];
-    return sharedKey.length == 0 ? nil : sharedKey;
+    return CredentialString(KEYCHAIN_KEY_SHARED_KEY);
 }
 
 + (void)setSharedKeyInKeychain:(NSString *)sharedKey
 {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_SHARED_KEY accessGroup:nil];
-    [keychain setObject:(__bridge id)kSecAttrAccessibleWhenUnlockedThisDeviceOnly forKey:(__bridge id)kSecAttrAccessible];
-
-    [keychain setObject:KEYCHAIN_KEY_SHARED_KEY forKey:(__bridge id)kSecAttrAccount];
-    [keychain setObject:[sharedKey dataUsingEncoding:NSUTF8StringEncoding] forKey:(__bridge id)kSecValueData];
+    SetCredentialString(KEYCHAIN_KEY_SHARED_KEY, sharedKey);
 }
 
 + (void)removeSharedKeyFromKeychain
 {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_SHARED_KEY accessGroup:nil];
-
-    [keychain resetKeychainItem];
+    RemoveCredential(KEYCHAIN_KEY_SHARED_KEY);
 }
 
 #pragma mark - PIN
 
 + (void)setPINInKeychain:(NSString *)pin
 {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_PIN accessGroup:nil];
-    [keychain setObject:(__bridge id)kSecAttrAccessibleWhenUnlockedThisDeviceOnly forKey:(__bridge id)kSecAttrAccessible];
-
-    [keychain setObject:KEYCHAIN_KEY_PIN forKey:(__bridge id)kSecAttrAccount];
-    [keychain setObject:[pin dataUsingEncoding:NSUTF8StringEncoding] forKey:(__bridge id)kSecValueData];
+    SetCredentialString(KEYCHAIN_KEY_PIN, pin);
 }
 
 + (NSString *)pinFromKeychain
 {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_PIN accessGroup:nil];
-    NSData *pinData = [keychain objectForKey:(__bridge id)kSecValueData];
-    NSString *pin = [[NSString alloc] initWithData:pinData encoding:NSUTF8StringEncoding];
-
-    return pin.length == 0 ? nil : pin;
+    return CredentialString(KEYCHAIN_KEY_PIN);
 }
 
 + (void)removePinFromKeychain
 {
-    KeychainItemWrapper *keychain = [[KeychainItemWrapper alloc] initWithIdentifier:KEYCHAIN_KEY_PIN accessGroup:nil];
-
-    [keychain resetKeychainItem];
+    RemoveCredential(KEYCHAIN_KEY_PIN);
 }
 
 @end
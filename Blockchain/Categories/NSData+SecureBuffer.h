@@ -0,0 +1,24 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+#import "secbuf.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface NSData (SecureBuffer)
+
+/// Copies a password or salt passed from JS, an array of byte values or a string taken as UTF-8,
+/// into a pool buffer. NO if `secret` is neither or the pool is out of memory.
++ (BOOL)copySecret:(id)secret toSecureBuffer:(struct secbuf *)buffer;
+
+/// Data over the bytes of `buffer`, which it takes over, leaving `buffer` empty, and gives back
+/// to the secbuf pool when released.
++ (NSData *)dataTakingSecureBuffer:(struct secbuf *)buffer;
+
+/// The hexadecimal representation of this NSData, held in a secbuf pool buffer that is wiped when
+/// the string is released. Copies made from the string, e.g. by JavaScriptCore, are not.
+- (NSString *)secureHexadecimalString;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,60 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import "NSData+SecureBuffer.h"
+#import "NSData+Hex.h"
+
+@implementation NSData (SecureBuffer)
+
++ (BOOL)copySecret:(id)secret toSecureBuffer:(struct secbuf *)buffer
+{
+    if ([secret isKindOfClass:[NSArray class]]) {
+        if (secbuf_get(buffer, [secret count]) != 0) {
+            return NO;
+        }
+        size_t i = 0;
+        for (NSNumber *number in secret) {
+            buffer->buf[i++] = (uint8_t)[number shortValue];
+        }
+        return YES;
+    }
+    if ([secret isKindOfClass:[NSString class]]) {
+        const char *utf8String = [secret UTF8String];
+        size_t length = strlen(utf8String);
+        if (secbuf_get(buffer, length) != 0) {
+            return NO;
+        }
+        memcpy(buffer->buf, utf8String, length);
+        return YES;
+    }
+    return NO;
+}
+
++ (NSData *)dataTakingSecureBuffer:(struct secbuf *)buffer
+{
+    struct secbuf owned = *buffer;
+    *buffer = (struct secbuf)SECBUF_INITIALIZER;
+    return [[NSData alloc] initWithBytesNoCopy:owned.buf length:owned.len deallocator:^(void *bytes, NSUInteger length) {
+        struct secbuf released = owned;
+        secbuf_put(&released);
+    }];
+}
+
+- (NSString *)secureHexadecimalString
+{
+    static const char digits[] = "0123456789abcdef";
+    struct secbuf hex = SECBUF_INITIALIZER;
+    if (secbuf_get(&hex, self.length * 2) != 0) {
+        return [self hexadecimalString];
+    }
+    const uint8_t *bytes = self.bytes;
+    for (NSUInteger i = 0; i < self.length; i++) {
+        hex.buf[2 * i] = digits[bytes[i] >> 4];
+        hex.buf[2 * i + 1] = digits[bytes[i] & 0xf];
+    }
+    return [[NSString alloc] initWithBytesNoCopy:hex.buf length:hex.len encoding:NSASCIIStringEncoding deallocator:^(void *bytes, NSUInteger length) {
+        struct secbuf released = hex;
+        secbuf_put(&released);
+    }];
+}
+
+@end
@@ -7,7 +7,13 @@
 + (NSString*)formatMoney:(uint64_t)value;
 + (NSString*)formatMoney:(uint64_t)value localCurrency:(BOOL)fsymbolLocal;
 
+/// Formats every amount in satoshi of `values` as `formatMoney:localCurrency:` would, in a single pass.
++ (NSArray<NSString *> *)formatMoneyValues:(NSArray<NSNumber *> *)values localCurrency:(BOOL)fsymbolLocal;
+
 + (NSString *)formatBCHAmountInAutomaticLocalCurrency:(uint64_t)amount;
 + (NSString *)formatBCHAmount:(uint64_t)amount includeSymbol:(BOOL)includeSymbol inLocalCurrency:(BOOL)localCurrency;
 
+/// Formats every amount in satoshi of `amounts` as `formatBCHAmount:includeSymbol:inLocalCurrency:` would, in a single pass.
++ (NSArray<NSString *> *)formatBCHAmounts:(NSArray<NSNumber *> *)amounts includeSymbol:(BOOL)includeSymbol inLocalCurrency:(BOOL)localCurrency;
+
 @end
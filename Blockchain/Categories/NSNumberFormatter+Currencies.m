@@ -1,10 +1,70 @@
 // Copyright © Blockchain Luxembourg S.A. All rights reserved.
 
 #import "NSNumberFormatter+Currencies.h"
+#import "BCAmountFormat.h"
 #import "Blockchain-Swift.h"
 
 @import FeatureSettingsDomain;
 
+// Amounts formatted with a buffer on the stack, larger batches allocate one.
+#define AMOUNT_FORMAT_STACK_COUNT 16
+
+// Copies the separators, grouping and fraction digits of `formatter` into `style`, then checks a few
+// values against the formatter's own output. Returns NO if they differ, e.g. in locales that use
+// non-ASCII digits or add affixes, in which case amounts are formatted with NSNumberFormatter instead.
+static BOOL
+AmountFormatStyleFromFormatter(NSNumberFormatter *formatter, BCAmountFormatStyle *style)
+{
+    *style = (BCAmountFormatStyle){ 0 };
+
+    NSString *groupingSeparator = formatter.usesGroupingSeparator ? formatter.groupingSeparator : @"";
+    if (!BCAmountFormatStyleSetString(style->decimalSeparator, sizeof(style->decimalSeparator), formatter.decimalSeparator.UTF8String) ||
+        !BCAmountFormatStyleSetString(style->groupingSeparator, sizeof(style->groupingSeparator), groupingSeparator.UTF8String)) {
+        return NO;
+    }
+    style->primaryGroupingSize = formatter.usesGroupingSeparator ? (uint8_t)MIN(MAX(formatter.groupingSize, 0), UINT8_MAX) : 0;
+    style->secondaryGroupingSize = (uint8_t)MIN(MAX(formatter.secondaryGroupingSize, 0), UINT8_MAX);
+    style->minimumFractionDigits = (uint8_t)MIN(formatter.minimumFractionDigits, UINT8_MAX);
+    style->maximumFractionDigits = (uint8_t)MIN(formatter.maximumFractionDigits, UINT8_MAX);
+
+    const uint64_t probes[] = { 0, 50000000, 100000000000, 123456712345678 };
+    char buffer[BC_AMOUNT_FORMAT_MAX_LENGTH];
+    for (size_t i = 0; i < sizeof(probes) / sizeof(probes[0]); i++) {
+        NSDecimalNumber *number = [NSDecimalNumber decimalNumberWithMantissa:probes[i] exponent:-BC_AMOUNT_FORMAT_SATOSHI_EXPONENT isNegative:NO];
+        NSString *expected = [formatter stringFromNumber:number];
+        if (BCAmountFormatCrypto(probes[i], style, buffer, sizeof(buffer)) == 0 || ![expected isEqualToString:@(buffer)]) {
+            DLog(@"Amount format style of %@ does not match NSNumberFormatter, using NSNumberFormatter", formatter.locale.localeIdentifier);
+            return NO;
+        }
+    }
+    return YES;
+}
+
+// Styles are computed once, the formatters they mirror are never reconfigured.
+static const BCAmountFormatStyle *
+BitcoinAmountFormatStyle(void)
+{
+    static BCAmountFormatStyle style;
+    static BOOL isValid;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        isValid = AmountFormatStyleFromFormatter(NSNumberFormatter.bitcoinFormatterWithGroupingSeparator, &style);
+    });
+    return isValid ? &style : NULL;
+}
+
+static const BCAmountFormatStyle *
+LocalCurrencyAmountFormatStyle(void)
+{
+    static BCAmountFormatStyle style;
+    static BOOL isValid;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        isValid = AmountFormatStyleFromFormatter(NSNumberFormatter.localCurrencyFormatterWithGroupingSeparator, &style);
+    });
+    return isValid ? &style : NULL;
+}
+
 @implementation NSNumberFormatter (Currencies)
 
 #pragma mark - Format helpers
@@ -17,6 +77,44 @@
 // Format amount in satoshi as NSString (with symbol)
 + (NSString*)formatMoney:(uint64_t)value
            localCurrency:(BOOL)fsymbolLocal
+{
+    return [self formatMoneyValues:&value count:1 localCurrency:fsymbolLocal].firstObject;
+}
+
++ (NSArray<NSString *> *)formatMoneyValues:(NSArray<NSNumber *> *)values localCurrency:(BOOL)fsymbolLocal
+{
+    return [self formatAmounts:values withBlock:^NSArray<NSString *> *(const uint64_t *amounts, NSUInteger count) {
+        return [self formatMoneyValues:amounts count:count localCurrency:fsymbolLocal];
+    }];
+}
+
++ (NSArray<NSString *> *)formatMoneyValues:(const uint64_t *)values count:(NSUInteger)count localCurrency:(BOOL)fsymbolLocal
+{
+    CurrencySymbol *currencySymbol = WalletManager.sharedInstance.latestMultiAddressResponse.symbol_local;
+    NSArray<NSString *> *strings = nil;
+    if (fsymbolLocal && currencySymbol.conversion) {
+        strings = [self formatAmounts:values
+                                count:count
+                                style:LocalCurrencyAmountFormatStyle()
+                                 rate:currencySymbol.last.stringValue
+                               prefix:currencySymbol.symbol
+                               suffix:nil];
+    } else {
+        strings = [self formatAmounts:values count:count style:BitcoinAmountFormatStyle() rate:nil prefix:nil suffix:@" BTC"];
+    }
+    if (strings) {
+        return strings;
+    }
+
+    NSMutableArray<NSString *> *result = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [result addObject:[self decimalFormatMoney:values[i] localCurrency:fsymbolLocal]];
+    }
+    return result;
+}
+
++ (NSString*)decimalFormatMoney:(uint64_t)value
+                  localCurrency:(BOOL)fsymbolLocal
 {
     if (fsymbolLocal && WalletManager.sharedInstance.latestMultiAddressResponse.symbol_local.conversion) {
         @try {
@@ -49,9 +147,47 @@
 
 // Format BCH amount in satoshi as NSString, option to include Symbol, option to show in fiat.
 + (NSString *)formatBCHAmount:(uint64_t)amount includeSymbol:(BOOL)includeSymbol inLocalCurrency:(BOOL)localCurrency
+{
+    return [self formatBCHAmounts:&amount count:1 includeSymbol:includeSymbol inLocalCurrency:localCurrency].firstObject;
+}
+
++ (NSArray<NSString *> *)formatBCHAmounts:(NSArray<NSNumber *> *)amounts includeSymbol:(BOOL)includeSymbol inLocalCurrency:(BOOL)localCurrency
+{
+    return [self formatAmounts:amounts withBlock:^NSArray<NSString *> *(const uint64_t *values, NSUInteger count) {
+        return [self formatBCHAmounts:values count:count includeSymbol:includeSymbol inLocalCurrency:localCurrency];
+    }];
+}
+
++ (NSArray<NSString *> *)formatBCHAmounts:(const uint64_t *)amounts count:(NSUInteger)count includeSymbol:(BOOL)includeSymbol inLocalCurrency:(BOOL)localCurrency
+{
+    NSString *lastRate = localCurrency ? [WalletManager.sharedInstance.wallet bitcoinCashExchangeRate] : nil;
+    NSArray<NSString *> *strings = nil;
+    if (lastRate) {
+        NSString *currencyCode = WalletManager.sharedInstance.latestMultiAddressResponse.symbol_local.symbol;
+        strings = [self formatAmounts:amounts
+                                count:count
+                                style:LocalCurrencyAmountFormatStyle()
+                                 rate:lastRate
+                               prefix:includeSymbol && currencyCode ? [currencyCode stringByAppendingString:@" "] : nil
+                               suffix:nil];
+    } else {
+        strings = [self formatAmounts:amounts count:count style:BitcoinAmountFormatStyle() rate:nil prefix:nil suffix:includeSymbol ? @" BCH" : nil];
+    }
+    if (strings) {
+        return strings;
+    }
+
+    NSMutableArray<NSString *> *result = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [result addObject:[self decimalFormatBCHAmount:amounts[i] includeSymbol:includeSymbol inLocalCurrency:localCurrency]];
+    }
+    return result;
+}
+
++ (NSString *)decimalFormatBCHAmount:(uint64_t)amount includeSymbol:(BOOL)includeSymbol inLocalCurrency:(BOOL)localCurrency
 {
     NSString *returnValue = @"";
-    
+
     if (localCurrency && [WalletManager.sharedInstance.wallet bitcoinCashExchangeRate]) {
         @try {
             NSString *lastRate = [WalletManager.sharedInstance.wallet bitcoinCashExchangeRate];
@@ -84,8 +220,78 @@
         }
     }
 
-    
+
     return returnValue;
 }
 
+#pragma mark - Fixed point formatting
+
++ (NSArray<NSString *> *)formatAmounts:(NSArray<NSNumber *> *)amounts withBlock:(NSArray<NSString *> *(^)(const uint64_t *amounts, NSUInteger count))block
+{
+    NSUInteger count = amounts.count;
+    uint64_t *values = malloc(MAX(count, 1) * sizeof(uint64_t));
+    if (values == NULL) {
+        return @[];
+    }
+    for (NSUInteger i = 0; i < count; i++) {
+        values[i] = amounts[i].unsignedLongLongValue;
+    }
+    NSArray<NSString *> *result = block(values, count);
+    free(values);
+    return result;
+}
+
+// Formats `amounts` with the integer engine, as fiat at the decimal string `rate` when set.
+// Returns nil when the engine cannot produce the same output as NSNumberFormatter.
++ (NSArray<NSString *> *)formatAmounts:(const uint64_t *)amounts
+                                 count:(NSUInteger)count
+                                 style:(const BCAmountFormatStyle *)baseStyle
+                                  rate:(NSString *)rate
+                                prefix:(NSString *)prefix
+                                suffix:(NSString *)suffix
+{
+    if (baseStyle == NULL) {
+        return nil;
+    }
+
+    BCAmountFormatStyle style = *baseStyle;
+    if (!BCAmountFormatStyleSetString(style.prefix, sizeof(style.prefix), prefix.UTF8String) ||
+        !BCAmountFormatStyleSetString(style.suffix, sizeof(style.suffix), suffix.UTF8String)) {
+        return nil;
+    }
+
+    BCAmountRate amountRate;
+    if (rate && !BCAmountRateFromDecimalString(rate.UTF8String, &amountRate)) {
+        return nil;
+    }
+
+    char stackBuffer[AMOUNT_FORMAT_STACK_COUNT * BC_AMOUNT_FORMAT_MAX_LENGTH];
+    size_t stackLengths[AMOUNT_FORMAT_STACK_COUNT];
+    BOOL isOnStack = count <= AMOUNT_FORMAT_STACK_COUNT;
+    size_t capacity = MAX(count, 1) * BC_AMOUNT_FORMAT_MAX_LENGTH;
+    char *buffer = isOnStack ? stackBuffer : malloc(capacity);
+    size_t *lengths = isOnStack ? stackLengths : malloc(count * sizeof(size_t));
+
+    NSMutableArray<NSString *> *result = nil;
+    if (buffer && lengths && (count == 0 || BCAmountFormatBulk(amounts, count, rate ? &amountRate : NULL, &style, buffer, capacity, lengths) > 0)) {
+        result = [NSMutableArray arrayWithCapacity:count];
+        const char *string = buffer;
+        for (NSUInteger i = 0; i < count; i++) {
+            NSString *formatted = [[NSString alloc] initWithBytes:string length:lengths[i] encoding:NSUTF8StringEncoding];
+            if (formatted == nil) {
+                result = nil;
+                break;
+            }
+            [result addObject:formatted];
+            string += lengths[i] + 1;
+        }
+    }
+
+    if (!isOnStack) {
+        free(buffer);
+        free(lengths);
+    }
+    return result;
+}
+
 @end
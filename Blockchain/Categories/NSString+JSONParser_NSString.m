@@ -1,22 +1,19 @@
 // Copyright © Blockchain Luxembourg S.A. All rights reserved.
 
 #import "NSString+JSONParser_NSString.h"
+#import "WalletJSONDocument.h"
 
 @implementation NSString (JSONParser_NSString)
 
 -(id)getJSONObject {
-    NSError * error = nil;
-    
-    id dict = [NSJSONSerialization JSONObjectWithData:[self dataUsingEncoding:NSUTF8StringEncoding]
-                                              options:kNilOptions
-                                                error:&error];
-    
-    if (error != NULL) {
-        DLog(@"Error Parsing JSON %@", error);
+    id object = [WalletJSONDocument documentWithString:self].objectValue;
+
+    if (object == nil) {
+        DLog(@"Error Parsing JSON");
         return nil;
     }
-    
-    return dict;
+
+    return object;
 }
 
 
@@ -0,0 +1,567 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include "BCBridgeTrace.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Four buckets per power of two of nanoseconds, up to 2^40 ns (about 18 minutes).
+#define BC_BRIDGE_TRACE_SUB_BUCKET_BITS 2
+#define BC_BRIDGE_TRACE_BUCKET_COUNT (40 << BC_BRIDGE_TRACE_SUB_BUCKET_BITS)
+// Sites interned past this many go to the overflow site, so probes stay short and always end.
+#define BC_BRIDGE_TRACE_SITE_SLOTS (BC_BRIDGE_TRACE_MAX_SITES * 2)
+#define BC_BRIDGE_TRACE_OVERFLOW_SITE BC_BRIDGE_TRACE_SITE_SLOTS
+// Script names are cut at this length.
+#define BC_BRIDGE_TRACE_MAX_SCRIPT_NAME 96
+
+typedef struct {
+    uint64_t hash;
+    size_t length;
+    /// Set last, once `hash` and `length` are: a non-NULL name is a complete slot.
+    _Atomic(const char *) name;
+} BCBridgeTraceSiteSlot;
+
+/// One thread's numbers for one site. Written by that thread only, read by anyone.
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t totalNanoseconds;
+    _Atomic uint64_t maxNanoseconds;
+    _Atomic uint64_t bytes;
+    _Atomic uint32_t buckets[BC_BRIDGE_TRACE_BUCKET_COUNT];
+} BCBridgeTraceStats;
+
+typedef struct {
+    /// The index of the call plus one once written, 0 while being written.
+    _Atomic uint64_t sequence;
+    _Atomic uint64_t site;
+    _Atomic uint64_t start;
+    _Atomic uint64_t duration;
+    _Atomic uint64_t bytes;
+} BCBridgeTraceEvent;
+
+typedef struct BCBridgeTraceBuffer {
+    /// Set before the buffer is published and never changed.
+    struct BCBridgeTraceBuffer *next;
+    _Atomic bool isClaimed;
+    _Atomic uint64_t threadID;
+    /// Calls written to the ring so far.
+    _Atomic uint64_t head;
+    /// Allocated on the first call; the slot of a site on its first call there.
+    _Atomic(BCBridgeTraceEvent *) ring;
+    _Atomic(BCBridgeTraceStats *) stats[BC_BRIDGE_TRACE_SITE_SLOTS + 1];
+} BCBridgeTraceBuffer;
+
+static _Atomic bool BCBridgeTraceEnabled;
+static BCBridgeTraceSiteSlot BCBridgeTraceSites[BC_BRIDGE_TRACE_SITE_SLOTS];
+static size_t BCBridgeTraceSiteCount;
+static pthread_mutex_t BCBridgeTraceSiteLock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic(BCBridgeTraceBuffer *) BCBridgeTraceBuffers;
+static pthread_key_t BCBridgeTraceBufferKey;
+static pthread_once_t BCBridgeTraceBufferKeyOnce = PTHREAD_ONCE_INIT;
+static _Thread_local BCBridgeTraceBuffer *BCBridgeTraceCurrentBuffer;
+
+void
+BCBridgeTraceSetEnabled(bool enabled)
+{
+    atomic_store_explicit(&BCBridgeTraceEnabled, enabled, memory_order_relaxed);
+}
+
+bool
+BCBridgeTraceIsEnabled(void)
+{
+    return atomic_load_explicit(&BCBridgeTraceEnabled, memory_order_relaxed);
+}
+
+uint64_t
+BCBridgeTraceNow(void)
+{
+#ifdef __APPLE__
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+#endif
+}
+
+/// FNV-1a, never 0.
+static uint64_t
+BCBridgeTraceHash(const char *name, size_t length)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 0x100000001b3;
+    }
+    return hash | 1;
+}
+
+/// The slot holding `name`, or the empty slot where it would go.
+static BCBridgeTraceSiteSlot *
+BCBridgeTraceProbe(const char *name, size_t length, uint64_t hash, const char **found)
+{
+    size_t i = (size_t)(hash >> 32) & (BC_BRIDGE_TRACE_SITE_SLOTS - 1);
+    for (;; i = (i + 1) & (BC_BRIDGE_TRACE_SITE_SLOTS - 1)) {
+        BCBridgeTraceSiteSlot *slot = &BCBridgeTraceSites[i];
+        const char *slotName = atomic_load_explicit(&slot->name, memory_order_acquire);
+        if (slotName == NULL || (slot->hash == hash && slot->length == length && memcmp(slotName, name, length) == 0)) {
+            *found = slotName;
+            return slot;
+        }
+    }
+}
+
+BCBridgeTraceSite
+BCBridgeTraceSiteForName(const char *name, size_t length)
+{
+    uint64_t hash = BCBridgeTraceHash(name, length);
+    const char *found;
+    BCBridgeTraceSiteSlot *slot = BCBridgeTraceProbe(name, length, hash, &found);
+    if (found != NULL) {
+        return (BCBridgeTraceSite)(slot - BCBridgeTraceSites);
+    }
+
+    pthread_mutex_lock(&BCBridgeTraceSiteLock);
+    // Another thread may have interned it since the probe.
+    slot = BCBridgeTraceProbe(name, length, hash, &found);
+    BCBridgeTraceSite site = (BCBridgeTraceSite)(slot - BCBridgeTraceSites);
+    if (found == NULL) {
+        char *copy = BCBridgeTraceSiteCount < BC_BRIDGE_TRACE_MAX_SITES ? malloc(length + 1) : NULL;
+        if (copy != NULL) {
+            memcpy(copy, name, length);
+            copy[length] = '\0';
+            slot->hash = hash;
+            slot->length = length;
+            atomic_store_explicit(&slot->name, copy, memory_order_release);
+            BCBridgeTraceSiteCount++;
+        } else {
+            site = BC_BRIDGE_TRACE_OVERFLOW_SITE;
+        }
+    }
+    pthread_mutex_unlock(&BCBridgeTraceSiteLock);
+    return site;
+}
+
+static bool
+BCBridgeTraceIsIdentifierStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$';
+}
+
+static bool
+BCBridgeTraceIsIdentifierPart(char c)
+{
+    return BCBridgeTraceIsIdentifierStart(c) || (c >= '0' && c <= '9') || c == '.';
+}
+
+BCBridgeTraceSite
+BCBridgeTraceSiteForScript(const char *script, size_t length)
+{
+    size_t start = 0;
+    while (start < length && (script[start] == ' ' || script[start] == '\n' || script[start] == '\t' || script[start] == '\r')) {
+        start++;
+    }
+    size_t end = start;
+    while (end < length && BCBridgeTraceIsIdentifierPart(script[end])) {
+        end++;
+    }
+    // A call whose first argument is a call too, such as JSON.stringify(f(…)), is named for both.
+    if (end > start && end + 1 < length && script[end] == '(' && BCBridgeTraceIsIdentifierStart(script[end + 1])) {
+        end++;
+        while (end < length && BCBridgeTraceIsIdentifierPart(script[end])) {
+            end++;
+        }
+    }
+    if (end == start) {
+        return BCBridgeTraceSiteForName("(script)", 8);
+    }
+    if (end - start > BC_BRIDGE_TRACE_MAX_SCRIPT_NAME) {
+        end = start + BC_BRIDGE_TRACE_MAX_SCRIPT_NAME;
+    }
+    return BCBridgeTraceSiteForName(script + start, end - start);
+}
+
+static const char *
+BCBridgeTraceSiteName(size_t site)
+{
+    if (site >= BC_BRIDGE_TRACE_SITE_SLOTS) {
+        return "(other)";
+    }
+    return atomic_load_explicit(&BCBridgeTraceSites[site].name, memory_order_acquire);
+}
+
+/// Hands the buffer of an exiting thread to the next thread that needs one.
+static void
+BCBridgeTraceReleaseBuffer(void *buffer)
+{
+    atomic_store_explicit(&((BCBridgeTraceBuffer *)buffer)->isClaimed, false, memory_order_release);
+}
+
+static void
+BCBridgeTraceCreateBufferKey(void)
+{
+    pthread_key_create(&BCBridgeTraceBufferKey, BCBridgeTraceReleaseBuffer);
+}
+
+static uint64_t
+BCBridgeTraceThreadID(void)
+{
+#ifdef __APPLE__
+    uint64_t threadID = 0;
+    pthread_threadid_np(NULL, &threadID);
+    return threadID;
+#else
+    static _Atomic uint64_t lastThreadID;
+    return atomic_fetch_add_explicit(&lastThreadID, 1, memory_order_relaxed) + 1;
+#endif
+}
+
+/// The calling thread's buffer, claimed or created on its first call. NULL if out of memory.
+static BCBridgeTraceBuffer *
+BCBridgeTraceClaimBuffer(void)
+{
+    pthread_once(&BCBridgeTraceBufferKeyOnce, BCBridgeTraceCreateBufferKey);
+    BCBridgeTraceBuffer *buffer = atomic_load_explicit(&BCBridgeTraceBuffers, memory_order_acquire);
+    for (; buffer != NULL; buffer = buffer->next) {
+        bool isClaimed = false;
+        if (!atomic_load_explicit(&buffer->isClaimed, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&buffer->isClaimed, &isClaimed, true, memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (buffer == NULL) {
+        buffer = calloc(1, sizeof(*buffer));
+        if (buffer == NULL) {
+            return NULL;
+        }
+        atomic_init(&buffer->isClaimed, true);
+        BCBridgeTraceBuffer *head = atomic_load_explicit(&BCBridgeTraceBuffers, memory_order_relaxed);
+        do {
+            buffer->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&BCBridgeTraceBuffers, &head, buffer, memory_order_release, memory_order_relaxed));
+    }
+    atomic_store_explicit(&buffer->threadID, BCBridgeTraceThreadID(), memory_order_relaxed);
+    pthread_setspecific(BCBridgeTraceBufferKey, buffer);
+    BCBridgeTraceCurrentBuffer = buffer;
+    return buffer;
+}
+
+static size_t
+BCBridgeTraceBucket(uint64_t nanoseconds)
+{
+    if (nanoseconds < (1 << BC_BRIDGE_TRACE_SUB_BUCKET_BITS)) {
+        return (size_t)nanoseconds;
+    }
+    unsigned shift = 63 - (unsigned)__builtin_clzll(nanoseconds) - BC_BRIDGE_TRACE_SUB_BUCKET_BITS;
+    size_t bucket = ((size_t)(shift + 1) << BC_BRIDGE_TRACE_SUB_BUCKET_BITS) + (size_t)((nanoseconds >> shift) & ((1 << BC_BRIDGE_TRACE_SUB_BUCKET_BITS) - 1));
+    return bucket < BC_BRIDGE_TRACE_BUCKET_COUNT ? bucket : BC_BRIDGE_TRACE_BUCKET_COUNT - 1;
+}
+
+/// The largest value that falls in `bucket`.
+static uint64_t
+BCBridgeTraceBucketLimit(size_t bucket)
+{
+    if (bucket < (1 << BC_BRIDGE_TRACE_SUB_BUCKET_BITS)) {
+        return bucket;
+    }
+    unsigned shift = (unsigned)(bucket >> BC_BRIDGE_TRACE_SUB_BUCKET_BITS) - 1;
+    uint64_t mantissa = (1 << BC_BRIDGE_TRACE_SUB_BUCKET_BITS) + (bucket & ((1 << BC_BRIDGE_TRACE_SUB_BUCKET_BITS) - 1));
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/// Adds to a counter only this thread writes, without a read-modify-write.
+static inline void
+BCBridgeTraceAdd(_Atomic uint64_t *counter, uint64_t value)
+{
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value, memory_order_relaxed);
+}
+
+void
+BCBridgeTraceRecord(BCBridgeTraceSite site, uint64_t start, uint64_t end, uint64_t bytes)
+{
+    if (!BCBridgeTraceIsEnabled() || site > BC_BRIDGE_TRACE_OVERFLOW_SITE) {
+        return;
+    }
+    BCBridgeTraceBuffer *buffer = BCBridgeTraceCurrentBuffer;
+    if (buffer == NULL && (buffer = BCBridgeTraceClaimBuffer()) == NULL) {
+        return;
+    }
+    uint64_t duration = end > start ? end - start : 0;
+
+    BCBridgeTraceStats *stats = atomic_load_explicit(&buffer->stats[site], memory_order_relaxed);
+    if (stats == NULL) {
+        if ((stats = calloc(1, sizeof(*stats))) == NULL) {
+            return;
+        }
+        atomic_store_explicit(&buffer->stats[site], stats, memory_order_release);
+    }
+    BCBridgeTraceAdd(&stats->count, 1);
+    BCBridgeTraceAdd(&stats->totalNanoseconds, duration);
+    BCBridgeTraceAdd(&stats->bytes, bytes);
+    if (duration > atomic_load_explicit(&stats->maxNanoseconds, memory_order_relaxed)) {
+        atomic_store_explicit(&stats->maxNanoseconds, duration, memory_order_relaxed);
+    }
+    _Atomic uint32_t *bucket = &stats->buckets[BCBridgeTraceBucket(duration)];
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+
+    BCBridgeTraceEvent *ring = atomic_load_explicit(&buffer->ring, memory_order_relaxed);
+    if (ring == NULL) {
+        if ((ring = calloc(BC_BRIDGE_TRACE_RING_LENGTH, sizeof(*ring))) == NULL) {
+            return;
+        }
+        atomic_store_explicit(&buffer->ring, ring, memory_order_release);
+    }
+    uint64_t index = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    BCBridgeTraceEvent *event = &ring[index % BC_BRIDGE_TRACE_RING_LENGTH];
+    atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&event->site, site, memory_order_relaxed);
+    atomic_store_explicit(&event->start, start, memory_order_relaxed);
+    atomic_store_explicit(&event->duration, duration, memory_order_relaxed);
+    atomic_store_explicit(&event->bytes, bytes, memory_order_relaxed);
+    atomic_store_explicit(&event->sequence, index + 1, memory_order_release);
+    atomic_store_explicit(&buffer->head, index + 1, memory_order_release);
+}
+
+/// A site's numbers summed over every buffer.
+typedef struct {
+    BCBridgeTraceSummary summary;
+    uint64_t buckets[BC_BRIDGE_TRACE_BUCKET_COUNT];
+} BCBridgeTraceTotal;
+
+static uint64_t
+BCBridgeTracePercentile(const BCBridgeTraceTotal *total, uint64_t percent)
+{
+    uint64_t rank = (total->summary.count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BC_BRIDGE_TRACE_BUCKET_COUNT; i++) {
+        seen += total->buckets[i];
+        if (seen >= rank && seen > 0) {
+            uint64_t limit = BCBridgeTraceBucketLimit(i);
+            return limit < total->summary.maxNanoseconds ? limit : total->summary.maxNanoseconds;
+        }
+    }
+    return total->summary.maxNanoseconds;
+}
+
+static int
+BCBridgeTraceCompareTotalTime(const void *a, const void *b)
+{
+    uint64_t lhs = ((const BCBridgeTraceSummary *)a)->totalNanoseconds;
+    uint64_t rhs = ((const BCBridgeTraceSummary *)b)->totalNanoseconds;
+    return lhs < rhs ? 1 : (lhs > rhs ? -1 : 0);
+}
+
+/// Summaries of every site called so far, by descending total time. NULL if out of memory.
+static BCBridgeTraceSummary *
+BCBridgeTraceCopyAllSummaries(size_t *count)
+{
+    BCBridgeTraceTotal *total = malloc(sizeof(*total));
+    BCBridgeTraceSummary *summaries = malloc((BC_BRIDGE_TRACE_SITE_SLOTS + 1) * sizeof(*summaries));
+    if (total == NULL || summaries == NULL) {
+        free(total);
+        free(summaries);
+        return NULL;
+    }
+    *count = 0;
+    for (size_t site = 0; site <= BC_BRIDGE_TRACE_OVERFLOW_SITE; site++) {
+        memset(total, 0, sizeof(*total));
+        BCBridgeTraceBuffer *buffer = atomic_load_explicit(&BCBridgeTraceBuffers, memory_order_acquire);
+        for (; buffer != NULL; buffer = buffer->next) {
+            BCBridgeTraceStats *stats = atomic_load_explicit(&buffer->stats[site], memory_order_acquire);
+            if (stats == NULL) {
+                continue;
+            }
+            // The fields are read one by one, so a call being recorded may be half counted.
+            total->summary.count += atomic_load_explicit(&stats->count, memory_order_relaxed);
+            total->summary.totalNanoseconds += atomic_load_explicit(&stats->totalNanoseconds, memory_order_relaxed);
+            total->summary.bytes += atomic_load_explicit(&stats->bytes, memory_order_relaxed);
+            uint64_t max = atomic_load_explicit(&stats->maxNanoseconds, memory_order_relaxed);
+            if (max > total->summary.maxNanoseconds) {
+                total->summary.maxNanoseconds = max;
+            }
+            for (size_t i = 0; i < BC_BRIDGE_TRACE_BUCKET_COUNT; i++) {
+                total->buckets[i] += atomic_load_explicit(&stats->buckets[i], memory_order_relaxed);
+            }
+        }
+        if (total->summary.count == 0) {
+            continue;
+        }
+        total->summary.name = BCBridgeTraceSiteName(site);
+        total->summary.p50Nanoseconds = BCBridgeTracePercentile(total, 50);
+        total->summary.p99Nanoseconds = BCBridgeTracePercentile(total, 99);
+        summaries[(*count)++] = total->summary;
+    }
+    free(total);
+    qsort(summaries, *count, sizeof(*summaries), BCBridgeTraceCompareTotalTime);
+    return summaries;
+}
+
+size_t
+BCBridgeTraceCopySummaries(BCBridgeTraceSummary *summaries, size_t capacity)
+{
+    size_t count = 0;
+    BCBridgeTraceSummary *all = BCBridgeTraceCopyAllSummaries(&count);
+    if (all == NULL) {
+        return 0;
+    }
+    if (capacity > 0) {
+        memcpy(summaries, all, (count < capacity ? count : capacity) * sizeof(*summaries));
+    }
+    free(all);
+    return count;
+}
+
+typedef struct {
+    char *bytes;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} BCBridgeTraceWriter;
+
+static void
+BCBridgeTraceAppend(BCBridgeTraceWriter *writer, const char *format, ...)
+{
+    if (writer->failed) {
+        return;
+    }
+    for (;;) {
+        va_list arguments;
+        va_start(arguments, format);
+        int written = vsnprintf(writer->bytes + writer->length, writer->capacity - writer->length, format, arguments);
+        va_end(arguments);
+        if (written < 0) {
+            writer->failed = true;
+            return;
+        }
+        if ((size_t)written < writer->capacity - writer->length) {
+            writer->length += (size_t)written;
+            return;
+        }
+        size_t capacity = writer->capacity * 2 > writer->length + (size_t)written + 1 ? writer->capacity * 2 : writer->length + (size_t)written + 1;
+        char *bytes = realloc(writer->bytes, capacity);
+        if (bytes == NULL) {
+            writer->failed = true;
+            return;
+        }
+        writer->bytes = bytes;
+        writer->capacity = capacity;
+    }
+}
+
+/// Appends `string` as a quoted JSON string.
+static void
+BCBridgeTraceAppendString(BCBridgeTraceWriter *writer, const char *string)
+{
+    BCBridgeTraceAppend(writer, "\"");
+    for (const char *c = string; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            BCBridgeTraceAppend(writer, "\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            BCBridgeTraceAppend(writer, "\\u%04x", (unsigned)*c);
+        } else {
+            BCBridgeTraceAppend(writer, "%c", *c);
+        }
+    }
+    BCBridgeTraceAppend(writer, "\"");
+}
+
+static bool
+BCBridgeTraceWriterBegin(BCBridgeTraceWriter *writer)
+{
+    writer->length = 0;
+    writer->capacity = 4096;
+    writer->failed = false;
+    writer->bytes = malloc(writer->capacity);
+    return writer->bytes != NULL;
+}
+
+static char *
+BCBridgeTraceWriterFinish(BCBridgeTraceWriter *writer, size_t *length)
+{
+    if (writer->failed) {
+        free(writer->bytes);
+        return NULL;
+    }
+    if (length != NULL) {
+        *length = writer->length;
+    }
+    return writer->bytes;
+}
+
+char *
+BCBridgeTraceCopyJSON(size_t *length)
+{
+    BCBridgeTraceWriter writer;
+    size_t count = 0;
+    BCBridgeTraceSummary *summaries = BCBridgeTraceCopyAllSummaries(&count);
+    if (summaries == NULL || !BCBridgeTraceWriterBegin(&writer)) {
+        free(summaries);
+        return NULL;
+    }
+    BCBridgeTraceAppend(&writer, "{\"sites\":[");
+    for (size_t i = 0; i < count; i++) {
+        const BCBridgeTraceSummary *summary = &summaries[i];
+        BCBridgeTraceAppend(&writer, "%s{\"name\":", i > 0 ? "," : "");
+        BCBridgeTraceAppendString(&writer, summary->name);
+        BCBridgeTraceAppend(&writer, ",\"count\":%llu,\"total_us\":%llu,\"p50_us\":%llu,\"p99_us\":%llu,\"max_us\":%llu,\"bytes\":%llu}",
+                            (unsigned long long)summary->count,
+                            (unsigned long long)(summary->totalNanoseconds / 1000),
+                            (unsigned long long)(summary->p50Nanoseconds / 1000),
+                            (unsigned long long)(summary->p99Nanoseconds / 1000),
+                            (unsigned long long)(summary->maxNanoseconds / 1000),
+                            (unsigned long long)summary->bytes);
+    }
+    BCBridgeTraceAppend(&writer, "]}");
+    free(summaries);
+    return BCBridgeTraceWriterFinish(&writer, length);
+}
+
+char *
+BCBridgeTraceCopyChromeTrace(size_t *length)
+{
+    BCBridgeTraceWriter writer;
+    if (!BCBridgeTraceWriterBegin(&writer)) {
+        return NULL;
+    }
+    BCBridgeTraceAppend(&writer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool isFirst = true;
+    BCBridgeTraceBuffer *buffer = atomic_load_explicit(&BCBridgeTraceBuffers, memory_order_acquire);
+    for (; buffer != NULL; buffer = buffer->next) {
+        BCBridgeTraceEvent *ring = atomic_load_explicit(&buffer->ring, memory_order_acquire);
+        if (ring == NULL) {
+            continue;
+        }
+        uint64_t threadID = atomic_load_explicit(&buffer->threadID, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        uint64_t index = head > BC_BRIDGE_TRACE_RING_LENGTH ? head - BC_BRIDGE_TRACE_RING_LENGTH : 0;
+        for (; index < head; index++) {
+            BCBridgeTraceEvent *event = &ring[index % BC_BRIDGE_TRACE_RING_LENGTH];
+            if (atomic_load_explicit(&event->sequence, memory_order_acquire) != index + 1) {
+                continue;
+            }
+            uint64_t site = atomic_load_explicit(&event->site, memory_order_relaxed);
+            uint64_t start = atomic_load_explicit(&event->start, memory_order_relaxed);
+            uint64_t duration = atomic_load_explicit(&event->duration, memory_order_relaxed);
+            uint64_t bytes = atomic_load_explicit(&event->bytes, memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            // Overwritten by the owning thread while being read.
+            if (atomic_load_explicit(&event->sequence, memory_order_relaxed) != index + 1) {
+                continue;
+            }
+            BCBridgeTraceAppend(&writer, "%s{\"name\":", isFirst ? "" : ",");
+            BCBridgeTraceAppendString(&writer, BCBridgeTraceSiteName((size_t)site));
+            BCBridgeTraceAppend(&writer, ",\"cat\":\"bridge\",\"ph\":\"X\",\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":1,\"tid\":%llu,\"args\":{\"bytes\":%llu}}",
+                                (unsigned long long)(start / 1000), (unsigned)(start % 1000),
+                                (unsigned long long)(duration / 1000), (unsigned)(duration % 1000),
+                                (unsigned long long)threadID,
+                                (unsigned long long)bytes);
+            isFirst = false;
+        }
+    }
+    BCBridgeTraceAppend(&writer, "]}");
+    return BCBridgeTraceWriterFinish(&writer, length);
+}
@@ -0,0 +1,128 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef BCBridgeTrace_h
+#define BCBridgeTrace_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Timings of the calls that cross the JS bridge: script evaluations, native callbacks and
+ * XMLHttpRequest sends, keyed by a call site name.
+ *
+ * Each thread that records gets its own buffer: per-site counters and a latency histogram, and a
+ * ring of its latest calls. Only the owning thread writes to a buffer, without locks or
+ * read-modify-write atomics; readers copy out of every buffer and drop ring entries that were
+ * overwritten while they read, as told by a per-entry sequence. Buffers are kept for reuse by
+ * later threads and never freed. Site names are interned once, under a lock, and looked up
+ * without one.
+ *
+ * Tracing starts disabled; a disabled trace costs one relaxed load per call. Define
+ * BC_BRIDGE_TRACE to 0 to compile the call sites out.
+ */
+
+#ifndef BC_BRIDGE_TRACE
+#define BC_BRIDGE_TRACE 1
+#endif
+
+/// Distinct site names; calls past them are all counted under "(other)".
+#define BC_BRIDGE_TRACE_MAX_SITES 512
+/// Latest calls kept per thread for the Chrome trace.
+#define BC_BRIDGE_TRACE_RING_LENGTH 4096
+
+/// An interned call site name.
+typedef uint32_t BCBridgeTraceSite;
+
+typedef struct {
+    /// Interned, valid for the life of the process.
+    const char *name;
+    uint64_t count;
+    uint64_t totalNanoseconds;
+    uint64_t maxNanoseconds;
+    /// Percentiles are read off a histogram with four buckets per power of two, so they are
+    /// within 25% of the true value and never above the max.
+    uint64_t p50Nanoseconds;
+    uint64_t p99Nanoseconds;
+    uint64_t bytes;
+} BCBridgeTraceSummary;
+
+void BCBridgeTraceSetEnabled(bool enabled);
+bool BCBridgeTraceIsEnabled(void);
+
+/// Monotonic time in nanoseconds.
+uint64_t BCBridgeTraceNow(void);
+
+/// Interns `name`, which need not be NUL terminated.
+BCBridgeTraceSite BCBridgeTraceSiteForName(const char *name, size_t length);
+
+/// Interns the name of a script: its leading dotted identifier, followed by the one it is called
+/// on when that is also an identifier, e.g. `JSON.stringify(MyWalletPhone.getLabels` for
+/// `JSON.stringify(MyWalletPhone.getLabels(0))`. Arguments are left out so that one function is
+/// one site.
+BCBridgeTraceSite BCBridgeTraceSiteForScript(const char *script, size_t length);
+
+/// Records one call from `start` to `end` that marshalled `bytes`. Does nothing while disabled.
+void BCBridgeTraceRecord(BCBridgeTraceSite site, uint64_t start, uint64_t end, uint64_t bytes);
+
+/// Fills up to `capacity` summaries of the sites called so far, by descending total time, and
+/// returns how many there are in all.
+size_t BCBridgeTraceCopySummaries(BCBridgeTraceSummary *summaries, size_t capacity);
+
+/// The summaries as a JSON object `{"sites":[{"name":…,"count":…,"total_us":…,"p50_us":…,
+/// "p99_us":…,"max_us":…,"bytes":…}]}`, NUL terminated. The caller frees it. NULL if out of memory.
+char *BCBridgeTraceCopyJSON(size_t *length);
+
+/// The calls still in the rings in the Chrome trace event format, one complete ("X") event each,
+/// NUL terminated. The caller frees it. NULL if out of memory.
+char *BCBridgeTraceCopyChromeTrace(size_t *length);
+
+/// A call being timed, from `BCBridgeTraceScopeBegin` to `BCBridgeTraceScopeEnd`.
+typedef struct {
+    BCBridgeTraceSite site;
+    uint64_t start;
+    uint64_t bytes;
+    bool isActive;
+} BCBridgeTraceScope;
+
+static inline BCBridgeTraceScope
+BCBridgeTraceScopeBegin(const char *name, uint64_t bytes)
+{
+    BCBridgeTraceScope scope = { 0, 0, 0, false };
+    if (BCBridgeTraceIsEnabled()) {
+        scope.site = BCBridgeTraceSiteForName(name, strlen(name));
+        scope.bytes = bytes;
+        scope.isActive = true;
+        scope.start = BCBridgeTraceNow();
+    }
+    return scope;
+}
+
+static inline void
+BCBridgeTraceScopeEnd(BCBridgeTraceScope *scope)
+{
+    if (scope->isActive) {
+        BCBridgeTraceRecord(scope->site, scope->start, BCBridgeTraceNow(), scope->bytes);
+    }
+}
+
+#if BC_BRIDGE_TRACE
+/// Times the rest of the enclosing scope as a call to `name`, a C string. `bytes` is only
+/// evaluated while tracing is enabled.
+#define BC_BRIDGE_TRACE_SCOPE(name, bytes) \
+    BCBridgeTraceScope bcBridgeTraceScope __attribute__((cleanup(BCBridgeTraceScopeEnd), unused)) = \
+        BCBridgeTraceScopeBegin((name), BCBridgeTraceIsEnabled() ? (uint64_t)(bytes) : 0)
+#else
+#define BC_BRIDGE_TRACE_SCOPE(name, bytes) do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BCBridgeTrace_h */
@@ -0,0 +1,47 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+@class JSContext;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Loads the bundled wallet JavaScript (my-wallet.js followed by wallet-ios.js) into a JSContext.
+/// Asset specific helpers (wallet-ios-<module>.js) are kept out of the startup path and are
+/// evaluated on demand with `-evaluateModuleNamed:inContext:`.
+///
+/// Sources are memory-mapped instead of being read and concatenated into a single NSString.
+/// When JavaScriptCore provides `JSScript`, each source is compiled with a bytecode cache stored in
+/// the Caches directory and keyed on the SHA-256 of the source, so warm launches skip parsing and compilation.
+/// Otherwise it falls back to `-[JSContext evaluateScript:withSourceURL:]`.
+///
+/// Resources with a pinned digest are checked against it before they are evaluated, and in release
+/// builds are not evaluated if they do not match. Digests come from `WalletJSIntegrity`, which
+/// records them in the cache directory, so neither the check nor the bytecode cache key costs a
+/// hash on warm launches.
+@interface WalletJSBundle : NSObject
+
+/// The wallet bundle shipped in the main bundle.
++ (instancetype)mainBundle;
+
+- (instancetype)initWithResourceNames:(NSArray<NSString *> *)resourceNames
+                          moduleNames:(NSArray<NSString *> *)moduleNames
+                        pinnedDigests:(NSDictionary<NSString *, NSData *> *)pinnedDigests
+                               bundle:(NSBundle *)bundle
+                        cacheDirectory:(NSURL *)cacheDirectory NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Evaluates the prefix script and every resource, in order, in `context`.
+- (void)evaluateInContext:(JSContext *)context;
+
+/// Evaluates the lazily loaded module `name` (one of `moduleNames`) in `context`.
+/// Returns NO if the module is unknown or its source could not be loaded.
+- (BOOL)evaluateModuleNamed:(NSString *)name inContext:(JSContext *)context;
+
+/// Removes every cached bytecode file.
+- (void)purgeBytecodeCache;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,234 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <CommonCrypto/CommonDigest.h>
+#import <JavaScriptCore/JavaScriptCore.h>
+#import "WalletJSBundle.h"
+#import "WalletJSIntegrity.h"
+#import "NSData+Hex.h"
+
+#define WALLET_JS_BUNDLE_CACHE_DIRECTORY @"WalletJS"
+#define WALLET_JS_BUNDLE_BYTECODE_EXTENSION @"jsc"
+#define WALLET_JS_BUNDLE_INTEGRITY_RECORD @"integrity.plist"
+
+// JSScript is only exposed by JavaScriptCore on newer OS versions, so it is looked up at runtime.
+typedef NS_ENUM(NSInteger, WalletJSScriptType) {
+    WalletJSScriptTypeProgram = 0,
+};
+
+@protocol WalletJSScriptClass <NSObject>
++ (nullable id)scriptOfType:(WalletJSScriptType)type memoryMappedFromASCIIFile:(NSURL *)filePath withSourceURL:(NSURL *)sourceURL andBytecodeCache:(nullable NSURL *)cachePath inVirtualMachine:(JSVirtualMachine *)vm error:(out NSError **)error;
++ (nullable id)scriptOfType:(WalletJSScriptType)type withSource:(NSString *)source andSourceURL:(NSURL *)sourceURL andBytecodeCache:(nullable NSURL *)cachePath inVirtualMachine:(JSVirtualMachine *)vm error:(out NSError **)error;
+@end
+
+@protocol WalletJSScript <NSObject>
+- (BOOL)cacheBytecodeWithError:(out NSError **)error;
+- (BOOL)isUsingBytecodeCache;
+@end
+
+@interface JSContext (WalletJSScript)
+- (JSValue *)evaluateJSScript:(id)script;
+@end
+
+@interface WalletJSBundle ()
+
+@property (nonatomic, copy) NSArray<NSString *> *resourceNames;
+@property (nonatomic, copy) NSArray<NSString *> *moduleNames;
+@property (nonatomic, copy) NSDictionary<NSString *, NSData *> *pinnedDigests;
+@property (nonatomic, strong) WalletJSIntegrity *integrity;
+@property (nonatomic, strong) NSBundle *bundle;
+@property (nonatomic, strong) NSURL *cacheDirectory;
+
+@end
+
+@implementation WalletJSBundle
+
++ (instancetype)mainBundle
+{
+    NSURL *caches = [[[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] firstObject];
+    NSBundle *bundle = [NSBundle mainBundle];
+    NSMutableDictionary<NSString *, NSData *> *pinnedDigests = [NSMutableDictionary dictionary];
+    NSURL *checksumURL = [bundle URLForResource:JAVASCRIPTCORE_RESOURCE_MY_WALLET withExtension:JAVASCRIPTCORE_TYPE_JS_CHECKSUM];
+    NSData *pinnedDigest = checksumURL ? [WalletJSIntegrity pinnedDigestFromChecksumFileAtURL:checksumURL] : nil;
+    if (pinnedDigest) {
+        pinnedDigests[JAVASCRIPTCORE_RESOURCE_MY_WALLET] = pinnedDigest;
+    } else {
+        DLog(@"No pinned digest for %@", JAVASCRIPTCORE_RESOURCE_MY_WALLET);
+    }
+    return [[WalletJSBundle alloc] initWithResourceNames:@[JAVASCRIPTCORE_RESOURCE_MY_WALLET, JAVASCRIPTCORE_RESOURCE_WALLET_IOS]
+                                             moduleNames:@[JAVASCRIPTCORE_MODULE_BCH, JAVASCRIPTCORE_MODULE_XLM]
+                                           pinnedDigests:pinnedDigests
+                                                  bundle:bundle
+                                          cacheDirectory:[caches URLByAppendingPathComponent:WALLET_JS_BUNDLE_CACHE_DIRECTORY isDirectory:YES]];
+}
+
+- (instancetype)initWithResourceNames:(NSArray<NSString *> *)resourceNames moduleNames:(NSArray<NSString *> *)moduleNames pinnedDigests:(NSDictionary<NSString *, NSData *> *)pinnedDigests bundle:(NSBundle *)bundle cacheDirectory:(NSURL *)cacheDirectory
+{
+    self = [super init];
+    if (self) {
+        _resourceNames = [resourceNames copy];
+        _moduleNames = [moduleNames copy];
+        _pinnedDigests = [pinnedDigests copy];
+        _bundle = bundle;
+        _cacheDirectory = cacheDirectory;
+        NSString *appVersion = [NSString stringWithFormat:@"%@ (%@)", [bundle objectForInfoDictionaryKey:@"CFBundleShortVersionString"], [bundle objectForInfoDictionaryKey:@"CFBundleVersion"]];
+        _integrity = [[WalletJSIntegrity alloc] initWithRecordURL:[cacheDirectory URLByAppendingPathComponent:WALLET_JS_BUNDLE_INTEGRITY_RECORD isDirectory:NO]
+                                                       appVersion:appVersion];
+    }
+    return self;
+}
+
+- (void)evaluateInContext:(JSContext *)context
+{
+    [context evaluateScript:JAVASCRIPTCORE_PREFIX_JS_SOURCE];
+
+    for (NSString *name in self.resourceNames) {
+        [self evaluateResourceNamed:name inContext:context];
+    }
+}
+
+- (BOOL)evaluateModuleNamed:(NSString *)name inContext:(JSContext *)context
+{
+    if (![self.moduleNames containsObject:name]) {
+        DLog(@"Unknown JS module %@", name);
+        return NO;
+    }
+    return [self evaluateResourceNamed:[NSString stringWithFormat:JAVASCRIPTCORE_RESOURCE_WALLET_IOS_MODULE_FORMAT, name] inContext:context];
+}
+
+- (BOOL)evaluateResourceNamed:(NSString *)name inContext:(JSContext *)context
+{
+    NSURL *sourceURL = [self.bundle URLForResource:name withExtension:JAVASCRIPTCORE_TYPE_JS];
+    if (!sourceURL) {
+        DLog(@"Missing JS resource %@", name);
+        return NO;
+    }
+
+    BOOL hasCacheDirectory = [self prepareCacheDirectory];
+    NSData *pinnedDigest = self.pinnedDigests[name];
+    if (pinnedDigest && ![self.integrity verifyFileAtURL:sourceURL pinnedDigest:pinnedDigest]) {
+        DLog(@"JS resource %@ does not match its pinned digest", name);
+#if !DEBUG
+        return NO;
+#endif
+    }
+
+    NSError *error = nil;
+    NS_VALID_UNTIL_END_OF_SCOPE NSData *source = [NSData dataWithContentsOfURL:sourceURL options:NSDataReadingMappedAlways error:&error];
+    if (!source) {
+        DLog(@"Failed to map JS resource %@: %@", name, error);
+        return NO;
+    }
+
+    BOOL canUseBytecodeCache = [self scriptClass] != nil && [context respondsToSelector:@selector(evaluateJSScript:)] && hasCacheDirectory;
+    if (canUseBytecodeCache && [self evaluateSource:source named:name sourceURL:sourceURL withBytecodeCacheInContext:context]) {
+        return YES;
+    }
+
+    [context evaluateScript:[self stringWithoutCopyingData:source] withSourceURL:sourceURL];
+    return YES;
+}
+
+- (void)purgeBytecodeCache
+{
+    [[NSFileManager defaultManager] removeItemAtURL:self.cacheDirectory error:nil];
+}
+
+#pragma mark - Bytecode cache
+
+- (Class<WalletJSScriptClass>)scriptClass
+{
+    Class scriptClass = NSClassFromString(@"JSScript");
+    if (![scriptClass respondsToSelector:@selector(scriptOfType:withSource:andSourceURL:andBytecodeCache:inVirtualMachine:error:)]) {
+        return nil;
+    }
+    return (Class<WalletJSScriptClass>)scriptClass;
+}
+
+- (BOOL)evaluateSource:(NSData *)source named:(NSString *)name sourceURL:(NSURL *)sourceURL withBytecodeCacheInContext:(JSContext *)context
+{
+    NSString *digest = [[self.integrity digestOfFileAtURL:sourceURL] hexadecimalString] ?: [self sha256HexStringForData:source];
+    NSURL *cacheURL = [self bytecodeCacheURLForResourceNamed:name digest:digest];
+    [self removeStaleBytecodeForResourceNamed:name keeping:cacheURL];
+
+    Class<WalletJSScriptClass> scriptClass = [self scriptClass];
+    NSError *error = nil;
+
+    // The mapped-file variant hands the pages straight to JSC, but it only accepts pure ASCII sources.
+    id<WalletJSScript> script = nil;
+    if ([scriptClass respondsToSelector:@selector(scriptOfType:memoryMappedFromASCIIFile:withSourceURL:andBytecodeCache:inVirtualMachine:error:)]) {
+        script = [scriptClass scriptOfType:WalletJSScriptTypeProgram memoryMappedFromASCIIFile:sourceURL withSourceURL:sourceURL andBytecodeCache:cacheURL inVirtualMachine:context.virtualMachine error:&error];
+    }
+    if (!script) {
+        script = [scriptClass scriptOfType:WalletJSScriptTypeProgram withSource:[self stringWithoutCopyingData:source] andSourceURL:sourceURL andBytecodeCache:cacheURL inVirtualMachine:context.virtualMachine error:&error];
+    }
+    if (!script) {
+        DLog(@"Unable to create JSScript for %@: %@", name, error);
+        return NO;
+    }
+
+    [context evaluateJSScript:script];
+
+    if (![script isUsingBytecodeCache] && ![script cacheBytecodeWithError:&error]) {
+        DLog(@"Unable to cache bytecode for %@: %@", name, error);
+    }
+    return YES;
+}
+
+- (BOOL)prepareCacheDirectory
+{
+    NSError *error = nil;
+    if (![[NSFileManager defaultManager] createDirectoryAtURL:self.cacheDirectory withIntermediateDirectories:YES attributes:nil error:&error]) {
+        DLog(@"Unable to create JS bytecode cache directory: %@", error);
+        return NO;
+    }
+    return YES;
+}
+
+- (NSURL *)bytecodeCacheURLForResourceNamed:(NSString *)name digest:(NSString *)digest
+{
+    NSString *fileName = [NSString stringWithFormat:@"%@-%@.%@", name, digest, WALLET_JS_BUNDLE_BYTECODE_EXTENSION];
+    return [self.cacheDirectory URLByAppendingPathComponent:fileName isDirectory:NO];
+}
+
+- (void)removeStaleBytecodeForResourceNamed:(NSString *)name keeping:(NSURL *)currentURL
+{
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSArray<NSURL *> *contents = [fileManager contentsOfDirectoryAtURL:self.cacheDirectory includingPropertiesForKeys:nil options:0 error:nil];
+    for (NSURL *url in contents) {
+        if ([self isBytecodeCacheFileName:url.lastPathComponent forResourceNamed:name] && ![url.lastPathComponent isEqualToString:currentURL.lastPathComponent]) {
+            [fileManager removeItemAtURL:url error:nil];
+        }
+    }
+}
+
+/// Whether `fileName` is `<name>-<SHA-256 hex>.jsc`. A bare prefix would also match the caches
+/// of the asset modules, as `wallet-ios-bch` starts with `wallet-ios-`.
+- (BOOL)isBytecodeCacheFileName:(NSString *)fileName forResourceNamed:(NSString *)name
+{
+    NSString *prefix = [name stringByAppendingString:@"-"];
+    NSString *suffix = [@"." stringByAppendingString:WALLET_JS_BUNDLE_BYTECODE_EXTENSION];
+    NSUInteger digestLength = CC_SHA256_DIGEST_LENGTH * 2;
+    if (fileName.length != prefix.length + digestLength + suffix.length || ![fileName hasPrefix:prefix] || ![fileName hasSuffix:suffix]) {
+        return NO;
+    }
+    NSString *digest = [fileName substringWithRange:NSMakeRange(prefix.length, digestLength)];
+    NSCharacterSet *nonHexCharacters = [[NSCharacterSet characterSetWithCharactersInString:@"0123456789abcdefABCDEF"] invertedSet];
+    return [digest rangeOfCharacterFromSet:nonHexCharacters].location == NSNotFound;
+}
+
+#pragma mark - Helpers
+
+- (NSString *)sha256HexStringForData:(NSData *)data
+{
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+    return [[NSData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH] hexadecimalString];
+}
+
+/// Wraps the mapped bytes without copying them; `data` must outlive the returned string's use.
+- (NSString *)stringWithoutCopyingData:(NSData *)data
+{
+    return [[NSString alloc] initWithBytesNoCopy:(void *)data.bytes length:data.length encoding:NSUTF8StringEncoding freeWhenDone:NO];
+}
+
+@end
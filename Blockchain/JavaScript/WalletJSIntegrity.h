@@ -0,0 +1,35 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// SHA-256 digests of the bundled JS, each file hashed at most once per install.
+///
+/// A file is memory-mapped and hashed in a single sequential pass. The digest is recorded in a
+/// plist keyed on the file's device, inode, size and modification time, and on the app version,
+/// so a launch that finds the file unchanged since it was hashed takes the digest from the record.
+/// Used from one thread at a time.
+@interface WalletJSIntegrity : NSObject
+
+/// `recordURL` is the plist the digests are kept in; its directory must exist.
+- (instancetype)initWithRecordURL:(NSURL *)recordURL appVersion:(NSString *)appVersion NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// The digest pinned in a `shasum -a 256` checksum file, e.g. my-wallet.js.sha256. nil if the file
+/// is missing or does not start with one.
++ (nullable NSData *)pinnedDigestFromChecksumFileAtURL:(NSURL *)url;
+
+/// The SHA-256 of the file at `url`; nil if it cannot be read.
+- (nullable NSData *)digestOfFileAtURL:(NSURL *)url;
+
+/// Whether the file at `url` hashes to `pinnedDigest`.
+- (BOOL)verifyFileAtURL:(NSURL *)url pinnedDigest:(NSData *)pinnedDigest;
+
+/// Files hashed rather than taken from the record, since init.
+@property (nonatomic, readonly) NSUInteger hashCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,132 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <CommonCrypto/CommonDigest.h>
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import "WalletJSIntegrity.h"
+
+#define WALLET_JS_INTEGRITY_RECORD_IDENTITY @"identity"
+#define WALLET_JS_INTEGRITY_RECORD_DIGEST @"digest"
+
+/// Bytes hashed per update, which takes a 32-bit length.
+static const size_t WalletJSIntegrityChunkLength = 16 << 20;
+
+/// SHA-256 of the `size` bytes of `fd`, mapped rather than read.
+static NSData *WalletJSIntegrityHashFile(int fd, size_t size)
+{
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+    if (size > 0) {
+        const uint8_t *bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (bytes == MAP_FAILED) {
+            return nil;
+        }
+        // Read once, front to back: let the kernel read ahead and drop the pages behind.
+        (void)madvise((void *)bytes, size, MADV_SEQUENTIAL);
+        for (size_t offset = 0; offset < size; offset += WalletJSIntegrityChunkLength) {
+            CC_SHA256_Update(&context, bytes + offset, (CC_LONG)MIN(WalletJSIntegrityChunkLength, size - offset));
+        }
+        munmap((void *)bytes, size);
+    }
+    uint8_t digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest, &context);
+    return [NSData dataWithBytes:digest length:sizeof(digest)];
+}
+
+@interface WalletJSIntegrity ()
+
+@property (nonatomic, strong) NSURL *recordURL;
+@property (nonatomic, copy) NSString *appVersion;
+/// File name to identity and digest, loaded on first use.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSDictionary *> *records;
+@property (nonatomic, readwrite) NSUInteger hashCount;
+
+@end
+
+@implementation WalletJSIntegrity
+
+- (instancetype)initWithRecordURL:(NSURL *)recordURL appVersion:(NSString *)appVersion
+{
+    self = [super init];
+    if (self) {
+        _recordURL = recordURL;
+        _appVersion = [appVersion copy];
+    }
+    return self;
+}
+
++ (NSData *)pinnedDigestFromChecksumFileAtURL:(NSURL *)url
+{
+    NSString *contents = [NSString stringWithContentsOfURL:url encoding:NSUTF8StringEncoding error:nil];
+    NSString *hex = [[contents componentsSeparatedByCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]] firstObject];
+    if (hex.length != CC_SHA256_DIGEST_LENGTH * 2) {
+        return nil;
+    }
+    NSMutableData *digest = [NSMutableData dataWithLength:CC_SHA256_DIGEST_LENGTH];
+    uint8_t *bytes = digest.mutableBytes;
+    const char *characters = hex.UTF8String;
+    for (NSUInteger i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+        if (!isxdigit(characters[2 * i]) || !isxdigit(characters[2 * i + 1])) {
+            return nil;
+        }
+        bytes[i] = (uint8_t)(digittoint(characters[2 * i]) << 4 | digittoint(characters[2 * i + 1]));
+    }
+    return digest;
+}
+
+- (NSData *)digestOfFileAtURL:(NSURL *)url
+{
+    int fd = open(url.fileSystemRepresentation, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nil;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        close(fd);
+        return nil;
+    }
+
+    // The same file, unchanged, in the same app version; the bundle path itself moves with every update.
+    NSString *identity = [NSString stringWithFormat:@"%llu:%llu:%lld:%ld.%09ld:%@",
+                          (unsigned long long)status.st_dev, (unsigned long long)status.st_ino, (long long)status.st_size,
+                          (long)status.st_mtimespec.tv_sec, (long)status.st_mtimespec.tv_nsec, self.appVersion];
+    NSString *name = url.lastPathComponent;
+    NSDictionary *record = self.loadedRecords[name];
+    NSData *recordedDigest = record[WALLET_JS_INTEGRITY_RECORD_DIGEST];
+    if ([record[WALLET_JS_INTEGRITY_RECORD_IDENTITY] isEqual:identity] &&
+        [recordedDigest isKindOfClass:[NSData class]] && recordedDigest.length == CC_SHA256_DIGEST_LENGTH) {
+        close(fd);
+        return recordedDigest;
+    }
+
+    NSData *digest = WalletJSIntegrityHashFile(fd, (size_t)status.st_size);
+    close(fd);
+    if (!digest) {
+        return nil;
+    }
+    self.hashCount += 1;
+    self.records[name] = @{ WALLET_JS_INTEGRITY_RECORD_IDENTITY: identity, WALLET_JS_INTEGRITY_RECORD_DIGEST: digest };
+    if (![self.records writeToURL:self.recordURL atomically:YES]) {
+        DLog(@"Unable to save JS integrity record to %@", self.recordURL);
+    }
+    return digest;
+}
+
+- (BOOL)verifyFileAtURL:(NSURL *)url pinnedDigest:(NSData *)pinnedDigest
+{
+    NSData *digest = [self digestOfFileAtURL:url];
+    return digest != nil && [digest isEqualToData:pinnedDigest];
+}
+
+- (NSMutableDictionary<NSString *, NSDictionary *> *)loadedRecords
+{
+    if (!self.records) {
+        NSDictionary *saved = [NSDictionary dictionaryWithContentsOfURL:self.recordURL];
+        self.records = saved ? [saved mutableCopy] : [NSMutableDictionary dictionary];
+    }
+    return self.records;
+}
+
+@end
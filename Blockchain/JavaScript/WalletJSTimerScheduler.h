@@ -0,0 +1,40 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Handle returned by `WalletJSTimerScheduler`. Zero is never a valid handle.
+typedef uint32_t WalletJSTimerHandle;
+
+/// Backs the JS `setTimeout` / `setInterval` shims.
+///
+/// Timers live in a binary min-heap ordered by deadline and are driven by a single run loop timer
+/// that is re-armed for the earliest deadline, so any number of pending JS timers costs one wakeup.
+/// Handles index directly into a slot table, making cancellation O(1); cancelled heap entries are
+/// discarded lazily when they reach the top.
+///
+/// Follows HTML timer semantics: callbacks never run synchronously from `schedule`, timers with
+/// equal deadlines run in scheduling order, and timers added by a callback do not run in the same pass.
+/// Must only be used from the thread that owns `runLoop`.
+@interface WalletJSTimerScheduler : NSObject
+
+- (instancetype)initWithRunLoop:(NSRunLoop *)runLoop NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// Number of timers that are scheduled and not cancelled.
+@property (nonatomic, readonly) NSUInteger count;
+
+/// Schedules `block` to run after `delay` seconds, and every `delay` seconds afterwards if `repeats`.
+- (WalletJSTimerHandle)scheduleAfter:(NSTimeInterval)delay repeats:(BOOL)repeats block:(dispatch_block_t)block;
+
+/// Cancels the timer for `handle`. Unknown or already fired handles are ignored.
+- (void)cancel:(WalletJSTimerHandle)handle;
+
+/// Cancels every timer.
+- (void)cancelAll;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,321 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <time.h>
+#import "WalletJSTimerScheduler.h"
+
+// A handle packs the slot (plus one, so handles are never zero) with the slot's generation,
+// which invalidates handles, and heap entries, belonging to a previous occupant of the slot.
+#define WALLET_JS_TIMER_SLOT_BITS 16
+#define WALLET_JS_TIMER_SLOT_MASK ((1u << WALLET_JS_TIMER_SLOT_BITS) - 1)
+#define WALLET_JS_TIMER_MAX_SLOTS WALLET_JS_TIMER_SLOT_MASK
+#define WALLET_JS_TIMER_GENERATION_MASK 0x7fffu
+
+// Timers due within this window after a wakeup run in that same wakeup.
+#define WALLET_JS_TIMER_LEEWAY_NSEC (1 * NSEC_PER_MSEC)
+// Fire date used to park the wakeup timer while no JS timer is pending.
+#define WALLET_JS_TIMER_PARKED_INTERVAL (60.0 * 60 * 24 * 365)
+// Repeating timers never run more often than this, mirroring the clamping browsers apply.
+#define WALLET_JS_TIMER_MIN_INTERVAL_NSEC (1 * NSEC_PER_MSEC)
+
+typedef struct {
+    uint64_t deadline;
+    uint64_t sequence;
+    uint32_t slot;
+    uint32_t generation;
+} WalletJSTimerEntry;
+
+typedef struct {
+    uint64_t interval; // 0 for one-shot timers
+    uint32_t generation;
+    BOOL active;
+} WalletJSTimerSlot;
+
+static uint64_t
+WalletJSTimerNow(void)
+{
+    return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+}
+
+static BOOL
+WalletJSTimerEntryPrecedes(const WalletJSTimerEntry *a, const WalletJSTimerEntry *b)
+{
+    if (a->deadline != b->deadline) {
+        return a->deadline < b->deadline;
+    }
+    return a->sequence < b->sequence;
+}
+
+@implementation WalletJSTimerScheduler
+{
+    CFRunLoopTimerRef _wakeup;
+
+    WalletJSTimerEntry *_heap;
+    size_t _heapCount;
+    size_t _heapCapacity;
+
+    WalletJSTimerSlot *_slots;
+    uint32_t *_freeSlots;
+    size_t _freeCount;
+    size_t _slotCount;
+    size_t _slotCapacity;
+    NSMutableArray *_blocks;
+
+    uint64_t _nextSequence;
+    NSUInteger _count;
+}
+
+- (instancetype)initWithRunLoop:(NSRunLoop *)runLoop
+{
+    self = [super init];
+    if (self) {
+        _blocks = [NSMutableArray new];
+
+        __weak WalletJSTimerScheduler *weakSelf = self;
+        // A repeating timer is never invalidated by firing, so it can be re-armed with SetNextFireDate.
+        _wakeup = CFRunLoopTimerCreateWithHandler(kCFAllocatorDefault, CFAbsoluteTimeGetCurrent() + WALLET_JS_TIMER_PARKED_INTERVAL, WALLET_JS_TIMER_PARKED_INTERVAL, 0, 0, ^(CFRunLoopTimerRef timer) {
+            [weakSelf fire];
+        });
+        CFRunLoopTimerSetTolerance(_wakeup, (double)WALLET_JS_TIMER_LEEWAY_NSEC / NSEC_PER_SEC);
+        CFRunLoopAddTimer([runLoop getCFRunLoop], _wakeup, kCFRunLoopCommonModes);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    CFRunLoopTimerInvalidate(_wakeup);
+    CFRelease(_wakeup);
+    free(_heap);
+    free(_slots);
+    free(_freeSlots);
+}
+
+- (NSUInteger)count
+{
+    return _count;
+}
+
+#pragma mark - Scheduling
+
+- (WalletJSTimerHandle)scheduleAfter:(NSTimeInterval)delay repeats:(BOOL)repeats block:(dispatch_block_t)block
+{
+    if (isnan(delay) || delay < 0) {
+        delay = 0;
+    }
+    uint64_t delayNsec = (uint64_t)MIN(delay * NSEC_PER_SEC, (double)(UINT64_MAX / 4));
+
+    uint32_t slot;
+    if (![self allocateSlot:&slot]) {
+        DLog(@"Error: too many JS timers scheduled");
+        return 0;
+    }
+
+    _slots[slot].interval = repeats ? MAX(delayNsec, WALLET_JS_TIMER_MIN_INTERVAL_NSEC) : 0;
+    _slots[slot].active = YES;
+    _blocks[slot] = [block copy];
+    _count++;
+
+    [self pushEntry:(WalletJSTimerEntry){
+        .deadline = WalletJSTimerNow() + delayNsec,
+        .sequence = _nextSequence++,
+        .slot = slot,
+        .generation = _slots[slot].generation,
+    }];
+    [self rearm];
+
+    return (_slots[slot].generation << WALLET_JS_TIMER_SLOT_BITS) | (slot + 1);
+}
+
+- (void)cancel:(WalletJSTimerHandle)handle
+{
+    uint32_t slotPlusOne = handle & WALLET_JS_TIMER_SLOT_MASK;
+    if (slotPlusOne == 0 || slotPlusOne > _slotCount) {
+        return;
+    }
+    uint32_t slot = slotPlusOne - 1;
+    if (!_slots[slot].active || _slots[slot].generation != (handle >> WALLET_JS_TIMER_SLOT_BITS)) {
+        return;
+    }
+    [self releaseSlot:slot];
+
+    // Cancelled entries are normally dropped when they reach the top of the heap; compact if they pile up.
+    if (_heapCount > 2 * _count + 64) {
+        [self compactHeap];
+    }
+}
+
+- (void)cancelAll
+{
+    for (uint32_t slot = 0; slot < _slotCount; slot++) {
+        if (_slots[slot].active) {
+            [self releaseSlot:slot];
+        }
+    }
+    _heapCount = 0;
+    [self rearm];
+}
+
+#pragma mark - Firing
+
+- (void)fire
+{
+    uint64_t now = WalletJSTimerNow();
+    uint64_t limit = now + WALLET_JS_TIMER_LEEWAY_NSEC;
+    // Timers scheduled by the callbacks below wait for the next wakeup, even with a zero delay.
+    uint64_t sequenceLimit = _nextSequence;
+
+    while (_heapCount > 0) {
+        WalletJSTimerEntry entry = _heap[0];
+        if (![self isEntryLive:&entry]) {
+            [self popEntry];
+            continue;
+        }
+        if (entry.deadline > limit || entry.sequence >= sequenceLimit) {
+            break;
+        }
+        [self popEntry];
+
+        dispatch_block_t block = _blocks[entry.slot];
+        uint64_t interval = _slots[entry.slot].interval;
+        if (interval > 0) {
+            // Reschedule before running so that the callback can clear its own interval.
+            uint64_t deadline = entry.deadline + interval;
+            [self pushEntry:(WalletJSTimerEntry){
+                .deadline = deadline > now ? deadline : now + interval,
+                .sequence = _nextSequence++,
+                .slot = entry.slot,
+                .generation = entry.generation,
+            }];
+        } else {
+            [self releaseSlot:entry.slot];
+        }
+
+        block();
+    }
+
+    [self rearm];
+}
+
+- (void)rearm
+{
+    while (_heapCount > 0 && ![self isEntryLive:&_heap[0]]) {
+        [self popEntry];
+    }
+    if (_heapCount == 0) {
+        CFRunLoopTimerSetNextFireDate(_wakeup, CFAbsoluteTimeGetCurrent() + WALLET_JS_TIMER_PARKED_INTERVAL);
+        return;
+    }
+    uint64_t now = WalletJSTimerNow();
+    uint64_t deadline = _heap[0].deadline;
+    CFTimeInterval delay = deadline > now ? (double)(deadline - now) / NSEC_PER_SEC : 0;
+    CFRunLoopTimerSetNextFireDate(_wakeup, CFAbsoluteTimeGetCurrent() + delay);
+}
+
+#pragma mark - Slots
+
+- (BOOL)allocateSlot:(uint32_t *)slot
+{
+    if (_freeCount > 0) {
+        *slot = _freeSlots[--_freeCount];
+        return YES;
+    }
+    if (_slotCount == WALLET_JS_TIMER_MAX_SLOTS) {
+        return NO;
+    }
+    if (_slotCount == _slotCapacity) {
+        size_t capacity = _slotCapacity ? _slotCapacity * 2 : 16;
+        _slots = reallocf(_slots, capacity * sizeof(WalletJSTimerSlot));
+        _freeSlots = reallocf(_freeSlots, capacity * sizeof(uint32_t));
+        if (_slots == NULL || _freeSlots == NULL) {
+            @throw [NSException exceptionWithName:NSMallocException reason:@"Unable to grow JS timer slots" userInfo:nil];
+        }
+        _slotCapacity = capacity;
+    }
+    *slot = (uint32_t)_slotCount++;
+    _slots[*slot] = (WalletJSTimerSlot){ .interval = 0, .generation = 0, .active = NO };
+    [_blocks addObject:[NSNull null]];
+    return YES;
+}
+
+- (void)releaseSlot:(uint32_t)slot
+{
+    _slots[slot].active = NO;
+    _slots[slot].generation = (_slots[slot].generation + 1) & WALLET_JS_TIMER_GENERATION_MASK;
+    _blocks[slot] = [NSNull null];
+    _freeSlots[_freeCount++] = slot;
+    _count--;
+}
+
+- (BOOL)isEntryLive:(const WalletJSTimerEntry *)entry
+{
+    return _slots[entry->slot].active && _slots[entry->slot].generation == entry->generation;
+}
+
+#pragma mark - Heap
+
+- (void)pushEntry:(WalletJSTimerEntry)entry
+{
+    if (_heapCount == _heapCapacity) {
+        size_t capacity = _heapCapacity ? _heapCapacity * 2 : 16;
+        _heap = reallocf(_heap, capacity * sizeof(WalletJSTimerEntry));
+        if (_heap == NULL) {
+            @throw [NSException exceptionWithName:NSMallocException reason:@"Unable to grow JS timer heap" userInfo:nil];
+        }
+        _heapCapacity = capacity;
+    }
+
+    size_t i = _heapCount++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!WalletJSTimerEntryPrecedes(&entry, &_heap[parent])) {
+            break;
+        }
+        _heap[i] = _heap[parent];
+        i = parent;
+    }
+    _heap[i] = entry;
+}
+
+- (void)popEntry
+{
+    WalletJSTimerEntry last = _heap[--_heapCount];
+    if (_heapCount == 0) {
+        return;
+    }
+    [self siftDown:last from:0];
+}
+
+- (void)siftDown:(WalletJSTimerEntry)entry from:(size_t)i
+{
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= _heapCount) {
+            break;
+        }
+        if (child + 1 < _heapCount && WalletJSTimerEntryPrecedes(&_heap[child + 1], &_heap[child])) {
+            child++;
+        }
+        if (!WalletJSTimerEntryPrecedes(&_heap[child], &entry)) {
+            break;
+        }
+        _heap[i] = _heap[child];
+        i = child;
+    }
+    _heap[i] = entry;
+}
+
+- (void)compactHeap
+{
+    size_t live = 0;
+    for (size_t i = 0; i < _heapCount; i++) {
+        if ([self isEntryLive:&_heap[i]]) {
+            _heap[live++] = _heap[i];
+        }
+    }
+    _heapCount = live;
+    for (size_t i = _heapCount / 2; i-- > 0;) {
+        [self siftDown:_heap[i] from:i];
+    }
+}
+
+@end
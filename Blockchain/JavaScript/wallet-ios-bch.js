@@ -0,0 +1,183 @@
+// MARK: MyWalletPhone.bch
+
+MyWalletPhone.defineModule('bch', {
+    getHistory : function() {
+        var success = function(promise) {
+            console.log('Success fetching bch history')
+            objc_on_fetch_bch_history_success();
+            return promise;
+        };
+
+        var error = function(error) {
+            console.log('Error fetching bch history')
+            console.log(error);
+            objc_on_fetch_bch_history_error(error);
+        };
+
+        return MyWallet.wallet.bch.getHistory().then(success).catch(error);
+    },
+
+    hasAccount : function() {
+        var bch = MyWallet.wallet.bch;
+        return bch && bch.defaultAccount;
+    },
+
+    getAllAccountsCount : function() {
+        var bch = MyWallet.wallet.bch;
+        return bch.accounts.length;
+    },
+
+    getLabelForDefaultAccount : function() {
+        return MyWallet.wallet.bch.defaultAccount.label;
+    },
+        
+    getDefaultBCHAccount : function() {
+        const defaultAccount = MyWallet.wallet.bch.defaultAccount;
+        const account = {
+            "label": defaultAccount.label,
+            "xpub": defaultAccount.xpub,
+            "index": defaultAccount.index,
+            "archived": defaultAccount.archived
+        }
+        return JSON.stringify(account)
+    },
+
+    getDefaultAccountIndex : function() {
+        return MyWallet.wallet.bch.defaultAccountIdx;
+    },
+
+    setDefaultAccount : function(index) {
+        MyWallet.wallet.bch.defaultAccountIdx = index;
+    },
+
+    getReceivingAddressForAccount : function(index) {
+        return Helpers.toBitcoinCash(MyWallet.wallet.bch.accounts[index].receiveAddress);
+    },
+
+    getReceivingAddressForAccountXPub : function(xpub) {
+        const found = MyWallet.wallet.bch.accounts.find(account => account.xpub == xpub);
+        return Helpers.toBitcoinCash(found.receiveAddress);
+    },
+
+    getReceiveIndexForAccountXPub : function(xpub) {
+        const found = MyWallet.wallet.bch.accounts.find(account => account.xpub == xpub);
+        if (!found || typeof found.receiveIndex !== 'number') {
+            return -1;
+        }
+        return found.receiveIndex;
+    },
+
+    getFirstReceivingAddressForAccountXPub: function(xpub) {
+        const found = MyWallet.wallet.bch.accounts.find(account => account.xpub == xpub);
+        return Helpers.toBitcoinCash(found.firstReceiveAddress);
+    },
+
+    getLabelForAccount : function(index) {
+        return MyWallet.wallet.bch.accounts[index].label;
+    },
+
+    setLabelForAccount : function(num, label) {
+        MyWallet.wallet.bch.accounts[num].label = label;
+    },
+
+    getIndexOfActiveAccount : function(index) {
+        var activeAccounts = MyWallet.wallet.bch.activeAccounts;
+        var realNum = activeAccounts[index].index;
+        return realNum;
+    },
+
+    getActiveAccountsCount : function() {
+        return MyWallet.wallet.bch.activeAccounts.length;
+    },
+
+    getActiveLegacyAddresses : function() {
+        if (!MyWallet.wallet || !MyWallet.wallet.bch || !MyWallet.wallet.bch.importedAddresses) {
+            return [];
+        }
+        return MyWallet.wallet.bch.importedAddresses.addresses.map(function(address) {
+            var prefix = 'bitcoincash:';
+            return Helpers.toBitcoinCash(address).slice(prefix.length);
+        });
+    },
+
+    getAllAccounts : function() {
+        const accounts = MyWallet.wallet.bch.accounts.map(function(account) {
+            return {
+                "label": account.label,
+                "xpub": account.xpub,
+                "index": account.index,
+                "archived": account.archived
+            };
+        });
+        return JSON.stringify(accounts)
+    },
+
+    isArchived : function(index) {
+        return MyWallet.wallet.bch.accounts[index].archived;
+    },
+
+    toggleArchived : function(index) {
+        var account = MyWallet.wallet.bch.accounts[index];
+        account.archived = !account.archived;
+    },
+
+    balanceActiveLegacy : function() {
+        return MyWallet.wallet.bch.importedAddresses.balance;
+    },
+
+    getBalance : function() {
+        return MyWallet.wallet.bch.balance;
+    },
+
+    getBalanceForAccount : function(index) {
+        return MyWallet.wallet.bch.accounts[index].balance;
+    },
+
+    hasLegacyAddresses : function() {
+        if (MyWallet.wallet.bch.importedAddresses) {
+            return true;
+        } else {
+            return false;
+        }
+    },
+
+    getBalanceForAddress : function(address) {
+        return MyWallet.wallet.bch.getAddressBalance(Helpers.fromBitcoinCash('bitcoincash:' + address));
+    },
+
+    getXpubForAccount : function(index) {
+        return MyWallet.wallet.bch.accounts[index].xpub;
+    },
+
+    isValidAddress : function(address) {
+        var base = 'bitcoincash:';
+        var prefixed = address.includes(base);
+        if (!prefixed) address = base + address;
+        return Helpers.fromBitcoinCash(address);
+    },
+
+    // Payment
+
+    changePaymentToAddress : function(to) {
+        console.log('Changing bch payment to address');
+        if (Helpers.isBitcoinAddress(to)) {
+            currentBitcoinCashPayment.to(to);
+        } else {
+            let base = 'bitcoincash:';
+            let prefixed = to.includes(base);
+            let toArg = prefixed ? to : (base + to);
+            currentBitcoinCashPayment.to(Helpers.fromBitcoinCash(toArg));
+        }
+    },
+
+    fromBitcoinCash : function(address) {
+        var base = 'bitcoincash:';
+        var prefixed = address.includes(base);
+        if (!prefixed) address = base + address;
+        return Helpers.fromBitcoinCash(address);
+    },
+
+    toBitcoinCash : function(address) {
+        return Helpers.toBitcoinCash(address);
+    }
+});
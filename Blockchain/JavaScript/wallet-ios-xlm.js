@@ -0,0 +1,27 @@
+// MARK: MyWalletPhone.xlm
+
+MyWalletPhone.defineModule('xlm', {
+    saveAccount: function(publicKey, label) {
+        let error = function (e) {
+            console.log('Error MyWalletPhone.xlm.saveAccount')
+            console.log(e)
+            objc_xlmSaveAccount_error(e)
+        };
+        let success = function () {
+            console.log('Success MyWalletPhone.xlm.saveAccount')
+            objc_xlmSaveAccount_success()
+        };
+        MyWallet.wallet.xlm.saveAccount(
+          publicKey,
+          label,
+          success,
+          error
+        );
+    },
+
+    accounts: function() {
+        return MyWallet.wallet.xlm.accounts.map(function(account) {
+          return account.toJSON();
+        });
+    }
+});
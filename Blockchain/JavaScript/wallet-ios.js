@@ -121,6 +121,23 @@ WalletCrypto.stretchPassword = function (password, salt, iterations, keylen) {
     return new Buffer(retVal, 'hex');
 }
 
+// Payloads encrypted with the main password take a key stretched ahead of time by the native side,
+// over a fresh salt that is also the IV. Anything else, such as secrets under the second
+// password, is stretched as before.
+WalletCrypto.encryptDataWithPassword = (function (encryptDataWithPassword) {
+    return function (data, password, iterations) {
+        if (!data || password !== WalletStore.getPassword()) {
+            return encryptDataWithPassword(data, password, iterations);
+        }
+        var saltAndKey = objc_take_payload_key(password, iterations);
+        if (!saltAndKey) {
+            return encryptDataWithPassword(data, password, iterations);
+        }
+        var bytes = new Buffer(saltAndKey, 'hex');
+        return WalletCrypto.encryptDataWithKey(data, bytes.slice(16, 48), bytes.slice(0, 16));
+    };
+})(WalletCrypto.encryptDataWithPassword);
+
 // MARK: - BIP39 overrides
 
 BIP39.mnemonicToSeed = function(mnemonic, enteredPassword) {
@@ -196,6 +213,86 @@ WalletStore.addEventListener(function (event, obj) {
 
 var MyWalletPhone = {};
 
+// MARK: Backups
+
+// Edits made in quick succession, such as relabelling several addresses, are backed up together
+// once none has come for syncDelay milliseconds, or syncMaxDelay after the first of them.
+MyWalletPhone.syncDelay = 500;
+MyWalletPhone.syncMaxDelay = 2000;
+MyWalletPhone.pendingSync = null;
+MyWalletPhone.syncWallet = MyWallet.syncWallet;
+
+MyWallet.syncWallet = function(success, error) {
+    // Keys added or edited before this backup reach the native address index now, not at the next multiaddr.
+    MyWalletPhone.reportLegacyAddressIndexChanges();
+
+    var pending = MyWalletPhone.pendingSync;
+    if (pending) {
+        clearTimeout(pending.timer);
+    } else {
+        pending = MyWalletPhone.pendingSync = { since: Date.now(), successes: [], errors: [] };
+    }
+    if (success) {
+        pending.successes.push(success);
+    }
+    if (error) {
+        pending.errors.push(error);
+    }
+    var delay = Math.min(MyWalletPhone.syncDelay, pending.since + MyWalletPhone.syncMaxDelay - Date.now());
+    pending.timer = setTimeout(MyWalletPhone.flushPendingSync, Math.max(delay, 0));
+};
+
+MyWalletPhone.flushPendingSync = function() {
+    var pending = MyWalletPhone.pendingSync;
+    if (!pending) {
+        return;
+    }
+    clearTimeout(pending.timer);
+    MyWalletPhone.pendingSync = null;
+
+    var callAll = function(callbacks) {
+        return function() {
+            var args = arguments;
+            callbacks.forEach(function(callback) {
+                callback.apply(null, args);
+            });
+        };
+    };
+    MyWalletPhone.syncWallet(callAll(pending.successes), callAll(pending.errors));
+};
+
+// MARK: Asset modules
+
+// Asset specific helpers live in their own wallet-ios-<name>.js resource and are only
+// evaluated the first time MyWalletPhone.<name> is accessed, see objc_load_js_module.
+
+MyWalletPhone.defineModule = function(name, module) {
+    Object.defineProperty(MyWalletPhone, name, {
+        value: module,
+        writable: true,
+        enumerable: true,
+        configurable: true
+    });
+}
+
+MyWalletPhone.lazyModule = function(name) {
+    Object.defineProperty(MyWalletPhone, name, {
+        enumerable: true,
+        configurable: true,
+        get: function() {
+            objc_load_js_module(name);
+            var descriptor = Object.getOwnPropertyDescriptor(MyWalletPhone, name);
+            if (!descriptor || descriptor.get) {
+                throw new Error('Unable to load wallet JS module ' + name);
+            }
+            return descriptor.value;
+        }
+    });
+}
+
+MyWalletPhone.lazyModule('bch');
+MyWalletPhone.lazyModule('xlm');
+
 MyWalletPhone.upgradeToV4 = function() {
     var success = function () {
         console.log('Upgraded V3 wallet to V4 wallet');
@@ -752,7 +849,7 @@ MyWalletPhone.getAccountInfo = function () {
 
     var success = function (data) {
         console.log('Getting account info');
-        var accountInfo = JSON.stringify(data, null, 2);
+        var accountInfo = JSON.stringify(data);
         objc_on_get_account_info_success(accountInfo);
         return data;
     }
@@ -764,19 +861,6 @@ MyWalletPhone.getAccountInfo = function () {
     return MyWallet.wallet.fetchAccountInfo().then(success).catch(error);
 }
 
-MyWalletPhone.getAccountInfoAndExchangeRates = function() {
-
-    var success = function() {
-        objc_on_get_account_info_and_exchange_rates()
-    };
-
-    MyWalletPhone.getAccountInfo().then(function(data) {
-        var getBtcExchangeRates = MyWalletPhone.getBtcExchangeRates()
-        var getBchExchangeRates = MyWalletPhone.bch.fetchExchangeRates()
-        Promise.all([getBtcExchangeRates, getBchExchangeRates]).then(success);
-    });
-}
-
 MyWalletPhone.changePassword = function(password) {
 
     var success = function () {
@@ -810,7 +894,7 @@ MyWalletPhone.getBtcExchangeRates = function () {
 
     var success = function (data) {
         console.log('Getting btc exchange rates');
-        var currencySymbolData = JSON.stringify(data, null, 2);
+        var currencySymbolData = JSON.stringify(data);
         objc_on_get_btc_exchange_rates_success(currencySymbolData);
         return data;
     };
@@ -832,6 +916,53 @@ MyWalletPhone.checkIfWalletHasAddress = function(address) {
     return (MyWallet.wallet.addresses.indexOf(address) > -1);
 }
 
+// The native address index is loaded once from getLegacyAddressIndex and then kept current with
+// getLegacyAddressIndexChanges, which only returns the entries added or changed since the last call.
+MyWalletPhone.legacyAddressIndexSnapshot = {};
+
+// [address, label, archived, isWatchOnly, balance]
+MyWalletPhone.legacyAddressIndexEntry = function(key) {
+    return [key.address, key.label || '', key.archived, key.isWatchOnly, key.balance || 0];
+}
+
+// One entry per legacy address.
+MyWalletPhone.getLegacyAddressIndex = function() {
+    var snapshot = MyWalletPhone.legacyAddressIndexSnapshot = {};
+    return JSON.stringify(MyWallet.wallet.keys.map(function(key) {
+        var entry = MyWalletPhone.legacyAddressIndexEntry(key);
+        snapshot[entry[0]] = entry;
+        return entry;
+    }));
+}
+
+// The entries added or changed since the last call, or an empty string if there are none.
+MyWalletPhone.getLegacyAddressIndexChanges = function() {
+    var snapshot = MyWalletPhone.legacyAddressIndexSnapshot;
+    var changes = [];
+    MyWallet.wallet.keys.forEach(function(key) {
+        var entry = MyWalletPhone.legacyAddressIndexEntry(key);
+        var previous = snapshot[entry[0]];
+        var isChanged = !previous || entry.some(function(field, i) {
+            return field !== previous[i];
+        });
+        if (isChanged) {
+            snapshot[entry[0]] = entry;
+            changes.push(entry);
+        }
+    });
+    return changes.length > 0 ? JSON.stringify(changes) : '';
+}
+
+MyWalletPhone.reportLegacyAddressIndexChanges = function() {
+    if (!MyWallet.wallet) {
+        return;
+    }
+    var changes = MyWalletPhone.getLegacyAddressIndexChanges();
+    if (changes) {
+        objc_on_legacy_address_index_changes(changes);
+    }
+}
+
 MyWalletPhone.recoverWithPassphrase = function(email, password, passphrase) {
 
     if (Helpers.isValidBIP39Mnemonic(passphrase)) {
@@ -1109,32 +1240,6 @@ MyWalletPhone.walletConnect = {
     }
 }
 
-MyWalletPhone.xlm = {
-    saveAccount: function(publicKey, label) {
-        let error = function (e) {
-            console.log('Error MyWalletPhone.xlm.saveAccount')
-            console.log(e)
-            objc_xlmSaveAccount_error(e)
-        };
-        let success = function () {
-            console.log('Success MyWalletPhone.xlm.saveAccount')
-            objc_xlmSaveAccount_success()
-        };
-        MyWallet.wallet.xlm.saveAccount(
-          publicKey,
-          label,
-          success,
-          error
-        );
-    },
-
-    accounts: function() {
-        return MyWallet.wallet.xlm.accounts.map(function(account) {
-          return account.toJSON();
-        });
-    }
-}
-
 MyWalletPhone.getBitcoinNote = function(txHash) {
     return MyWallet.wallet._tx_notes[txHash];
 }
@@ -1232,222 +1337,66 @@ MyWalletPhone.getMobileMessage = function(languageCode) {
     return notice;
 }
 
-MyWalletPhone.bch = {
-    getHistory : function() {
-        var success = function(promise) {
-            console.log('Success fetching bch history')
-            objc_on_fetch_bch_history_success();
-            return promise;
-        };
-
-        var error = function(error) {
-            console.log('Error fetching bch history')
-            console.log(error);
-            objc_on_fetch_bch_history_error(error);
-        };
-
-        return MyWallet.wallet.bch.getHistory().then(success).catch(error);
-    },
-
-    getHistoryAndRates : function() {
-        var success = function(result) {
-            objc_did_get_bitcoin_cash_exchange_rates(result[1], false);
-            objc_on_fetch_bch_history_success();
-            return result;
-        }
-
-        var error = function(e) {
-            console.log('Error fetching bch history and rates')
-            console.log(e);
-        }
-
-        var getBitcoinCashHistory = MyWallet.wallet.bch.getHistory();
-        var getBitcoinCashExchangeRates = BlockchainAPI.getExchangeRate('USD', 'BCH');
-        return Promise.all([getBitcoinCashHistory, getBitcoinCashExchangeRates]).then(success).catch(error);
-    },
-
-    fetchExchangeRates : function() {
-        var success = function(result) {
-            objc_did_get_bitcoin_cash_exchange_rates(result);
-            return result;
-        }
-
-        var error = function(e) {
-            console.log(e);
-        }
-        return BlockchainAPI.getExchangeRate('USD', 'BCH').then(success).catch(error);
-    },
-
-    hasAccount : function() {
-        var bch = MyWallet.wallet.bch;
-        return bch && bch.defaultAccount;
-    },
-
-    getAllAccountsCount : function() {
-        var bch = MyWallet.wallet.bch;
-        return bch.accounts.length;
-    },
+MyWalletPhone.loadMetadata = function() {
+    MyWallet.wallet.loadMetadata().then(function() {
+        objc_reload();
+    });
+}
 
-    getLabelForDefaultAccount : function() {
-        return MyWallet.wallet.bch.defaultAccount.label;
-    },
-        
-    getDefaultBCHAccount : function() {
-        const defaultAccount = MyWallet.wallet.bch.defaultAccount;
-        const account = {
-            "label": defaultAccount.label,
-            "xpub": defaultAccount.xpub,
-            "index": defaultAccount.index,
-            "archived": defaultAccount.archived
+// Fetches the parts asked for (WalletRefreshParts in WalletRefreshCoordinator.h) all at once, and
+// reports them together to objc_on_refresh_assets when the slowest is done. A part that fails is
+// reported in errors instead of failing the others.
+MyWalletPhone.refreshAssets = function(refreshId, parts) {
+    var fetches = [];
+
+    var fetch = function(part, name, run) {
+        if (!(parts & part)) return;
+        var promise;
+        try {
+            promise = Promise.resolve(run());
+        } catch (e) {
+            promise = Promise.reject(e);
         }
-        return JSON.stringify(account)
-    },
-
-    getDefaultAccountIndex : function() {
-        return MyWallet.wallet.bch.defaultAccountIdx;
-    },
-
-    setDefaultAccount : function(index) {
-        MyWallet.wallet.bch.defaultAccountIdx = index;
-    },
-
-    getReceivingAddressForAccount : function(index) {
-        return Helpers.toBitcoinCash(MyWallet.wallet.bch.accounts[index].receiveAddress);
-    },
-
-    getReceivingAddressForAccountXPub : function(xpub) {
-        const found = MyWallet.wallet.bch.accounts.find(account => account.xpub == xpub);
-        return Helpers.toBitcoinCash(found.receiveAddress);
-    },
-
-    getFirstReceivingAddressForAccountXPub: function(xpub) {
-        const found = MyWallet.wallet.bch.accounts.find(account => account.xpub == xpub);
-        return Helpers.toBitcoinCash(found.firstReceiveAddress);
-    },
-
-    getLabelForAccount : function(index) {
-        return MyWallet.wallet.bch.accounts[index].label;
-    },
-
-    setLabelForAccount : function(num, label) {
-        MyWallet.wallet.bch.accounts[num].label = label;
-    },
-
-    getIndexOfActiveAccount : function(index) {
-        var activeAccounts = MyWallet.wallet.bch.activeAccounts;
-        var realNum = activeAccounts[index].index;
-        return realNum;
-    },
+        fetches.push(promise.then(function(value) {
+            return { name: name, value: value };
+        }, function(e) {
+            return { name: name, error: String(e) };
+        }));
+    };
 
-    getActiveAccountsCount : function() {
-        return MyWallet.wallet.bch.activeAccounts.length;
-    },
+    var done = function() {
+        return true;
+    };
 
-    getActiveLegacyAddresses : function() {
-        if (!MyWallet.wallet || !MyWallet.wallet.bch || !MyWallet.wallet.bch.importedAddresses) {
-            return [];
-        }
-        return MyWallet.wallet.bch.importedAddresses.addresses.map(function(address) {
-            var prefix = 'bitcoincash:';
-            return Helpers.toBitcoinCash(address).slice(prefix.length);
-        });
-    },
+    fetch(1 << 0, 'walletHistory', function() {
+        return Promise.all([MyWallet.wallet.getHistory(), MyWallet.wallet.btc.getHistory()]).then(done);
+    });
+    fetch(1 << 1, 'bitcoinCashHistory', function() {
+        return MyWallet.wallet.bch.getHistory().then(done);
+    });
+    fetch(1 << 2, 'accountInfo', function() {
+        return MyWallet.wallet.fetchAccountInfo();
+    });
+    fetch(1 << 3, 'bitcoinRates', function() {
+        return BlockchainAPI.getTicker();
+    });
+    fetch(1 << 4, 'bitcoinCashRates', function() {
+        return BlockchainAPI.getExchangeRate('USD', 'BCH');
+    });
 
-    getAllAccounts : function() {
-        const accounts = MyWallet.wallet.bch.accounts.map(function(account) {
-            return {
-                "label": account.label,
-                "xpub": account.xpub,
-                "index": account.index,
-                "archived": account.archived
-            };
+    Promise.all(fetches).then(function(results) {
+        var batch = { values: {}, errors: {} };
+        results.forEach(function(result) {
+            if ('error' in result) {
+                batch.errors[result.name] = result.error;
+            } else {
+                batch.values[result.name] = result.value;
+            }
         });
-        return JSON.stringify(accounts)
-    },
-
-    isArchived : function(index) {
-        return MyWallet.wallet.bch.accounts[index].archived;
-    },
-
-    toggleArchived : function(index) {
-        var account = MyWallet.wallet.bch.accounts[index];
-        account.archived = !account.archived;
-    },
-
-    balanceActiveLegacy : function() {
-        return MyWallet.wallet.bch.importedAddresses.balance;
-    },
-
-    getBalance : function() {
-        return MyWallet.wallet.bch.balance;
-    },
-
-    getBalanceForAccount : function(index) {
-        return MyWallet.wallet.bch.accounts[index].balance;
-    },
-
-    hasLegacyAddresses : function() {
-        if (MyWallet.wallet.bch.importedAddresses) {
-            return true;
-        } else {
-            return false;
-        }
-    },
-
-    getBalanceForAddress : function(address) {
-        return MyWallet.wallet.bch.getAddressBalance(Helpers.fromBitcoinCash('bitcoincash:' + address));
-    },
-
-    getXpubForAccount : function(index) {
-        return MyWallet.wallet.bch.accounts[index].xpub;
-    },
-
-    isValidAddress : function(address) {
-        var base = 'bitcoincash:';
-        var prefixed = address.includes(base);
-        if (!prefixed) address = base + address;
-        return Helpers.fromBitcoinCash(address);
-    },
-
-    // Payment
-
-    changePaymentToAddress : function(to) {
-        console.log('Changing bch payment to address');
-        if (Helpers.isBitcoinAddress(to)) {
-            currentBitcoinCashPayment.to(to);
-        } else {
-            let base = 'bitcoincash:';
-            let prefixed = to.includes(base);
-            let toArg = prefixed ? to : (base + to);
-            currentBitcoinCashPayment.to(Helpers.fromBitcoinCash(toArg));
-        }
-    },
-
-    fromBitcoinCash : function(address) {
-        var base = 'bitcoincash:';
-        var prefixed = address.includes(base);
-        if (!prefixed) address = base + address;
-        return Helpers.fromBitcoinCash(address);
-    },
-
-    toBitcoinCash : function(address) {
-        return Helpers.toBitcoinCash(address);
-    }
-};
-
-MyWalletPhone.loadMetadata = function() {
-    MyWallet.wallet.loadMetadata().then(function() {
-        objc_reload();
+        objc_on_refresh_assets(refreshId, JSON.stringify(batch));
     });
 }
 
-MyWalletPhone.getHistoryForAllAssets = function() {
-    var walletHistory = MyWallet.wallet.getHistory();
-    var bitcoinHistory = MyWallet.wallet.btc.getHistory();
-    var bitcoinCashHistory = MyWallet.wallet.bch.getHistory();
-    return Promise.all([walletHistory, bitcoinHistory, bitcoinCashHistory]);
-}
-
 MyWalletPhone.tradeExecution = {
     bitcoin: {
         /**
@@ -0,0 +1,370 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include "BCAddressIndex.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "addrcodec.h"
+
+// Tables are grown to keep at most half of their slots used.
+#define BC_ADDRESS_INDEX_MIN_CAPACITY 64
+// Labels are appended to chunks of at least this size.
+#define BC_ADDRESS_INDEX_LABEL_CHUNK 4096
+
+/// A label in a chunk: its length, then its bytes and a NUL.
+typedef struct {
+    size_t length;
+    char bytes[];
+} BCAddressIndexLabel;
+
+typedef struct BCAddressIndexLabelChunk {
+    struct BCAddressIndexLabelChunk *next;
+    size_t used;
+    size_t capacity;
+    char bytes[];
+} BCAddressIndexLabelChunk;
+
+typedef struct {
+    uint8_t key[BC_ADDRESS_INDEX_KEY_LENGTH];
+    bool isUsed;
+    uint32_t flags;
+    uint64_t balance;
+    /// Only ever points into a label chunk, so any value a reader sees is safe to read from.
+    _Atomic(const BCAddressIndexLabel *) label;
+} BCAddressIndexSlot;
+
+typedef struct BCAddressIndexTable {
+    /// The table this one replaced, kept for readers that may still be probing it.
+    struct BCAddressIndexTable *retired;
+    size_t mask;
+    BCAddressIndexSlot slots[];
+} BCAddressIndexTable;
+
+struct BCAddressIndex {
+    pthread_mutex_t writeLock;
+    /// Odd while a write is in progress.
+    _Atomic uint32_t sequence;
+    _Atomic(BCAddressIndexTable *) table;
+    _Atomic size_t count;
+    BCAddressIndexLabelChunk *labels;
+};
+
+static BCAddressIndexTable *
+BCAddressIndexTableCreate(size_t capacity)
+{
+    BCAddressIndexTable *table = calloc(1, sizeof(*table) + capacity * sizeof(BCAddressIndexSlot));
+    if (table != NULL) {
+        table->mask = capacity - 1;
+    }
+    return table;
+}
+
+static size_t
+BCAddressIndexHome(const BCAddressIndexTable *table, const uint8_t *key)
+{
+    uint64_t hash;
+    memcpy(&hash, key + 1, sizeof(hash));
+    return (size_t)(hash ^ key[0]) & table->mask;
+}
+
+/// The slot holding `key`, or the empty slot where it would go.
+static BCAddressIndexSlot *
+BCAddressIndexProbe(const BCAddressIndexTable *table, const uint8_t *key)
+{
+    size_t i = BCAddressIndexHome(table, key);
+    // Tables are never full, so the probe always ends.
+    for (;; i = (i + 1) & table->mask) {
+        const BCAddressIndexSlot *slot = &table->slots[i];
+        if (!slot->isUsed || memcmp(slot->key, key, BC_ADDRESS_INDEX_KEY_LENGTH) == 0) {
+            return (BCAddressIndexSlot *)slot;
+        }
+    }
+}
+
+/// Copies `label` into a chunk. Returns NULL if out of memory.
+static const BCAddressIndexLabel *
+BCAddressIndexAppendLabel(BCAddressIndex *index, const char *label, size_t length)
+{
+    size_t size = (sizeof(BCAddressIndexLabel) + length + 1 + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+    BCAddressIndexLabelChunk *chunk = index->labels;
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        size_t capacity = size > BC_ADDRESS_INDEX_LABEL_CHUNK ? size : BC_ADDRESS_INDEX_LABEL_CHUNK;
+        chunk = malloc(sizeof(*chunk) + capacity);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = index->labels;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        index->labels = chunk;
+    }
+    BCAddressIndexLabel *stored = (BCAddressIndexLabel *)(chunk->bytes + chunk->used);
+    stored->length = length;
+    memcpy(stored->bytes, label, length);
+    stored->bytes[length] = '\0';
+    chunk->used += size;
+    return stored;
+}
+
+static void
+BCAddressIndexBeginWrite(BCAddressIndex *index)
+{
+    pthread_mutex_lock(&index->writeLock);
+    atomic_store_explicit(&index->sequence, atomic_load_explicit(&index->sequence, memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void
+BCAddressIndexEndWrite(BCAddressIndex *index)
+{
+    atomic_store_explicit(&index->sequence, atomic_load_explicit(&index->sequence, memory_order_relaxed) + 1, memory_order_release);
+    pthread_mutex_unlock(&index->writeLock);
+}
+
+/// Moves every entry to a table twice the size. Called with the write lock held.
+static bool
+BCAddressIndexGrow(BCAddressIndex *index)
+{
+    BCAddressIndexTable *old = atomic_load_explicit(&index->table, memory_order_relaxed);
+    BCAddressIndexTable *table = BCAddressIndexTableCreate((old->mask + 1) * 2);
+    if (table == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i <= old->mask; i++) {
+        if (old->slots[i].isUsed) {
+            BCAddressIndexSlot *slot = BCAddressIndexProbe(table, old->slots[i].key);
+            memcpy(slot->key, old->slots[i].key, BC_ADDRESS_INDEX_KEY_LENGTH);
+            slot->isUsed = true;
+            slot->flags = old->slots[i].flags;
+            slot->balance = old->slots[i].balance;
+            atomic_init(&slot->label, atomic_load_explicit(&old->slots[i].label, memory_order_relaxed));
+        }
+    }
+    table->retired = old;
+    atomic_store_explicit(&index->table, table, memory_order_release);
+    return true;
+}
+
+/// Sets the label of `slot`, reusing the current one if it is the same. Called with the write lock held.
+static bool
+BCAddressIndexStoreLabel(BCAddressIndex *index, BCAddressIndexSlot *slot, const char *label)
+{
+    size_t length = label != NULL ? strlen(label) : 0;
+    const BCAddressIndexLabel *current = atomic_load_explicit(&slot->label, memory_order_relaxed);
+    if (length == 0) {
+        atomic_store_explicit(&slot->label, NULL, memory_order_relaxed);
+        return true;
+    }
+    if (current != NULL && current->length == length && memcmp(current->bytes, label, length) == 0) {
+        return true;
+    }
+    const BCAddressIndexLabel *stored = BCAddressIndexAppendLabel(index, label, length);
+    if (stored == NULL) {
+        return false;
+    }
+    // Released so that a reader seeing the pointer also sees the label it points to.
+    atomic_store_explicit(&slot->label, stored, memory_order_release);
+    return true;
+}
+
+BCAddressIndex *
+BCAddressIndexCreate(size_t capacityHint)
+{
+    size_t capacity = BC_ADDRESS_INDEX_MIN_CAPACITY;
+    while (capacity / 2 < capacityHint && capacity < (SIZE_MAX >> 2)) {
+        capacity *= 2;
+    }
+    BCAddressIndex *index = calloc(1, sizeof(*index));
+    BCAddressIndexTable *table = BCAddressIndexTableCreate(capacity);
+    if (index == NULL || table == NULL) {
+        free(index);
+        free(table);
+        return NULL;
+    }
+    pthread_mutex_init(&index->writeLock, NULL);
+    atomic_init(&index->sequence, 0);
+    atomic_init(&index->table, table);
+    atomic_init(&index->count, 0);
+    return index;
+}
+
+void
+BCAddressIndexDestroy(BCAddressIndex *index)
+{
+    if (index == NULL) {
+        return;
+    }
+    BCAddressIndexTable *table = atomic_load_explicit(&index->table, memory_order_relaxed);
+    while (table != NULL) {
+        BCAddressIndexTable *retired = table->retired;
+        free(table);
+        table = retired;
+    }
+    BCAddressIndexLabelChunk *chunk = index->labels;
+    while (chunk != NULL) {
+        BCAddressIndexLabelChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    pthread_mutex_destroy(&index->writeLock);
+    free(index);
+}
+
+bool
+BCAddressIndexKeyFromAddress(const char *address, uint8_t key[BC_ADDRESS_INDEX_KEY_LENGTH])
+{
+    return address != NULL && base58check_decode(address, key, BC_ADDRESS_INDEX_KEY_LENGTH) == BC_ADDRESS_INDEX_KEY_LENGTH;
+}
+
+bool
+BCAddressIndexPut(BCAddressIndex *index, const char *address, uint32_t flags, uint64_t balance, const char *label)
+{
+    uint8_t key[BC_ADDRESS_INDEX_KEY_LENGTH];
+    if (!BCAddressIndexKeyFromAddress(address, key)) {
+        return false;
+    }
+
+    BCAddressIndexBeginWrite(index);
+    bool isStored = false;
+    BCAddressIndexTable *table = atomic_load_explicit(&index->table, memory_order_relaxed);
+    BCAddressIndexSlot *slot = BCAddressIndexProbe(table, key);
+    if (!slot->isUsed) {
+        size_t count = atomic_load_explicit(&index->count, memory_order_relaxed);
+        if (count + 1 > (table->mask + 1) / 2) {
+            if (!BCAddressIndexGrow(index)) {
+                goto done;
+            }
+            table = atomic_load_explicit(&index->table, memory_order_relaxed);
+            slot = BCAddressIndexProbe(table, key);
+        }
+        memcpy(slot->key, key, sizeof(key));
+        atomic_store_explicit(&slot->label, NULL, memory_order_relaxed);
+        slot->isUsed = true;
+        atomic_store_explicit(&index->count, count + 1, memory_order_relaxed);
+    }
+    slot->flags = flags;
+    slot->balance = balance;
+    isStored = BCAddressIndexStoreLabel(index, slot, label);
+done:
+    BCAddressIndexEndWrite(index);
+    return isStored;
+}
+
+/// Finds `address` for an update, taking the write lock. Returns NULL, unlocked, if it is not there.
+static BCAddressIndexSlot *
+BCAddressIndexBeginUpdate(BCAddressIndex *index, const char *address)
+{
+    uint8_t key[BC_ADDRESS_INDEX_KEY_LENGTH];
+    if (!BCAddressIndexKeyFromAddress(address, key)) {
+        return NULL;
+    }
+    BCAddressIndexBeginWrite(index);
+    BCAddressIndexSlot *slot = BCAddressIndexProbe(atomic_load_explicit(&index->table, memory_order_relaxed), key);
+    if (!slot->isUsed) {
+        BCAddressIndexEndWrite(index);
+        return NULL;
+    }
+    return slot;
+}
+
+bool
+BCAddressIndexSetLabel(BCAddressIndex *index, const char *address, const char *label)
+{
+    BCAddressIndexSlot *slot = BCAddressIndexBeginUpdate(index, address);
+    if (slot == NULL) {
+        return false;
+    }
+    bool isStored = BCAddressIndexStoreLabel(index, slot, label);
+    BCAddressIndexEndWrite(index);
+    return isStored;
+}
+
+bool
+BCAddressIndexUpdateFlags(BCAddressIndex *index, const char *address, uint32_t set, uint32_t clear)
+{
+    BCAddressIndexSlot *slot = BCAddressIndexBeginUpdate(index, address);
+    if (slot == NULL) {
+        return false;
+    }
+    slot->flags = (slot->flags | set) & ~clear;
+    BCAddressIndexEndWrite(index);
+    return true;
+}
+
+bool
+BCAddressIndexSetBalance(BCAddressIndex *index, const char *address, uint64_t balance)
+{
+    BCAddressIndexSlot *slot = BCAddressIndexBeginUpdate(index, address);
+    if (slot == NULL) {
+        return false;
+    }
+    slot->balance = balance;
+    BCAddressIndexEndWrite(index);
+    return true;
+}
+
+void
+BCAddressIndexRemoveAll(BCAddressIndex *index)
+{
+    BCAddressIndexBeginWrite(index);
+    BCAddressIndexTable *table = atomic_load_explicit(&index->table, memory_order_relaxed);
+    for (size_t i = 0; i <= table->mask; i++) {
+        table->slots[i].isUsed = false;
+        atomic_store_explicit(&table->slots[i].label, NULL, memory_order_relaxed);
+    }
+    atomic_store_explicit(&index->count, 0, memory_order_relaxed);
+    BCAddressIndexEndWrite(index);
+}
+
+size_t
+BCAddressIndexCount(const BCAddressIndex *index)
+{
+    return atomic_load_explicit(&((BCAddressIndex *)index)->count, memory_order_relaxed);
+}
+
+bool
+BCAddressIndexLookup(const BCAddressIndex *index, const char *address, BCAddressIndexEntry *entry, char *label, size_t labelCapacity)
+{
+    uint8_t key[BC_ADDRESS_INDEX_KEY_LENGTH];
+    if (!BCAddressIndexKeyFromAddress(address, key)) {
+        return false;
+    }
+    BCAddressIndex *mutableIndex = (BCAddressIndex *)index;
+
+    for (;;) {
+        uint32_t sequence = atomic_load_explicit(&mutableIndex->sequence, memory_order_acquire);
+        if (sequence & 1) {
+            continue;
+        }
+
+        // Everything read here may be torn by a concurrent writer; the sequence check below discards it.
+        const BCAddressIndexTable *table = atomic_load_explicit(&mutableIndex->table, memory_order_acquire);
+        const BCAddressIndexSlot *slot = BCAddressIndexProbe(table, key);
+        bool isFound = slot->isUsed;
+        BCAddressIndexEntry found = { 0 };
+        if (isFound) {
+            const BCAddressIndexLabel *stored = atomic_load_explicit(&((BCAddressIndexSlot *)slot)->label, memory_order_acquire);
+            found.flags = slot->flags;
+            found.balance = slot->balance;
+            found.labelLength = stored != NULL ? stored->length : 0;
+            if (label != NULL && labelCapacity > 0) {
+                size_t length = found.labelLength < labelCapacity - 1 ? found.labelLength : labelCapacity - 1;
+                if (length > 0) {
+                    memcpy(label, stored->bytes, length);
+                }
+                label[length] = '\0';
+            }
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&mutableIndex->sequence, memory_order_relaxed) == sequence) {
+            if (isFound && entry != NULL) {
+                *entry = found;
+            }
+            return isFound;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef BCAddressIndex_h
+#define BCAddressIndex_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * An index of the legacy addresses of a wallet, with their labels, flags and balances.
+ *
+ * Addresses are keyed on their decoded version byte and hash160 in an open-addressing table with
+ * linear probing; the hash160 is already uniformly distributed, so its first bytes are the hash.
+ * Writers are serialized by a lock. Readers take no lock: they copy an entry out and retry if a
+ * write overlapped, as told by a sequence counter. Tables outgrown and labels replaced stay
+ * allocated until the index is destroyed, so a reader racing a writer never touches freed memory.
+ */
+
+typedef struct BCAddressIndex BCAddressIndex;
+
+/// Version byte and hash160 of a Base58Check address.
+#define BC_ADDRESS_INDEX_KEY_LENGTH 21
+
+typedef enum {
+    BCAddressIndexFlagWatchOnly = 1 << 0,
+    BCAddressIndexFlagArchived = 1 << 1,
+} BCAddressIndexFlag;
+
+typedef struct {
+    uint32_t flags;
+    uint64_t balance;
+    /// Length of the label, which may be longer than what was copied out. 0 if there is none.
+    size_t labelLength;
+} BCAddressIndexEntry;
+
+/// Creates an index sized for `capacityHint` addresses. Returns NULL if out of memory.
+BCAddressIndex *BCAddressIndexCreate(size_t capacityHint);
+
+/// Frees the index. There must be no readers left.
+void BCAddressIndexDestroy(BCAddressIndex *index);
+
+/// Decodes a Base58Check address into its key. Returns false if it is not a valid 21-byte payload.
+bool BCAddressIndexKeyFromAddress(const char *address, uint8_t key[BC_ADDRESS_INDEX_KEY_LENGTH]);
+
+/// Adds `address` or replaces what is known about it. A NULL or empty `label` clears the label.
+/// Returns false if the address does not decode or the index is out of memory.
+bool BCAddressIndexPut(BCAddressIndex *index, const char *address, uint32_t flags, uint64_t balance, const char *label);
+
+/// Replaces the label of `address`. Returns false if the address is not in the index.
+bool BCAddressIndexSetLabel(BCAddressIndex *index, const char *address, const char *label);
+
+/// Sets the `set` flags of `address`, then clears the `clear` ones. Returns false if the address is not in the index.
+bool BCAddressIndexUpdateFlags(BCAddressIndex *index, const char *address, uint32_t set, uint32_t clear);
+
+/// Replaces the balance of `address`. Returns false if the address is not in the index.
+bool BCAddressIndexSetBalance(BCAddressIndex *index, const char *address, uint64_t balance);
+
+/// Empties the index, keeping its memory for the next population.
+void BCAddressIndexRemoveAll(BCAddressIndex *index);
+
+/// Number of addresses in the index.
+size_t BCAddressIndexCount(const BCAddressIndex *index);
+
+/// Looks up `address` without locking. On a hit, fills `entry` when non-NULL and copies up to
+/// `labelCapacity - 1` bytes of the label, NUL terminated, into `label` when non-NULL.
+bool BCAddressIndexLookup(const BCAddressIndex *index, const char *address, BCAddressIndexEntry *entry, char *label, size_t labelCapacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BCAddressIndex_h */
@@ -7,6 +7,8 @@ import UIKit
 
 class CurrencySymbol: NSObject {
     @objc let conversion: NSDecimalNumber
+    /// Price of one bitcoin, parsed from its shortest decimal representation so it can be used as an exact rate.
+    @objc let last: NSDecimalNumber
     @objc let code: String
     @objc let symbol: String
     let name: String
@@ -27,6 +29,7 @@ class CurrencySymbol: NSObject {
         let satoshi = NSDecimalNumber(value: Constants.Conversions.satoshi)
         let lastDecimal = NSDecimalNumber(value: last)
         conversion = satoshi.dividing(by: lastDecimal)
+        self.last = NSDecimalNumber(string: String(last), locale: Locale(identifier: "en_US_POSIX"))
         self.code = code
         self.symbol = symbol
         name = fiatCurrency.name
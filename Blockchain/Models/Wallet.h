@@ -102,6 +102,7 @@
 - (BOOL)validateSecondPassword:(NSString *)secondPassword;
 
 - (void)getHistory;
+/// Refreshes the wallet, Bitcoin and Bitcoin Cash histories at once, joining a refresh already running.
 - (void)getHistoryForAllAssets;
 
 - (id)getLegacyAddressBalance:(NSString *)address assetType:(LegacyAssetType)assetType;
@@ -151,6 +152,10 @@
 # pragma mark - Bitcoin Cash
 
 - (NSString *)fromBitcoinCash:(NSString *)address;
+/// Converts many CashAddr addresses to legacy format in one call; addresses that fail to decode are left out.
+- (NSDictionary<NSString *, NSString *> *)fromBitcoinCashAddresses:(NSArray<NSString *> *)addresses;
+/// Derives the current receive address of a Bitcoin Cash account natively, or returns nil if JS has to.
+- (nullable NSString *)derivedBitcoinCashReceiveAddressForXPub:(nonnull NSString *)xpub;
 - (uint64_t)getBchBalance;
 - (NSString *)bitcoinCashExchangeRate;
 
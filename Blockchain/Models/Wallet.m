@@ -7,28 +7,104 @@
 #import <CommonCrypto/CommonKeyDerivation.h>
 #import <JavaScriptCore/JavaScriptCore.h>
 #import "Wallet.h"
+#import "WalletJSBundle.h"
+#import "WalletJSTimerScheduler.h"
+#import "WalletJSONDocument.h"
+#import "WalletPayloadKeyCache.h"
+#import "WalletRefreshCoordinator.h"
+#import "addrcodec.h"
 #import "Assets.h"
+#import "BCAddressIndex.h"
+#import "BCBridgeTrace.h"
+#import "bip32.h"
 #import "Blockchain-Swift.h"
 #import "BTCAddress.h"
 #import "BTCData.h"
-#import "BTCKey.h"
 #import "crypto_scrypt.h"
+#import "crypto_scrypt_budget.h"
+#import "eckey.h"
+#import "JSContext+BridgeTrace.h"
 #import "KeychainItemWrapper+Credentials.h"
 #import "ModuleXMLHttpRequest.h"
 #import "NSData+Hex.h"
+#import "NSData+SecureBuffer.h"
 #import "NSNumberFormatter+Currencies.h"
 #import "NSString+JSONParser_NSString.h"
+#import "secbuf.h"
+#import "signmsg.h"
 
 #define DICTIONARY_KEY_CURRENCY @"currency"
+/// Number of receive addresses derived per batch; a BIP44 gap limit's worth.
+#define RECEIVE_ADDRESS_WINDOW 20
 
 NSString * const kAccountInvitations = @"invited";
 
+#if CRYPTO_SCRYPT_STATS
+/// Forwards the phase timings of every scrypt derivation to ScryptMetrics, on the deriving thread.
+static void WalletScryptStatsCallback(const struct crypto_scrypt_stats *stats, void *cookie)
+{
+    NSMutableDictionary<NSString *, NSNumber *> *metrics = [NSMutableDictionary dictionary];
+    uint64_t totalNanoseconds = 0;
+    for (int phase = 0; phase < CRYPTO_SCRYPT_PHASE_COUNT; phase++) {
+        NSString *name = [NSString stringWithUTF8String:crypto_scrypt_phase_name(phase)];
+        metrics[[name stringByAppendingString:@"_us"]] = @(stats->phase[phase].wall_ns / 1000);
+        metrics[[name stringByAppendingString:@"_ticks"]] = @(stats->phase[phase].ticks);
+        metrics[[name stringByAppendingString:@"_faults"]] = @(stats->phase[phase].page_faults);
+        totalNanoseconds += stats->phase[phase].wall_ns;
+    }
+    metrics[@"total_us"] = @(totalNanoseconds / 1000);
+    metrics[@"v_bytes_written"] = @(stats->v_bytes_written);
+    metrics[@"v_bytes_read"] = @(stats->v_bytes_read);
+    metrics[@"v_shift"] = @(stats->v_shift);
+    struct crypto_scrypt_budget_usage usage;
+    crypto_scrypt_budget_usage(&usage);
+    metrics[@"budget_in_use"] = @(usage.in_use);
+    metrics[@"budget_wait_us_max"] = @(usage.wait_ns_max / 1000);
+    struct secbuf_usage secureBuffers;
+    secbuf_usage(&secureBuffers);
+    metrics[@"secure_buffers_in_use"] = @(secureBuffers.in_use);
+    NSString *parameters = [NSString stringWithFormat:@"N=%llu,r=%u,p=%u", stats->N, stats->r, stats->p];
+    [ScryptMetrics record:metrics parameters:parameters];
+}
+#endif
+
+/// UTF-8 bytes of the strings JS passed to the native callback being run.
+static uint64_t WalletCallbackArgumentBytes(void)
+{
+    uint64_t bytes = 0;
+    for (JSValue *argument in [JSContext currentArguments]) {
+        if (argument.isString) {
+            bytes += [[argument toString] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+        }
+    }
+    return bytes;
+}
+
+/// Times the rest of a native callback block for the bridge trace.
+#define WALLET_TRACE_CALLBACK(name) BC_BRIDGE_TRACE_SCOPE(name, WalletCallbackArgumentBytes())
+
 @interface Wallet ()
 
 @property (nonatomic, strong) JSContext *context;
 @property (nonatomic, assign) BOOL isSettingDefaultAccount;
-@property (nonatomic, strong) NSMutableDictionary *timers;
+@property (nonatomic, strong) WalletJSTimerScheduler *timerScheduler;
 @property (nonatomic, copy) NSDictionary *bitcoinCashExchangeRates;
+@property (nonatomic, strong) WalletJSBundle *jsBundle;
+@property (nonatomic, strong) NSMutableSet<NSString *> *loadedJSModules;
+/// Labels, flags and balances of the legacy addresses, read without a JS round trip.
+@property (nonatomic, assign) BCAddressIndex *addressIndex;
+/// Whether `addressIndex` reflects the wallet loaded in the current context.
+@property (nonatomic, assign) BOOL isAddressIndexLoaded;
+/// Public account nodes, keyed by asset type and account index; each value wraps a `bip32_node`.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSData *> *accountNodes;
+/// Bitcoin Cash receive addresses derived ahead, keyed by xpub and the first child number of each window.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSArray *> *receiveAddressWindows;
+/// Runs the history, account info and exchange rate fetches, one batch at a time.
+@property (nonatomic, strong) WalletRefreshCoordinator *refreshCoordinator;
+/// Whether a multiaddr response came in during a refresh and is yet to be passed on with the rest of it.
+@property (nonatomic, assign) BOOL hasDeferredMultiAddressResponse;
+/// Payload keys for the main password, stretched ahead of the backups that use them.
+@property (nonatomic, strong) WalletPayloadKeyCache *payloadKeyCache;
 
 @end
 
@@ -43,21 +119,44 @@ NSString * const kAccountInvitations = @"invited";
         _bitcoin = [[BitcoinWallet alloc] initWithLegacyWallet:self];
         _ethereum = [[EthereumWallet alloc] initWithLegacyWallet:self];
         _crypto = [[WalletCryptoJS alloc] init];
+        _jsBundle = [WalletJSBundle mainBundle];
+        // JS timer callbacks reach into UIKit through the Wallet delegate, so they stay on the main run loop.
+        _timerScheduler = [[WalletJSTimerScheduler alloc] initWithRunLoop:[NSRunLoop mainRunLoop]];
         _isSyncing = YES;
+        _addressIndex = BCAddressIndexCreate(0);
+        _accountNodes = [NSMutableDictionary dictionary];
+        _receiveAddressWindows = [NSMutableDictionary dictionary];
+        __weak Wallet *weakSelf = self;
+        _payloadKeyCache = [[WalletPayloadKeyCache alloc] init];
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(flushPendingBackup) name:UIApplicationDidEnterBackgroundNotification object:nil];
+        _refreshCoordinator = [[WalletRefreshCoordinator alloc] initWithStart:^(uint64_t refreshID, WalletRefreshParts parts) {
+            [weakSelf startRefresh:refreshID parts:parts];
+        }];
+        _refreshCoordinator.timedOut = ^(uint64_t refreshID, WalletRefreshParts parts) {
+            // Nothing came back, so every part is missing; the multiaddr it may have held back still goes out.
+            [weakSelf finishRefresh:refreshID values:@{} errors:@{}];
+        };
+        static dispatch_once_t onceToken;
+        dispatch_once(&onceToken, ^{
+            // Concurrent derivations share a slice of RAM; past it they trade time for memory instead of risking jetsam.
+            crypto_scrypt_budget_set(NSProcessInfo.processInfo.physicalMemory / 16, CRYPTO_SCRYPT_BUDGET_DEGRADE, 10000);
+            // Message signing and address derivation share the generator table; build it before the first call needs it.
+            dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+                eckey_precompute();
+            });
+#if CRYPTO_SCRYPT_STATS
+            crypto_scrypt_set_stats_callback(WalletScryptStatsCallback, NULL);
+#endif
+            [BridgeTraceReporter start];
+        });
     }
     return self;
 }
 
-- (NSString *)getJSSource
+- (void)dealloc
 {
-    NSString *walletJSPath = [[NSBundle mainBundle] pathForResource:JAVASCRIPTCORE_RESOURCE_MY_WALLET ofType:JAVASCRIPTCORE_TYPE_JS];
-    NSString *walletiOSPath = [[NSBundle mainBundle] pathForResource:JAVASCRIPTCORE_RESOURCE_WALLET_IOS ofType:JAVASCRIPTCORE_TYPE_JS];
-    NSString *walletJSSource = [NSString stringWithContentsOfFile:walletJSPath encoding:NSUTF8StringEncoding error:nil];
-    NSString *walletiOSSource = [NSString stringWithContentsOfFile:walletiOSPath encoding:NSUTF8StringEncoding error:nil];
-
-    NSString *jsSource = [NSString stringWithFormat:@"%@\n%@\n%@", JAVASCRIPTCORE_PREFIX_JS_SOURCE, walletJSSource, walletiOSSource];
-
-    return jsSource;
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    BCAddressIndexDestroy(_addressIndex);
 }
 
 - (NSString *)getConsoleScript
@@ -81,87 +180,49 @@ NSString * const kAccountInvitations = @"invited";
     return [[NSSet alloc] initWithObjects:@"log", @"debug", @"info", @"warn", @"error", @"assert", @"dir", @"dirxml", @"group", @"groupEnd", @"time", @"timeEnd", @"count", @"trace", @"profile", @"profileEnd", nil];
 }
 
-- (NSMutableDictionary *)timers
+- (id)getSetTimeout
 {
-    if (!_timers) {
-        _timers = [NSMutableDictionary new];
-    }
-
-    return _timers;
+    return [self getScheduleTimerRepeats:NO];
 }
 
-- (id)getSetTimeout
+- (id)getClearTimeout
 {
-    __weak Wallet *weakSelf = self;
-
-    return ^(JSValue* callback, double timeout) {
-
-        NSString *uuid = [[NSUUID alloc] init].UUIDString;
-
-        NSTimer *timer = [NSTimer scheduledTimerWithTimeInterval:timeout/1000
-                                                          target:[NSBlockOperation blockOperationWithBlock:^{
-            dispatch_async(dispatch_get_main_queue(), ^{
-                if ([weakSelf.timers objectForKey:uuid]) {
-                    [callback callWithArguments:nil];
-                }
-            });
-        }]
-                                                        selector:@selector(main)
-                                                        userInfo:nil
-                                                         repeats:NO];
-
-        weakSelf.timers[uuid] = timer;
-        [timer fire];
-
-        return uuid;
-    };
+    return [self getCancelTimer];
 }
 
-- (id)getClearTimeout
+- (id)getSetInterval
 {
-    __weak Wallet *weakSelf = self;
+    return [self getScheduleTimerRepeats:YES];
+}
 
-    return ^(NSString *identifier) {
-        NSTimer *timer = (NSTimer *)[weakSelf.timers objectForKey:identifier];
-        [timer invalidate];
-        [weakSelf.timers removeObjectForKey:identifier];
-    };
+- (id)getClearInterval
+{
+    return [self getCancelTimer];
 }
 
-- (id)getSetInterval
+- (id)getScheduleTimerRepeats:(BOOL)repeats
 {
     __weak Wallet *weakSelf = self;
 
-    return ^(JSValue *callback, double timeout) {
+    return ^WalletJSTimerHandle(JSValue *callback, double timeout) {
+        // Arguments after the delay are forwarded to the callback, as in setTimeout(callback, delay, ...args).
+        NSArray *arguments = [JSContext currentArguments];
+        NSArray *callbackArguments = arguments.count > 2 ? [arguments subarrayWithRange:NSMakeRange(2, arguments.count - 2)] : nil;
 
-        NSString *uuid = [[NSUUID alloc] init].UUIDString;
-
-        NSTimer *timer = [NSTimer scheduledTimerWithTimeInterval:timeout/1000
-                                                          target:[NSBlockOperation blockOperationWithBlock:^{
-            dispatch_async(dispatch_get_main_queue(), ^{
-                if ([weakSelf.timers objectForKey:uuid]) {
-                    [callback callWithArguments:nil];
-                }
-            });
-        }]
-                                                        selector:@selector(main)
-                                                        userInfo:nil
-                                                         repeats:YES];
-        weakSelf.timers[uuid] = timer;
-        [timer fire];
-
-        return uuid;
+        return [weakSelf.timerScheduler scheduleAfter:timeout / 1000 repeats:repeats block:^{
+            [callback callWithArguments:callbackArguments];
+        }];
     };
 }
 
-- (id)getClearInterval
+- (id)getCancelTimer
 {
     __weak Wallet *weakSelf = self;
 
-    return ^(NSString *identifier) {
-        NSTimer *timer = (NSTimer *)[weakSelf.timers objectForKey:identifier];
-        [timer invalidate];
-        [weakSelf.timers removeObjectForKey:identifier];
+    return ^(JSValue *identifier) {
+        if ([identifier isNumber]) {
+            [weakSelf.timerScheduler cancel:[identifier toUInt32]];
+        }
     };
 }
 
@@ -178,9 +239,26 @@ NSString * const kAccountInvitations = @"invited";
 }
 
 - (void)loadJS {
+    // Edits waiting to be backed up go out before their context does.
+    [self flushPendingBackup];
+    [self.payloadKeyCache invalidate];
+    // Timers belong to the context being replaced.
+    [self.timerScheduler cancelAll];
+    // So do refreshes in flight.
+    [self.refreshCoordinator cancel];
+    self.hasDeferredMultiAddressResponse = NO;
+    // So is the wallet the address index was populated from.
+    BCAddressIndexRemoveAll(self.addressIndex);
+    self.isAddressIndexLoaded = NO;
+    @synchronized (self.accountNodes) {
+        [self.accountNodes removeAllObjects];
+    }
+    @synchronized (self.receiveAddressWindows) {
+        [self.receiveAddressWindows removeAllObjects];
+    }
     self.context = [[JSContext alloc] init];
 
-    [self.context evaluateScriptCheckIsOnMainQueue:[self getConsoleScript]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[self getConsoleScript]];
 
     NSSet *names = [self getConsoleFunctionNames];
 
@@ -202,20 +280,29 @@ NSString * const kAccountInvitations = @"invited";
 #pragma mark Decryption
 
     self.context[@"objc_message_sign"] = ^(JSValue *privateKey, NSString *message, BOOL compressed) {
+        WALLET_TRACE_CALLBACK("objc_message_sign");
         NSData *data = [[NSData alloc] initWithBase64EncodedString:[privateKey toString] options:kNilOptions];
-        BTCKey *btcKey = [[BTCKey alloc] initWithPrivateKey:data];
-        [btcKey setPublicKeyCompressed:compressed];
-        return [[btcKey signatureForMessage:message] hexadecimalString];
+        NSData *messageData = [message dataUsingEncoding:NSUTF8StringEncoding];
+        NSMutableData *signature = [NSMutableData dataWithLength:SIGNMSG_SIGLEN];
+        if (data.length != 32 || signmsg_sign(data.bytes, compressed, messageData.bytes, messageData.length, signature.mutableBytes) != 0) {
+            return (NSString *)nil;
+        }
+        return [signature hexadecimalString];
     };
 
     self.context[@"objc_message_verify"] = ^(NSString *address, NSString *signature, NSString *message) {
+        WALLET_TRACE_CALLBACK("objc_message_verify");
         NSData *signatureData = BTCDataFromHex(signature);
         NSData *messageData = [message dataUsingEncoding:NSUTF8StringEncoding];
-        BTCKey *key = [BTCKey verifySignature:signatureData forBinaryMessage:messageData];
-        return [key.address.string isEqualToString:address];
+        uint8_t payload[21];
+        if (signatureData.length != SIGNMSG_SIGLEN || base58check_decode(address.UTF8String, payload, sizeof(payload)) != sizeof(payload) || payload[0] != ADDRCODEC_VERSION_P2PKH) {
+            return NO;
+        }
+        return (BOOL)(signmsg_verify(signatureData.bytes, messageData.bytes, messageData.length, &payload[1]) == 0);
     };
     
     self.context[@"objc_pbkdf2_sync"] = ^(NSString *mnemonicBuffer, NSString *saltBuffer, int iterations, int keylength) {
+        WALLET_TRACE_CALLBACK("objc_pbkdf2_sync");
         return [JSCrypto derivePBKDF2SHA512HexStringWithPassword:mnemonicBuffer
                                                             salt:saltBuffer
                                                       iterations:iterations
@@ -223,13 +310,13 @@ NSString * const kAccountInvitations = @"invited";
     };
 
     self.context[@"objc_sjcl_misc_pbkdf2"] = ^(NSString *_password, id _salt, int iterations, int keylength) {
-        uint8_t * _saltBuff = NULL;
-        size_t _saltBuffLen = 0;
+        WALLET_TRACE_CALLBACK("objc_sjcl_misc_pbkdf2");
+        NSData * _Nonnull saltData;
 
         if ([_salt isKindOfClass:[NSArray class]]) {
-            _saltBuff = alloca([_salt count]);
-            _saltBuffLen = [_salt count];
-
+            // The salt comes from JS, so its length is not bounded by the stack.
+            NSMutableData *saltBytes = [NSMutableData dataWithLength:[_salt count]];
+            uint8_t * _saltBuff = saltBytes.mutableBytes;
             {
                 int ii = 0;
                 for (NSNumber * number in _salt) {
@@ -237,96 +324,118 @@ NSString * const kAccountInvitations = @"invited";
                     ++ii;
                 }
             }
+            saltData = saltBytes;
         } else if ([_salt isKindOfClass:[NSString class]]) {
-            _saltBuff = (uint8_t*)[_salt UTF8String];
-            _saltBuffLen = [_salt length];
+            saltData = [NSData dataWithBytes:[_salt UTF8String] length:[_salt length]];
         } else {
             DLog(@"Scrypt salt unsupported type");
             return [[NSData new] hexadecimalString];
         }
-        
-        NSData * _Nonnull saltData = [NSData dataWithBytes:_saltBuff length:_saltBuffLen];
+
         return [JSCrypto derivePBKDF2SHA1HexStringWithPassword:_password
                                                       saltData:saltData
                                                     iterations:iterations
                                                   keySizeBytes:keylength];
     };
 
+    self.context[@"objc_take_payload_key"] = ^(NSString *password, uint32_t iterations) {
+        WALLET_TRACE_CALLBACK("objc_take_payload_key");
+        return [[weakSelf.payloadKeyCache takeKeyForPassword:password iterations:iterations] secureHexadecimalString];
+    };
+
     self.context[@"objc_on_error_creating_new_account"] = ^(NSString *error) {
+        WALLET_TRACE_CALLBACK("objc_on_error_creating_new_account");
         [weakSelf on_error_creating_new_account:error];
     };
 
     self.context[@"objc_loading_start_download_wallet"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_loading_start_download_wallet");
         [weakSelf loading_start_download_wallet];
     };
 
     self.context[@"objc_loading_stop"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_loading_stop");
         [weakSelf loading_stop];
     };
 
     self.context[@"objc_did_load_wallet"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_did_load_wallet");
         [weakSelf did_load_wallet];
     };
 
     self.context[@"objc_did_decrypt"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_did_decrypt");
         [weakSelf did_decrypt];
     };
 
     self.context[@"objc_error_other_decrypting_wallet"] = ^(NSString *error, NSString *stack) {
+        WALLET_TRACE_CALLBACK("objc_error_other_decrypting_wallet");
         [weakSelf error_other_decrypting_wallet:error stack:stack];
     };
 
     self.context[@"objc_loading_start_decrypt_wallet"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_loading_start_decrypt_wallet");
         [weakSelf loading_start_decrypt_wallet];
     };
 
     self.context[@"objc_loading_start_build_wallet"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_loading_start_build_wallet");
         [weakSelf loading_start_build_wallet];
     };
 
     self.context[@"objc_loading_start_multiaddr"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_loading_start_multiaddr");
         [weakSelf loading_start_multiaddr];
     };
 
 #pragma mark Multiaddress
 
     self.context[@"objc_did_multiaddr"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_did_multiaddr");
         [weakSelf did_multiaddr];
     };
 
     self.context[@"objc_loading_start_get_history"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_loading_start_get_history");
         [weakSelf loading_start_get_history];
     };
 
     self.context[@"objc_on_get_history_success"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_on_get_history_success");
         [weakSelf on_get_history_success];
     };
 
     self.context[@"objc_on_error_get_history"] = ^(NSString *error) {
+        WALLET_TRACE_CALLBACK("objc_on_error_get_history");
         [weakSelf on_error_get_history:error];
     };
 
 #pragma mark Wallet Creation/Pairing
 
     self.context[@"objc_on_create_new_account_sharedKey_password"] = ^(NSString *_guid, NSString *_sharedKey, NSString *_password) {
+        WALLET_TRACE_CALLBACK("objc_on_create_new_account_sharedKey_password");
         [weakSelf on_create_new_account:_guid sharedKey:_sharedKey password:_password];
     };
 
     self.context[@"objc_error_restoring_wallet"] = ^(){
+        WALLET_TRACE_CALLBACK("objc_error_restoring_wallet");
         [weakSelf error_restoring_wallet];
     };
 
     self.context[@"objc_get_second_password"] = ^(JSValue *secondPassword, JSValue *dismiss, JSValue *helperText) {
+        WALLET_TRACE_CALLBACK("objc_get_second_password");
         [weakSelf getSecondPasswordSuccess:secondPassword dismiss:dismiss error:nil helperText:[helperText isUndefined] ? nil :  [helperText toString]];
     };
 
     self.context[@"objc_get_private_key_password"] = ^(JSValue *privateKeyPassword) {
+        WALLET_TRACE_CALLBACK("objc_get_private_key_password");
         [weakSelf getPrivateKeyPasswordSuccess:privateKeyPassword error:nil];
     };
 
 #pragma mark Accounts/Addresses
 
     self.context[@"objc_getRandomValues"] = ^(JSValue *intArray) {
+        WALLET_TRACE_CALLBACK("objc_getRandomValues");
         DLog(@"objc_getRandomValues");
 
         NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingAtPath:@"/dev/urandom"];
@@ -348,67 +457,87 @@ NSString * const kAccountInvitations = @"invited";
     };
 
     self.context[@"objc_crypto_scrypt_salt_n_r_p_dkLen"] = ^(id _password, id salt, NSNumber *N, NSNumber *r, NSNumber *p, NSNumber *derivedKeyLen, JSValue *success, JSValue *error) {
+        WALLET_TRACE_CALLBACK("objc_crypto_scrypt_salt_n_r_p_dkLen");
         [weakSelf crypto_scrypt:_password salt:salt n:N r:r p:p dkLen:derivedKeyLen success:success error:error];
     };
 
     self.context[@"objc_loading_start_new_account"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_loading_start_new_account");
         [weakSelf loading_start_new_account];
     };
 
     self.context[@"objc_did_archive_or_unarchive"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_did_archive_or_unarchive");
         [weakSelf did_archive_or_unarchive];
     };
 
+    self.context[@"objc_on_legacy_address_index_changes"] = ^(NSString *changes) {
+        WALLET_TRACE_CALLBACK("objc_on_legacy_address_index_changes");
+        [weakSelf applyAddressIndexChanges:changes];
+    };
+
 #pragma mark State
 
     self.context[@"objc_reload"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_reload");
         [weakSelf reload];
     };
 
     self.context[@"objc_on_backup_wallet_start"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_on_backup_wallet_start");
         [weakSelf on_backup_wallet_start];
     };
 
     self.context[@"objc_on_backup_wallet_success"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_on_backup_wallet_success");
         [weakSelf on_backup_wallet_success];
     };
 
     self.context[@"objc_on_backup_wallet_error"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_on_backup_wallet_error");
         [weakSelf on_backup_wallet_error];
     };
 
     self.context[@"objc_ws_on_open"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_ws_on_open");
         [weakSelf ws_on_open];
     };
 
     self.context[@"objc_makeNotice_id_message"] = ^(NSString *type, NSString *_id, NSString *message) {
+        WALLET_TRACE_CALLBACK("objc_makeNotice_id_message");
         [weakSelf makeNotice:type id:_id message:message];
     };
 
 #pragma mark Recovery
 
     self.context[@"objc_loading_start_generate_uuids"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_loading_start_generate_uuids");
         [weakSelf loading_start_generate_uuids];
     };
 
     self.context[@"objc_loading_start_recover_wallet"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_loading_start_recover_wallet");
         [weakSelf loading_start_recover_wallet];
     };
 
     self.context[@"objc_on_success_recover_with_passphrase"] = ^(NSDictionary *recoveredWalletDictionary) {
+        WALLET_TRACE_CALLBACK("objc_on_success_recover_with_passphrase");
         [weakSelf on_success_recover_with_passphrase:recoveredWalletDictionary];
     };
 
     self.context[@"objc_on_error_recover_with_passphrase"] = ^(NSString *error) {
+        WALLET_TRACE_CALLBACK("objc_on_error_recover_with_passphrase");
         [weakSelf on_error_recover_with_passphrase:error];
     };
 
     self.context[@"objc_on_progress_recover_with_metadata"] = ^(JSValue *totalReceivedValue, JSValue *finalBalanceValue) {
+        WALLET_TRACE_CALLBACK("objc_on_progress_recover_with_metadata");
         NSString *totalReceived = totalReceivedValue.isString ? totalReceivedValue.toString : @"";
         NSString *finalBalance = finalBalanceValue.isString ? finalBalanceValue.toString : @"";
         [weakSelf on_progress_recover_with_passphrase:totalReceived finalBalance:finalBalance];
     };
     self.context[@"objc_on_progress_recover_with_passphrase"] = ^(JSValue *totalReceivedValue, JSValue *finalBalanceValue) {
+        WALLET_TRACE_CALLBACK("objc_on_progress_recover_with_passphrase");
         NSString *totalReceived = totalReceivedValue.isString ? totalReceivedValue.toString : @"";
         NSString *finalBalance = finalBalanceValue.isString ? finalBalanceValue.toString : @"";
         [weakSelf on_progress_recover_with_passphrase:totalReceived finalBalance:finalBalance];
@@ -416,19 +545,23 @@ NSString * const kAccountInvitations = @"invited";
 
 #pragma mark Settings
     
-    self.context[@"objc_on_get_account_info_and_exchange_rates"] = ^() {
-        [weakSelf on_get_account_info_and_exchange_rates];
+    self.context[@"objc_on_refresh_assets"] = ^(NSNumber *refreshID, NSString *batch) {
+        WALLET_TRACE_CALLBACK("objc_on_refresh_assets");
+        [weakSelf on_refresh_assets:refreshID.unsignedLongLongValue batch:batch];
     };
-    
+
     self.context[@"objc_on_get_account_info_success"] = ^(NSString *accountInfo) {
+        WALLET_TRACE_CALLBACK("objc_on_get_account_info_success");
         [weakSelf on_get_account_info_success:accountInfo];
     };
 
     self.context[@"objc_on_get_btc_exchange_rates_success"] = ^(NSString *currencies) {
+        WALLET_TRACE_CALLBACK("objc_on_get_btc_exchange_rates_success");
         [weakSelf on_get_btc_exchange_rates_success:currencies];
     };
 
     self.context[@"objc_on_change_local_currency_success"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_on_change_local_currency_success");
         [weakSelf on_change_local_currency_success];
     };
 
@@ -444,23 +577,17 @@ NSString * const kAccountInvitations = @"invited";
     
     [self.crypto setupWith:self.context];
     
-#pragma mark Bitcoin Cash
+#pragma mark Modules
 
-    self.context[@"objc_on_fetch_bch_history_success"] = ^() {
-        [weakSelf did_fetch_bch_history];
-    };
+    self.loadedJSModules = [NSMutableSet new];
 
-    self.context[@"objc_on_fetch_bch_history_error"] = ^(JSValue *error) {
-        [AlertViewPresenter.shared standardNotifyWithTitle:BC_STRING_ERROR message:[LocalizationConstantsObjcBridge balancesErrorGeneric] in:nil handler: nil];
-    };
-    
-    self.context[@"objc_did_get_bitcoin_cash_exchange_rates"] = ^(JSValue *result) {
-        [weakSelf did_get_bitcoin_cash_exchange_rates:[result toDictionary]];
+    self.context[JAVASCRIPTCORE_LOAD_MODULE] = ^(NSString *name) {
+        [weakSelf loadJSModule:name];
     };
 
 #pragma mark Other
 
-    [self.context evaluateScriptCheckIsOnMainQueue:[self getJSSource]];
+    [self.jsBundle evaluateInContext:self.context];
 
     self.context[@"XMLHttpRequest"] = [ModuleXMLHttpRequest class];
 
@@ -479,6 +606,38 @@ NSString * const kAccountInvitations = @"invited";
     }
 }
 
+/// Evaluates an asset module the first time wallet-ios.js touches `MyWalletPhone.<name>`
+/// and binds the native callbacks only that module uses.
+- (void)loadJSModule:(NSString *)name
+{
+    if ([self.loadedJSModules containsObject:name]) {
+        return;
+    }
+    if (![self.jsBundle evaluateModuleNamed:name inContext:self.context]) {
+        return;
+    }
+    [self.loadedJSModules addObject:name];
+
+    if ([name isEqualToString:JAVASCRIPTCORE_MODULE_BCH]) {
+        [self setupBitcoinCashModule];
+    }
+}
+
+- (void)setupBitcoinCashModule
+{
+    __weak Wallet *weakSelf = self;
+
+    self.context[@"objc_on_fetch_bch_history_success"] = ^() {
+        WALLET_TRACE_CALLBACK("objc_on_fetch_bch_history_success");
+        [weakSelf did_fetch_bch_history];
+    };
+
+    self.context[@"objc_on_fetch_bch_history_error"] = ^(JSValue *error) {
+        WALLET_TRACE_CALLBACK("objc_on_fetch_bch_history_error");
+        [weakSelf on_fetch_bch_history_error];
+    };
+}
+
 /// Called after recovering wallet with mnemonic
 - (void)loadWalletWithGuid:(NSString*)guid sharedKey:(NSString*)sharedKey password:(NSString*)password {
     [self loadJSIfNeeded];
@@ -495,7 +654,7 @@ NSString * const kAccountInvitations = @"invited";
     sessionToken = sessionToken == nil ? @"" : [sessionToken escapedForJS];
 
     NSString *script = [NSString stringWithFormat:@"MyWalletPhone.login(\"%@\", \"%@\", false, \"%@\", \"%@\")", escapedGuid, escapedSharedKey, escapedPassword, sessionToken];
-    [self.context evaluateScriptCheckIsOnMainQueue:script];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:script];
 }
 
 - (void)fetchWalletWith:(nonnull NSString *)password {
@@ -506,7 +665,7 @@ NSString * const kAccountInvitations = @"invited";
     [self loadJSIfNeeded];
 
     NSString *escapedPassword = [password escapedForJS];
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.loginAfterPairing(\"%@\")", escapedPassword]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.loginAfterPairing(\"%@\")", escapedPassword]];
 }
 
 - (void)resetSyncStatus
@@ -521,7 +680,7 @@ NSString * const kAccountInvitations = @"invited";
 - (BOOL)isInitialized
 {
     // Initialized when the webView is loaded and the wallet is initialized (decrypted and in-memory wallet built)
-    BOOL isInitialized = [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWallet.getIsInitialized()"] toBool];
+    BOOL isInitialized = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWallet.getIsInitialized()"] toBool];
     if (!isInitialized) {
         DLog(@"Warning: Wallet not initialized!");
     }
@@ -531,28 +690,39 @@ NSString * const kAccountInvitations = @"invited";
 
 - (float)getStrengthForPassword:(NSString *)passwordString
 {
-    return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getPasswordStrength(\"%@\")", [passwordString escapedForJS]]] toDouble];
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getPasswordStrength(\"%@\")", [passwordString escapedForJS]]] toDouble];
 }
 
 - (void)loadMetadata
 {
     if ([self isInitialized]) {
-        [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.loadMetadata()"];
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.loadMetadata()"];
     }
 }
 
 - (void)getHistory
 {
     if ([self isInitialized]) {
-        [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.get_history()"];
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.get_history()"];
     }
 }
 
 - (void)getHistoryForAllAssets
 {
-    if ([self isInitialized]) {
-        [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getHistoryForAllAssets()"];
+    [self.refreshCoordinator requestParts:WalletRefreshPartWalletHistory | WalletRefreshPartBitcoinCashHistory completion:nil];
+}
+
+/// Fetches every part of refresh `refreshID` in one JS call; see MyWalletPhone.refreshAssets.
+- (void)startRefresh:(uint64_t)refreshID parts:(WalletRefreshParts)parts
+{
+    if (![self isInitialized]) {
+        [self.refreshCoordinator finishRefresh:refreshID failedParts:parts apply:^{}];
+        return;
     }
+    // Only the refresh fetches run side by side; other JS callers still rely on synchronous sends.
+    [ModuleXMLHttpRequest sendAsynchronouslyDuring:^{
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.refreshAssets(%llu, %lu)", refreshID, (unsigned long)parts]];
+    }];
 }
 
 - (void)changeLocalCurrency:(NSString *)currencyCode
@@ -561,7 +731,7 @@ NSString * const kAccountInvitations = @"invited";
         return;
     }
 
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.changeLocalCurrency(\"%@\")", [currencyCode escapedForJS]]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.changeLocalCurrency(\"%@\")", [currencyCode escapedForJS]]];
 }
 
 - (void)getAccountInfoAndExchangeRates
@@ -569,7 +739,7 @@ NSString * const kAccountInvitations = @"invited";
     if (![self isInitialized]) {
         return;
     }
-    [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getAccountInfoAndExchangeRates()"];
+    [self.refreshCoordinator requestParts:WalletRefreshPartAccountInfo | WalletRefreshPartBitcoinRates | WalletRefreshPartBitcoinCashRates completion:nil];
 }
 
 
@@ -580,7 +750,7 @@ NSString * const kAccountInvitations = @"invited";
     NSString *emailEscaped = [__email escapedForJS];
     NSString *scriptFormat = @"MyWalletPhone.newAccount(\"%@\", \"%@\", \"%@\")";
     NSString *script = [NSString stringWithFormat:scriptFormat, passwordEscaped, emailEscaped, walletName];
-    [self.context evaluateScriptCheckIsOnMainQueue:script];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:script];
 }
 
 - (BOOL)needsSecondPassword
@@ -589,7 +759,7 @@ NSString * const kAccountInvitations = @"invited";
         return NO;
     }
 
-    return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.isDoubleEncrypted"]] toBool];
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.isDoubleEncrypted"]] toBool];
 }
 
 - (BOOL)validateSecondPassword:(NSString*)secondPassword
@@ -598,7 +768,7 @@ NSString * const kAccountInvitations = @"invited";
         return NO;
     }
 
-    return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.validateSecondPassword(\"%@\")", [secondPassword escapedForJS]]] toBool];
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.validateSecondPassword(\"%@\")", [secondPassword escapedForJS]]] toBool];
 }
 
 - (BOOL)isWatchOnlyLegacyAddress:(NSString*)address
@@ -607,8 +777,13 @@ NSString * const kAccountInvitations = @"invited";
         return NO;
     }
 
+    if (self.isAddressIndexLoaded) {
+        BCAddressIndexEntry entry;
+        return BCAddressIndexLookup(self.addressIndex, address.UTF8String, &entry, NULL, 0) && (entry.flags & BCAddressIndexFlagWatchOnly);
+    }
+
     if ([self checkIfWalletHasAddress:address]) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.key(\"%@\").isWatchOnly", [address escapedForJS]]] toBool];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.key(\"%@\").isWatchOnly", [address escapedForJS]]] toBool];
     } else {
         return NO;
     }
@@ -621,8 +796,11 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
+        if (self.isAddressIndexLoaded) {
+            return [self indexedLabelForLegacyAddress:address] ?: address;
+        }
         if ([[self allLegacyAddresses:assetType] containsObject:address]) {
-            NSString *label = [self checkIfWalletHasAddress:address] ? [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.labelForLegacyAddress(\"%@\")", [address escapedForJS]]] toString] : nil;
+            NSString *label = [self checkIfWalletHasAddress:address] ? [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.labelForLegacyAddress(\"%@\")", [address escapedForJS]]] toString] : nil;
             if (label && ![label isEqualToString:@""])
                 return label;
         }
@@ -639,7 +817,13 @@ NSString * const kAccountInvitations = @"invited";
         return FALSE;
     }
 
-    return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.isArchived(\"%@\")", [address escapedForJS]]] toBool];
+    BCAddressIndexEntry entry;
+    if (self.isAddressIndexLoaded && BCAddressIndexLookup(self.addressIndex, address.UTF8String, &entry, NULL, 0)) {
+        return (entry.flags & BCAddressIndexFlagArchived) != 0;
+    }
+
+    // Unknown addresses also send the user back to the address list, which only the JS side does.
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.isArchived(\"%@\")", [address escapedForJS]]] toBool];
 }
 
 - (BOOL)isAccountArchived:(int)account assetType:(LegacyAssetType)assetType
@@ -649,9 +833,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.isArchived(%d)", account]] toBool];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.isArchived(%d)", account]] toBool];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.isArchived(%d)", account]] toBool];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.isArchived(%d)", account]] toBool];
     }
     return NO;
 }
@@ -664,10 +848,10 @@ NSString * const kAccountInvitations = @"invited";
 
     NSString *allAddressesJSON;
     if (assetType == LegacyAssetTypeBitcoin) {
-        allAddressesJSON = [[self.context evaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWallet.wallet.addresses)"] toString];
+        allAddressesJSON = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWallet.wallet.addresses)"] toString];
         return [allAddressesJSON getJSONObject];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        allAddressesJSON = [[self.context evaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWalletPhone.bch.getActiveLegacyAddresses())"] toString];
+        allAddressesJSON = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWalletPhone.bch.getActiveLegacyAddresses())"] toString];
         return [allAddressesJSON getJSONObject];
     }
     return nil;
@@ -681,9 +865,9 @@ NSString * const kAccountInvitations = @"invited";
 
     NSString *activeAddressesJSON;
     if (assetType == LegacyAssetTypeBitcoin) {
-        activeAddressesJSON = [[self.context evaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWallet.wallet.activeAddresses)"] toString];
+        activeAddressesJSON = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWallet.wallet.activeAddresses)"] toString];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        activeAddressesJSON = [[self.context evaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWalletPhone.bch.getActiveLegacyAddresses())"] toString];
+        activeAddressesJSON = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"JSON.stringify(MyWalletPhone.bch.getActiveLegacyAddresses())"] toString];
     }
 
     return [activeAddressesJSON getJSONObject];
@@ -702,7 +886,8 @@ NSString * const kAccountInvitations = @"invited";
 
     self.isSyncing = YES;
 
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.setLabelForAddress(\"%@\", \"%@\")", [address escapedForJS], [label escapedForJS]]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.setLabelForAddress(\"%@\", \"%@\")", [address escapedForJS], [label escapedForJS]]];
+    BCAddressIndexSetLabel(self.addressIndex, address.UTF8String, label.UTF8String);
 }
 
 - (void)toggleArchiveLegacyAddress:(NSString*)address
@@ -718,7 +903,12 @@ NSString * const kAccountInvitations = @"invited";
 
     self.isSyncing = YES;
 
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.toggleArchived(\"%@\")", [address escapedForJS]]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.toggleArchived(\"%@\")", [address escapedForJS]]];
+    BCAddressIndexEntry entry;
+    if (BCAddressIndexLookup(self.addressIndex, address.UTF8String, &entry, NULL, 0)) {
+        BOOL isArchived = (entry.flags & BCAddressIndexFlagArchived) != 0;
+        BCAddressIndexUpdateFlags(self.addressIndex, address.UTF8String, isArchived ? 0 : BCAddressIndexFlagArchived, isArchived ? BCAddressIndexFlagArchived : 0);
+    }
 }
 
 - (void)toggleArchiveAccount:(int)account assetType:(LegacyAssetType)assetType
@@ -735,9 +925,9 @@ NSString * const kAccountInvitations = @"invited";
     self.isSyncing = YES;
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.toggleArchived(%d)", account]];
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.toggleArchived(%d)", account]];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.toggleArchived(%d)", account]];
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.toggleArchived(%d)", account]];
         [self reload];
     }
 }
@@ -750,14 +940,22 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
+        BCAddressIndexEntry entry;
+        if (self.isAddressIndexLoaded) {
+            if (BCAddressIndexLookup(self.addressIndex, address.UTF8String, &entry, NULL, 0)) {
+                return @(entry.balance);
+            }
+            DLog(@"Wallet error: Tried to get balance of address %@, which was not found in this wallet", address);
+            return errorBalance;
+        }
         if ([self checkIfWalletHasAddress:address]) {
-            return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.key(\"%@\").balance", [address escapedForJS]]] toNumber];
+            return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWallet.wallet.key(\"%@\").balance", [address escapedForJS]]] toNumber];
         } else {
             DLog(@"Wallet error: Tried to get balance of address %@, which was not found in this wallet", address);
             return errorBalance;
         }
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getBalanceForAddress(\"%@\")", [address escapedForJS]]] toNumber];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getBalanceForAddress(\"%@\")", [address escapedForJS]]] toNumber];
     }
     return 0;
 }
@@ -768,7 +966,109 @@ NSString * const kAccountInvitations = @"invited";
         return NO;
     }
 
-    return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.checkIfWalletHasAddress(\"%@\")", [address escapedForJS]] ] toBool];
+    if (self.isAddressIndexLoaded) {
+        return BCAddressIndexLookup(self.addressIndex, address.UTF8String, NULL, NULL, 0);
+    }
+
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.checkIfWalletHasAddress(\"%@\")", [address escapedForJS]] ] toBool];
+}
+
+/// The label of an address in the index, or nil if it has none or is not in the index.
+- (NSString *)indexedLabelForLegacyAddress:(NSString *)address
+{
+    char stackLabel[256];
+    BCAddressIndexEntry entry;
+    if (!BCAddressIndexLookup(self.addressIndex, address.UTF8String, &entry, stackLabel, sizeof(stackLabel)) || entry.labelLength == 0) {
+        return nil;
+    }
+    if (entry.labelLength < sizeof(stackLabel)) {
+        return [NSString stringWithUTF8String:stackLabel];
+    }
+    NSMutableData *label = [NSMutableData dataWithLength:entry.labelLength + 1];
+    if (!BCAddressIndexLookup(self.addressIndex, address.UTF8String, &entry, label.mutableBytes, label.length) || entry.labelLength == 0) {
+        return nil;
+    }
+    return [NSString stringWithUTF8String:label.bytes];
+}
+
+/// Populates the address index from the wallet model, in a single JS evaluation. Done once per
+/// loaded wallet; `updateAddressIndex` and `applyAddressIndexChanges:` keep it current after that.
+- (void)loadAddressIndex
+{
+    if (![self isInitialized]) {
+        return;
+    }
+
+    NSString *json = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getLegacyAddressIndex()"] toString];
+    // An address missing from the index would read as not in the wallet, so fall back to JS instead.
+    self.isAddressIndexLoaded = [self putAddressIndexEntriesFromJSON:json];
+}
+
+/// Brings the balances, and anything else that changed since the last update, into the index.
+- (void)updateAddressIndex
+{
+    if (![self isInitialized]) {
+        return;
+    }
+    if (!self.isAddressIndexLoaded) {
+        [self loadAddressIndex];
+        return;
+    }
+
+    NSString *json = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getLegacyAddressIndexChanges()"] toString];
+    [self applyAddressIndexChanges:json];
+}
+
+/// Puts the entries of MyWalletPhone.getLegacyAddressIndexChanges() into the index. An empty string means none changed.
+- (void)applyAddressIndexChanges:(NSString *)json
+{
+    if (!self.isAddressIndexLoaded || json.length == 0) {
+        return;
+    }
+    if (![self putAddressIndexEntriesFromJSON:json]) {
+        // The next update loads the whole index again.
+        self.isAddressIndexLoaded = NO;
+    }
+}
+
+/// Adds or replaces the [address, label, archived, isWatchOnly, balance] entries of `json`.
+/// Entries are replaced in place, so lookups in the meantime keep finding the addresses.
+/// Returns NO if any entry could not be put.
+- (BOOL)putAddressIndexEntriesFromJSON:(NSString *)json
+{
+    WalletJSONDocument *document = json ? [WalletJSONDocument documentWithString:json] : nil;
+    if (document == nil) {
+        return NO;
+    }
+
+    __block BOOL isComplete = YES;
+    BOOL isArray = [document enumerateValue:document.root usingBlock:^(NSString *key, BCJSONValue value, BOOL *stop) {
+        BCJSONValue fields[5];
+        size_t count = 0;
+        BCJSONIterator iterator;
+        BCJSONValue field;
+        if (BCJSONIteratorInit(&iterator, value)) {
+            while (count < 5 && BCJSONIteratorNext(&iterator, NULL, &field)) {
+                fields[count++] = field;
+            }
+        }
+        char address[ADDRCODEC_MAX_STRING];
+        bool isArchived = false;
+        bool isWatchOnly = false;
+        uint64_t balance = 0;
+        if (count != 5 || BCJSONStringCopy(fields[0], address, sizeof(address)) == SIZE_MAX) {
+            isComplete = NO;
+            return;
+        }
+        BCJSONValueGetBool(fields[2], &isArchived);
+        BCJSONValueGetBool(fields[3], &isWatchOnly);
+        BCJSONValueGetUInt64(fields[4], &balance);
+        uint32_t flags = (isArchived ? BCAddressIndexFlagArchived : 0) | (isWatchOnly ? BCAddressIndexFlagWatchOnly : 0);
+        if (!BCAddressIndexPut(self.addressIndex, address, flags, balance, [document stringForValue:fields[1]].UTF8String)) {
+            isComplete = NO;
+        }
+    }];
+    return isArray && isComplete;
 }
 
 - (void)recoverWithEmail:(nonnull NSString *)email password:(nonnull NSString *)recoveryPassword mnemonicPassphrase:(nonnull NSString *)mnemonicPassphrase
@@ -776,7 +1076,7 @@ NSString * const kAccountInvitations = @"invited";
     [self useDebugSettingsIfSet];
     self.emptyAccountIndex = 0;
     self.recoveredAccountIndex = 0;
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.recoverWithPassphrase(\"%@\",\"%@\",\"%@\")", [email escapedForJS], [recoveryPassword escapedForJS], [mnemonicPassphrase escapedForJS]]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.recoverWithPassphrase(\"%@\",\"%@\",\"%@\")", [email escapedForJS], [recoveryPassword escapedForJS], [mnemonicPassphrase escapedForJS]]];
 }
 
 - (void)recoverFromMetadataWithMnemonicPassphrase:(nonnull NSString *)mnemonicPassphrase
@@ -784,7 +1084,7 @@ NSString * const kAccountInvitations = @"invited";
     [self useDebugSettingsIfSet];
     self.emptyAccountIndex = 0;
     self.recoveredAccountIndex = 0;
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.recoverWithMetadata(\"%@\")", [mnemonicPassphrase escapedForJS]]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.recoverWithMetadata(\"%@\")", [mnemonicPassphrase escapedForJS]]];
 }
 
 - (NSString *)getXpubForAccount:(int)accountIndex assetType:(LegacyAssetType)assetType
@@ -793,12 +1093,51 @@ NSString * const kAccountInvitations = @"invited";
         return nil;
     }
 
+    bip32_node account;
+    if (![self getAccountNode:&account forAccount:accountIndex assetType:assetType]) {
+        return nil;
+    }
+    char xpub[ADDRCODEC_MAX_STRING];
+    if (bip32_serialize(&account, 0, xpub, sizeof(xpub)) < 0) {
+        return nil;
+    }
+    return [NSString stringWithUTF8String:xpub];
+}
+
+/// Copies the cached public node of an account, parsing its xpub from JS the first time.
+- (BOOL)getAccountNode:(bip32_node *)node forAccount:(int)accountIndex assetType:(LegacyAssetType)assetType
+{
+    NSString *key = [NSString stringWithFormat:@"%ld/%d", (long)assetType, accountIndex];
+    @synchronized (self.accountNodes) {
+        NSData *cached = self.accountNodes[key];
+        if (cached) {
+            [cached getBytes:node length:sizeof(*node)];
+            return YES;
+        }
+    }
+
+    NSString *script;
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getXpubForAccount(%d)", accountIndex]] toString];
+        script = [NSString stringWithFormat:@"MyWalletPhone.getXpubForAccount(%d)", accountIndex];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getXpubForAccount(%d)", accountIndex]] toString];
+        script = [NSString stringWithFormat:@"MyWalletPhone.bch.getXpubForAccount(%d)", accountIndex];
+    } else {
+        return NO;
     }
-    return nil;
+    JSValue *xpub = [self.context tracedEvaluateScriptCheckIsOnMainQueue:script];
+    if (!xpub.isString) {
+        return NO;
+    }
+    if (bip32_parse(xpub.toString.UTF8String, node) != 0) {
+        DLog(@"Could not parse the xpub of account %d", accountIndex);
+        return NO;
+    }
+    // Only the public node is kept, even if JS handed over an xprv.
+    bip32_neuter(node);
+    @synchronized (self.accountNodes) {
+        self.accountNodes[key] = [NSData dataWithBytes:node length:sizeof(*node)];
+    }
+    return YES;
 }
 
 - (BOOL)isAccountNameValid:(NSString *)name
@@ -807,7 +1146,7 @@ NSString * const kAccountInvitations = @"invited";
         return NO;
     }
 
-    return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.isAccountNameValid(\"%@\")", [name escapedForJS]]] toBool];
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.isAccountNameValid(\"%@\")", [name escapedForJS]]] toBool];
 }
 
 - (int)getIndexOfActiveAccount:(int)account assetType:(LegacyAssetType)assetType
@@ -817,9 +1156,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getIndexOfActiveAccount(%d)", account]] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getIndexOfActiveAccount(%d)", account]] toNumber] intValue];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getIndexOfActiveAccount(%d)", account]] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getIndexOfActiveAccount(%d)", account]] toNumber] intValue];
     }
     return 0;
 }
@@ -827,7 +1166,7 @@ NSString * const kAccountInvitations = @"invited";
 - (NSString *)getMobileMessage
 {
     if ([self isInitialized]) {
-        JSValue *message = [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getMobileMessage(\"%@\")", [[NSLocale currentLocale] objectForKey:NSLocaleLanguageCode]]];
+        JSValue *message = [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getMobileMessage(\"%@\")", [[NSLocale currentLocale] objectForKey:NSLocaleLanguageCode]]];
         if ([message isUndefined] || [message isNull]) return nil;
         return [message toString];
     }
@@ -842,7 +1181,7 @@ NSString * const kAccountInvitations = @"invited";
     if (!self.isInitialized) {
         return [[NSArray alloc] init];
     }
-    JSValue *xlmAccountsValue = [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.xlm.accounts()"];
+    JSValue *xlmAccountsValue = [self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.xlm.accounts()"];
     return [xlmAccountsValue toArray];
 }
 
@@ -855,27 +1194,130 @@ NSString * const kAccountInvitations = @"invited";
     }
     [self.context invokeOnceWithFunctionBlock:success forJsFunctionName:@"objc_xlmSaveAccount_success"];
     [self.context invokeOnceWithStringFunctionBlock:error forJsFunctionName:@"objc_xlmSaveAccount_error"];
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.xlm.saveAccount(\"%@\", \"%@\")", [publicKey escapedForJS], [label escapedForJS]]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.xlm.saveAccount(\"%@\", \"%@\")", [publicKey escapedForJS], [label escapedForJS]]];
 }
 
 # pragma mark - Bitcoin cash
 
 - (NSString *)fromBitcoinCash:(NSString *)address
 {
-    return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.fromBitcoinCash(\"%@\")", [address escapedForJS]]] toString];
+    char legacy[ADDRCODEC_MAX_STRING];
+    if (cashaddr_to_legacy("bitcoincash", address.UTF8String, legacy, sizeof(legacy)) >= 0) {
+        return [NSString stringWithUTF8String:legacy];
+    }
+    // Formats the native codec does not know, such as BitPay addresses, are left to the JS helper.
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.fromBitcoinCash(\"%@\")", [address escapedForJS]]] toString];
+}
+
+- (NSDictionary<NSString *, NSString *> *)fromBitcoinCashAddresses:(NSArray<NSString *> *)addresses
+{
+    size_t count = addresses.count;
+    if (count == 0) {
+        return @{};
+    }
+    const char **inputs = malloc(count * sizeof(*inputs));
+    char *outputs = malloc(count * ADDRCODEC_MAX_STRING);
+    if (inputs == NULL || outputs == NULL) {
+        free(inputs);
+        free(outputs);
+        return @{};
+    }
+    for (size_t i = 0; i < count; i++) {
+        inputs[i] = addresses[i].UTF8String ?: "";
+    }
+    cashaddr_to_legacy_batch("bitcoincash", inputs, count, outputs, ADDRCODEC_MAX_STRING);
+
+    NSMutableDictionary<NSString *, NSString *> *result = [NSMutableDictionary dictionaryWithCapacity:count];
+    for (size_t i = 0; i < count; i++) {
+        const char *legacy = &outputs[i * ADDRCODEC_MAX_STRING];
+        if (legacy[0] != '\0') {
+            result[addresses[i]] = [NSString stringWithUTF8String:legacy];
+        }
+    }
+    free(inputs);
+    free(outputs);
+    return result;
+}
+
+- (NSString *)derivedBitcoinCashReceiveAddressForXPub:(NSString *)xpub
+{
+    if (![self isInitialized]) {
+        return nil;
+    }
+
+    NSString *script = [NSString stringWithFormat:@"MyWalletPhone.bch.getReceiveIndexForAccountXPub(\"%@\")", [xpub escapedForJS]];
+    JSValue *receiveIndex = [self.context tracedEvaluateScriptCheckIsOnMainQueue:script];
+    if (!receiveIndex.isNumber || receiveIndex.toInt32 < 0) {
+        return nil;
+    }
+    uint32_t index = receiveIndex.toUInt32;
+    uint32_t first = index - index % RECEIVE_ADDRESS_WINDOW;
+
+    NSString *key = [NSString stringWithFormat:@"%@/%u", xpub, first];
+    NSArray *window;
+    @synchronized (self.receiveAddressWindows) {
+        window = self.receiveAddressWindows[key];
+    }
+    if (!window) {
+        window = [self deriveBitcoinCashReceiveAddressesForXPub:xpub first:first];
+        if (!window) {
+            return nil;
+        }
+        @synchronized (self.receiveAddressWindows) {
+            self.receiveAddressWindows[key] = window;
+        }
+    }
+    id address = window[index - first];
+    return [address isKindOfClass:[NSString class]] ? address : nil;
+}
+
+/// Derives the CashAddrs of receive children first onwards of xpub in one batch; children BIP32 skips hold NSNull.
+- (NSArray *)deriveBitcoinCashReceiveAddressesForXPub:(NSString *)xpub first:(uint32_t)first
+{
+    bip32_node account, receive;
+    if (bip32_parse(xpub.UTF8String, &account) != 0) {
+        DLog(@"Could not parse the xpub of a Bitcoin Cash account");
+        return nil;
+    }
+    bip32_neuter(&account);
+    int rc = bip32_ckd(&account, 0, &receive);
+    bip32_wipe(&account);
+    if (rc != 0) {
+        return nil;
+    }
+
+    uint8_t pubkeys[RECEIVE_ADDRESS_WINDOW * 33];
+    uint8_t hash160s[RECEIVE_ADDRESS_WINDOW * 20];
+    int ok[RECEIVE_ADDRESS_WINDOW];
+    size_t derived = bip32_ckd_pub_batch(&receive, first, RECEIVE_ADDRESS_WINDOW, pubkeys, hash160s, ok);
+    bip32_wipe(&receive);
+    if (derived == (size_t)(-1)) {
+        return nil;
+    }
+
+    NSMutableArray *window = [NSMutableArray arrayWithCapacity:RECEIVE_ADDRESS_WINDOW];
+    char address[ADDRCODEC_MAX_STRING];
+    for (size_t i = 0; i < RECEIVE_ADDRESS_WINDOW; i++) {
+        if (ok[i] == 0 && cashaddr_encode("bitcoincash", CASHADDR_P2PKH, &hash160s[i * 20], 20, address, sizeof(address)) >= 0) {
+            [window addObject:[NSString stringWithUTF8String:address]];
+        } else {
+            [window addObject:[NSNull null]];
+        }
+    }
+    return window;
 }
 
 - (void)getBitcoinCashHistoryAndRates
 {
     if ([self isInitialized]) {
-        [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getHistoryAndRates()"];
+        [self.refreshCoordinator requestParts:WalletRefreshPartBitcoinCashHistory | WalletRefreshPartBitcoinCashRates completion:nil];
     }
 }
 
 - (void)fetchBitcoinCashExchangeRates
 {
     if ([self isInitialized]) {
-        [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.fetchExchangeRates()"];
+        [self.refreshCoordinator requestParts:WalletRefreshPartBitcoinCashRates completion:nil];
     }
 }
 
@@ -895,7 +1337,7 @@ NSString * const kAccountInvitations = @"invited";
 - (BOOL)hasBchAccount
 {
     if ([self isInitialized]) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.hasAccount()"] toBool];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.hasAccount()"] toBool];
     }
     return NO;
 }
@@ -903,7 +1345,7 @@ NSString * const kAccountInvitations = @"invited";
 - (uint64_t)getBchBalance
 {
     if ([self isInitialized] && [self hasBchAccount]) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getBalance()"] toNumber] longLongValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getBalance()"] toNumber] longLongValue];
     }
     DLog(@"Warning: getting bch balance when not initialized - returning 0");
     return 0;
@@ -982,10 +1424,22 @@ NSString * const kAccountInvitations = @"invited";
 
     DLog(@"did_multiaddr");
 
+    // Balances, and anything else the wallet did not report when it was backed up.
+    [self updateAddressIndex];
+
     if (!self.isSyncing) {
         [self loading_stop];
     }
 
+    if (self.refreshCoordinator.partsInFlight & WalletRefreshPartWalletHistory) {
+        self.hasDeferredMultiAddressResponse = YES;
+        return;
+    }
+    [self notifyMultiAddressResponse];
+}
+
+- (void)notifyMultiAddressResponse
+{
     if ([delegate respondsToSelector:@selector(didGetMultiAddressResponse:)]) {
         [delegate didGetMultiAddressResponse:[MultiAddressResponse new]];
     } else {
@@ -1138,8 +1592,8 @@ NSString * const kAccountInvitations = @"invited";
 {
     DLog(@"did_decrypt");
 
-    NSString *sharedKey = [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.sharedKey"] toString];
-    NSString *guid = [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.guid"] toString];
+    NSString *sharedKey = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.sharedKey"] toString];
+    NSString *guid = [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.guid"] toString];
 
     if ([delegate respondsToSelector:@selector(walletDidDecryptWithSharedKey:guid:)]) {
         [delegate walletDidDecryptWithSharedKey:sharedKey guid:guid];
@@ -1152,6 +1606,8 @@ NSString * const kAccountInvitations = @"invited";
 {
     DLog(@"did_load_wallet");
 
+    [self loadAddressIndex];
+
     [self getHistoryForAllAssets];
 
     if (self.isNew) {
@@ -1195,6 +1651,15 @@ NSString * const kAccountInvitations = @"invited";
     DLog(@"on_backup_wallet_start");
 }
 
+/// Backs up edits still waiting out the debounce in MyWalletPhone.syncWallet, e.g. when the app
+/// goes to the background.
+- (void)flushPendingBackup
+{
+    if ([self isInitialized]) {
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.flushPendingSync()"];
+    }
+}
+
 - (void)on_backup_wallet_error
 {
     DLog(@"on_backup_wallet_error");
@@ -1260,8 +1725,18 @@ NSString * const kAccountInvitations = @"invited";
 - (void)on_get_account_info_success:(NSString *)accountInfo
 {
     DLog(@"on_get_account_info_success");
-    self.accountInfo = [accountInfo getJSONObject];
+    [self applyAccountInfo:[accountInfo getJSONObject]];
+    [self notifyAccountInfo];
+}
+
+- (void)applyAccountInfo:(NSDictionary *)accountInfo
+{
+    self.accountInfo = accountInfo;
     self.hasLoadedAccountInfo = YES;
+}
+
+- (void)notifyAccountInfo
+{
     [[NSNotificationCenter defaultCenter] postNotificationName:NOTIFICATION_KEY_GET_ACCOUNT_INFO_SUCCESS object:nil];
 
     if ([delegate respondsToSelector:@selector(walletDidGetAccountInfo:)]) {
@@ -1272,24 +1747,34 @@ NSString * const kAccountInvitations = @"invited";
 - (void)on_get_btc_exchange_rates_success:(NSString *)currencies
 {
     DLog(@"on_get_btc_exchange_rates_success");
-    NSDictionary *allCurrencySymbolsDictionary = [currencies getJSONObject];
-    NSMutableDictionary *currencySymbolsWithNames = [[NSMutableDictionary alloc] initWithDictionary:allCurrencySymbolsDictionary];
+    [self applyBtcExchangeRates:[currencies getJSONObject]];
+    [self notifyBtcExchangeRates];
+}
+
+/// `currencies` comes from the JSON decoder, whose containers are mutable, so names are added in place.
+- (void)applyBtcExchangeRates:(NSDictionary *)currencies
+{
+    NSMutableDictionary *currencySymbolsWithNames = [NSMutableDictionary new];
     NSDictionary *currencyNames = [CurrencySymbol currencyNames];
 
-    for (NSString *abbreviatedFiatString in [allCurrencySymbolsDictionary allKeys]) {
-        NSDictionary *values = allCurrencySymbolsDictionary[abbreviatedFiatString]; // should never be nil
-        NSMutableDictionary *valuesWithName = [[NSMutableDictionary alloc] initWithDictionary:values]; // create a mutable dictionary of the current dictionary values
+    [currencies enumerateKeysAndObjectsUsingBlock:^(NSString *abbreviatedFiatString, NSMutableDictionary *valuesWithName, BOOL *stop) {
+        if (![valuesWithName isKindOfClass:[NSMutableDictionary class]]) {
+            return;
+        }
         NSString *currencyName = currencyNames[abbreviatedFiatString];
         if (currencyName) {
             valuesWithName[DICTIONARY_KEY_NAME] = currencyName;
-            currencySymbolsWithNames[abbreviatedFiatString] = valuesWithName;
         } else {
             DLog(@"Warning: no name found for currency %@", abbreviatedFiatString);
         }
-    }
+        currencySymbolsWithNames[abbreviatedFiatString] = valuesWithName;
+    }];
 
     self.btcRates = currencySymbolsWithNames;
+}
 
+- (void)notifyBtcExchangeRates
+{
     if ([self.delegate respondsToSelector:@selector(walletDidGetBtcExchangeRates)]) {
         [self.delegate walletDidGetBtcExchangeRates];
     }
@@ -1300,6 +1785,103 @@ NSString * const kAccountInvitations = @"invited";
     DLog(@"on_get_history_success");
 }
 
+/// Applies every part of refresh `refreshID` before anyone is told about any of it, then reloads once.
+- (void)on_refresh_assets:(uint64_t)refreshID batch:(NSString *)batchJSON
+{
+    NSDictionary *batch = [batchJSON getJSONObject];
+    NSDictionary *values = [batch[@"values"] isKindOfClass:[NSDictionary class]] ? batch[@"values"] : @{};
+    NSDictionary *errors = [batch[@"errors"] isKindOfClass:[NSDictionary class]] ? batch[@"errors"] : @{};
+    [self finishRefresh:refreshID values:values errors:errors];
+}
+
+/// Fails the parts of refresh `refreshID` missing from `values`, and applies the rest.
+- (void)finishRefresh:(uint64_t)refreshID values:(NSDictionary *)values errors:(NSDictionary *)errors
+{
+    NSDictionary<NSNumber *, NSString *> *names = @{
+        @(WalletRefreshPartWalletHistory): @"walletHistory",
+        @(WalletRefreshPartBitcoinCashHistory): @"bitcoinCashHistory",
+        @(WalletRefreshPartAccountInfo): @"accountInfo",
+        @(WalletRefreshPartBitcoinRates): @"bitcoinRates",
+        @(WalletRefreshPartBitcoinCashRates): @"bitcoinCashRates",
+    };
+
+    WalletRefreshParts parts = self.refreshCoordinator.partsInFlight;
+    __block WalletRefreshParts failedParts = 0;
+    [names enumerateKeysAndObjectsUsingBlock:^(NSNumber *part, NSString *name, BOOL *stop) {
+        if ((parts & part.unsignedIntegerValue) && values[name] == nil) {
+            DLog(@"Error refreshing %@: %@", name, errors[name]);
+            failedParts |= part.unsignedIntegerValue;
+        }
+    }];
+
+    [self.refreshCoordinator finishRefresh:refreshID failedParts:failedParts apply:^{
+        WalletRefreshParts appliedParts = [self applyRefreshedParts:parts & ~failedParts values:values];
+        [self reportFailedRefreshParts:parts & ~appliedParts errors:errors];
+    }];
+}
+
+/// Applies and announces `parts`, and returns those that were, leaving out any whose value is malformed.
+- (WalletRefreshParts)applyRefreshedParts:(WalletRefreshParts)parts values:(NSDictionary *)values
+{
+    if ((parts & WalletRefreshPartAccountInfo) && [values[@"accountInfo"] isKindOfClass:[NSDictionary class]]) {
+        [self applyAccountInfo:values[@"accountInfo"]];
+    } else {
+        parts &= ~WalletRefreshPartAccountInfo;
+    }
+    if ((parts & WalletRefreshPartBitcoinRates) && [values[@"bitcoinRates"] isKindOfClass:[NSDictionary class]]) {
+        [self applyBtcExchangeRates:values[@"bitcoinRates"]];
+    } else {
+        parts &= ~WalletRefreshPartBitcoinRates;
+    }
+    if ((parts & WalletRefreshPartBitcoinCashRates) && [values[@"bitcoinCashRates"] isKindOfClass:[NSDictionary class]]) {
+        [self did_get_bitcoin_cash_exchange_rates:values[@"bitcoinCashRates"]];
+    } else {
+        parts &= ~WalletRefreshPartBitcoinCashRates;
+    }
+
+    // Observers of any one part now see the whole batch.
+    if (parts & WalletRefreshPartAccountInfo) {
+        [self notifyAccountInfo];
+    }
+    if (parts & WalletRefreshPartBitcoinRates) {
+        [self notifyBtcExchangeRates];
+    }
+    if (self.hasDeferredMultiAddressResponse) {
+        self.hasDeferredMultiAddressResponse = NO;
+        [self notifyMultiAddressResponse];
+    }
+    if (parts & WalletRefreshPartBitcoinCashHistory) {
+        [self did_fetch_bch_history];
+    }
+    // Whichever of these came back is announced; the rest are reported as failures.
+    if (parts & (WalletRefreshPartAccountInfo | WalletRefreshPartBitcoinRates | WalletRefreshPartBitcoinCashRates)) {
+        [self on_get_account_info_and_exchange_rates];
+    }
+    if (parts != 0) {
+        [self reload];
+    }
+    return parts;
+}
+
+/// Reports each of `parts` that a refresh could not fetch, through the same path its single-part fetch fails by.
+- (void)reportFailedRefreshParts:(WalletRefreshParts)parts errors:(NSDictionary *)errors
+{
+    if (parts & WalletRefreshPartWalletHistory) {
+        id error = errors[@"walletHistory"];
+        [self on_error_get_history:[error isKindOfClass:[NSString class]] ? error : nil];
+    }
+    if (parts & WalletRefreshPartBitcoinCashHistory) {
+        [self on_fetch_bch_history_error];
+    }
+    WalletRefreshParts accountInfoAndRates = parts & (WalletRefreshPartAccountInfo | WalletRefreshPartBitcoinRates | WalletRefreshPartBitcoinCashRates);
+    if (accountInfoAndRates == 0) {
+        return;
+    }
+    if ([self.delegate respondsToSelector:@selector(wallet:didFailToGetAccountInfoAndExchangeRates:)]) {
+        [self.delegate wallet:self didFailToGetAccountInfoAndExchangeRates:accountInfoAndRates];
+    }
+}
+
 // TODO: Separate the metadata recovery and loading wallet in the future
 // This will gives greater flexibility of when to load the wallet after recovery
 - (void)on_success_recover_with_passphrase:(NSDictionary *)recoveredWalletDictionary
@@ -1404,6 +1986,11 @@ NSString * const kAccountInvitations = @"invited";
     self.bitcoinCashExchangeRates = rates;
 }
 
+- (void)on_fetch_bch_history_error
+{
+    [AlertViewPresenter.shared standardNotifyWithTitle:BC_STRING_ERROR message:[LocalizationConstantsObjcBridge balancesErrorGeneric] in:nil handler: nil];
+}
+
 - (void)on_get_account_info_and_exchange_rates
 {
     if ([self.delegate respondsToSelector:@selector(walletDidGetAccountInfoAndExchangeRates:)]) {
@@ -1422,7 +2009,7 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     DLog(@"Creating HD Wallet");
-    [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.upgradeToV3(\"%@\");", [LocalizationConstantsObjcBridge myBitcoinWallet], nil]];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.upgradeToV3(\"%@\");", [LocalizationConstantsObjcBridge myBitcoinWallet], nil]];
 }
 
 - (BOOL)hasAccount
@@ -1436,7 +2023,7 @@ NSString * const kAccountInvitations = @"invited";
         return NO;
     }
 
-    return [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.isUpgradedToHD"] toBool];
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.isUpgradedToHD"] toBool];
 }
 
 - (NSString *_Nullable)getMnemonic:(NSString *_Nullable)secondPassword
@@ -1444,7 +2031,7 @@ NSString * const kAccountInvitations = @"invited";
     if (!self.isInitialized) {
         return nil;
     }
-    JSValue *mnemonicValue = [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getMnemonicPhrase(\"%@\")", [secondPassword escapedForJS]]];
+    JSValue *mnemonicValue = [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getMnemonicPhrase(\"%@\")", [secondPassword escapedForJS]]];
     return [mnemonicValue toString];
 }
 
@@ -1457,7 +2044,7 @@ NSString * const kAccountInvitations = @"invited";
         return NO;
     }
 
-    return [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.hdwallet.isMnemonicVerified"] toBool];
+    return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.hdwallet.isMnemonicVerified"] toBool];
 }
 
 - (void)markRecoveryPhraseVerifiedWithCompletion:(void (^ _Nullable)(void))completion error: (void (^ _Nullable)(void))error
@@ -1474,7 +2061,7 @@ NSString * const kAccountInvitations = @"invited";
         }
     } forJsFunctionName:@"objc_wallet_mnemonic_verification_error"];
     
-    [self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.markMnemonicAsVerified()"];
+    [self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.markMnemonicAsVerified()"];
 }
 
 - (int)getActiveAccountsCount:(LegacyAssetType)assetType
@@ -1484,9 +2071,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getActiveAccountsCount()"] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getActiveAccountsCount()"] toNumber] intValue];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getActiveAccountsCount()"] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getActiveAccountsCount()"] toNumber] intValue];
     }
     return 0;
 
@@ -1499,9 +2086,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getAllAccountsCount()"] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getAllAccountsCount()"] toNumber] intValue];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getAllAccountsCount()"] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getAllAccountsCount()"] toNumber] intValue];
     }
     return 0;
 }
@@ -1513,9 +2100,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getDefaultAccountIndex()"] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.getDefaultAccountIndex()"] toNumber] intValue];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getDefaultAccountIndex()"] toNumber] intValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.getDefaultAccountIndex()"] toNumber] intValue];
     }
     return 0;
 }
@@ -1527,10 +2114,10 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.setDefaultAccount(%d)", index]];
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.setDefaultAccount(%d)", index]];
         self.isSettingDefaultAccount = YES;
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        [self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.setDefaultAccount(%d)", index]];
+        [self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.setDefaultAccount(%d)", index]];
         [self getHistory];
         if ([self.delegate respondsToSelector:@selector(didSetDefaultAccount)]) {
             [self.delegate didSetDefaultAccount];
@@ -1547,9 +2134,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.addresses.length > 0"] toBool];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.addresses.length > 0"] toBool];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.hasLegacyAddresses()"] toBool];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.hasLegacyAddresses()"] toBool];
     }
     return NO;
 }
@@ -1560,7 +2147,7 @@ NSString * const kAccountInvitations = @"invited";
         return 0;
     }
 
-    return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.totalActiveBalance()"] toNumber] longLongValue];
+    return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.totalActiveBalance()"] toNumber] longLongValue];
 }
 
 - (uint64_t)getTotalBalanceForActiveLegacyAddresses:(LegacyAssetType)assetType
@@ -1570,9 +2157,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.balanceActiveLegacy"] toNumber] longLongValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWallet.wallet.balanceActiveLegacy"] toNumber] longLongValue];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[[self.context evaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.balanceActiveLegacy()"] toNumber] longLongValue];
+        return [[[self.context tracedEvaluateScriptCheckIsOnMainQueue:@"MyWalletPhone.bch.balanceActiveLegacy()"] toNumber] longLongValue];
     }
     DLog(@"Error getting total balance for active legacy addresses: unsupported asset type!");
     return 0;
@@ -1584,12 +2171,12 @@ NSString * const kAccountInvitations = @"invited";
         if (![self isInitialized]) {
             return @0;
         }
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getBalanceForAccount(%d)", account]] toNumber];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getBalanceForAccount(%d)", account]] toNumber];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
         if (![self isInitialized]) {
             return @0;
         }
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getBalanceForAccount(%d)", account]] toNumber];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getBalanceForAccount(%d)", account]] toNumber];
     }
     return nil;
 }
@@ -1601,9 +2188,9 @@ NSString * const kAccountInvitations = @"invited";
     }
 
     if (assetType == LegacyAssetTypeBitcoin) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getLabelForAccount(%d)", account]] toString];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.getLabelForAccount(%d)", account]] toString];
     } else if (assetType == LegacyAssetTypeBitcoinCash) {
-        return [[self.context evaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getLabelForAccount(%d)", account]] toString];
+        return [[self.context tracedEvaluateScriptCheckIsOnMainQueue:[NSString stringWithFormat:@"MyWalletPhone.bch.getLabelForAccount(%d)", account]] toString];
     }
     return nil;
 }
@@ -1614,7 +2201,9 @@ NSString * const kAccountInvitations = @"invited";
 {
     DLog(@"reload");
 
-    self.handleReload();
+    if (self.handleReload) {
+        self.handleReload();
+    }
 }
 
 - (void)logging_out
@@ -1635,7 +2224,7 @@ NSString * const kAccountInvitations = @"invited";
 
         dispatch_async(dispatch_get_main_queue(), ^{
             if (data) {
-                [_success callWithArguments:@[[data hexadecimalString]]];
+                [_success callWithArguments:@[[data secureHexadecimalString]]];
             } else {
                 [LoadingViewPresenter.shared hide];
                 [_error callWithArguments:@[@"Scrypt Error"]];
@@ -1646,58 +2235,28 @@ NSString * const kAccountInvitations = @"invited";
 
 - (NSData*)_internal_crypto_scrypt:(id)_password salt:(id)_salt n:(uint64_t)N r:(uint32_t)r p:(uint32_t)p dkLen:(uint32_t)derivedKeyLen
 {
-    uint8_t * _passwordBuff = NULL;
-    size_t _passwordBuffLen = 0;
-    if ([_password isKindOfClass:[NSArray class]]) {
-        _passwordBuff = alloca([_password count]);
-        _passwordBuffLen = [_password count];
-
-        {
-            int ii = 0;
-            for (NSNumber * number in _password) {
-                _passwordBuff[ii] = [number shortValue];
-                ++ii;
-            }
-        }
-    } else if ([_password isKindOfClass:[NSString class]]) {
-        const char *passwordUTF8String = [_password UTF8String];
-        _passwordBuff = (uint8_t*)passwordUTF8String;
-        _passwordBuffLen = strlen(passwordUTF8String);
-    } else {
+    // Password, salt and key live in locked pool buffers that are wiped however this returns.
+    SECBUF_SCOPED(password);
+    SECBUF_SCOPED(salt);
+    SECBUF_SCOPED(derivedKey);
+
+    if (![NSData copySecret:_password toSecureBuffer:&password]) {
         DLog(@"Scrypt password unsupported type");
         return nil;
     }
-
-    uint8_t * _saltBuff = NULL;
-    size_t _saltBuffLen = 0;
-
-    if ([_salt isKindOfClass:[NSArray class]]) {
-        _saltBuff = alloca([_salt count]);
-        _saltBuffLen = [_salt count];
-
-        {
-            int ii = 0;
-            for (NSNumber * number in _salt) {
-                _saltBuff[ii] = [number shortValue];
-                ++ii;
-            }
-        }
-    } else if ([_salt isKindOfClass:[NSString class]]) {
-        const char *saltUTF8String = [_salt UTF8String];
-        _saltBuff = (uint8_t*)saltUTF8String;
-        _saltBuffLen = strlen(saltUTF8String);
-    } else {
+    if (![NSData copySecret:_salt toSecureBuffer:&salt]) {
         DLog(@"Scrypt salt unsupported type");
         return nil;
     }
+    if (secbuf_get(&derivedKey, derivedKeyLen) != 0) {
+        return nil;
+    }
 
-    uint8_t * derivedBytes = malloc(derivedKeyLen);
-
-    if (crypto_scrypt((uint8_t*)_passwordBuff, _passwordBuffLen, (uint8_t*)_saltBuff, _saltBuffLen, N, r, p, derivedBytes, derivedKeyLen) == -1) {
+    if (crypto_scrypt(password.buf, password.len, salt.buf, salt.len, N, r, p, derivedKey.buf, derivedKey.len) == -1) {
         return nil;
     }
 
-    return [NSData dataWithBytesNoCopy:derivedBytes length:derivedKeyLen];
+    return [NSData dataTakingSecureBuffer:&derivedKey];
 }
 
 @end
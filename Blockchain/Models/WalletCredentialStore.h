@@ -0,0 +1,64 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Where a `WalletCredentialStore` keeps its items, each an identifier and its data.
+@protocol WalletCredentialBacking <NSObject>
+
+/// The data of each of `identifiers` that has an item, fetched in one query; nil if the query failed.
+- (nullable NSDictionary<NSString *, NSData *> *)loadDataForIdentifiers:(NSSet<NSString *> *)identifiers;
+
+/// Saves `data` as the item for `identifier`, or deletes the item if `data` is nil. NO on failure.
+- (BOOL)storeData:(nullable NSData *)data forIdentifier:(NSString *)identifier;
+
+@end
+
+/// Generic password items in the keychain, in the format of `KeychainItemWrapper`: the identifier is
+/// both the generic attribute and the account, and items are accessible when unlocked, on this device.
+@interface WalletKeychainCredentialBacking : NSObject <WalletCredentialBacking>
+@end
+
+/// Wallet credentials served from memory, and written behind to a backing store.
+///
+/// Every item the store covers is loaded in a single query on the first read. Writes update memory
+/// at once and are saved together by one flush, `flushDelay` after the first of them, so that login,
+/// which sets several credentials in a row, costs one pass over the backing store. Removals are
+/// saved before they return, as a credential that was forgotten must not survive a crash. Writes
+/// that fail stay pending for the next flush. Thread safe.
+@interface WalletCredentialStore : NSObject
+
+/// The keychain store of the guid, shared key and PIN. It flushes when the app resigns active and
+/// reloads when protected data becomes available, as a launch before first unlock reads nothing.
++ (instancetype)sharedStore;
+
+/// A store of the items `identifiers` in `backing`.
+- (instancetype)initWithBacking:(id<WalletCredentialBacking>)backing
+                    identifiers:(NSSet<NSString *> *)identifiers
+                     flushDelay:(NSTimeInterval)flushDelay NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// The data of the item for `identifier`, one of the store's identifiers; nil if there is none.
+- (nullable NSData *)dataForIdentifier:(NSString *)identifier;
+
+- (void)setData:(NSData *)data forIdentifier:(NSString *)identifier;
+
+/// Deletes the item from the backing store now, saving any pending writes with it. NO if any of
+/// that failed, in which case what failed stays pending for the next flush.
+- (BOOL)removeDataForIdentifier:(NSString *)identifier;
+
+/// Saves pending writes now. YES if none remain.
+- (BOOL)flush;
+
+/// Drops what was loaded, keeping pending writes, so the next read queries the backing store again.
+- (void)reload;
+
+/// Queries of the backing store, and items written to or deleted from it, since init.
+@property (atomic, readonly) NSUInteger loadCount;
+@property (atomic, readonly) NSUInteger storeCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
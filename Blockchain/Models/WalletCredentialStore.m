@@ -0,0 +1,226 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Security/Security.h>
+#import <UIKit/UIKit.h>
+#import "WalletCredentialStore.h"
+
+/// Long enough to gather the writes of a login, short enough that few are at stake if the app dies.
+static const NSTimeInterval WalletCredentialStoreFlushDelay = 0.25;
+
+@implementation WalletKeychainCredentialBacking
+
+- (NSDictionary<NSString *, NSData *> *)loadDataForIdentifiers:(NSSet<NSString *> *)identifiers
+{
+    NSDictionary *query = @{
+        (__bridge id)kSecClass: (__bridge id)kSecClassGenericPassword,
+        (__bridge id)kSecMatchLimit: (__bridge id)kSecMatchLimitAll,
+        (__bridge id)kSecReturnAttributes: @YES,
+        (__bridge id)kSecReturnData: @YES
+    };
+    CFTypeRef result = NULL;
+    OSStatus status = SecItemCopyMatching((__bridge CFDictionaryRef)query, &result);
+    if (status == errSecItemNotFound) {
+        return @{};
+    }
+    if (status != errSecSuccess) {
+        DLog(@"Unable to load credentials from keychain: %d", (int)status);
+        return nil;
+    }
+
+    NSMutableDictionary<NSString *, NSData *> *loaded = [NSMutableDictionary dictionary];
+    for (NSDictionary *item in (__bridge_transfer NSArray *)result) {
+        // Set as a string by KeychainItemWrapper, but read back as data.
+        id generic = item[(__bridge id)kSecAttrGeneric];
+        NSString *identifier = [generic isKindOfClass:[NSData class]] ? [[NSString alloc] initWithData:generic encoding:NSUTF8StringEncoding] : generic;
+        NSData *data = item[(__bridge id)kSecValueData];
+        if ([identifier isKindOfClass:[NSString class]] && [identifiers containsObject:identifier] && [data isKindOfClass:[NSData class]]) {
+            loaded[identifier] = data;
+        }
+    }
+    return loaded;
+}
+
+- (BOOL)storeData:(NSData *)data forIdentifier:(NSString *)identifier
+{
+    NSDictionary *query = @{
+        (__bridge id)kSecClass: (__bridge id)kSecClassGenericPassword,
+        (__bridge id)kSecAttrGeneric: identifier
+    };
+    if (!data) {
+        OSStatus status = SecItemDelete((__bridge CFDictionaryRef)query);
+        return status == errSecSuccess || status == errSecItemNotFound;
+    }
+
+    NSDictionary *attributes = @{
+        (__bridge id)kSecAttrAccessible: (__bridge id)kSecAttrAccessibleWhenUnlockedThisDeviceOnly,
+        (__bridge id)kSecValueData: data
+    };
+    OSStatus status = SecItemUpdate((__bridge CFDictionaryRef)query, (__bridge CFDictionaryRef)attributes);
+    if (status == errSecItemNotFound) {
+        NSMutableDictionary *item = [query mutableCopy];
+        [item addEntriesFromDictionary:attributes];
+        item[(__bridge id)kSecAttrAccount] = identifier;
+        status = SecItemAdd((__bridge CFDictionaryRef)item, NULL);
+    }
+    if (status != errSecSuccess) {
+        DLog(@"Unable to save %@ to keychain: %d", identifier, (int)status);
+    }
+    return status == errSecSuccess;
+}
+
+@end
+
+@interface WalletCredentialStore ()
+
+@property (nonatomic, strong) id<WalletCredentialBacking> backing;
+@property (nonatomic, copy) NSSet<NSString *> *identifiers;
+@property (nonatomic) NSTimeInterval flushDelay;
+@property (nonatomic, strong) dispatch_queue_t queue;
+/// Identifier to data, nil until loaded; on the queue.
+@property (nonatomic, strong, nullable) NSMutableDictionary<NSString *, NSData *> *values;
+/// Identifier to the data to save, or NSNull to delete; on the queue.
+@property (nonatomic, strong) NSMutableDictionary<NSString *, id> *pending;
+@property (nonatomic) BOOL isFlushScheduled;
+@property (atomic, readwrite) NSUInteger loadCount;
+@property (atomic, readwrite) NSUInteger storeCount;
+
+@end
+
+@implementation WalletCredentialStore
+
++ (instancetype)sharedStore
+{
+    static WalletCredentialStore *sharedStore;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedStore = [[WalletCredentialStore alloc] initWithBacking:[[WalletKeychainCredentialBacking alloc] init]
+                                                         identifiers:[NSSet setWithObjects:KEYCHAIN_KEY_GUID, KEYCHAIN_KEY_SHARED_KEY, KEYCHAIN_KEY_PIN, nil]
+                                                          flushDelay:WalletCredentialStoreFlushDelay];
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        [center addObserver:sharedStore selector:@selector(flush) name:UIApplicationWillResignActiveNotification object:nil];
+        [center addObserver:sharedStore selector:@selector(flush) name:UIApplicationWillTerminateNotification object:nil];
+        [center addObserver:sharedStore selector:@selector(reload) name:UIApplicationProtectedDataDidBecomeAvailable object:nil];
+    });
+    return sharedStore;
+}
+
+- (instancetype)initWithBacking:(id<WalletCredentialBacking>)backing
+                    identifiers:(NSSet<NSString *> *)identifiers
+                     flushDelay:(NSTimeInterval)flushDelay
+{
+    self = [super init];
+    if (self) {
+        _backing = backing;
+        _identifiers = [identifiers copy];
+        _flushDelay = flushDelay;
+        _queue = dispatch_queue_create("com.blockchain.wallet.credentials", DISPATCH_QUEUE_SERIAL);
+        _pending = [NSMutableDictionary dictionary];
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (NSData *)dataForIdentifier:(NSString *)identifier
+{
+    NSAssert([self.identifiers containsObject:identifier], @"%@ is not kept by this store", identifier);
+    __block NSData *data;
+    dispatch_sync(self.queue, ^{
+        data = [self loadedValues][identifier];
+    });
+    return data;
+}
+
+- (void)setData:(NSData *)data forIdentifier:(NSString *)identifier
+{
+    [self enqueueData:[data copy] forIdentifier:identifier];
+}
+
+- (BOOL)removeDataForIdentifier:(NSString *)identifier
+{
+    return [self enqueueData:nil forIdentifier:identifier];
+}
+
+- (BOOL)flush
+{
+    __block BOOL flushed;
+    dispatch_sync(self.queue, ^{
+        flushed = [self flushPending];
+    });
+    return flushed;
+}
+
+- (void)reload
+{
+    dispatch_sync(self.queue, ^{
+        self.values = nil;
+    });
+}
+
+#pragma mark - Private, on the queue
+
+/// Sets or, if `data` is nil, removes the item. A removal is flushed at once, with any writes
+/// pending, so a forgotten credential never outlives the call; returns NO if that flush failed.
+- (BOOL)enqueueData:(nullable NSData *)data forIdentifier:(NSString *)identifier
+{
+    NSAssert([self.identifiers containsObject:identifier], @"%@ is not kept by this store", identifier);
+    __block BOOL flushed = YES;
+    dispatch_sync(self.queue, ^{
+        // An item set to what it holds, like KeychainItemWrapper, is not written again.
+        if (data && self.pending[identifier] == nil && [self.values[identifier] isEqualToData:data]) {
+            return;
+        }
+        self.values[identifier] = data;
+        self.pending[identifier] = data ?: [NSNull null];
+        if (!data) {
+            flushed = [self flushPending];
+            return;
+        }
+        if (self.isFlushScheduled) {
+            return;
+        }
+        self.isFlushScheduled = YES;
+        __weak WalletCredentialStore *weakSelf = self;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.flushDelay * NSEC_PER_SEC)), self.queue, ^{
+            [weakSelf flushPending];
+        });
+    });
+    return flushed;
+}
+
+/// The loaded values with pending writes over them, or only the pending writes if the load failed.
+- (NSMutableDictionary<NSString *, NSData *> *)loadedValues
+{
+    if (self.values) {
+        return self.values;
+    }
+    self.loadCount += 1;
+    NSDictionary<NSString *, NSData *> *loaded = [self.backing loadDataForIdentifiers:self.identifiers];
+    NSMutableDictionary<NSString *, NSData *> *values = loaded ? [loaded mutableCopy] : [NSMutableDictionary dictionary];
+    [self.pending enumerateKeysAndObjectsUsingBlock:^(NSString *identifier, id data, BOOL *stop) {
+        values[identifier] = data == [NSNull null] ? nil : data;
+    }];
+    // Not kept after a failed load, so the next read tries again; pending writes still answer for themselves.
+    if (loaded) {
+        self.values = values;
+    }
+    return values;
+}
+
+- (BOOL)flushPending
+{
+    self.isFlushScheduled = NO;
+    for (NSString *identifier in self.pending.allKeys) {
+        id data = self.pending[identifier];
+        self.storeCount += 1;
+        if ([self.backing storeData:data == [NSNull null] ? nil : data forIdentifier:identifier]) {
+            [self.pending removeObjectForKey:identifier];
+        }
+    }
+    return self.pending.count == 0;
+}
+
+@end
@@ -1,6 +1,7 @@
 // Copyright © Blockchain Luxembourg S.A. All rights reserved.
 
 #import <Foundation/Foundation.h>
+#import "WalletRefreshCoordinator.h"
 
 @class Wallet;
 @class MultiAddressResponse;
@@ -27,6 +28,8 @@
 - (void)walletDidFinishLoad;
 - (void)walletDidGetAccountInfo:(Wallet *)wallet;
 - (void)walletDidGetAccountInfoAndExchangeRates:(Wallet *)wallet;
+/// `failedParts` are the account info and exchange rate parts of a refresh that could not be fetched.
+- (void)wallet:(Wallet *)wallet didFailToGetAccountInfoAndExchangeRates:(WalletRefreshParts)failedParts;
 - (void)walletDidGetBtcExchangeRates;
 - (void)walletDidLoad;
 - (void)walletFailedToDecrypt;
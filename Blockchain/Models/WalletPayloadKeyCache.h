@@ -0,0 +1,35 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// Bytes of a payload salt, which is also the AES-CBC IV of the payload.
+extern const NSUInteger WalletPayloadSaltLength;
+/// Bytes of a payload key.
+extern const NSUInteger WalletPayloadKeyLength;
+
+/// Payload encryption keys for the main password, stretched ahead of the backups that use them.
+///
+/// A payload key is PBKDF2-HMAC-SHA1 of the main password over a random salt that doubles as the
+/// IV, so one key cannot serve two backups without repeating an IV. Instead the cache keeps the
+/// password and iteration count of the session in a locked secbuf, and stretches the key for the
+/// next backup, over a fresh salt, on a background queue as soon as one is taken. A backup only
+/// stretches in line when it comes before the next key is ready, or with a password or iteration
+/// count other than the last, which drops the stocked key. Thread safe.
+@interface WalletPayloadKeyCache : NSObject
+
+/// A fresh salt followed by the key for it, `WalletPayloadSaltLength` + `WalletPayloadKeyLength`
+/// bytes that are wiped when released; nil if the key could not be derived.
+- (nullable NSData *)takeKeyForPassword:(NSString *)password iterations:(uint32_t)iterations;
+
+/// Forgets the password and the stocked key, e.g. on logout.
+- (void)invalidate;
+
+/// Keys taken from the stock, and keys stretched in line.
+@property (atomic, readonly) NSUInteger hitCount;
+@property (atomic, readonly) NSUInteger missCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
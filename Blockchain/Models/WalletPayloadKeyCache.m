@@ -0,0 +1,169 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <CommonCrypto/CommonKeyDerivation.h>
+#import <Security/Security.h>
+#import "WalletPayloadKeyCache.h"
+#import "NSData+SecureBuffer.h"
+
+const NSUInteger WalletPayloadSaltLength = 16;
+const NSUInteger WalletPayloadKeyLength = 32;
+
+/// Fills `saltAndKey` with a random salt and the key of `password` over it.
+static BOOL WalletPayloadStretch(const uint8_t *password, size_t passwordLength, uint32_t iterations, struct secbuf *saltAndKey)
+{
+    if (secbuf_get(saltAndKey, WalletPayloadSaltLength + WalletPayloadKeyLength) != 0) {
+        return NO;
+    }
+    if (SecRandomCopyBytes(kSecRandomDefault, WalletPayloadSaltLength, saltAndKey->buf) != errSecSuccess ||
+        CCKeyDerivationPBKDF(kCCPBKDF2, (const char *)password, passwordLength, saltAndKey->buf, WalletPayloadSaltLength,
+                             kCCPRFHmacAlgSHA1, iterations, saltAndKey->buf + WalletPayloadSaltLength, WalletPayloadKeyLength) != kCCSuccess) {
+        secbuf_put(saltAndKey);
+        return NO;
+    }
+    return YES;
+}
+
+@interface WalletPayloadKeyCache ()
+
+@property (nonatomic, strong) dispatch_queue_t queue;
+@property (atomic, readwrite) NSUInteger hitCount;
+@property (atomic, readwrite) NSUInteger missCount;
+
+@end
+
+@implementation WalletPayloadKeyCache {
+    /// UTF-8 bytes of the password the stock is for; empty until the first key is taken.
+    struct secbuf _password;
+    uint32_t _iterations;
+    /// The next salt and key, empty until stretched.
+    struct secbuf _stocked;
+    /// Bumped whenever the password is dropped, so that a key stretched for it is not stocked.
+    uint64_t _generation;
+    BOOL _isStretching;
+}
+
+- (instancetype)init
+{
+    self = [super init];
+    if (self) {
+        _queue = dispatch_queue_create("com.blockchain.wallet.payload-key", DISPATCH_QUEUE_SERIAL);
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    secbuf_put(&_password);
+    secbuf_put(&_stocked);
+}
+
+- (NSData *)takeKeyForPassword:(NSString *)password iterations:(uint32_t)iterations
+{
+    const char *utf8String = password.UTF8String;
+    size_t length = strlen(utf8String);
+    BOOL isStretching;
+
+    @synchronized (self) {
+        if (![self holdsPassword:utf8String length:length iterations:iterations]) {
+            [self forget];
+            if (secbuf_get(&_password, length) == 0) {
+                memcpy(_password.buf, utf8String, length);
+                _iterations = iterations;
+            }
+        }
+        NSData *key = [self takeStockedKey];
+        if (key) {
+            return key;
+        }
+        isStretching = _isStretching;
+        [self stretchNextKey];
+    }
+
+    if (isStretching) {
+        // The next key is on its way; waiting for it is cheaper than stretching another.
+        dispatch_sync(self.queue, ^{});
+        @synchronized (self) {
+            NSData *key = [self takeStockedKey];
+            if (key) {
+                return key;
+            }
+        }
+    }
+
+    self.missCount += 1;
+    SECBUF_SCOPED(saltAndKey);
+    if (!WalletPayloadStretch((const uint8_t *)utf8String, length, iterations, &saltAndKey)) {
+        return nil;
+    }
+    return [NSData dataTakingSecureBuffer:&saltAndKey];
+}
+
+- (void)invalidate
+{
+    @synchronized (self) {
+        [self forget];
+    }
+}
+
+#pragma mark - Private, under the lock
+
+- (BOOL)holdsPassword:(const char *)password length:(size_t)length iterations:(uint32_t)iterations
+{
+    return _password.buf != NULL && _password.len == length && _iterations == iterations &&
+        memcmp(_password.buf, password, length) == 0;
+}
+
+- (void)forget
+{
+    secbuf_put(&_password);
+    secbuf_put(&_stocked);
+    _iterations = 0;
+    _generation += 1;
+}
+
+/// The stocked key, with the next one set stretching; nil if there is none.
+- (NSData *)takeStockedKey
+{
+    if (_stocked.buf == NULL) {
+        return nil;
+    }
+    NSData *key = [NSData dataTakingSecureBuffer:&_stocked];
+    self.hitCount += 1;
+    [self stretchNextKey];
+    return key;
+}
+
+- (void)stretchNextKey
+{
+    if (_isStretching || _stocked.buf != NULL || _password.buf == NULL) {
+        return;
+    }
+    struct secbuf password = SECBUF_INITIALIZER;
+    if (secbuf_get(&password, _password.len) != 0) {
+        return;
+    }
+    memcpy(password.buf, _password.buf, _password.len);
+    uint32_t iterations = _iterations;
+    uint64_t generation = _generation;
+    _isStretching = YES;
+
+    dispatch_async(self.queue, ^{
+        struct secbuf ownedPassword = password;
+        SECBUF_SCOPED(saltAndKey);
+        BOOL isStretched = WalletPayloadStretch(ownedPassword.buf, ownedPassword.len, iterations, &saltAndKey);
+        secbuf_put(&ownedPassword);
+
+        @synchronized (self) {
+            self->_isStretching = NO;
+            if (generation != self->_generation) {
+                // The password changed while this one stretched; start on the new one.
+                [self stretchNextKey];
+            } else if (isStretched && self->_stocked.buf == NULL) {
+                self->_stocked = saltAndKey;
+                saltAndKey = (struct secbuf)SECBUF_INITIALIZER;
+            }
+        }
+    });
+}
+
+@end
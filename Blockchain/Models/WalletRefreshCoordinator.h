@@ -0,0 +1,60 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// What a refresh fetches. The values are shared with `MyWalletPhone.refreshAssets` in wallet-ios.js.
+typedef NS_OPTIONS(NSUInteger, WalletRefreshParts) {
+    /// The wallet and Bitcoin histories, ending in a multiaddr response.
+    WalletRefreshPartWalletHistory = 1 << 0,
+    WalletRefreshPartBitcoinCashHistory = 1 << 1,
+    WalletRefreshPartAccountInfo = 1 << 2,
+    WalletRefreshPartBitcoinRates = 1 << 3,
+    WalletRefreshPartBitcoinCashRates = 1 << 4,
+    WalletRefreshPartAll = (1 << 5) - 1,
+};
+
+/// Fetches each part of the wallet data once however many callers ask for it at the same time.
+///
+/// One refresh runs at a time, fetching all of its parts at once. A request for parts the refresh
+/// in flight is already fetching joins it; requests for other parts are gathered into a single
+/// follow-up refresh, started as soon as the current one is applied. Requests made while results
+/// are being applied are answered by them if they are covered, so a callback that asks for the
+/// data it was just handed does not start another round. Must be used from the main queue.
+@interface WalletRefreshCoordinator : NSObject
+
+/// `start` begins fetching `parts`, and the fetch must end with one `finishRefresh:` call with
+/// the same id, possibly before `start` returns.
+- (instancetype)initWithStart:(void (^)(uint64_t refreshID, WalletRefreshParts parts))start NS_DESIGNATED_INITIALIZER;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/// How long a refresh may run before its parts are failed, 60 seconds unless set. 0 waits forever.
+@property (nonatomic, assign) NSTimeInterval timeout;
+
+/// Called when a refresh times out, to end it with `finishRefresh:` and the parts it is missing.
+/// If this is nil, or the refresh is still in flight after it, every part of it fails unapplied.
+@property (nonatomic, copy, nullable) void (^timedOut)(uint64_t refreshID, WalletRefreshParts parts);
+
+/// The parts of the refresh in flight, 0 when there is none.
+@property (nonatomic, readonly) WalletRefreshParts partsInFlight;
+
+/// YES while the results of a refresh are being applied.
+@property (nonatomic, readonly) BOOL isApplying;
+
+/// Asks for `parts`. `completion` is called once the refresh that covers them is applied, with
+/// those of `parts` that failed.
+- (void)requestParts:(WalletRefreshParts)parts completion:(nullable void (^)(WalletRefreshParts failedParts))completion;
+
+/// Ends refresh `refreshID`: runs `apply`, starts the follow-up refresh if one is due, then calls
+/// the completions of the requests it answered. Ignored if `refreshID` is not in flight.
+- (void)finishRefresh:(uint64_t)refreshID failedParts:(WalletRefreshParts)failedParts apply:(void (NS_NOESCAPE ^)(void))apply;
+
+/// Forgets the refresh in flight and the follow-up, e.g. when the JS context is replaced. Their
+/// completions are called with every part failed.
+- (void)cancel;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,157 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import "WalletRefreshCoordinator.h"
+
+/// A caller waiting on a refresh.
+@interface WalletRefreshRequest : NSObject
+
+@property (nonatomic, assign) WalletRefreshParts parts;
+@property (nonatomic, copy, nullable) void (^completion)(WalletRefreshParts failedParts);
+
+@end
+
+@implementation WalletRefreshRequest
+@end
+
+@interface WalletRefreshCoordinator ()
+
+@property (nonatomic, copy) void (^start)(uint64_t refreshID, WalletRefreshParts parts);
+@property (nonatomic, assign) uint64_t lastRefreshID;
+/// 0 when idle.
+@property (nonatomic, assign) uint64_t refreshID;
+@property (nonatomic, readwrite) WalletRefreshParts partsInFlight;
+@property (nonatomic, readwrite) BOOL isApplying;
+@property (nonatomic, strong) NSMutableArray<WalletRefreshRequest *> *joined;
+@property (nonatomic, assign) WalletRefreshParts followUpParts;
+@property (nonatomic, strong) NSMutableArray<WalletRefreshRequest *> *followUp;
+
+@end
+
+@implementation WalletRefreshCoordinator
+
+- (instancetype)initWithStart:(void (^)(uint64_t, WalletRefreshParts))start
+{
+    self = [super init];
+    if (self) {
+        _start = [start copy];
+        _joined = [NSMutableArray array];
+        _followUp = [NSMutableArray array];
+        _timeout = 60;
+    }
+    return self;
+}
+
+- (void)requestParts:(WalletRefreshParts)parts completion:(void (^)(WalletRefreshParts))completion
+{
+    WalletRefreshRequest *request = [WalletRefreshRequest new];
+    request.parts = parts & WalletRefreshPartAll;
+    request.completion = completion;
+
+    if (request.parts == 0) {
+        if (completion) {
+            completion(0);
+        }
+        return;
+    }
+    if (self.refreshID != 0) {
+        if ((request.parts & ~self.partsInFlight) == 0) {
+            [self.joined addObject:request];
+        } else {
+            self.followUpParts |= request.parts;
+            [self.followUp addObject:request];
+        }
+        return;
+    }
+
+    uint64_t refreshID = ++self.lastRefreshID;
+    self.refreshID = refreshID;
+    self.partsInFlight = request.parts;
+    [self.joined addObject:request];
+    [self scheduleTimeoutForRefresh:refreshID];
+    self.start(refreshID, request.parts);
+}
+
+- (void)scheduleTimeoutForRefresh:(uint64_t)refreshID
+{
+    if (self.timeout <= 0) {
+        return;
+    }
+    __weak WalletRefreshCoordinator *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.timeout * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [weakSelf refreshDidTimeOut:refreshID];
+    });
+}
+
+/// Fails whatever refresh `refreshID` has not reported, unless it has ended in the meantime.
+- (void)refreshDidTimeOut:(uint64_t)refreshID
+{
+    if (refreshID != self.refreshID || self.isApplying) {
+        return;
+    }
+    if (self.timedOut) {
+        self.timedOut(refreshID, self.partsInFlight);
+    }
+    [self finishRefresh:refreshID failedParts:self.partsInFlight apply:^{}];
+}
+
+- (void)finishRefresh:(uint64_t)refreshID failedParts:(WalletRefreshParts)failedParts apply:(void (NS_NOESCAPE ^)(void))apply
+{
+    if (refreshID == 0 || refreshID != self.refreshID || self.isApplying) {
+        return;
+    }
+
+    self.isApplying = YES;
+    apply();
+    self.isApplying = NO;
+
+    NSArray<WalletRefreshRequest *> *answered = [self.joined copy];
+    [self.joined removeAllObjects];
+    self.refreshID = 0;
+    self.partsInFlight = 0;
+    [self startFollowUp];
+
+    for (WalletRefreshRequest *request in answered) {
+        if (request.completion) {
+            request.completion(failedParts & request.parts);
+        }
+    }
+}
+
+/// Starts one refresh for every request that came in for parts the last one did not fetch.
+- (void)startFollowUp
+{
+    if (self.followUpParts == 0) {
+        return;
+    }
+    NSArray<WalletRefreshRequest *> *followUp = [self.followUp copy];
+    WalletRefreshParts parts = self.followUpParts;
+    [self.followUp removeAllObjects];
+    self.followUpParts = 0;
+
+    [self requestParts:parts completion:^(WalletRefreshParts failedParts) {
+        for (WalletRefreshRequest *request in followUp) {
+            if (request.completion) {
+                request.completion(failedParts & request.parts);
+            }
+        }
+    }];
+}
+
+- (void)cancel
+{
+    NSMutableArray<WalletRefreshRequest *> *dropped = [self.joined mutableCopy];
+    [dropped addObjectsFromArray:self.followUp];
+    [self.joined removeAllObjects];
+    [self.followUp removeAllObjects];
+    self.followUpParts = 0;
+    self.refreshID = 0;
+    self.partsInFlight = 0;
+
+    for (WalletRefreshRequest *request in dropped) {
+        if (request.completion) {
+            request.completion(request.parts);
+        }
+    }
+}
+
+@end
@@ -0,0 +1,896 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include "BCJSON.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define BC_JSON_BLOCK_SIZE 64
+// Documents are padded with whitespace so that scalars can be read past their end without bounds checks.
+#define BC_JSON_PADDING BC_JSON_BLOCK_SIZE
+#define BC_JSON_MAX_LENGTH (UINT32_MAX - BC_JSON_PADDING)
+#define BC_JSON_MAX_DEPTH 1024
+#define BC_JSON_NO_TOKEN UINT32_MAX
+
+#define BC_JSON_ODD_BITS 0xaaaaaaaaaaaaaaaaULL
+
+struct BCJSONDocument {
+    uint8_t *bytes;
+    size_t length;
+    uint32_t *tokens;
+    uint32_t tokenCount;
+    // For each '{' or '[' token, the index of the matching '}' or ']' token.
+    uint32_t *matches;
+};
+
+typedef struct BCJSONParser BCJSONParser;
+
+struct BCJSONParser {
+    uint8_t *bytes;
+    size_t length;
+    size_t capacity;
+    // Bytes [0, indexed) have been through stage one, always a multiple of the block size.
+    size_t indexed;
+
+    uint32_t *tokens;
+    size_t tokenCount;
+    size_t tokenCapacity;
+
+    // State carried from one block to the next.
+    uint64_t previousInString;
+    uint64_t previousEscaped;
+    uint64_t previousScalar;
+};
+
+#pragma mark - Stage one
+
+typedef struct {
+    uint64_t backslash;
+    uint64_t quote;
+    uint64_t whitespace;
+    uint64_t operator;
+} BCJSONBlockMasks;
+
+#if defined(__ARM_NEON)
+
+static inline uint64_t
+BCJSONMoveMask(uint8x16_t v0, uint8x16_t v1, uint8x16_t v2, uint8x16_t v3)
+{
+    const uint8x16_t bits = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(v0, bits), vandq_u8(v1, bits));
+    uint8x16_t sum1 = vpaddq_u8(vandq_u8(v2, bits), vandq_u8(v3, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+static inline uint64_t
+BCJSONEqualMask(const uint8x16_t *chunks, uint8_t c)
+{
+    uint8x16_t mask = vdupq_n_u8(c);
+    return BCJSONMoveMask(vceqq_u8(chunks[0], mask), vceqq_u8(chunks[1], mask), vceqq_u8(chunks[2], mask), vceqq_u8(chunks[3], mask));
+}
+
+static void
+BCJSONClassifyBlock(const uint8_t *block, BCJSONBlockMasks *masks)
+{
+    uint8x16_t chunks[4] = { vld1q_u8(block), vld1q_u8(block + 16), vld1q_u8(block + 32), vld1q_u8(block + 48) };
+    masks->backslash = BCJSONEqualMask(chunks, '\\');
+    masks->quote = BCJSONEqualMask(chunks, '"');
+    masks->whitespace = BCJSONEqualMask(chunks, ' ') | BCJSONEqualMask(chunks, '\t') | BCJSONEqualMask(chunks, '\n') | BCJSONEqualMask(chunks, '\r');
+    // '[' | 0x20 == '{' and ']' | 0x20 == '}', which saves two compares.
+    uint8x16_t folded[4];
+    for (int i = 0; i < 4; i++) {
+        folded[i] = vorrq_u8(chunks[i], vdupq_n_u8(0x20));
+    }
+    masks->operator = BCJSONEqualMask(folded, '{') | BCJSONEqualMask(folded, '}') | BCJSONEqualMask(chunks, ':') | BCJSONEqualMask(chunks, ',');
+}
+
+#elif defined(__SSE2__)
+
+static inline uint64_t
+BCJSONEqualMask(const __m128i *chunks, char c)
+{
+    __m128i mask = _mm_set1_epi8(c);
+    uint64_t result = 0;
+    for (int i = 0; i < 4; i++) {
+        result |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], mask)) << (16 * i);
+    }
+    return result;
+}
+
+static void
+BCJSONClassifyBlock(const uint8_t *block, BCJSONBlockMasks *masks)
+{
+    __m128i chunks[4];
+    __m128i folded[4];
+    for (int i = 0; i < 4; i++) {
+        chunks[i] = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+        folded[i] = _mm_or_si128(chunks[i], _mm_set1_epi8(0x20));
+    }
+    masks->backslash = BCJSONEqualMask(chunks, '\\');
+    masks->quote = BCJSONEqualMask(chunks, '"');
+    masks->whitespace = BCJSONEqualMask(chunks, ' ') | BCJSONEqualMask(chunks, '\t') | BCJSONEqualMask(chunks, '\n') | BCJSONEqualMask(chunks, '\r');
+    masks->operator = BCJSONEqualMask(folded, '{') | BCJSONEqualMask(folded, '}') | BCJSONEqualMask(chunks, ':') | BCJSONEqualMask(chunks, ',');
+}
+
+#else
+
+static void
+BCJSONClassifyBlock(const uint8_t *block, BCJSONBlockMasks *masks)
+{
+    *masks = (BCJSONBlockMasks){ 0 };
+    for (int i = 0; i < BC_JSON_BLOCK_SIZE; i++) {
+        uint64_t bit = 1ULL << i;
+        switch (block[i]) {
+            case '\\': masks->backslash |= bit; break;
+            case '"': masks->quote |= bit; break;
+            case ' ': case '\t': case '\n': case '\r': masks->whitespace |= bit; break;
+            case '{': case '}': case '[': case ']': case ':': case ',': masks->operator |= bit; break;
+            default: break;
+        }
+    }
+}
+
+#endif
+
+/*
+ * Each bit of the result is the XOR of every bit of `bits` at or below it,
+ * which turns the positions of quotes into a mask of the bytes inside strings.
+ */
+static inline uint64_t
+BCJSONPrefixXor(uint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/*
+ * Returns the bytes escaped by a backslash: those that follow an odd length run of backslashes.
+ * Adding the first bit of a run to the run carries past its end; whether the run started on an
+ * even or odd bit then tells whether its length was odd.
+ */
+static inline uint64_t
+BCJSONEscapedMask(uint64_t backslash, uint64_t *previousEscaped)
+{
+    uint64_t escapedIn = *previousEscaped;
+    if (backslash == 0) {
+        *previousEscaped = 0;
+        return escapedIn;
+    }
+
+    // A backslash escaped by the previous block does not start a run.
+    uint64_t runs = backslash & ~escapedIn;
+    uint64_t starts = runs & ~(runs << 1);
+    uint64_t evenStarts = starts & ~BC_JSON_ODD_BITS;
+    uint64_t oddStarts = starts & BC_JSON_ODD_BITS;
+
+    uint64_t evenCarries = runs + evenStarts;
+    uint64_t oddCarries;
+    // A run reaching the end of the block escapes the first byte of the next one if it started on an odd bit.
+    *previousEscaped = __builtin_add_overflow(runs, oddStarts, &oddCarries) ? 1 : 0;
+
+    uint64_t evenCarryEnds = evenCarries & ~runs;
+    uint64_t oddCarryEnds = oddCarries & ~runs;
+    uint64_t oddLengthEnds = (evenCarryEnds & BC_JSON_ODD_BITS) | (oddCarryEnds & ~BC_JSON_ODD_BITS);
+
+    return oddLengthEnds | escapedIn;
+}
+
+static bool
+BCJSONParserReserveTokens(BCJSONParser *parser, size_t count)
+{
+    if (parser->tokenCount + count <= parser->tokenCapacity) {
+        return true;
+    }
+    size_t capacity = parser->tokenCapacity ? parser->tokenCapacity : 256;
+    while (capacity < parser->tokenCount + count) {
+        capacity *= 2;
+    }
+    uint32_t *tokens = realloc(parser->tokens, capacity * sizeof(uint32_t));
+    if (tokens == NULL) {
+        return false;
+    }
+    parser->tokens = tokens;
+    parser->tokenCapacity = capacity;
+    return true;
+}
+
+static bool
+BCJSONParserIndexBlock(BCJSONParser *parser, const uint8_t *block, size_t offset)
+{
+    BCJSONBlockMasks masks;
+    BCJSONClassifyBlock(block, &masks);
+
+    uint64_t escaped = BCJSONEscapedMask(masks.backslash, &parser->previousEscaped);
+    uint64_t quote = masks.quote & ~escaped;
+
+    uint64_t inString = BCJSONPrefixXor(quote) ^ parser->previousInString;
+    parser->previousInString = (uint64_t)((int64_t)inString >> 63);
+    // Everything inside a string except its opening quote, closing quote included.
+    uint64_t stringTail = inString ^ quote;
+
+    // Scalars (numbers, literals and opening quotes) start at any non-whitespace, non-operator
+    // byte that does not follow another such byte.
+    uint64_t scalar = ~(masks.operator | masks.whitespace);
+    uint64_t nonQuoteScalar = scalar & ~quote;
+    uint64_t followsNonQuoteScalar = (nonQuoteScalar << 1) | parser->previousScalar;
+    parser->previousScalar = nonQuoteScalar >> 63;
+
+    uint64_t structurals = (masks.operator | (scalar & ~followsNonQuoteScalar)) & ~stringTail;
+
+    if (!BCJSONParserReserveTokens(parser, (size_t)__builtin_popcountll(structurals))) {
+        return false;
+    }
+    while (structurals != 0) {
+        parser->tokens[parser->tokenCount++] = (uint32_t)(offset + (size_t)__builtin_ctzll(structurals));
+        structurals &= structurals - 1;
+    }
+    return true;
+}
+
+static BCJSONParser *
+BCJSONParserCreate(size_t sizeHint)
+{
+    BCJSONParser *parser = calloc(1, sizeof(BCJSONParser));
+    if (parser == NULL) {
+        return NULL;
+    }
+    if (sizeHint > BC_JSON_MAX_LENGTH) {
+        sizeHint = BC_JSON_MAX_LENGTH;
+    }
+    parser->capacity = sizeHint + BC_JSON_PADDING;
+    parser->bytes = malloc(parser->capacity);
+    if (parser->bytes == NULL) {
+        free(parser);
+        return NULL;
+    }
+    return parser;
+}
+
+static bool
+BCJSONParserAppend(BCJSONParser *parser, const void *bytes, size_t length)
+{
+    if (length > BC_JSON_MAX_LENGTH - parser->length) {
+        return false;
+    }
+    if (parser->length + length + BC_JSON_PADDING > parser->capacity) {
+        size_t capacity = parser->capacity * 2;
+        if (capacity < parser->length + length + BC_JSON_PADDING) {
+            capacity = parser->length + length + BC_JSON_PADDING;
+        }
+        uint8_t *grown = realloc(parser->bytes, capacity);
+        if (grown == NULL) {
+            return false;
+        }
+        parser->bytes = grown;
+        parser->capacity = capacity;
+    }
+    memcpy(parser->bytes + parser->length, bytes, length);
+    parser->length += length;
+
+    while (parser->length - parser->indexed >= BC_JSON_BLOCK_SIZE) {
+        if (!BCJSONParserIndexBlock(parser, parser->bytes + parser->indexed, parser->indexed)) {
+            return false;
+        }
+        parser->indexed += BC_JSON_BLOCK_SIZE;
+    }
+    return true;
+}
+
+static void
+BCJSONParserDestroy(BCJSONParser *parser)
+{
+    if (parser == NULL) {
+        return;
+    }
+    free(parser->bytes);
+    free(parser->tokens);
+    free(parser);
+}
+
+#pragma mark - Stage two
+
+static bool
+BCJSONMatchBrackets(BCJSONDocument *document)
+{
+    uint32_t stack[BC_JSON_MAX_DEPTH];
+    size_t depth = 0;
+
+    for (uint32_t i = 0; i < document->tokenCount; i++) {
+        uint8_t c = document->bytes[document->tokens[i]];
+        if (c == '{' || c == '[') {
+            if (depth == BC_JSON_MAX_DEPTH) {
+                return false;
+            }
+            stack[depth++] = i;
+        } else if (c == '}' || c == ']') {
+            if (depth == 0) {
+                return false;
+            }
+            uint32_t open = stack[--depth];
+            // '[' + 2 == ']' and '{' + 2 == '}'.
+            if (document->bytes[document->tokens[open]] + 2 != c) {
+                return false;
+            }
+            document->matches[open] = i;
+        }
+        // Nothing may follow the root value.
+        if (depth == 0 && i + 1 < document->tokenCount) {
+            return false;
+        }
+    }
+    return depth == 0 && document->tokenCount > 0;
+}
+
+static BCJSONDocument *
+BCJSONParserFinish(BCJSONParser *parser)
+{
+    if (parser == NULL) {
+        return NULL;
+    }
+
+    // Pad the last partial block with whitespace and index it.
+    memset(parser->bytes + parser->length, ' ', BC_JSON_PADDING);
+    if (parser->indexed < parser->length) {
+        if (!BCJSONParserIndexBlock(parser, parser->bytes + parser->indexed, parser->indexed)) {
+            BCJSONParserDestroy(parser);
+            return NULL;
+        }
+    }
+    if (parser->previousInString) {
+        BCJSONParserDestroy(parser);
+        return NULL;
+    }
+
+    BCJSONDocument *document = calloc(1, sizeof(BCJSONDocument));
+    uint32_t *matches = malloc((parser->tokenCount ? parser->tokenCount : 1) * sizeof(uint32_t));
+    if (document == NULL || matches == NULL) {
+        free(document);
+        free(matches);
+        BCJSONParserDestroy(parser);
+        return NULL;
+    }
+    document->bytes = parser->bytes;
+    document->length = parser->length;
+    document->tokens = parser->tokens;
+    document->tokenCount = (uint32_t)parser->tokenCount;
+    document->matches = matches;
+    free(parser);
+
+    if (!BCJSONMatchBrackets(document)) {
+        BCJSONDocumentDestroy(document);
+        return NULL;
+    }
+    return document;
+}
+
+BCJSONDocument *
+BCJSONDocumentCreate(const void *bytes, size_t length)
+{
+    BCJSONParser *parser = BCJSONParserCreate(length);
+    if (parser == NULL) {
+        return NULL;
+    }
+    if (!BCJSONParserAppend(parser, bytes, length)) {
+        BCJSONParserDestroy(parser);
+        return NULL;
+    }
+    return BCJSONParserFinish(parser);
+}
+
+void
+BCJSONDocumentDestroy(BCJSONDocument *document)
+{
+    if (document == NULL) {
+        return;
+    }
+    free(document->bytes);
+    free(document->tokens);
+    free(document->matches);
+    free(document);
+}
+
+#pragma mark - Values
+
+static inline uint8_t
+BCJSONTokenChar(const BCJSONDocument *document, uint32_t token)
+{
+    return document->bytes[document->tokens[token]];
+}
+
+static inline bool
+BCJSONIsDelimiter(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' || c == ':' || c == ']' || c == '}';
+}
+
+// Index of the last token of the value starting at `token`.
+static inline uint32_t
+BCJSONValueEnd(const BCJSONDocument *document, uint32_t token)
+{
+    uint8_t c = BCJSONTokenChar(document, token);
+    return (c == '{' || c == '[') ? document->matches[token] : token;
+}
+
+static bool
+BCJSONLiteralEquals(const uint8_t *bytes, const char *literal, size_t length)
+{
+    // Padding guarantees that the byte after a literal at the end of the document can be read.
+    return memcmp(bytes, literal, length) == 0 && BCJSONIsDelimiter(bytes[length]);
+}
+
+BCJSONValue
+BCJSONDocumentGetRoot(const BCJSONDocument *document)
+{
+    return (BCJSONValue){ .document = document, .token = 0 };
+}
+
+BCJSONType
+BCJSONValueGetType(BCJSONValue value)
+{
+    if (value.document == NULL || value.token >= value.document->tokenCount) {
+        return BCJSONTypeInvalid;
+    }
+    const uint8_t *bytes = value.document->bytes + value.document->tokens[value.token];
+    switch (bytes[0]) {
+        case '{': return BCJSONTypeObject;
+        case '[': return BCJSONTypeArray;
+        case '"': return BCJSONTypeString;
+        case 't': return BCJSONLiteralEquals(bytes, "true", 4) ? BCJSONTypeTrue : BCJSONTypeInvalid;
+        case 'f': return BCJSONLiteralEquals(bytes, "false", 5) ? BCJSONTypeFalse : BCJSONTypeInvalid;
+        case 'n': return BCJSONLiteralEquals(bytes, "null", 4) ? BCJSONTypeNull : BCJSONTypeInvalid;
+        case '-': case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+            return BCJSONTypeNumber;
+        default:
+            return BCJSONTypeInvalid;
+    }
+}
+
+bool
+BCJSONIteratorInit(BCJSONIterator *iterator, BCJSONValue container)
+{
+    BCJSONType type = BCJSONValueGetType(container);
+    if (type != BCJSONTypeObject && type != BCJSONTypeArray) {
+        return false;
+    }
+    const BCJSONDocument *document = container.document;
+    iterator->document = document;
+    iterator->isObject = type == BCJSONTypeObject;
+    iterator->next = container.token + 1;
+    iterator->isDone = iterator->next == document->matches[container.token];
+    iterator->isMalformed = false;
+    return true;
+}
+
+bool
+BCJSONIteratorNext(BCJSONIterator *iterator, BCJSONValue *key, BCJSONValue *value)
+{
+    if (iterator->isDone) {
+        return false;
+    }
+    const BCJSONDocument *document = iterator->document;
+    uint32_t token = iterator->next;
+    // Stop here unless a separator follows, so that a malformed container ends the iteration.
+    iterator->isDone = true;
+    iterator->isMalformed = true;
+
+    if (iterator->isObject) {
+        if (token + 2 >= document->tokenCount || BCJSONTokenChar(document, token) != '"' || BCJSONTokenChar(document, token + 1) != ':') {
+            return false;
+        }
+        if (key) {
+            *key = (BCJSONValue){ .document = document, .token = token };
+        }
+        token += 2;
+    } else if (key) {
+        *key = (BCJSONValue){ .document = NULL, .token = BC_JSON_NO_TOKEN };
+    }
+
+    uint8_t c = BCJSONTokenChar(document, token);
+    if (c == ',' || c == ':' || c == '}' || c == ']') {
+        return false;
+    }
+    uint32_t end = BCJSONValueEnd(document, token);
+    if (end + 1 >= document->tokenCount) {
+        return false;
+    }
+
+    uint8_t separator = BCJSONTokenChar(document, end + 1);
+    if (separator == ',') {
+        iterator->next = end + 2;
+        iterator->isDone = false;
+    } else if (separator != (iterator->isObject ? '}' : ']')) {
+        return false;
+    }
+    iterator->isMalformed = false;
+
+    *value = (BCJSONValue){ .document = document, .token = token };
+    return true;
+}
+
+bool
+BCJSONObjectGetMember(BCJSONValue object, const char *key, size_t keyLength, BCJSONValue *member)
+{
+    if (BCJSONValueGetType(object) != BCJSONTypeObject) {
+        return false;
+    }
+    BCJSONIterator iterator;
+    BCJSONIteratorInit(&iterator, object);
+    BCJSONValue name;
+    BCJSONValue value;
+    while (BCJSONIteratorNext(&iterator, &name, &value)) {
+        if (BCJSONStringEquals(name, key, keyLength)) {
+            *member = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t
+BCJSONValueGetCount(BCJSONValue container)
+{
+    BCJSONIterator iterator;
+    if (!BCJSONIteratorInit(&iterator, container)) {
+        return 0;
+    }
+    size_t count = 0;
+    BCJSONValue value;
+    while (BCJSONIteratorNext(&iterator, NULL, &value)) {
+        count++;
+    }
+    return count;
+}
+
+#pragma mark - Numbers
+
+// Checks a number against the JSON grammar and returns its length, or 0 if it is malformed.
+static size_t
+BCJSONNumberLength(const uint8_t *bytes, bool *isInteger)
+{
+    const uint8_t *p = bytes;
+    if (*p == '-') {
+        p++;
+    }
+    if (*p == '0') {
+        p++;
+    } else if (*p >= '1' && *p <= '9') {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    } else {
+        return 0;
+    }
+    *isInteger = true;
+    if (*p == '.') {
+        *isInteger = false;
+        p++;
+        if (*p < '0' || *p > '9') {
+            return 0;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if (*p == 'e' || *p == 'E') {
+        *isInteger = false;
+        p++;
+        if (*p == '+' || *p == '-') {
+            p++;
+        }
+        if (*p < '0' || *p > '9') {
+            return 0;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    return BCJSONIsDelimiter(*p) ? (size_t)(p - bytes) : 0;
+}
+
+static const uint8_t *
+BCJSONNumberBytes(BCJSONValue value, size_t *length, bool *isInteger)
+{
+    if (BCJSONValueGetType(value) != BCJSONTypeNumber) {
+        return NULL;
+    }
+    const uint8_t *bytes = value.document->bytes + value.document->tokens[value.token];
+    *length = BCJSONNumberLength(bytes, isInteger);
+    return *length > 0 ? bytes : NULL;
+}
+
+bool
+BCJSONValueGetUInt64(BCJSONValue value, uint64_t *result)
+{
+    size_t length;
+    bool isInteger;
+    const uint8_t *bytes = BCJSONNumberBytes(value, &length, &isInteger);
+    if (bytes == NULL || !isInteger || bytes[0] == '-') {
+        return false;
+    }
+    uint64_t number = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (__builtin_mul_overflow(number, 10, &number) || __builtin_add_overflow(number, (uint64_t)(bytes[i] - '0'), &number)) {
+            return false;
+        }
+    }
+    *result = number;
+    return true;
+}
+
+bool
+BCJSONValueGetInt64(BCJSONValue value, int64_t *result)
+{
+    size_t length;
+    bool isInteger;
+    const uint8_t *bytes = BCJSONNumberBytes(value, &length, &isInteger);
+    if (bytes == NULL || !isInteger) {
+        return false;
+    }
+    bool isNegative = bytes[0] == '-';
+    uint64_t magnitude = 0;
+    for (size_t i = isNegative ? 1 : 0; i < length; i++) {
+        if (__builtin_mul_overflow(magnitude, 10, &magnitude) || __builtin_add_overflow(magnitude, (uint64_t)(bytes[i] - '0'), &magnitude)) {
+            return false;
+        }
+    }
+    if (magnitude > (isNegative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX)) {
+        return false;
+    }
+    *result = isNegative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    return true;
+}
+
+bool
+BCJSONValueGetDouble(BCJSONValue value, double *result)
+{
+    size_t length;
+    bool isInteger;
+    const uint8_t *bytes = BCJSONNumberBytes(value, &length, &isInteger);
+    if (bytes == NULL) {
+        return false;
+    }
+    // The number is followed by a delimiter, so strtod stops at its end.
+    char *end = NULL;
+    double number = strtod((const char *)bytes, &end);
+    if (end != (const char *)bytes + length) {
+        return false;
+    }
+    *result = number;
+    return true;
+}
+
+bool
+BCJSONValueGetBool(BCJSONValue value, bool *result)
+{
+    switch (BCJSONValueGetType(value)) {
+        case BCJSONTypeTrue:
+            *result = true;
+            return true;
+        case BCJSONTypeFalse:
+            *result = false;
+            return true;
+        default:
+            return false;
+    }
+}
+
+#pragma mark - Strings
+
+bool
+BCJSONStringGetRaw(BCJSONValue value, const char **bytes, size_t *length, bool *hasEscapes)
+{
+    if (BCJSONValueGetType(value) != BCJSONTypeString) {
+        return false;
+    }
+    const BCJSONDocument *document = value.document;
+    const uint8_t *start = document->bytes + document->tokens[value.token] + 1;
+    const uint8_t *end = document->bytes + document->length;
+    bool escapes = false;
+
+    // Stage one guarantees the string is terminated.
+    const uint8_t *p = start;
+    for (;;) {
+        const uint8_t *quote = memchr(p, '"', (size_t)(end - p));
+        if (quote == NULL) {
+            return false;
+        }
+        const uint8_t *backslash = quote;
+        while (backslash > start && backslash[-1] == '\\') {
+            backslash--;
+        }
+        if (backslash != quote) {
+            escapes = true;
+        }
+        if ((quote - backslash) % 2 == 0) {
+            if (!escapes && memchr(start, '\\', (size_t)(quote - start)) != NULL) {
+                escapes = true;
+            }
+            *bytes = (const char *)start;
+            *length = (size_t)(quote - start);
+            if (hasEscapes) {
+                *hasEscapes = escapes;
+            }
+            return true;
+        }
+        p = quote + 1;
+    }
+}
+
+static int
+BCJSONHexValue(uint8_t c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static bool
+BCJSONReadHex4(const uint8_t *p, const uint8_t *end, uint32_t *result)
+{
+    if (end - p < 4) {
+        return false;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = BCJSONHexValue(p[i]);
+        if (digit < 0) {
+            return false;
+        }
+        value = (value << 4) | (uint32_t)digit;
+    }
+    *result = value;
+    return true;
+}
+
+static size_t
+BCJSONEncodeUTF8(uint32_t codePoint, uint8_t *out)
+{
+    if (codePoint < 0x80) {
+        out[0] = (uint8_t)codePoint;
+        return 1;
+    }
+    if (codePoint < 0x800) {
+        out[0] = (uint8_t)(0xc0 | (codePoint >> 6));
+        out[1] = (uint8_t)(0x80 | (codePoint & 0x3f));
+        return 2;
+    }
+    if (codePoint < 0x10000) {
+        out[0] = (uint8_t)(0xe0 | (codePoint >> 12));
+        out[1] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3f));
+        out[2] = (uint8_t)(0x80 | (codePoint & 0x3f));
+        return 3;
+    }
+    out[0] = (uint8_t)(0xf0 | (codePoint >> 18));
+    out[1] = (uint8_t)(0x80 | ((codePoint >> 12) & 0x3f));
+    out[2] = (uint8_t)(0x80 | ((codePoint >> 6) & 0x3f));
+    out[3] = (uint8_t)(0x80 | (codePoint & 0x3f));
+    return 4;
+}
+
+// Unescapes `length` raw bytes into `out`, which must hold at least `length` bytes.
+static size_t
+BCJSONUnescape(const uint8_t *raw, size_t length, uint8_t *out)
+{
+    const uint8_t *p = raw;
+    const uint8_t *end = raw + length;
+    uint8_t *o = out;
+
+    while (p < end) {
+        if (*p < 0x20) {
+            return SIZE_MAX;
+        }
+        if (*p != '\\') {
+            *o++ = *p++;
+            continue;
+        }
+        if (++p == end) {
+            return SIZE_MAX;
+        }
+        switch (*p++) {
+            case '"': *o++ = '"'; break;
+            case '\\': *o++ = '\\'; break;
+            case '/': *o++ = '/'; break;
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'n': *o++ = '\n'; break;
+            case 'r': *o++ = '\r'; break;
+            case 't': *o++ = '\t'; break;
+            case 'u': {
+                uint32_t codePoint;
+                if (!BCJSONReadHex4(p, end, &codePoint)) {
+                    return SIZE_MAX;
+                }
+                p += 4;
+                if (codePoint >= 0xd800 && codePoint < 0xdc00) {
+                    uint32_t low;
+                    if (end - p < 6 || p[0] != '\\' || p[1] != 'u' || !BCJSONReadHex4(p + 2, end, &low) || low < 0xdc00 || low > 0xdfff) {
+                        return SIZE_MAX;
+                    }
+                    p += 6;
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                } else if (codePoint >= 0xdc00 && codePoint <= 0xdfff) {
+                    return SIZE_MAX;
+                }
+                // An escape takes 6 bytes (12 for a surrogate pair) and encodes to at most 4, so `out` cannot overflow.
+                o += BCJSONEncodeUTF8(codePoint, o);
+                break;
+            }
+            default:
+                return SIZE_MAX;
+        }
+    }
+    return (size_t)(o - out);
+}
+
+size_t
+BCJSONStringCopy(BCJSONValue value, char *buffer, size_t capacity)
+{
+    const char *raw;
+    size_t length;
+    bool hasEscapes;
+    if (!BCJSONStringGetRaw(value, &raw, &length, &hasEscapes) || capacity <= length) {
+        return SIZE_MAX;
+    }
+    if (!hasEscapes) {
+        for (size_t i = 0; i < length; i++) {
+            if ((uint8_t)raw[i] < 0x20) {
+                return SIZE_MAX;
+            }
+        }
+        memcpy(buffer, raw, length);
+        buffer[length] = '\0';
+        return length;
+    }
+    size_t unescaped = BCJSONUnescape((const uint8_t *)raw, length, (uint8_t *)buffer);
+    if (unescaped != SIZE_MAX) {
+        buffer[unescaped] = '\0';
+    }
+    return unescaped;
+}
+
+bool
+BCJSONStringEquals(BCJSONValue value, const char *string, size_t length)
+{
+    const char *raw;
+    size_t rawLength;
+    bool hasEscapes;
+    if (!BCJSONStringGetRaw(value, &raw, &rawLength, &hasEscapes)) {
+        return false;
+    }
+    if (!hasEscapes) {
+        return rawLength == length && memcmp(raw, string, length) == 0;
+    }
+    // Escapes only ever make a string longer.
+    if (rawLength < length) {
+        return false;
+    }
+    char stackBuffer[256];
+    char *buffer = rawLength < sizeof(stackBuffer) ? stackBuffer : malloc(rawLength + 1);
+    if (buffer == NULL) {
+        return false;
+    }
+    size_t unescaped = BCJSONStringCopy(value, buffer, rawLength + 1);
+    bool isEqual = unescaped == length && memcmp(buffer, string, length) == 0;
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    return isEqual;
+}
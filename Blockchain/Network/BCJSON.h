@@ -0,0 +1,101 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef BCJSON_h
+#define BCJSON_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * An on-demand JSON parser.
+ *
+ * Parsing is split in two stages. Stage one classifies the input 64 bytes at a time with SIMD
+ * compares (NEON on device, SSE2 on the simulator) and bit arithmetic, producing the offsets of
+ * every structural character and value start. Stage two only matches brackets.
+ *
+ * Values are then read on demand straight from the input bytes: looking up a member skips over
+ * the values before it without materializing them, and scalars are only decoded when asked for.
+ * Only the parts of the document that are read are checked against the JSON grammar.
+ */
+
+typedef enum {
+    BCJSONTypeInvalid = 0,
+    BCJSONTypeObject,
+    BCJSONTypeArray,
+    BCJSONTypeString,
+    BCJSONTypeNumber,
+    BCJSONTypeTrue,
+    BCJSONTypeFalse,
+    BCJSONTypeNull,
+} BCJSONType;
+
+typedef struct BCJSONDocument BCJSONDocument;
+
+/// A value of a document, only valid for the lifetime of the document.
+typedef struct {
+    const BCJSONDocument *document;
+    uint32_t token;
+} BCJSONValue;
+
+/// Iterates over the members of an object or the elements of an array.
+typedef struct {
+    const BCJSONDocument *document;
+    uint32_t next;
+    bool isObject;
+    bool isDone;
+    /// Set when iteration stopped on malformed input rather than at the end of the container.
+    bool isMalformed;
+} BCJSONIterator;
+
+/// Parses `bytes`. Returns NULL if out of memory, if the input exceeds 4 GB, or if it is not a
+/// single JSON value with balanced brackets and terminated strings.
+BCJSONDocument *BCJSONDocumentCreate(const void *bytes, size_t length);
+
+void BCJSONDocumentDestroy(BCJSONDocument *document);
+
+BCJSONValue BCJSONDocumentGetRoot(const BCJSONDocument *document);
+
+BCJSONType BCJSONValueGetType(BCJSONValue value);
+
+/// Finds the member `key` of `object`. Returns false if it is not an object or has no such member.
+bool BCJSONObjectGetMember(BCJSONValue object, const char *key, size_t keyLength, BCJSONValue *member);
+
+/// Starts iterating over `container`. Returns false if it is neither an object nor an array.
+bool BCJSONIteratorInit(BCJSONIterator *iterator, BCJSONValue container);
+
+/// Moves to the next member or element. `key` receives the member name of objects and may be NULL.
+/// Returns false at the end, or if the container is malformed.
+bool BCJSONIteratorNext(BCJSONIterator *iterator, BCJSONValue *key, BCJSONValue *value);
+
+/// Number of members or elements of `container`, 0 if it is neither an object nor an array.
+size_t BCJSONValueGetCount(BCJSONValue container);
+
+/// Reads an integer number. Returns false for fractions, exponents, out of range or malformed numbers.
+bool BCJSONValueGetInt64(BCJSONValue value, int64_t *result);
+bool BCJSONValueGetUInt64(BCJSONValue value, uint64_t *result);
+
+/// Reads any number.
+bool BCJSONValueGetDouble(BCJSONValue value, double *result);
+
+bool BCJSONValueGetBool(BCJSONValue value, bool *result);
+
+/// The bytes between the quotes of a string, escapes included. `hasEscapes` may be NULL.
+bool BCJSONStringGetRaw(BCJSONValue value, const char **bytes, size_t *length, bool *hasEscapes);
+
+/// Unescapes a string into `buffer` as NUL terminated UTF-8. A capacity of the raw length plus one
+/// is always enough. Returns the length, or SIZE_MAX if it is not a valid string or does not fit.
+size_t BCJSONStringCopy(BCJSONValue value, char *buffer, size_t capacity);
+
+/// Compares a string to the UTF-8 bytes of `string`, resolving escapes.
+bool BCJSONStringEquals(BCJSONValue value, const char *string, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BCJSON_h */
@@ -44,4 +44,8 @@
 
 @interface ModuleXMLHttpRequest: NSObject <ExportXMLHttpRequest>
 
+/// Honours `async` for the requests opened while `block` runs, which are otherwise sent
+/// synchronously. Must be called on the main queue.
++ (void)sendAsynchronouslyDuring:(void (NS_NOESCAPE ^)(void))block;
+
 @end
@@ -23,9 +23,16 @@
  THE SOFTWARE.
 */
 #import "ModuleXMLHttpRequest.h"
+#import "BCBridgeTrace.h"
 #import "NSURLSession+SendSynchronousRequest.h"
 #import "Blockchain-Swift.h"
 
+/// Matches the wait of a synchronous send.
+static const NSTimeInterval ModuleXMLHttpRequestTimeout = 30;
+
+/// How many `sendAsynchronouslyDuring:` blocks are running; only touched on the main queue.
+static NSUInteger ModuleXMLHttpRequestAsyncDepth = 0;
+
 @implementation ModuleXMLHttpRequest
 {
     NSString* _method;
@@ -48,11 +55,35 @@
     return error;
 }
 
+/// Records a send in the bridge trace under its method, host and first path component, so
+/// requests to one endpoint add up whatever their ids and query.
++ (void)traceRequest:(NSURLRequest *)request start:(uint64_t)start responseLength:(NSUInteger)responseLength
+{
+#if BC_BRIDGE_TRACE
+    if (!BCBridgeTraceIsEnabled()) {
+        return;
+    }
+    NSArray<NSString *> *components = request.URL.pathComponents;
+    NSString *endpoint = components.count > 1 ? components[1] : @"";
+    NSString *name = [NSString stringWithFormat:@"XMLHttpRequest %@ %@/%@", request.HTTPMethod, request.URL.host ?: @"", endpoint];
+    const char *utf8 = name.UTF8String;
+    BCBridgeTraceRecord(BCBridgeTraceSiteForName(utf8, strlen(utf8)), start, BCBridgeTraceNow(), request.HTTPBody.length + responseLength);
+#endif
+}
+
++ (void)sendAsynchronouslyDuring:(void (NS_NOESCAPE ^)(void))block
+{
+    ModuleXMLHttpRequestAsyncDepth++;
+    block();
+    ModuleXMLHttpRequestAsyncDepth--;
+}
+
 -(void)open:(NSString*)httpMethod :(NSString*)url :(bool)async;
 {
     _method = httpMethod;
     _url = url;
-    _async = async;
+    // Callers outside sendAsynchronouslyDuring: still expect the response before send returns.
+    _async = async && ModuleXMLHttpRequestAsyncDepth > 0;
 }
 
 -(void)setOnload:(JSValue *)onload
@@ -85,26 +116,52 @@
 
     req.HTTPMethod = _method;
 
-    NSError *error = nil;
-    if ([Reachability hasInternetConnection]) {
+    if (![Reachability hasInternetConnection]) {
+        [self completeWithData:nil response:nil];
+        return;
+    }
+
+    uint64_t start = BCBridgeTraceNow();
+    if (!_async) {
         SynchronousRequestResponse *response = [NSURLSession sendSynchronousRequest:req
                                                                             session:NetworkDependenciesObjc.session
                                                                  sessionDescription:req.URL.host];
-        if (response.data != nil) {
-            status = response.response.statusCode;
-            self.responseText = [[NSString alloc] initWithData:response.data encoding:NSUTF8StringEncoding];
-            _responseHeaders = response.response.allHeaderFields;
-        } else {
-            error = [ModuleXMLHttpRequest networkConnectivityError];
-        }
+        [ModuleXMLHttpRequest traceRequest:req start:start responseLength:response.data.length];
+        [self completeWithData:response.data response:response.response];
+        return;
+    }
+
+    // Asynchronous requests run side by side instead of blocking the JS thread one after the
+    // other. Like the JS timers, their callbacks come back on the main queue.
+    req.timeoutInterval = ModuleXMLHttpRequestTimeout;
+    NSURLSessionDataTask *task = [NetworkDependenciesObjc.session dataTaskWithRequest:req completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+        [ModuleXMLHttpRequest traceRequest:req start:start responseLength:data.length];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self completeWithData:data response:(NSHTTPURLResponse *)response];
+        });
+    }];
+    // The session is shared with requests in flight, so the host goes on the task instead.
+    task.taskDescription = req.URL.host;
+    [task resume];
+}
+
+/// Sets the response, or a connectivity error if there is no data, and calls onload or onerror.
+- (void)completeWithData:(NSData *)data response:(NSHTTPURLResponse *)response
+{
+    NSError *error = nil;
+    if (data != nil) {
+        status = response.statusCode;
+        self.responseText = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+        _responseHeaders = response.allHeaderFields;
     } else {
         error = [ModuleXMLHttpRequest networkConnectivityError];
     }
-    
+
     if (!error && _onLoad) {
         [[_onLoad.value invokeMethod:@"bind" withArguments:@[self]] callWithArguments:NULL];
     } else if (error && _onError) {
-        [[_onError.value invokeMethod:@"bind" withArguments:@[self]] callWithArguments:@[[JSValue valueWithNewErrorFromMessage:error.localizedDescription inContext:[JSContext currentContext]]]];
+        JSValue *onError = _onError.value;
+        [[onError invokeMethod:@"bind" withArguments:@[self]] callWithArguments:@[[JSValue valueWithNewErrorFromMessage:error.localizedDescription inContext:onError.context]]];
     }
 }
 
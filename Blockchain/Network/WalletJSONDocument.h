@@ -0,0 +1,40 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import <Foundation/Foundation.h>
+#import "BCJSON.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A JSON document parsed with the on-demand parser in BCJSON.h.
+///
+/// Nothing is converted to Foundation objects up front: callers look up the members they need and
+/// only those are decoded. `objectValue` converts the whole document, like NSJSONSerialization.
+/// Values are only valid while the document that returned them is alive.
+@interface WalletJSONDocument : NSObject
+
+/// Parses the UTF-8 representation of `string`. Returns nil if it is not valid JSON.
++ (nullable instancetype)documentWithString:(NSString *)string;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+@property (nonatomic, readonly) BCJSONValue root;
+
+/// The whole document as Foundation objects, with mutable containers. Nil if any part of it is malformed.
+@property (nonatomic, readonly, nullable) id objectValue;
+
+/// The member `key` of `object`, or an invalid value if there is none.
+- (BCJSONValue)memberNamed:(NSString *)key ofObject:(BCJSONValue)object;
+
+/// `value` as Foundation objects, with mutable containers. Nil if it is malformed.
+- (nullable id)objectForValue:(BCJSONValue)value;
+
+/// `value` if it is a string, otherwise nil.
+- (nullable NSString *)stringForValue:(BCJSONValue)value;
+
+/// Calls `block` with each member of an object, or with each element of an array and a nil key.
+/// Returns NO if `container` is neither, or is malformed.
+- (BOOL)enumerateValue:(BCJSONValue)container usingBlock:(void (NS_NOESCAPE ^)(NSString * _Nullable key, BCJSONValue value, BOOL *stop))block;
+
+@end
+
+NS_ASSUME_NONNULL_END
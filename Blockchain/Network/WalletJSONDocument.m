@@ -0,0 +1,171 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#import "WalletJSONDocument.h"
+
+// Strings up to this length are unescaped on the stack.
+#define WALLET_JSON_STACK_STRING_LENGTH 256
+
+@interface WalletJSONDocument ()
+
+- (instancetype)initWithDocument:(BCJSONDocument *)document NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@implementation WalletJSONDocument
+{
+    BCJSONDocument *_document;
+}
+
++ (instancetype)documentWithString:(NSString *)string
+{
+    // UTF8String avoids the intermediate NSData of -dataUsingEncoding:, and is usually not a copy.
+    const char *bytes = string.UTF8String;
+    if (bytes == NULL) {
+        return nil;
+    }
+    BCJSONDocument *document = BCJSONDocumentCreate(bytes, strlen(bytes));
+    return document ? [[self alloc] initWithDocument:document] : nil;
+}
+
+- (instancetype)initWithDocument:(BCJSONDocument *)document
+{
+    self = [super init];
+    if (self) {
+        _document = document;
+    }
+    return self;
+}
+
+- (void)dealloc
+{
+    BCJSONDocumentDestroy(_document);
+}
+
+- (BCJSONValue)root
+{
+    return BCJSONDocumentGetRoot(_document);
+}
+
+- (id)objectValue
+{
+    return [self objectForValue:self.root];
+}
+
+- (BCJSONValue)memberNamed:(NSString *)key ofObject:(BCJSONValue)object
+{
+    BCJSONValue member;
+    const char *bytes = key.UTF8String;
+    if (bytes == NULL || !BCJSONObjectGetMember(object, bytes, strlen(bytes), &member)) {
+        return (BCJSONValue){ .document = NULL, .token = 0 };
+    }
+    return member;
+}
+
+- (NSString *)stringForValue:(BCJSONValue)value
+{
+    const char *raw;
+    size_t length;
+    bool hasEscapes;
+    if (!BCJSONStringGetRaw(value, &raw, &length, &hasEscapes)) {
+        return nil;
+    }
+    if (!hasEscapes) {
+        return [[NSString alloc] initWithBytes:raw length:length encoding:NSUTF8StringEncoding];
+    }
+
+    char stackBuffer[WALLET_JSON_STACK_STRING_LENGTH];
+    char *buffer = length < sizeof(stackBuffer) ? stackBuffer : malloc(length + 1);
+    if (buffer == NULL) {
+        return nil;
+    }
+    NSString *string = nil;
+    size_t unescaped = BCJSONStringCopy(value, buffer, length + 1);
+    if (unescaped != SIZE_MAX) {
+        string = [[NSString alloc] initWithBytes:buffer length:unescaped encoding:NSUTF8StringEncoding];
+    }
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+    return string;
+}
+
+- (id)objectForValue:(BCJSONValue)value
+{
+    switch (BCJSONValueGetType(value)) {
+        case BCJSONTypeObject: {
+            NSMutableDictionary *dictionary = [NSMutableDictionary new];
+            __block BOOL isComplete = YES;
+            BOOL isValid = [self enumerateValue:value usingBlock:^(NSString *key, BCJSONValue member, BOOL *stop) {
+                id object = [self objectForValue:member];
+                if (object == nil) {
+                    isComplete = NO;
+                    *stop = YES;
+                    return;
+                }
+                // The last of duplicate keys wins.
+                dictionary[key] = object;
+            }];
+            return isValid && isComplete ? dictionary : nil;
+        }
+        case BCJSONTypeArray: {
+            NSMutableArray *array = [NSMutableArray new];
+            __block BOOL isComplete = YES;
+            BOOL isValid = [self enumerateValue:value usingBlock:^(NSString *key, BCJSONValue element, BOOL *stop) {
+                id object = [self objectForValue:element];
+                if (object == nil) {
+                    isComplete = NO;
+                    *stop = YES;
+                    return;
+                }
+                [array addObject:object];
+            }];
+            return isValid && isComplete ? array : nil;
+        }
+        case BCJSONTypeString:
+            return [self stringForValue:value];
+        case BCJSONTypeNumber: {
+            int64_t integer;
+            if (BCJSONValueGetInt64(value, &integer)) {
+                return @(integer);
+            }
+            uint64_t unsignedInteger;
+            if (BCJSONValueGetUInt64(value, &unsignedInteger)) {
+                return @(unsignedInteger);
+            }
+            double number;
+            return BCJSONValueGetDouble(value, &number) ? @(number) : nil;
+        }
+        case BCJSONTypeTrue:
+            return @YES;
+        case BCJSONTypeFalse:
+            return @NO;
+        case BCJSONTypeNull:
+            return [NSNull null];
+        case BCJSONTypeInvalid:
+            return nil;
+    }
+}
+
+- (BOOL)enumerateValue:(BCJSONValue)container usingBlock:(void (NS_NOESCAPE ^)(NSString *, BCJSONValue, BOOL *))block
+{
+    BCJSONIterator iterator;
+    if (!BCJSONIteratorInit(&iterator, container)) {
+        return NO;
+    }
+    BCJSONValue key;
+    BCJSONValue value;
+    BOOL stop = NO;
+    while (!stop && BCJSONIteratorNext(&iterator, &key, &value)) {
+        NSString *name = nil;
+        if (iterator.isObject) {
+            name = [self stringForValue:key];
+            if (name == nil) {
+                return NO;
+            }
+        }
+        block(name, value, &stop);
+    }
+    return !iterator.isMalformed;
+}
+
+@end
@@ -0,0 +1,78 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import Foundation
+import ToolKit
+import UIKit
+
+/// Turns the JS bridge trace on in internal builds and writes it to the caches directory each time
+/// the app goes to the background: `bridge_trace.json` with count, total, p50, p99 and bytes per
+/// call site, and `bridge_trace_chrome.json` with the latest calls, for chrome://tracing.
+@objc final class BridgeTraceReporter: NSObject {
+
+    private static let summaryFileName = "bridge_trace.json"
+    private static let chromeTraceFileName = "bridge_trace_chrome.json"
+    /// Sites logged on each write, slowest in total first.
+    private static let loggedSiteCount = 10
+
+    private static var observer: NSObjectProtocol?
+
+    /// Called once the wallet is created; does nothing in release builds.
+    @objc static func start() {
+        #if DEBUG || INTERNAL_BUILD
+        guard observer == nil else {
+            return
+        }
+        BCBridgeTraceSetEnabled(true)
+        observer = NotificationCenter.default.addObserver(
+            forName: UIApplication.didEnterBackgroundNotification,
+            object: nil,
+            queue: .main
+        ) { _ in
+            DispatchQueue.global(qos: .utility).async {
+                writeReports()
+            }
+        }
+        #endif
+    }
+
+    /// The per-site summary as JSON.
+    @objc static func summaryJSON() -> String? {
+        string(from: BCBridgeTraceCopyJSON(nil))
+    }
+
+    /// The latest calls of every thread in the Chrome trace event format.
+    @objc static func chromeTrace() -> String? {
+        string(from: BCBridgeTraceCopyChromeTrace(nil))
+    }
+
+    private static func string(from bytes: UnsafeMutablePointer<CChar>?) -> String? {
+        guard let bytes = bytes else {
+            return nil
+        }
+        defer { free(bytes) }
+        return String(cString: bytes)
+    }
+
+    private static func writeReports() {
+        guard let directory = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first else {
+            return
+        }
+        for (fileName, report) in [(summaryFileName, summaryJSON()), (chromeTraceFileName, chromeTrace())] {
+            do {
+                try report?.write(to: directory.appendingPathComponent(fileName), atomically: true, encoding: .utf8)
+            } catch {
+                Logger.shared.error(error)
+            }
+        }
+
+        var summaries = [BCBridgeTraceSummary](repeating: BCBridgeTraceSummary(), count: loggedSiteCount)
+        let count = min(BCBridgeTraceCopySummaries(&summaries, summaries.count), summaries.count)
+        for summary in summaries.prefix(count) {
+            let name = summary.name.map { String(cString: $0) } ?? ""
+            Logger.shared.debug(
+                "[bridge] \(name) count=\(summary.count) total_us=\(summary.totalNanoseconds / 1000)"
+                    + " p50_us=\(summary.p50Nanoseconds / 1000) p99_us=\(summary.p99Nanoseconds / 1000) bytes=\(summary.bytes)"
+            )
+        }
+    }
+}
@@ -0,0 +1,36 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import FirebasePerformance
+import Foundation
+import PlatformUIKit
+import ToolKit
+
+/// Receives the per-phase numbers of each scrypt derivation from `Wallet`
+/// and reports them as one trace, so latency can be broken down by device.
+@objc final class ScryptMetrics: NSObject {
+
+    private static let traceName = "ios_trace_scrypt"
+
+    /// Records one derivation.
+    /// - Parameters:
+    ///   - metrics: metric names, e.g. `smix_mix_us`, to their values.
+    ///   - parameters: the scrypt parameters, e.g. `N=16384,r=8,p=1`.
+    @objc static func record(_ metrics: [String: NSNumber], parameters: String) {
+        #if DEBUG || INTERNAL_BUILD
+        let values = metrics
+            .sorted { $0.key < $1.key }
+            .map { "\($0.key)=\($0.value)" }
+            .joined(separator: " ")
+        Logger.shared.debug("[scrypt] \(parameters) \(values)")
+        #endif
+        guard let trace = Performance.startTrace(name: traceName) else {
+            return
+        }
+        trace.setValue(UIDevice.current.modelName, forAttribute: "device_class")
+        trace.setValue(parameters, forAttribute: "parameters")
+        for (name, value) in metrics {
+            trace.setValue(value.int64Value, forMetric: name)
+        }
+        trace.stop()
+    }
+}
@@ -0,0 +1,132 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _ADDRCODEC_H_
+#define _ADDRCODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * String encodings of Bitcoin and Bitcoin Cash addresses: Base58Check for
+ * legacy addresses, Bech32 and Bech32m for segwit addresses, and CashAddr.
+ * Base58 works on 32-bit limbs, five digits per multiply or divide, and the
+ * BCH checksums of Bech32 and CashAddr use per-symbol tables.  Functions
+ * writing a string take the size of out, NUL included, and return the
+ * length of the string; decoders return the number of bytes decoded.  All
+ * return -1 if the input is not valid or out is too small.
+ */
+
+/* Largest payload the Base58 functions accept, checksum included. */
+#define ADDRCODEC_MAX_PAYLOAD	132
+
+/* Room for any string these functions write, NUL included. */
+#define ADDRCODEC_MAX_STRING	192
+
+/* Version bytes of legacy mainnet addresses. */
+#define ADDRCODEC_VERSION_P2PKH	0x00
+#define ADDRCODEC_VERSION_P2SH	0x05
+
+/**
+ * base58_encode(in, len, out, outlen), base58_decode(str, out, outlen):
+ * Convert between bytes and Base58, without a checksum.
+ */
+int	base58_encode(const uint8_t *, size_t, char *, size_t);
+int	base58_decode(const char *, uint8_t *, size_t);
+
+/**
+ * base58check_encode(in, len, out, outlen):
+ * Encode in, normally a version byte and a hash, followed by the first four
+ * bytes of its sha256d.
+ */
+int	base58check_encode(const uint8_t *, size_t, char *, size_t);
+
+/**
+ * base58check_decode(str, out, outlen):
+ * Decode str and check and strip its checksum.
+ */
+int	base58check_decode(const char *, uint8_t *, size_t);
+
+typedef enum {
+	BECH32_ENCODING_BECH32 = 1,
+	BECH32_ENCODING_BECH32M
+} bech32_encoding;
+
+/**
+ * segwit_addr_encode(hrp, witver, prog, proglen, out, outlen):
+ * Encode a witness program as a segwit address with human-readable part
+ * hrp: Bech32 for version 0, Bech32m for later versions.
+ */
+int	segwit_addr_encode(const char *, int, const uint8_t *, size_t, char *,
+    size_t);
+
+/**
+ * segwit_addr_decode(hrp, addr, witver, prog, proglen):
+ * Decode a segwit address, which must have human-readable part hrp and the
+ * encoding its version calls for, into its version and program.
+ */
+int	segwit_addr_decode(const char *, const char *, int *, uint8_t *, size_t);
+
+typedef enum {
+	CASHADDR_P2PKH = 0,
+	CASHADDR_P2SH = 1
+} cashaddr_type;
+
+/**
+ * cashaddr_encode(prefix, type, hash, hashlen, out, outlen):
+ * Encode hash, of 20, 24, 28, 32, 40, 48, 56 or 64 bytes, as a CashAddr
+ * with the given prefix, such as "bitcoincash".
+ */
+int	cashaddr_encode(const char *, cashaddr_type, const uint8_t *, size_t,
+    char *, size_t);
+
+/**
+ * cashaddr_decode(prefix, addr, type, hash, hashlen):
+ * Decode a CashAddr, written with or without prefix, into its type and hash.
+ */
+int	cashaddr_decode(const char *, const char *, cashaddr_type *, uint8_t *,
+    size_t);
+
+/**
+ * cashaddr_to_legacy(prefix, addr, out, outlen):
+ * Convert a CashAddr with a 20-byte hash into the Base58Check address of
+ * the same key or script.
+ */
+int	cashaddr_to_legacy(const char *, const char *, char *, size_t);
+
+/**
+ * legacy_to_cashaddr(prefix, addr, out, outlen):
+ * Convert a legacy P2PKH or P2SH address into a CashAddr.
+ */
+int	legacy_to_cashaddr(const char *, const char *, char *, size_t);
+
+/*
+ * The batch functions below handle n items per call.  Item i of out starts
+ * at out + i * stride, and a string item is left empty if it fails.  Each
+ * returns the number of items that succeeded.
+ */
+
+/**
+ * base58check_encode_batch(in, len, n, out, stride):
+ * Encode the n payloads of len bytes each stored back to back in in.
+ */
+size_t	base58check_encode_batch(const uint8_t *, size_t, size_t, char *,
+    size_t);
+
+/**
+ * base58check_decode_batch(strs, n, out, stride, lens):
+ * Decode strs[0 .. n - 1], storing each payload length, or -1, in lens.
+ */
+size_t	base58check_decode_batch(const char * const *, size_t, uint8_t *,
+    size_t, int *);
+
+/**
+ * cashaddr_to_legacy_batch(prefix, addrs, n, out, stride),
+ * legacy_to_cashaddr_batch(prefix, addrs, n, out, stride):
+ * Convert addrs[0 .. n - 1] as cashaddr_to_legacy and legacy_to_cashaddr do.
+ */
+size_t	cashaddr_to_legacy_batch(const char *, const char * const *, size_t,
+    char *, size_t);
+size_t	legacy_to_cashaddr_batch(const char *, const char * const *, size_t,
+    char *, size_t);
+
+#endif /* !_ADDRCODEC_H_ */
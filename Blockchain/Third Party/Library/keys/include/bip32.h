@@ -0,0 +1,90 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _BIP32_H_
+#define _BIP32_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * BIP32 hierarchical deterministic keys over eckey.  HMAC-SHA512 keyed with
+ * a node's chain code is set up once per node and reused for every child,
+ * and the public children of a node are derived in batches that share one
+ * field inversion.  Functions return 0 on success or -1 on invalid input or
+ * if the derived key is invalid, which BIP32 leaves to the caller to skip.
+ */
+
+#define BIP32_HARDENED		0x80000000U
+
+/* Mainnet serialization versions. */
+#define BIP32_VERSION_XPUB	0x0488B21EU
+#define BIP32_VERSION_XPRV	0x0488ADE4U
+
+typedef struct {
+	uint8_t depth;
+	uint8_t parent_fingerprint[4];
+	uint32_t child;
+	uint8_t chain_code[32];
+	uint8_t pubkey[33];
+	/* Only meaningful if has_seckey. */
+	uint8_t seckey[32];
+	int has_seckey;
+} bip32_node;
+
+/**
+ * bip32_from_seed(seed, seedlen, node):
+ * Compute the master node of seed, of 16 to 64 bytes.
+ */
+int	bip32_from_seed(const uint8_t *, size_t, bip32_node *);
+
+/**
+ * bip32_ckd(parent, index, child):
+ * Derive child number index of parent: from the secret key if parent has
+ * one, from the public key otherwise, which cannot derive hardened children.
+ */
+int	bip32_ckd(const bip32_node *, uint32_t, bip32_node *);
+
+/**
+ * bip32_derive_path(node, path, depth, out):
+ * Derive out from node along the depth child numbers of path.
+ */
+int	bip32_derive_path(const bip32_node *, const uint32_t *, size_t,
+    bip32_node *);
+
+/**
+ * bip32_neuter(node):
+ * Drop the secret key of node, leaving its public node.
+ */
+void	bip32_neuter(bip32_node *);
+
+/**
+ * bip32_wipe(node):
+ * Zero node, secret key included.
+ */
+void	bip32_wipe(bip32_node *);
+
+/**
+ * bip32_serialize(node, private, out, outlen):
+ * Write node as an xprv if private is non-zero and node has a secret key,
+ * or as an xpub otherwise, and return the length of the string.
+ */
+int	bip32_serialize(const bip32_node *, int, char *, size_t);
+
+/**
+ * bip32_parse(str, node):
+ * Parse an xpub or xprv string into node.
+ */
+int	bip32_parse(const char *, bip32_node *);
+
+/**
+ * bip32_ckd_pub_batch(parent, first, n, pubkeys, hash160s, ok):
+ * Derive the public keys of the n non-hardened children of parent numbered
+ * first onwards, writing them back to back to pubkeys, and their hash160s
+ * to hash160s unless it is NULL.  Set ok[i] to 0, or to -1 for an index
+ * BIP32 says to skip.  Return the number derived, or (size_t)(-1) on
+ * invalid input or if memory runs out.
+ */
+size_t	bip32_ckd_pub_batch(const bip32_node *, uint32_t, size_t, uint8_t *,
+    uint8_t *, int *);
+
+#endif /* !_BIP32_H_ */
@@ -29,6 +29,7 @@
 #ifndef _CRYPTO_SCRYPT_H_
 #define _CRYPTO_SCRYPT_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -43,4 +44,119 @@
 int crypto_scrypt(const uint8_t *, size_t, const uint8_t *, size_t, uint64_t,
     uint32_t, uint32_t, uint8_t *, size_t);
 
+/* Scratch memory kept across crypto_scrypt_r calls. */
+typedef struct {
+	void * base;
+	size_t size;
+} crypto_scrypt_local_t;
+
+/**
+ * crypto_scrypt_init_local(local):
+ * Initialize local to hold no memory yet.  Return 0.
+ */
+int crypto_scrypt_init_local(crypto_scrypt_local_t *);
+
+/**
+ * crypto_scrypt_free_local(local):
+ * Release the scratch memory of local.  Return 0 on success; or -1 on error.
+ */
+int crypto_scrypt_free_local(crypto_scrypt_local_t *);
+
+/**
+ * crypto_scrypt_reserve_local(local, N, r, p):
+ * Grow the scratch memory of local, if needed, to what crypto_scrypt_r
+ * takes for N, r and p, so that calls with those parameters do not allocate.
+ * Return 0 on success; or -1 and set errno as crypto_scrypt_r would.
+ */
+int crypto_scrypt_reserve_local(crypto_scrypt_local_t *, uint64_t, uint32_t,
+    uint32_t);
+
+/**
+ * crypto_scrypt_r(local, passwd, passwdlen, salt, saltlen, N, r, p, buf,
+ *     buflen):
+ * Compute scrypt as crypto_scrypt does, in the scratch memory of local,
+ * which is grown as needed and kept, already faulted in, for the next call.
+ * A local must not be used by two threads at once.  Derivations made this
+ * way are not reported to the stats callback.
+ */
+int crypto_scrypt_r(crypto_scrypt_local_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, uint64_t, uint32_t, uint32_t, uint8_t *, size_t);
+
+/*
+ * Per-phase instrumentation.  Define CRYPTO_SCRYPT_STATS to 0 to compile it
+ * out, leaving crypto_scrypt exactly as above.
+ */
+#ifndef CRYPTO_SCRYPT_STATS
+#define CRYPTO_SCRYPT_STATS 1
+#endif
+
+struct crypto_scrypt_stats;
+
+#if CRYPTO_SCRYPT_STATS
+
+/* Phases of crypto_scrypt, in the order they run. */
+typedef enum {
+	CRYPTO_SCRYPT_PHASE_RESERVE,	/* Waiting on the memory budget. */
+	CRYPTO_SCRYPT_PHASE_ALLOC,	/* Allocating B, XY and mapping V. */
+	CRYPTO_SCRYPT_PHASE_PBKDF2_IN,	/* PBKDF2(P, S, 1, p * MFLen). */
+	CRYPTO_SCRYPT_PHASE_SMIX_FILL,	/* Sequential writes of V. */
+	CRYPTO_SCRYPT_PHASE_SMIX_MIX,	/* Random reads of V. */
+	CRYPTO_SCRYPT_PHASE_PBKDF2_OUT,	/* PBKDF2(P, B, 1, dkLen). */
+	CRYPTO_SCRYPT_PHASE_FREE,	/* Unmapping V and freeing B, XY. */
+	CRYPTO_SCRYPT_PHASE_COUNT
+} crypto_scrypt_phase;
+
+struct crypto_scrypt_stats {
+	uint64_t N;
+	uint32_t r;
+	uint32_t p;
+
+	/* Size of V, and the bytes of it written and read over all p smixes. */
+	uint64_t v_bytes;
+	uint64_t v_bytes_written;
+	uint64_t v_bytes_read;
+	/* Nonzero if the budget left room for only 1 in 2^v_shift blocks of V. */
+	uint32_t v_shift;
+
+	struct {
+		/* Monotonic wall time. */
+		uint64_t wall_ns;
+		/*
+		 * Timestamp counter ticks: the TSC on x86, the generic timer on
+		 * arm64, where user space cannot read the cycle counter.
+		 */
+		uint64_t ticks;
+		/* Page faults and reclaims of the whole process. */
+		uint64_t page_faults;
+	} phase[CRYPTO_SCRYPT_PHASE_COUNT];
+};
+
+/**
+ * crypto_scrypt_stats(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen,
+ *     stats):
+ * Compute scrypt as crypto_scrypt does, and record how long each phase took
+ * in stats, which may be NULL.
+ */
+int crypto_scrypt_stats(const uint8_t *, size_t, const uint8_t *, size_t,
+    uint64_t, uint32_t, uint32_t, uint8_t *, size_t,
+    struct crypto_scrypt_stats *);
+
+typedef void (*crypto_scrypt_stats_callback)(const struct crypto_scrypt_stats *,
+    void *);
+
+/**
+ * crypto_scrypt_set_stats_callback(callback, cookie):
+ * Call callback(stats, cookie) after every successful derivation, on the
+ * thread that ran it.  Meant to be set once, before any derivation.
+ */
+void crypto_scrypt_set_stats_callback(crypto_scrypt_stats_callback, void *);
+
+/**
+ * crypto_scrypt_phase_name(phase):
+ * Return a short snake_case name of phase, for metric names.
+ */
+const char * crypto_scrypt_phase_name(crypto_scrypt_phase);
+
+#endif /* CRYPTO_SCRYPT_STATS */
+
 #endif /* !_CRYPTO_SCRYPT_H_ */
@@ -0,0 +1,99 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _CRYPTO_SCRYPT_BUDGET_H_
+#define _CRYPTO_SCRYPT_BUDGET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A process-wide budget for scrypt scratch memory.  Every derivation
+ * reserves its V, B and XY from the budget before allocating them, and
+ * gives them back when done.  Without a limit, reservations always succeed
+ * and are only counted.
+ */
+
+/* A timeout that never expires. */
+#define CRYPTO_SCRYPT_BUDGET_FOREVER	UINT32_MAX
+
+/* What a derivation does when the budget cannot cover it. */
+typedef enum {
+	/* Whatever crypto_scrypt_budget_set chose. */
+	CRYPTO_SCRYPT_BUDGET_DEFAULT,
+	/* Block until enough memory is given back, or the timeout. */
+	CRYPTO_SCRYPT_BUDGET_WAIT,
+	/* Fail at once with EAGAIN. */
+	CRYPTO_SCRYPT_BUDGET_FAIL,
+	/*
+	 * Keep only every 2^k-th block of V, for the smallest k that fits,
+	 * and recompute the others as they are read: the same key, for up to
+	 * (2^k + 1) / 2 times the work of the mixing loop.  Block if even the
+	 * smallest V does not fit.
+	 */
+	CRYPTO_SCRYPT_BUDGET_DEGRADE
+} crypto_scrypt_budget_policy;
+
+/* Most V blocks a degraded derivation recomputes per read, as a shift. */
+#define CRYPTO_SCRYPT_BUDGET_MAX_SHIFT	6
+
+struct crypto_scrypt_budget_usage {
+	uint64_t limit;
+	uint64_t in_use;
+	uint64_t peak;
+	uint64_t reservations;
+	/* Reservations that had to wait, and for how long. */
+	uint64_t waits;
+	uint64_t wait_ns_total;
+	uint64_t wait_ns_max;
+	/* Reservations refused: timed out, failed fast or larger than limit. */
+	uint64_t timeouts;
+	uint64_t rejections;
+	/* Reservations granted with a smaller V. */
+	uint64_t degraded;
+};
+
+/**
+ * crypto_scrypt_budget_set(limit, policy, timeout_ms):
+ * Limit the scrypt memory of the process to limit bytes, or remove the
+ * limit if zero, and make policy with timeout_ms the default for calls that
+ * do not choose one.  Reservations already granted are kept.
+ */
+void crypto_scrypt_budget_set(uint64_t, crypto_scrypt_budget_policy,
+    uint32_t);
+
+/**
+ * crypto_scrypt_budget_usage(usage):
+ * Store a snapshot of the budget and its counters in usage.
+ */
+void crypto_scrypt_budget_usage(struct crypto_scrypt_budget_usage *);
+
+/**
+ * crypto_scrypt_policy(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen,
+ *     policy, timeout_ms):
+ * Compute scrypt as crypto_scrypt does, reserving its memory under policy.
+ * Return 0 on success; or -1 and set errno to EAGAIN if refused by
+ * CRYPTO_SCRYPT_BUDGET_FAIL, ETIMEDOUT if the wait timed out, or ENOMEM if
+ * the derivation could never fit the limit.
+ */
+int crypto_scrypt_policy(const uint8_t *, size_t, const uint8_t *, size_t,
+    uint64_t, uint32_t, uint32_t, uint8_t *, size_t,
+    crypto_scrypt_budget_policy, uint32_t);
+
+/**
+ * crypto_scrypt_budget_reserve(sizes, nsizes, policy, timeout_ms, chosen):
+ * Reserve the first of the nsizes sizes, which are in descending order,
+ * that fits; sizes after the first are only tried under
+ * CRYPTO_SCRYPT_BUDGET_DEGRADE.  Store the index of the reserved size in
+ * chosen.  Return 0 on success; or -1 and set errno as crypto_scrypt_policy
+ * describes.  Used by crypto_scrypt.
+ */
+int crypto_scrypt_budget_reserve(const uint64_t *, size_t,
+    crypto_scrypt_budget_policy, uint32_t, size_t *);
+
+/**
+ * crypto_scrypt_budget_release(size):
+ * Give back size bytes reserved by crypto_scrypt_budget_reserve.
+ */
+void crypto_scrypt_budget_release(uint64_t);
+
+#endif /* !_CRYPTO_SCRYPT_BUDGET_H_ */
@@ -0,0 +1,49 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _CRYPTO_SCRYPT_NUMA_H_
+#define _CRYPTO_SCRYPT_NUMA_H_
+
+#include <stddef.h>
+
+/*
+ * NUMA placement of scrypt derivations.  Where the platform has neither NUMA
+ * nor thread affinity, as on Darwin, there is a single node holding every
+ * CPU and binding only records the node.
+ */
+
+/**
+ * crypto_scrypt_numa_nodes():
+ * Return the number of NUMA nodes, at least 1.
+ */
+int crypto_scrypt_numa_nodes(void);
+
+/**
+ * crypto_scrypt_numa_node_cpus(node, cpus, ncpus):
+ * Store up to ncpus of the CPUs of node in cpus, and return how many the
+ * node has, so that worker sets can be sized per node; or -1 on error.
+ */
+int crypto_scrypt_numa_node_cpus(int, int *, size_t);
+
+/**
+ * crypto_scrypt_numa_bind(node, cpu):
+ * Pin the calling thread to cpu of node, or to all CPUs of node if cpu is
+ * negative, and place V of every later crypto_scrypt call on this thread
+ * on node.  B and XY are small and first touched by this thread, so they
+ * land on node anyway.  Return 0 on success; or -1 on error.
+ */
+int crypto_scrypt_numa_bind(int, int);
+
+/**
+ * crypto_scrypt_numa_unbind():
+ * Let the calling thread run anywhere and allocate V as it used to.
+ */
+void crypto_scrypt_numa_unbind(void);
+
+/**
+ * crypto_scrypt_numa_place(addr, len):
+ * Place the mapping addr[0 .. len - 1] on the node the calling thread is
+ * bound to, if any.  Called by crypto_scrypt before V is first touched.
+ */
+void crypto_scrypt_numa_place(void *, size_t);
+
+#endif /* !_CRYPTO_SCRYPT_NUMA_H_ */
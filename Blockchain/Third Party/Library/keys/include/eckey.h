@@ -0,0 +1,102 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _ECKEY_H_
+#define _ECKEY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Key arithmetic on secp256k1.  Field elements are four 64-bit limbs
+ * reduced with the special form of p = 2^256 - 0x1000003D1, and multiples of
+ * the generator come from a table of 64 windows of 4 bits built once per
+ * process, so k*G costs 64 point additions and no doublings.  Secret scalars
+ * are looked up and added in constant time.  Public keys are 33-byte
+ * compressed points.  Functions return 0 on success or -1 if an input is
+ * not a valid key, or the result would be the point at infinity.
+ */
+
+/**
+ * eckey_precompute(void):
+ * Build the generator table now rather than on first use, which takes a
+ * few milliseconds.
+ */
+void	eckey_precompute(void);
+
+/**
+ * eckey_seckey_verify(seckey):
+ * Check that seckey is a valid secret key: non-zero and less than n.
+ */
+int	eckey_seckey_verify(const uint8_t [32]);
+
+/**
+ * eckey_pubkey_create(seckey, pubkey):
+ * Compute the public key of seckey.
+ */
+int	eckey_pubkey_create(const uint8_t [32], uint8_t [33]);
+
+/**
+ * eckey_pubkey_verify(pubkey):
+ * Check that pubkey is a compressed point on the curve.
+ */
+int	eckey_pubkey_verify(const uint8_t [33]);
+
+/**
+ * eckey_pubkey_decompress(pubkey, out):
+ * Write the 65-byte uncompressed form of pubkey to out.
+ */
+int	eckey_pubkey_decompress(const uint8_t [33], uint8_t [65]);
+
+/**
+ * eckey_seckey_tweak_add(seckey, tweak):
+ * Replace seckey by seckey + tweak mod n.
+ */
+int	eckey_seckey_tweak_add(uint8_t [32], const uint8_t [32]);
+
+/**
+ * eckey_pubkey_tweak_add(pubkey, tweak, out):
+ * Compute pubkey + tweak*G into out.
+ */
+int	eckey_pubkey_tweak_add(const uint8_t [33], const uint8_t [32],
+    uint8_t [33]);
+
+/**
+ * eckey_pubkey_tweak_add_batch(pubkey, tweaks, n, out, ok):
+ * Compute pubkey + tweaks[i]*G for the n 32-byte tweaks stored back to back
+ * in tweaks, writing the n results back to back to out with a single field
+ * inversion.  Set ok[i] to 0 or -1 as eckey_pubkey_tweak_add would return;
+ * out is zeroed where it is -1.  Return the number of keys computed, or
+ * (size_t)(-1) if pubkey itself is invalid or memory runs out.
+ */
+size_t	eckey_pubkey_tweak_add_batch(const uint8_t [33], const uint8_t *,
+    size_t, uint8_t *, int *);
+
+/**
+ * eckey_sign_recoverable(seckey, hash, sig, recid):
+ * Sign the 32-byte hash with seckey, writing r and s to sig and the
+ * recovery id, 0 to 3, to recid.  The nonce is derived per RFC 6979 and s
+ * is at most n / 2.
+ */
+int	eckey_sign_recoverable(const uint8_t [32], const uint8_t [32],
+    uint8_t [64], int *);
+
+/**
+ * eckey_recover(sig, recid, hash, pubkey):
+ * Recover the 65-byte uncompressed public key which made the signature sig
+ * with recovery id recid of the 32-byte hash.
+ */
+int	eckey_recover(const uint8_t [64], int, const uint8_t [32],
+    uint8_t [65]);
+
+/**
+ * eckey_recover_batch(sigs, recids, hashes, n, pubkeys, ok):
+ * Recover the public keys of n signatures as eckey_recover would, with a
+ * single field inversion, writing them back to back to pubkeys.  Set ok[i]
+ * to 0 or -1 as eckey_recover would return; pubkeys is zeroed where it is
+ * -1.  Return the number of keys recovered, or (size_t)(-1) if memory runs
+ * out.
+ */
+size_t	eckey_recover_batch(const uint8_t *, const int *, const uint8_t *,
+    size_t, uint8_t *, int *);
+
+#endif /* !_ECKEY_H_ */
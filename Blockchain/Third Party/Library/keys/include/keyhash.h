@@ -0,0 +1,56 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _KEYHASH_H_
+#define _KEYHASH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * The hashes of Bitcoin keys and addresses: SHA256(SHA256(x)) for checksums
+ * and transaction ids, and RIPEMD160(SHA256(x)) for public key hashes.
+ * Inputs are hashed in one shot, straight from the caller's buffer, with the
+ * SHA-256 instructions of the CPU where it has them.
+ */
+
+/**
+ * sha256d(in, len, out):
+ * Compute SHA256(SHA256(in[0 .. len - 1])) into out.
+ */
+void	sha256d(const uint8_t *, size_t, uint8_t [32]);
+
+/**
+ * sha256d_32(in, out):
+ * Compute sha256d of a 32-byte input, such as a digest, in two compressions.
+ */
+void	sha256d_32(const uint8_t [32], uint8_t [32]);
+
+/**
+ * hash160(in, len, out):
+ * Compute RIPEMD160(SHA256(in[0 .. len - 1])) into out.
+ */
+void	hash160(const uint8_t *, size_t, uint8_t [20]);
+
+/**
+ * hash160_33(pubkey, out), hash160_65(pubkey, out):
+ * Compute hash160 of a compressed or uncompressed public key.
+ */
+void	hash160_33(const uint8_t [33], uint8_t [20]);
+void	hash160_65(const uint8_t [65], uint8_t [20]);
+
+/**
+ * sha256d_batch(in, len, n, out):
+ * Compute sha256d of the n inputs of len bytes each stored back to back in
+ * in, writing the n digests back to back to out.
+ */
+void	sha256d_batch(const uint8_t *, size_t, size_t, uint8_t *);
+
+/**
+ * hash160_batch(in, len, n, out):
+ * Compute hash160 of the n inputs of len bytes each stored back to back in
+ * in, such as public keys of 33 or 65 bytes, writing the n hashes back to
+ * back to out.
+ */
+void	hash160_batch(const uint8_t *, size_t, size_t, uint8_t *);
+
+#endif /* !_KEYHASH_H_ */
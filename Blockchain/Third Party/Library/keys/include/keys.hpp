@@ -0,0 +1,430 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _KEYS_HPP_
+#define _KEYS_HPP_
+
+/*
+ * A C++20 interface to scrypt and HMAC-SHA256 from this library.  Inputs and
+ * outputs are spans over memory the caller owns, and errors are returned as
+ * values rather than left in errno.  A ScryptContext holds the scratch memory
+ * for its parameters, and an HmacKey the hashed pads of its key, so once
+ * created neither allocates nor rehashes anything per call.  Header only.
+ */
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <version>
+
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+#include <expected>
+#define KEYS_HAVE_STD_EXPECTED 1
+#else
+#define KEYS_HAVE_STD_EXPECTED 0
+#endif
+
+extern "C" {
+#include "crypto_scrypt.h"
+#include "secbuf.h"
+#include "sha256.h"
+}
+
+namespace keys {
+
+#if KEYS_HAVE_STD_EXPECTED
+
+template <class T>
+using expected = std::expected<T, std::errc>;
+using unexpected = std::unexpected<std::errc>;
+
+#else
+
+/* The parts of std::expected<T, std::errc> used here, until C++23. */
+class unexpected {
+public:
+	constexpr explicit unexpected(std::errc error) noexcept : error_(error) {}
+	constexpr std::errc error() const noexcept { return (error_); }
+
+private:
+	std::errc error_;
+};
+
+template <class T>
+class [[nodiscard]] expected {
+public:
+	constexpr expected(T value)
+	    noexcept(std::is_nothrow_move_constructible_v<T>)
+	    : has_value_(true)
+	{
+
+		std::construct_at(&value_, std::move(value));
+	}
+	constexpr expected(unexpected u) noexcept
+	    : has_value_(false), error_(u.error())
+	{
+
+	}
+	constexpr expected(expected && other)
+	    noexcept(std::is_nothrow_move_constructible_v<T>)
+	    : has_value_(other.has_value_)
+	{
+
+		if (has_value_)
+			std::construct_at(&value_, std::move(other.value_));
+		else
+			error_ = other.error_;
+	}
+	constexpr expected & operator=(expected && other)
+	    noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+
+		if (this != &other) {
+			this->~expected();
+			std::construct_at(this, std::move(other));
+		}
+		return (*this);
+	}
+	constexpr ~expected()
+	{
+
+		if (has_value_)
+			std::destroy_at(&value_);
+	}
+
+	constexpr bool has_value() const noexcept { return (has_value_); }
+	constexpr explicit operator bool() const noexcept
+	{
+
+		return (has_value_);
+	}
+
+	/* Only to be called when has_value(), or error() when not. */
+	constexpr T & value() & noexcept { return (value_); }
+	constexpr const T & value() const & noexcept { return (value_); }
+	constexpr T && value() && noexcept { return (std::move(value_)); }
+	constexpr T & operator*() & noexcept { return (value_); }
+	constexpr const T & operator*() const & noexcept { return (value_); }
+	constexpr T && operator*() && noexcept { return (std::move(value_)); }
+	constexpr T * operator->() noexcept { return (&value_); }
+	constexpr const T * operator->() const noexcept { return (&value_); }
+	constexpr std::errc error() const noexcept { return (error_); }
+
+private:
+	bool has_value_;
+	union {
+		T value_;
+		std::errc error_;
+	};
+};
+
+template <>
+class [[nodiscard]] expected<void> {
+public:
+	constexpr expected() noexcept : error_() {}
+	constexpr expected(unexpected u) noexcept : error_(u.error()) {}
+
+	constexpr bool has_value() const noexcept
+	{
+
+		return (error_ == std::errc());
+	}
+	constexpr explicit operator bool() const noexcept
+	{
+
+		return (has_value());
+	}
+	constexpr std::errc error() const noexcept { return (error_); }
+
+private:
+	std::errc error_;
+};
+
+#endif /* !KEYS_HAVE_STD_EXPECTED */
+
+/* Longest output of scrypt and PBKDF2-HMAC-SHA256: (2^32 - 1) * 32 bytes. */
+inline constexpr std::uint64_t max_derived_length =
+    ((std::uint64_t(1) << 32) - 1) * 32;
+
+/* The error of errno after a failed C call, never success. */
+inline std::errc
+errno_error() noexcept
+{
+	int e = errno;
+
+	return (e != 0 ? std::errc(e) : std::errc::io_error);
+}
+
+/*
+ * Cost parameters of scrypt.  check() is crypto_scrypt's own validation, and
+ * constexpr, so parameters known at compile time can be checked there; see
+ * scrypt_params.
+ */
+struct ScryptParams {
+	std::uint64_t N;
+	std::uint32_t r;
+	std::uint32_t p;
+
+	/* The error crypto_scrypt fails with for these, or std::errc() if none. */
+	constexpr std::errc check() const noexcept
+	{
+
+		if (r == 0 || p == 0)
+			return (std::errc::invalid_argument);
+		if (std::uint64_t(r) * std::uint64_t(p) >= (1 << 30))
+			return (std::errc::file_too_large);
+		if ((N & (N - 1)) != 0 || N < 2)
+			return (std::errc::invalid_argument);
+		if (r > SIZE_MAX / 128 / p || r > SIZE_MAX / 256 ||
+		    N > SIZE_MAX / 128 / r)
+			return (std::errc::not_enough_memory);
+		if (Vlen() > SIZE_MAX - Blen() - XYlen() - 63)
+			return (std::errc::not_enough_memory);
+		return (std::errc());
+	}
+
+	/* Bytes of scratch memory a derivation takes; only if check() passes. */
+	constexpr std::size_t scratch_bytes() const noexcept
+	{
+
+		return (Vlen() + Blen() + XYlen());
+	}
+
+	static constexpr expected<ScryptParams> make(std::uint64_t N,
+	    std::uint32_t r, std::uint32_t p) noexcept
+	{
+		ScryptParams params{N, r, p};
+
+		if (std::errc e = params.check(); e != std::errc())
+			return (unexpected(e));
+		return (params);
+	}
+
+	friend constexpr bool operator==(const ScryptParams &,
+	    const ScryptParams &) = default;
+
+private:
+	/* Bytes of V, B and XY, as crypto_scrypt_r lays them out. */
+	constexpr std::size_t Vlen() const noexcept
+	{
+
+		return (std::size_t(128) * r * N);
+	}
+	constexpr std::size_t Blen() const noexcept
+	{
+
+		return (std::size_t(128) * r * p);
+	}
+	constexpr std::size_t XYlen() const noexcept
+	{
+
+		return (std::size_t(256) * r + 64);
+	}
+};
+
+/* Parameters checked at compile time, e.g. scrypt_params<16384, 8, 8>. */
+template <std::uint64_t N, std::uint32_t r, std::uint32_t p>
+inline constexpr ScryptParams scrypt_params = [] {
+	constexpr ScryptParams params{N, r, p};
+
+	static_assert(params.check() == std::errc(),
+	    "N must be a power of 2 greater than 1, r * p less than 2^30");
+	return (params);
+}();
+
+/*
+ * An HMAC-SHA256 key, hashed into its inner and outer pads once.  Each MAC,
+ * and each PBKDF2 iteration, starts from a copy of the pads rather than from
+ * the key.  Move only, so the pads exist once; they are wiped when the key
+ * goes away, and a key moved from is not to be used again.
+ */
+class HmacKey {
+public:
+	static constexpr std::size_t digest_length = 32;
+
+	explicit HmacKey(std::span<const std::uint8_t> key) noexcept
+	{
+
+		HMAC_SHA256_Init(&ctx_, key.data(), key.size());
+	}
+	HmacKey(HmacKey && other) noexcept : ctx_(other.ctx_)
+	{
+
+		secbuf_wipe(&other.ctx_, sizeof(other.ctx_));
+	}
+	HmacKey & operator=(HmacKey && other) noexcept
+	{
+
+		if (this != &other) {
+			ctx_ = other.ctx_;
+			secbuf_wipe(&other.ctx_, sizeof(other.ctx_));
+		}
+		return (*this);
+	}
+	HmacKey(const HmacKey &) = delete;
+	HmacKey & operator=(const HmacKey &) = delete;
+	~HmacKey() { secbuf_wipe(&ctx_, sizeof(ctx_)); }
+
+	/* HMAC-SHA256(key, message) into out. */
+	void mac(std::span<const std::uint8_t> message,
+	    std::span<std::uint8_t, digest_length> out) const noexcept
+	{
+		HMAC_SHA256_CTX ctx = ctx_;
+
+		HMAC_SHA256_Update(&ctx, message.data(), message.size());
+		HMAC_SHA256_Final(out.data(), &ctx);
+		secbuf_wipe(&ctx, sizeof(ctx));
+	}
+
+	/*
+	 * PBKDF2-HMAC-SHA256 with the key as the password, filling out; the
+	 * same bytes as PBKDF2_SHA256.  Fails with invalid_argument if
+	 * iterations is 0, or file_too_large if out is longer than
+	 * max_derived_length.
+	 */
+	expected<void> pbkdf2(std::span<const std::uint8_t> salt,
+	    std::uint64_t iterations, std::span<std::uint8_t> out) const noexcept
+	{
+		HMAC_SHA256_CTX salted, ctx;
+		std::uint8_t ivec[4];
+		std::uint8_t U[digest_length];
+		std::uint8_t T[digest_length];
+		std::size_t i, k, clen;
+		std::uint64_t j;
+
+		if (iterations == 0)
+			return (unexpected(std::errc::invalid_argument));
+		if (std::uint64_t(out.size()) > max_derived_length)
+			return (unexpected(std::errc::file_too_large));
+
+		/* The salt is hashed once, for every block. */
+		salted = ctx_;
+		HMAC_SHA256_Update(&salted, salt.data(), salt.size());
+
+		for (i = 0; i * digest_length < out.size(); i++) {
+			ivec[0] = std::uint8_t((i + 1) >> 24);
+			ivec[1] = std::uint8_t((i + 1) >> 16);
+			ivec[2] = std::uint8_t((i + 1) >> 8);
+			ivec[3] = std::uint8_t(i + 1);
+
+			/* U_1 = PRF(P, S || INT(i)), and T_i = U_1 ... */
+			ctx = salted;
+			HMAC_SHA256_Update(&ctx, ivec, 4);
+			HMAC_SHA256_Final(U, &ctx);
+			for (k = 0; k < digest_length; k++)
+				T[k] = U[k];
+
+			/* ... xor U_j, U_j = PRF(P, U_{j-1}). */
+			for (j = 2; j <= iterations; j++) {
+				ctx = ctx_;
+				HMAC_SHA256_Update(&ctx, U, digest_length);
+				HMAC_SHA256_Final(U, &ctx);
+				for (k = 0; k < digest_length; k++)
+					T[k] ^= U[k];
+			}
+
+			clen = out.size() - i * digest_length;
+			if (clen > digest_length)
+				clen = digest_length;
+			for (k = 0; k < clen; k++)
+				out[i * digest_length + k] = T[k];
+		}
+
+		secbuf_wipe(&salted, sizeof(salted));
+		secbuf_wipe(&ctx, sizeof(ctx));
+		secbuf_wipe(U, sizeof(U));
+		secbuf_wipe(T, sizeof(T));
+		return {};
+	}
+
+private:
+	HMAC_SHA256_CTX ctx_;
+};
+
+/*
+ * Scratch memory for scrypt with one set of parameters, sized and charged to
+ * the memory budget when the context is created and held until it goes away,
+ * so derive makes no allocation.  Move only; not to be used by two threads
+ * at once, nor again once moved from.
+ */
+class ScryptContext {
+public:
+	/*
+	 * A context for params, or the error crypto_scrypt would fail with,
+	 * e.g. not_enough_memory if the budget cannot cover the scratch.
+	 */
+	static expected<ScryptContext> create(const ScryptParams & params)
+	    noexcept
+	{
+		ScryptContext context(params);
+
+		if (std::errc e = params.check(); e != std::errc())
+			return (unexpected(e));
+		if (crypto_scrypt_reserve_local(&context.local_, params.N,
+		    params.r, params.p))
+			return (unexpected(errno_error()));
+		return (context);
+	}
+	ScryptContext(ScryptContext && other) noexcept
+	    : params_(other.params_),
+	      local_(std::exchange(other.local_, crypto_scrypt_local_t()))
+	{
+
+	}
+	ScryptContext & operator=(ScryptContext && other) noexcept
+	{
+
+		if (this != &other) {
+			(void)crypto_scrypt_free_local(&local_);
+			params_ = other.params_;
+			local_ = std::exchange(other.local_,
+			    crypto_scrypt_local_t());
+		}
+		return (*this);
+	}
+	ScryptContext(const ScryptContext &) = delete;
+	ScryptContext & operator=(const ScryptContext &) = delete;
+	~ScryptContext() { (void)crypto_scrypt_free_local(&local_); }
+
+	const ScryptParams & params() const noexcept { return (params_); }
+
+	/*
+	 * scrypt(passwd, salt) with the parameters of the context, filling
+	 * out.  Fails with file_too_large if out is longer than
+	 * max_derived_length.
+	 */
+	expected<void> derive(std::span<const std::uint8_t> passwd,
+	    std::span<const std::uint8_t> salt,
+	    std::span<std::uint8_t> out) noexcept
+	{
+
+		if (std::uint64_t(out.size()) > max_derived_length)
+			return (unexpected(std::errc::file_too_large));
+		if (local_.base == nullptr)
+			return (unexpected(std::errc::invalid_argument));
+		if (crypto_scrypt_r(&local_, passwd.data(), passwd.size(),
+		    salt.data(), salt.size(), params_.N, params_.r, params_.p,
+		    out.data(), out.size()))
+			return (unexpected(errno_error()));
+		return {};
+	}
+
+private:
+	explicit ScryptContext(const ScryptParams & params) noexcept
+	    : params_(params), local_()
+	{
+
+	}
+
+	ScryptParams params_;
+	crypto_scrypt_local_t local_;
+};
+
+} /* namespace keys */
+
+#endif /* !_KEYS_HPP_ */
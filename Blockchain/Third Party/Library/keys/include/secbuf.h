@@ -0,0 +1,81 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _SECBUF_H_
+#define _SECBUF_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Buffers for secrets: passwords, salts and derived keys on their way
+ * between JS and the key derivation functions.  Buffers come in a few fixed
+ * size classes, carved out of slabs of pages that are locked into memory and
+ * kept out of core dumps, mapped the first time a class runs dry and never
+ * given back.  Each thread keeps a few free buffers of every class, so a
+ * derivation that takes and returns its buffers makes no system call and
+ * takes no lock once the slabs exist.  Buffers are zeroed when given back.
+ * Larger requests get pages of their own, locked and unmapped per call.
+ */
+
+/* Largest buffer served from the slabs. */
+#define SECBUF_MAX_POOLED	4096
+
+struct secbuf {
+	uint8_t * buf;
+	/* The length asked for; not to be changed until secbuf_put. */
+	size_t len;
+};
+
+#define SECBUF_INITIALIZER	{ NULL, 0 }
+
+struct secbuf_usage {
+	/* Slab bytes mapped, and how many of them are locked. */
+	uint64_t mapped;
+	uint64_t locked;
+	/* Buffers taken and not yet given back. */
+	uint64_t in_use;
+	uint64_t peak;
+	/* Buffers taken that were too large for the slabs, in all. */
+	uint64_t large;
+	/* Mappings that could not be locked, e.g. past RLIMIT_MEMLOCK. */
+	uint64_t lock_failures;
+};
+
+/**
+ * secbuf_get(sb, len):
+ * Point sb at a zeroed buffer of at least len bytes, for secbuf_put to give
+ * back.  Return 0 on success; or -1 and set errno to ENOMEM, leaving sb
+ * empty.  Memory that cannot be locked is used anyway and counted in
+ * lock_failures.
+ */
+int	secbuf_get(struct secbuf *, size_t);
+
+/**
+ * secbuf_put(sb):
+ * Zero the buffer of sb and give it back, leaving sb empty.  Does nothing if
+ * sb is empty, so it can run twice.
+ */
+void	secbuf_put(struct secbuf *);
+
+/**
+ * secbuf_wipe(buf, len):
+ * Zero buf[0 .. len - 1] in a way the compiler cannot drop as a dead store.
+ */
+void	secbuf_wipe(void *, size_t);
+
+/**
+ * secbuf_usage(usage):
+ * Store a snapshot of the pool counters in usage.
+ */
+void	secbuf_usage(struct secbuf_usage *);
+
+/*
+ * SECBUF_SCOPED(name):
+ * Declare an empty struct secbuf that is given back when it goes out of
+ * scope, however the scope is left.
+ */
+#define SECBUF_SCOPED(name)						\
+	struct secbuf name __attribute__((cleanup(secbuf_put))) =	\
+	    SECBUF_INITIALIZER
+
+#endif /* !_SECBUF_H_ */
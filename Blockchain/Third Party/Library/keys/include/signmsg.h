@@ -0,0 +1,60 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _SIGNMSG_H_
+#define _SIGNMSG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Bitcoin signed messages: a recoverable signature of the sha256d of the
+ * message behind the "Bitcoin Signed Message:\n" prefix, serialized as a
+ * header byte 27 + recid, plus 4 for a compressed key, followed by r and s.
+ * A signature is checked by recovering its key and comparing the hash160
+ * of that key with the one the address carries.
+ */
+
+#define SIGNMSG_SIGLEN	65
+
+/**
+ * signmsg_hash(msg, len, hash):
+ * Compute the hash a signature of the len-byte message msg signs.
+ */
+void	signmsg_hash(const uint8_t *, size_t, uint8_t [32]);
+
+/**
+ * signmsg_sign(seckey, compressed, msg, len, sig):
+ * Sign msg with seckey, for the compressed public key if compressed is
+ * non-zero or the uncompressed one otherwise.
+ */
+int	signmsg_sign(const uint8_t [32], int, const uint8_t *, size_t,
+    uint8_t [SIGNMSG_SIGLEN]);
+
+/**
+ * signmsg_recover_hash160(sig, msg, len, hash160):
+ * Recover the key which signed msg and write its hash160, in the form the
+ * signature's header names, to hash160.
+ */
+int	signmsg_recover_hash160(const uint8_t [SIGNMSG_SIGLEN],
+    const uint8_t *, size_t, uint8_t [20]);
+
+/**
+ * signmsg_verify(sig, msg, len, hash160):
+ * Return 0 if sig is a signature of msg by the key with the given hash160,
+ * and -1 otherwise.
+ */
+int	signmsg_verify(const uint8_t [SIGNMSG_SIGLEN], const uint8_t *, size_t,
+    const uint8_t [20]);
+
+/**
+ * signmsg_verify_batch(sigs, msgs, lens, hash160s, n, ok):
+ * Verify n signatures stored back to back in sigs, of the messages msgs[i]
+ * of lens[i] bytes, against the hash160s stored back to back, with one
+ * field inversion for all the recovered keys.  Set ok[i] as signmsg_verify
+ * would return, and return the number which verify, or (size_t)(-1) if
+ * memory runs out.
+ */
+size_t	signmsg_verify_batch(const uint8_t *, const uint8_t * const *,
+    const size_t *, const uint8_t *, size_t, int *);
+
+#endif /* !_SIGNMSG_H_ */
@@ -0,0 +1,639 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+/*
+ * kdfd: scrypt as a local service.
+ *
+ *	kdfd [-s socket] [-w workers] [-q queue] [-b batch] [-m MiB] [-c]
+ *
+ * Requests arrive over a Unix domain socket in the framing of kdfd_proto.h.
+ * One thread per connection reads them into a single bounded queue; a
+ * request that finds the queue full is answered KDFD_EBUSY at once, so load
+ * beyond capacity is shed instead of building latency.  Workers take up to
+ * a batch of queued requests sharing (N, r, p) at a time and derive them
+ * back to back in scratch memory they keep warm between requests.  Workers
+ * are spread over the NUMA nodes, each pinned to its node (or, with -c, to
+ * one of its cores) so that its scratch stays node-local.  With -m, worker
+ * scratch is held to a memory budget; a worker that cannot grow its scratch
+ * within it answers KDFD_EBUSY.  Responses are queued per connection and
+ * written without blocking; a client that lets CONN_OUT_MAX bytes of them
+ * pile up is dropped rather than allowed to stall a worker.
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "crypto_scrypt.h"
+#include "crypto_scrypt_budget.h"
+#include "crypto_scrypt_numa.h"
+#include "sysendian.h"
+
+#include "kdfd_proto.h"
+
+#define DEFAULT_SOCKET	"/tmp/kdfd.sock"
+#define DEFAULT_QUEUE	256
+#define DEFAULT_BATCH	8
+
+/* Most CPUs a worker set is spread over. */
+#define CPU_SLOTS	1024
+
+/* Bytes of responses a connection may have queued before it is dropped. */
+#define CONN_OUT_MAX	(64 * 1024)
+
+/* How often a reader looks for queued responses it can now write, in ms. */
+#define CONN_TICK_MS	50
+
+/* Latency histogram buckets: bucket i counts latencies below 2^i us. */
+#define LATENCY_BUCKETS	32
+
+struct conn {
+	int fd;
+	/* Guards out, outlen and dropped, which workers write concurrently. */
+	pthread_mutex_t lock;
+	/* Framed responses not yet written, CONN_OUT_MAX bytes. */
+	uint8_t * out;
+	size_t outlen;
+	/* Shut down for falling behind; responses are discarded. */
+	int dropped;
+	/* The reader and every queued job of this connection. */
+	int refs;
+};
+
+struct job {
+	struct job * next;
+	struct conn * conn;
+	struct kdfd_scrypt_req req;
+	uint64_t enqueued_ns;
+	/* Password and salt, copied out of the frame. */
+	uint8_t data[];
+};
+
+struct worker {
+	pthread_t thread;
+	int node;
+	int cpu;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t nonempty;
+	struct job * head;
+	struct job * tail;
+	size_t depth;
+	size_t max;
+	size_t batch;
+
+	/* Metrics, under lock. */
+	uint64_t accepted;
+	uint64_t rejected;
+	uint64_t completed;
+	uint64_t failed;
+	uint64_t batches;
+	uint64_t latency[LATENCY_BUCKETS];
+	uint64_t latency_max_us;
+} queue = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.nonempty = PTHREAD_COND_INITIALIZER,
+};
+
+static volatile sig_atomic_t stopping;
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)(ts.tv_sec) * 1000000000 + (uint64_t)(ts.tv_nsec));
+}
+
+static void
+conn_unref(struct conn * conn)
+{
+	int refs;
+
+	pthread_mutex_lock(&conn->lock);
+	refs = --conn->refs;
+	pthread_mutex_unlock(&conn->lock);
+	if (refs > 0)
+		return;
+	close(conn->fd);
+	pthread_mutex_destroy(&conn->lock);
+	/* Derived keys wait here. */
+	memset(conn->out, 0, CONN_OUT_MAX);
+	free(conn->out);
+	free(conn);
+}
+
+/* Stop serving a connection; its reader sees the shutdown.  Under lock. */
+static void
+conn_drop(struct conn * conn)
+{
+
+	conn->dropped = 1;
+	memset(conn->out, 0, conn->outlen);
+	conn->outlen = 0;
+	(void)shutdown(conn->fd, SHUT_RDWR);
+}
+
+/* Write as much queued output as the socket takes now.  Under lock. */
+static void
+conn_flush(struct conn * conn)
+{
+	size_t off = 0;
+	ssize_t n;
+
+	while (off < conn->outlen) {
+		if ((n = send(conn->fd, &conn->out[off], conn->outlen - off,
+		    MSG_DONTWAIT)) == -1) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			/* A client that went away only loses its own responses. */
+			conn_drop(conn);
+			return;
+		}
+		off += (size_t)n;
+	}
+	memmove(conn->out, &conn->out[off], conn->outlen - off);
+	memset(&conn->out[conn->outlen - off], 0, off);
+	conn->outlen -= off;
+}
+
+/*
+ * Answer a request with a bare status, or with a payload if KDFD_OK.  The
+ * frame is queued and written as far as the socket takes it without
+ * blocking; the reader writes the rest as the client catches up.
+ */
+static void
+respond(struct conn * conn, uint8_t op, uint8_t status, uint32_t id,
+    const uint8_t * payload, size_t len)
+{
+	uint8_t * frame;
+
+	pthread_mutex_lock(&conn->lock);
+	if (conn->dropped)
+		goto done;
+	if (4 + KDFD_HEADER_LEN + len > CONN_OUT_MAX - conn->outlen) {
+		conn_drop(conn);
+		goto done;
+	}
+	frame = &conn->out[conn->outlen];
+	be32enc(frame, (uint32_t)(KDFD_HEADER_LEN + len));
+	memset(&frame[4], 0, KDFD_HEADER_LEN);
+	frame[4] = op;
+	frame[5] = status;
+	be32enc(&frame[8], id);
+	if (len > 0)
+		memcpy(&frame[4 + KDFD_HEADER_LEN], payload, len);
+	conn->outlen += 4 + KDFD_HEADER_LEN + len;
+	conn_flush(conn);
+done:
+	pthread_mutex_unlock(&conn->lock);
+}
+
+/* Upper bound of the bucket holding the q-th quantile, under queue.lock. */
+static uint64_t
+latency_quantile(double q)
+{
+	uint64_t total = 0, seen = 0;
+	int i;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+		total += queue.latency[i];
+	if (total == 0)
+		return (0);
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += queue.latency[i];
+		if ((double)seen >= q * (double)total)
+			break;
+	}
+	return (((uint64_t)(1) << i) < queue.latency_max_us ?
+	    (uint64_t)(1) << i : queue.latency_max_us);
+}
+
+static void
+respond_stats(struct conn * conn, uint32_t id)
+{
+	uint64_t stats[KDFD_STAT_COUNT];
+	uint8_t payload[KDFD_STAT_COUNT * 8];
+	int i;
+
+	pthread_mutex_lock(&queue.lock);
+	stats[KDFD_STAT_QUEUE_DEPTH] = queue.depth;
+	stats[KDFD_STAT_QUEUE_MAX] = queue.max;
+	stats[KDFD_STAT_ACCEPTED] = queue.accepted;
+	stats[KDFD_STAT_REJECTED] = queue.rejected;
+	stats[KDFD_STAT_COMPLETED] = queue.completed;
+	stats[KDFD_STAT_FAILED] = queue.failed;
+	stats[KDFD_STAT_BATCHES] = queue.batches;
+	stats[KDFD_STAT_LATENCY_P50_US] = latency_quantile(0.50);
+	stats[KDFD_STAT_LATENCY_P90_US] = latency_quantile(0.90);
+	stats[KDFD_STAT_LATENCY_P99_US] = latency_quantile(0.99);
+	stats[KDFD_STAT_LATENCY_MAX_US] = queue.latency_max_us;
+	pthread_mutex_unlock(&queue.lock);
+
+	for (i = 0; i < KDFD_STAT_COUNT; i++)
+		be64enc(&payload[8 * i], stats[i]);
+	respond(conn, KDFD_OP_STATS, KDFD_OK, id, payload, sizeof(payload));
+}
+
+/* Queue a request, or return -1 if the queue is full. */
+static int
+enqueue(struct conn * conn, const struct kdfd_scrypt_req * req)
+{
+	struct job * job;
+
+	if ((job = malloc(sizeof(*job) + req->passwdlen + req->saltlen)) ==
+	    NULL)
+		return (-1);
+	job->next = NULL;
+	job->conn = conn;
+	job->req = *req;
+	if (req->passwdlen > 0)
+		memcpy(job->data, req->passwd, req->passwdlen);
+	if (req->saltlen > 0)
+		memcpy(&job->data[req->passwdlen], req->salt, req->saltlen);
+	job->req.passwd = job->data;
+	job->req.salt = &job->data[req->passwdlen];
+
+	pthread_mutex_lock(&queue.lock);
+	if (queue.depth >= queue.max) {
+		queue.rejected++;
+		pthread_mutex_unlock(&queue.lock);
+		free(job);
+		return (-1);
+	}
+	pthread_mutex_lock(&conn->lock);
+	conn->refs++;
+	pthread_mutex_unlock(&conn->lock);
+	job->enqueued_ns = now_ns();
+	if (queue.tail != NULL)
+		queue.tail->next = job;
+	else
+		queue.head = job;
+	queue.tail = job;
+	queue.depth++;
+	queue.accepted++;
+	pthread_cond_signal(&queue.nonempty);
+	pthread_mutex_unlock(&queue.lock);
+	return (0);
+}
+
+/*
+ * Take the oldest job and up to batch - 1 more with the same (N, r, p),
+ * which then reuse the scratch memory exactly as sized.  Under queue.lock.
+ */
+static size_t
+dequeue_batch(struct job ** batch)
+{
+	struct job * first = queue.head;
+	struct job ** link;
+	struct job * job;
+	size_t n = 0;
+
+	queue.head = first->next;
+	batch[n++] = first;
+	for (link = &queue.head; (job = *link) != NULL && n < queue.batch; ) {
+		if (job->req.N == first->req.N && job->req.r == first->req.r &&
+		    job->req.p == first->req.p) {
+			*link = job->next;
+			batch[n++] = job;
+		} else {
+			link = &job->next;
+		}
+	}
+
+	/* The tail may have been taken. */
+	queue.tail = NULL;
+	for (job = queue.head; job != NULL; job = job->next)
+		queue.tail = job;
+	queue.depth -= n;
+	queue.batches++;
+	return (n);
+}
+
+static void
+record_latency(struct job * job, int ok)
+{
+	uint64_t us = (now_ns() - job->enqueued_ns) / 1000;
+	int i;
+
+	for (i = 0; i < LATENCY_BUCKETS - 1 && ((uint64_t)(1) << i) <= us; i++)
+		continue;
+
+	pthread_mutex_lock(&queue.lock);
+	if (ok)
+		queue.completed++;
+	else
+		queue.failed++;
+	queue.latency[i]++;
+	if (us > queue.latency_max_us)
+		queue.latency_max_us = us;
+	pthread_mutex_unlock(&queue.lock);
+}
+
+static void *
+worker_main(void * cookie)
+{
+	struct worker * w = cookie;
+	crypto_scrypt_local_t local;
+	struct job ** batch;
+	struct job * job;
+	uint8_t dk[KDFD_MAX_DKLEN];
+	size_t i, n;
+	int ok, err;
+
+	/* Before any scratch is mapped, so that it lands on this node. */
+	if (crypto_scrypt_numa_bind(w->node, w->cpu))
+		fprintf(stderr, "kdfd: cannot bind worker to node %d: %s\n",
+		    w->node, strerror(errno));
+	crypto_scrypt_init_local(&local);
+	if ((batch = malloc(queue.batch * sizeof(*batch))) == NULL)
+		return (NULL);
+
+	for (;;) {
+		pthread_mutex_lock(&queue.lock);
+		while (queue.head == NULL)
+			pthread_cond_wait(&queue.nonempty, &queue.lock);
+		n = dequeue_batch(batch);
+		pthread_mutex_unlock(&queue.lock);
+
+		for (i = 0; i < n; i++) {
+			job = batch[i];
+			ok = crypto_scrypt_r(&local, job->req.passwd,
+			    job->req.passwdlen, job->req.salt, job->req.saltlen,
+			    job->req.N, job->req.r, job->req.p, dk,
+			    job->req.dklen) == 0;
+			err = errno;
+			record_latency(job, ok);
+			if (ok)
+				respond(job->conn, KDFD_OP_SCRYPT, KDFD_OK,
+				    job->req.id, dk, job->req.dklen);
+			else
+				respond(job->conn, KDFD_OP_SCRYPT,
+				    (err == EAGAIN || err == ENOMEM) ?
+				    KDFD_EBUSY : KDFD_EINTERNAL, job->req.id,
+				    NULL, 0);
+
+			memset(dk, 0, sizeof(dk));
+			memset(job->data, 0,
+			    job->req.passwdlen + job->req.saltlen);
+			conn_unref(job->conn);
+			free(job);
+		}
+	}
+
+	/* NOTREACHED */
+}
+
+static void *
+conn_main(void * cookie)
+{
+	struct conn * conn = cookie;
+	struct kdfd_scrypt_req req;
+	struct pollfd pfd;
+	uint8_t * body;
+	size_t len;
+	int dropped;
+
+	if ((body = malloc(KDFD_MAX_FRAME)) == NULL)
+		goto done;
+
+	pfd.fd = conn->fd;
+	for (;;) {
+		/* Wait for a request, or for room to write queued responses. */
+		pthread_mutex_lock(&conn->lock);
+		dropped = conn->dropped;
+		pfd.events = POLLIN | (conn->outlen > 0 ? POLLOUT : 0);
+		pthread_mutex_unlock(&conn->lock);
+		if (dropped)
+			break;
+		if (poll(&pfd, 1, CONN_TICK_MS) == -1) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (pfd.revents & POLLOUT) {
+			pthread_mutex_lock(&conn->lock);
+			conn_flush(conn);
+			pthread_mutex_unlock(&conn->lock);
+		}
+		if ((pfd.revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+			continue;
+
+		if (kdfd_read_frame(conn->fd, body, &len) != 0)
+			break;
+		if (len < KDFD_HEADER_LEN)
+			break;
+		switch (body[0]) {
+		case KDFD_OP_SCRYPT:
+			if (kdfd_parse_scrypt(body, len, &req))
+				respond(conn, body[0], KDFD_EINVAL,
+				    be32dec(&body[4]), NULL, 0);
+			else if (enqueue(conn, &req))
+				respond(conn, body[0], KDFD_EBUSY, req.id,
+				    NULL, 0);
+			break;
+		case KDFD_OP_STATS:
+			respond_stats(conn, be32dec(&body[4]));
+			break;
+		default:
+			respond(conn, body[0], KDFD_EINVAL, be32dec(&body[4]),
+			    NULL, 0);
+			break;
+		}
+	}
+
+	/* Secrets pass through here too. */
+	memset(body, 0, KDFD_MAX_FRAME);
+	free(body);
+done:
+	conn_unref(conn);
+	return (NULL);
+}
+
+/*
+ * Start nworkers workers, or one per CPU if zero.  CPUs are handed out
+ * alternating between nodes, so that any number of workers spreads evenly
+ * and each node's worker set grows with its CPU count.
+ */
+static struct worker *
+start_workers(size_t * nworkers, int pin_cores)
+{
+	struct worker * workers, * slots;
+	int nodes = crypto_scrypt_numa_nodes();
+	int * cpus, * ncpus;
+	int node, k, more;
+	size_t i, n, total = 0;
+
+	if ((slots = calloc(CPU_SLOTS, sizeof(*slots))) == NULL ||
+	    (cpus = calloc((size_t)nodes * CPU_SLOTS, sizeof(*cpus))) == NULL ||
+	    (ncpus = calloc((size_t)nodes, sizeof(*ncpus))) == NULL)
+		return (NULL);
+	for (node = 0; node < nodes; node++)
+		if ((ncpus[node] = crypto_scrypt_numa_node_cpus(node,
+		    &cpus[node * CPU_SLOTS], CPU_SLOTS)) > CPU_SLOTS)
+			ncpus[node] = CPU_SLOTS;
+
+	/* The k-th CPU of every node before the (k + 1)-th of any. */
+	for (k = 0, more = 1; more && total < CPU_SLOTS; k++) {
+		more = 0;
+		for (node = 0; node < nodes && total < CPU_SLOTS; node++) {
+			if (k >= ncpus[node])
+				continue;
+			slots[total].node = node;
+			slots[total++].cpu = cpus[node * CPU_SLOTS + k];
+			more = 1;
+		}
+	}
+	free(cpus);
+	free(ncpus);
+	if (total == 0)
+		return (NULL);
+
+	n = (*nworkers > 0) ? *nworkers : total;
+	if ((workers = calloc(n, sizeof(*workers))) == NULL)
+		return (NULL);
+	for (i = 0; i < n; i++) {
+		workers[i] = slots[i % total];
+		if (!pin_cores)
+			workers[i].cpu = -1;
+		if ((errno = pthread_create(&workers[i].thread, NULL,
+		    worker_main, &workers[i])) != 0)
+			return (NULL);
+	}
+	free(slots);
+
+	*nworkers = n;
+	return (workers);
+}
+
+static void
+on_signal(int sig)
+{
+
+	(void)sig;
+	stopping = 1;
+}
+
+static void
+usage(void)
+{
+
+	fprintf(stderr, "usage: kdfd [-s socket] [-w workers] [-q queue] "
+	    "[-b batch] [-m MiB] [-c]\n");
+	exit(1);
+}
+
+int
+main(int argc, char * argv[])
+{
+	struct sockaddr_un sun;
+	struct pollfd pfd;
+	struct conn * conn;
+	pthread_t thread;
+	const char * path = DEFAULT_SOCKET;
+	size_t nworkers = 0;
+	int pin_cores = 0;
+	int ch, fd, s;
+
+	queue.max = DEFAULT_QUEUE;
+	queue.batch = DEFAULT_BATCH;
+	while ((ch = getopt(argc, argv, "b:cm:q:s:w:")) != -1) {
+		switch (ch) {
+		case 'b':
+			queue.batch = strtoul(optarg, NULL, 10);
+			break;
+		case 'c':
+			pin_cores = 1;
+			break;
+		case 'm':
+			/* Workers must not stall on each other's scratch. */
+			crypto_scrypt_budget_set(strtoull(optarg, NULL, 10) << 20,
+			    CRYPTO_SCRYPT_BUDGET_FAIL, 0);
+			break;
+		case 'q':
+			queue.max = strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			path = optarg;
+			break;
+		case 'w':
+			nworkers = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (queue.batch == 0 || queue.max == 0 ||
+	    strlen(path) >= sizeof(sun.sun_path))
+		usage();
+
+	signal(SIGPIPE, SIG_IGN);
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	strcpy(sun.sun_path, path);
+	unlink(path);
+	if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) == -1 ||
+	    bind(s, (struct sockaddr *)&sun, sizeof(sun)) ||
+	    listen(s, 64)) {
+		fprintf(stderr, "kdfd: %s: %s\n", path, strerror(errno));
+		return (1);
+	}
+
+	if (start_workers(&nworkers, pin_cores) == NULL) {
+		fprintf(stderr, "kdfd: cannot start workers: %s\n",
+		    strerror(errno));
+		return (1);
+	}
+	fprintf(stderr, "kdfd: listening on %s with %zu workers over %d "
+	    "nodes\n", path, nworkers, crypto_scrypt_numa_nodes());
+
+	/* Poll, so that a signal stops the loop within a tick. */
+	pfd.fd = s;
+	pfd.events = POLLIN;
+	while (!stopping) {
+		if (poll(&pfd, 1, 200) <= 0)
+			continue;
+		if ((fd = accept(s, NULL, NULL)) == -1)
+			continue;
+		if ((conn = malloc(sizeof(*conn))) == NULL) {
+			close(fd);
+			continue;
+		}
+		if ((conn->out = malloc(CONN_OUT_MAX)) == NULL) {
+			free(conn);
+			close(fd);
+			continue;
+		}
+		conn->fd = fd;
+		conn->outlen = 0;
+		conn->dropped = 0;
+		conn->refs = 1;
+		pthread_mutex_init(&conn->lock, NULL);
+		if (pthread_create(&thread, NULL, conn_main, conn) != 0) {
+			conn_unref(conn);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+
+	/* Workers die with the process; clients see the connection close. */
+	close(s);
+	unlink(path);
+	return (0);
+}
@@ -0,0 +1,306 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+/*
+ * kdfd_loadgen: drive kdfd and check its answers.
+ *
+ *	kdfd_loadgen [-s socket] [-c connections] [-d depth] [-n requests]
+ *	    [-N N] [-r r] [-p p] [-k dkLen]
+ *
+ * Each connection keeps up to depth requests in flight until it has sent
+ * its share of requests.  Every derived key is checked against crypto_scrypt
+ * run in this process.  Client-side throughput and latency are printed,
+ * followed by the server's own counters.  Exits non-zero if any key was
+ * wrong or any request failed other than by backpressure.
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "crypto_scrypt.h"
+#include "sysendian.h"
+
+#include "kdfd_proto.h"
+
+struct client {
+	pthread_t thread;
+	uint32_t index;
+	uint8_t salt[16];
+	uint8_t expected[KDFD_MAX_DKLEN];
+
+	/* Results. */
+	uint64_t * latency_us;
+	size_t nlatency;
+	uint64_t ok;
+	uint64_t busy;
+	uint64_t errors;
+	uint64_t mismatches;
+};
+
+static const char * path = "/tmp/kdfd.sock";
+static size_t depth = 8;
+static size_t nrequests = 100;
+static uint64_t N = 1024;
+static uint32_t r = 8;
+static uint32_t p = 1;
+static uint32_t dklen = 32;
+
+static const uint8_t passwd[] = "correct horse battery staple";
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)(ts.tv_sec) * 1000000000 + (uint64_t)(ts.tv_nsec));
+}
+
+static int
+connect_kdfd(void)
+{
+	struct sockaddr_un sun;
+	int fd;
+
+	memset(&sun, 0, sizeof(sun));
+	sun.sun_family = AF_UNIX;
+	strncpy(sun.sun_path, path, sizeof(sun.sun_path) - 1);
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return (-1);
+	if (connect(fd, (struct sockaddr *)&sun, sizeof(sun))) {
+		close(fd);
+		return (-1);
+	}
+	return (fd);
+}
+
+static void *
+client_main(void * cookie)
+{
+	struct client * c = cookie;
+	struct kdfd_scrypt_req req;
+	uint64_t * sent_ns;
+	uint8_t * body;
+	size_t sent = 0, done = 0, len;
+	uint32_t id;
+	int fd;
+
+	if ((sent_ns = calloc(nrequests, sizeof(*sent_ns))) == NULL ||
+	    (body = malloc(KDFD_MAX_FRAME)) == NULL ||
+	    (fd = connect_kdfd()) == -1) {
+		c->errors = nrequests;
+		return (NULL);
+	}
+
+	req.N = N;
+	req.r = r;
+	req.p = p;
+	req.dklen = dklen;
+	req.passwd = passwd;
+	req.passwdlen = sizeof(passwd) - 1;
+	req.salt = c->salt;
+	req.saltlen = sizeof(c->salt);
+
+	while (done < nrequests) {
+		/* Keep the pipe full. */
+		for (; sent < nrequests && sent - done < depth; sent++) {
+			req.id = (uint32_t)sent;
+			len = kdfd_encode_scrypt(&req, body);
+			sent_ns[sent] = now_ns();
+			if (kdfd_write_frame(fd, body, len))
+				goto fail;
+		}
+
+		if (kdfd_read_frame(fd, body, &len) != 0 ||
+		    len < KDFD_HEADER_LEN)
+			goto fail;
+		id = be32dec(&body[4]);
+		if (id >= sent)
+			goto fail;
+		done++;
+
+		switch (body[1]) {
+		case KDFD_OK:
+			c->latency_us[c->nlatency++] =
+			    (now_ns() - sent_ns[id]) / 1000;
+			if (len != KDFD_HEADER_LEN + dklen ||
+			    memcmp(&body[KDFD_HEADER_LEN], c->expected, dklen))
+				c->mismatches++;
+			else
+				c->ok++;
+			break;
+		case KDFD_EBUSY:
+			c->busy++;
+			break;
+		default:
+			c->errors++;
+			break;
+		}
+	}
+
+	close(fd);
+	free(body);
+	free(sent_ns);
+	return (NULL);
+
+fail:
+	c->errors += nrequests - done;
+	close(fd);
+	free(body);
+	free(sent_ns);
+	return (NULL);
+}
+
+static int
+cmp_u64(const void * a, const void * b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return ((x > y) - (x < y));
+}
+
+static int
+print_server_stats(void)
+{
+	uint8_t body[KDFD_MAX_FRAME];
+	size_t len;
+	int fd, i;
+
+	if ((fd = connect_kdfd()) == -1)
+		return (-1);
+	memset(body, 0, KDFD_HEADER_LEN);
+	body[0] = KDFD_OP_STATS;
+	if (kdfd_write_frame(fd, body, KDFD_HEADER_LEN) ||
+	    kdfd_read_frame(fd, body, &len) ||
+	    body[1] != KDFD_OK || len < KDFD_HEADER_LEN + KDFD_STAT_COUNT * 8) {
+		close(fd);
+		return (-1);
+	}
+	close(fd);
+
+	printf("server:");
+	for (i = 0; i < KDFD_STAT_COUNT; i++)
+		printf(" %s=%llu", kdfd_stat_names[i], (unsigned long long)
+		    be64dec(&body[KDFD_HEADER_LEN + 8 * i]));
+	printf("\n");
+	return (0);
+}
+
+static void
+usage(void)
+{
+
+	fprintf(stderr, "usage: kdfd_loadgen [-s socket] [-c connections] "
+	    "[-d depth] [-n requests]\n"
+	    "    [-N N] [-r r] [-p p] [-k dkLen]\n");
+	exit(1);
+}
+
+int
+main(int argc, char * argv[])
+{
+	struct client * clients;
+	uint64_t * latency;
+	uint64_t ok = 0, busy = 0, errors = 0, mismatches = 0, start, elapsed;
+	size_t nclients = 4, nlatency = 0, i;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "c:d:k:n:N:p:r:s:")) != -1) {
+		switch (ch) {
+		case 'c':
+			nclients = strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			depth = strtoul(optarg, NULL, 10);
+			break;
+		case 'k':
+			dklen = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'n':
+			nrequests = strtoul(optarg, NULL, 10);
+			break;
+		case 'N':
+			N = strtoull(optarg, NULL, 10);
+			break;
+		case 'p':
+			p = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			r = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			path = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (nclients == 0 || depth == 0 || nrequests == 0 || dklen == 0 ||
+	    dklen > KDFD_MAX_DKLEN)
+		usage();
+
+	if ((clients = calloc(nclients, sizeof(*clients))) == NULL)
+		return (1);
+	for (i = 0; i < nclients; i++) {
+		/* A salt per connection, so a mixed-up response shows. */
+		clients[i].index = (uint32_t)i;
+		memset(clients[i].salt, 0, sizeof(clients[i].salt));
+		be32enc(clients[i].salt, (uint32_t)i);
+		if (crypto_scrypt(passwd, sizeof(passwd) - 1, clients[i].salt,
+		    sizeof(clients[i].salt), N, r, p, clients[i].expected,
+		    dklen)) {
+			fprintf(stderr, "kdfd_loadgen: bad parameters: %s\n",
+			    strerror(errno));
+			return (1);
+		}
+		if ((clients[i].latency_us = calloc(nrequests,
+		    sizeof(uint64_t))) == NULL)
+			return (1);
+	}
+
+	start = now_ns();
+	for (i = 0; i < nclients; i++)
+		pthread_create(&clients[i].thread, NULL, client_main,
+		    &clients[i]);
+	for (i = 0; i < nclients; i++)
+		pthread_join(clients[i].thread, NULL);
+	elapsed = now_ns() - start;
+
+	if ((latency = calloc(nclients * nrequests, sizeof(uint64_t))) == NULL)
+		return (1);
+	for (i = 0; i < nclients; i++) {
+		memcpy(&latency[nlatency], clients[i].latency_us,
+		    clients[i].nlatency * sizeof(uint64_t));
+		nlatency += clients[i].nlatency;
+		ok += clients[i].ok;
+		busy += clients[i].busy;
+		errors += clients[i].errors;
+		mismatches += clients[i].mismatches;
+	}
+	qsort(latency, nlatency, sizeof(uint64_t), cmp_u64);
+
+	printf("client: ok=%llu busy=%llu errors=%llu mismatches=%llu "
+	    "rate=%.1f/s", (unsigned long long)ok, (unsigned long long)busy,
+	    (unsigned long long)errors, (unsigned long long)mismatches,
+	    (double)ok * 1e9 / (double)elapsed);
+	if (nlatency > 0)
+		printf(" p50_us=%llu p90_us=%llu p99_us=%llu max_us=%llu",
+		    (unsigned long long)latency[nlatency / 2],
+		    (unsigned long long)latency[nlatency * 9 / 10],
+		    (unsigned long long)latency[nlatency * 99 / 100],
+		    (unsigned long long)latency[nlatency - 1]);
+	printf("\n");
+
+	if (print_server_stats())
+		fprintf(stderr, "kdfd_loadgen: no stats from %s\n", path);
+
+	return ((errors > 0 || mismatches > 0) ? 1 : 0);
+}
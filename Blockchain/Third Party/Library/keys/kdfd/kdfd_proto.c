@@ -0,0 +1,142 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sysendian.h"
+
+#include "kdfd_proto.h"
+
+const char * const kdfd_stat_names[KDFD_STAT_COUNT] = {
+	[KDFD_STAT_QUEUE_DEPTH] = "queue_depth",
+	[KDFD_STAT_QUEUE_MAX] = "queue_max",
+	[KDFD_STAT_ACCEPTED] = "accepted",
+	[KDFD_STAT_REJECTED] = "rejected",
+	[KDFD_STAT_COMPLETED] = "completed",
+	[KDFD_STAT_FAILED] = "failed",
+	[KDFD_STAT_BATCHES] = "batches",
+	[KDFD_STAT_LATENCY_P50_US] = "latency_p50_us",
+	[KDFD_STAT_LATENCY_P90_US] = "latency_p90_us",
+	[KDFD_STAT_LATENCY_P99_US] = "latency_p99_us",
+	[KDFD_STAT_LATENCY_MAX_US] = "latency_max_us",
+};
+
+/* Read exactly len bytes.  Return 0, 1 on end of file at once, or -1. */
+static int
+read_full(int fd, uint8_t * buf, size_t len)
+{
+	size_t off = 0;
+	ssize_t n;
+
+	while (off < len) {
+		if ((n = read(fd, &buf[off], len - off)) == -1) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		if (n == 0) {
+			if (off == 0)
+				return (1);
+			errno = EPIPE;
+			return (-1);
+		}
+		off += (size_t)n;
+	}
+	return (0);
+}
+
+int
+kdfd_read_frame(int fd, uint8_t * body, size_t * bodylen)
+{
+	uint8_t len[4];
+	uint32_t n;
+	int rc;
+
+	if ((rc = read_full(fd, len, 4)) != 0)
+		return (rc);
+	if ((n = be32dec(len)) > KDFD_MAX_FRAME) {
+		errno = EMSGSIZE;
+		return (-1);
+	}
+	if (read_full(fd, body, n))
+		return (-1);
+	*bodylen = n;
+	return (0);
+}
+
+int
+kdfd_write_frame(int fd, const uint8_t * body, size_t bodylen)
+{
+	uint8_t buf[4 + KDFD_MAX_FRAME];
+	size_t off = 0, len;
+	ssize_t n;
+
+	/* Length and body in one buffer, to send small frames in one segment. */
+	if (bodylen > KDFD_MAX_FRAME) {
+		errno = EMSGSIZE;
+		return (-1);
+	}
+	be32enc(buf, (uint32_t)bodylen);
+	memcpy(&buf[4], body, bodylen);
+	for (len = 4 + bodylen; off < len; off += (size_t)n) {
+		if ((n = write(fd, &buf[off], len - off)) == -1) {
+			if (errno == EINTR) {
+				n = 0;
+				continue;
+			}
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+int
+kdfd_parse_scrypt(const uint8_t * body, size_t bodylen,
+    struct kdfd_scrypt_req * req)
+{
+
+	if (bodylen < KDFD_SCRYPT_LEN || body[0] != KDFD_OP_SCRYPT)
+		return (-1);
+	req->id = be32dec(&body[4]);
+	req->N = be64dec(&body[8]);
+	req->r = be32dec(&body[16]);
+	req->p = be32dec(&body[20]);
+	req->dklen = be32dec(&body[24]);
+	req->passwdlen = be32dec(&body[28]);
+	if (req->passwdlen > bodylen - KDFD_SCRYPT_LEN)
+		return (-1);
+	req->passwd = &body[KDFD_SCRYPT_LEN];
+	req->salt = &body[KDFD_SCRYPT_LEN + req->passwdlen];
+	req->saltlen = bodylen - KDFD_SCRYPT_LEN - req->passwdlen;
+
+	/* Keep every request within what one worker's scratch may grow to. */
+	if (req->N < 2 || req->N > KDFD_MAX_N || (req->N & (req->N - 1)) != 0)
+		return (-1);
+	if (req->r == 0 || req->p == 0 ||
+	    (uint64_t)(req->r) * req->p > KDFD_MAX_RP)
+		return (-1);
+	if (req->dklen == 0 || req->dklen > KDFD_MAX_DKLEN)
+		return (-1);
+	return (0);
+}
+
+size_t
+kdfd_encode_scrypt(const struct kdfd_scrypt_req * req, uint8_t * body)
+{
+	size_t len = KDFD_SCRYPT_LEN + req->passwdlen + req->saltlen;
+
+	if (req->passwdlen > KDFD_MAX_FRAME || len > KDFD_MAX_FRAME)
+		return (0);
+	memset(body, 0, KDFD_HEADER_LEN);
+	body[0] = KDFD_OP_SCRYPT;
+	be32enc(&body[4], req->id);
+	be64enc(&body[8], req->N);
+	be32enc(&body[16], req->r);
+	be32enc(&body[20], req->p);
+	be32enc(&body[24], req->dklen);
+	be32enc(&body[28], (uint32_t)req->passwdlen);
+	memcpy(&body[KDFD_SCRYPT_LEN], req->passwd, req->passwdlen);
+	memcpy(&body[KDFD_SCRYPT_LEN + req->passwdlen], req->salt, req->saltlen);
+	return (len);
+}
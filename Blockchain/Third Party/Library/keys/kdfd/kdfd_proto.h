@@ -0,0 +1,110 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _KDFD_PROTO_H_
+#define _KDFD_PROTO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Wire format of kdfd.  Every message is a frame: a big-endian uint32 length
+ * followed by that many bytes of body.  All integers are big-endian.
+ *
+ * Request body:
+ *	0	uint8	op
+ *	1	uint8	reserved[3]
+ *	4	uint32	id, echoed in the response
+ * KDFD_OP_SCRYPT continues with:
+ *	8	uint64	N
+ *	16	uint32	r
+ *	20	uint32	p
+ *	24	uint32	dkLen
+ *	28	uint32	passwdlen
+ *	32	passwd, then the salt up to the end of the body
+ *
+ * Response body:
+ *	0	uint8	op
+ *	1	uint8	status
+ *	2	uint8	reserved[2]
+ *	4	uint32	id
+ *	8	the derived key for KDFD_OP_SCRYPT, or the KDFD_STAT_* counters as
+ *		uint64s for KDFD_OP_STATS; nothing unless status is KDFD_OK.
+ *
+ * Responses on a connection may come back in any order.
+ */
+
+#define KDFD_OP_SCRYPT		1
+#define KDFD_OP_STATS		2
+
+#define KDFD_OK			0
+#define KDFD_EINVAL		1	/* Malformed, or parameters out of bounds. */
+#define KDFD_EBUSY		2	/* Queue full; retry later. */
+#define KDFD_EINTERNAL		3
+
+#define KDFD_HEADER_LEN		8
+#define KDFD_SCRYPT_LEN		32
+#define KDFD_MAX_FRAME		(64 * 1024)
+
+/* Bounds on what one request may ask for. */
+#define KDFD_MAX_N		((uint64_t)(1) << 20)
+#define KDFD_MAX_RP		64
+#define KDFD_MAX_DKLEN		1024
+
+/* Counters of KDFD_OP_STATS, in order. */
+enum {
+	KDFD_STAT_QUEUE_DEPTH,
+	KDFD_STAT_QUEUE_MAX,
+	KDFD_STAT_ACCEPTED,
+	KDFD_STAT_REJECTED,
+	KDFD_STAT_COMPLETED,
+	KDFD_STAT_FAILED,
+	KDFD_STAT_BATCHES,
+	KDFD_STAT_LATENCY_P50_US,
+	KDFD_STAT_LATENCY_P90_US,
+	KDFD_STAT_LATENCY_P99_US,
+	KDFD_STAT_LATENCY_MAX_US,
+	KDFD_STAT_COUNT
+};
+
+extern const char * const kdfd_stat_names[KDFD_STAT_COUNT];
+
+/* A KDFD_OP_SCRYPT request, pointing into the body it was parsed from. */
+struct kdfd_scrypt_req {
+	uint32_t id;
+	uint64_t N;
+	uint32_t r;
+	uint32_t p;
+	uint32_t dklen;
+	const uint8_t * passwd;
+	size_t passwdlen;
+	const uint8_t * salt;
+	size_t saltlen;
+};
+
+/**
+ * kdfd_read_frame(fd, body, bodylen):
+ * Read one frame into body, which must hold KDFD_MAX_FRAME bytes.  Return 0
+ * on success, 1 on end of file before the frame, or -1 on error.
+ */
+int kdfd_read_frame(int, uint8_t *, size_t *);
+
+/**
+ * kdfd_write_frame(fd, body, bodylen):
+ * Write a frame holding body.  Return 0 on success; or -1 on error.
+ */
+int kdfd_write_frame(int, const uint8_t *, size_t);
+
+/**
+ * kdfd_parse_scrypt(body, bodylen, req):
+ * Parse and bound-check a KDFD_OP_SCRYPT body.  Return 0 on success; or -1.
+ */
+int kdfd_parse_scrypt(const uint8_t *, size_t, struct kdfd_scrypt_req *);
+
+/**
+ * kdfd_encode_scrypt(req, body):
+ * Encode req into body, which must hold KDFD_MAX_FRAME bytes.  Return the
+ * length of the body; or 0 if it would not fit.
+ */
+size_t kdfd_encode_scrypt(const struct kdfd_scrypt_req *, uint8_t *);
+
+#endif /* !_KDFD_PROTO_H_ */
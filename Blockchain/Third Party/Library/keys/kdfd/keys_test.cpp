@@ -0,0 +1,184 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+/*
+ * keys_test: check keys.hpp against the C functions it wraps.
+ *
+ *	keys_test
+ *
+ * Compiles the header as C++20, checks scrypt_params and ScryptParams at
+ * compile time, then compares ScryptContext::derive with crypto_scrypt and
+ * HmacKey::pbkdf2 with PBKDF2_SHA256, and checks what moving a context or
+ * key leaves behind.  Prints each failure and exits non-zero if any.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "keys.hpp"
+
+/* Compile-time checks of the parameter validation. */
+static_assert(keys::scrypt_params<16384, 8, 1>.N == 16384);
+static_assert(keys::scrypt_params<16384, 8, 1> ==
+    keys::ScryptParams{16384, 8, 1});
+static_assert(keys::ScryptParams{1024, 8, 16}.check() == std::errc());
+static_assert(keys::ScryptParams{1000, 8, 16}.check() ==
+    std::errc::invalid_argument);
+static_assert(keys::ScryptParams{1, 8, 16}.check() ==
+    std::errc::invalid_argument);
+static_assert(keys::ScryptParams{1024, 0, 16}.check() ==
+    std::errc::invalid_argument);
+static_assert(keys::ScryptParams{1024, 1 << 15, 1 << 15}.check() ==
+    std::errc::file_too_large);
+static_assert(keys::ScryptParams{16, 1, 1}.scratch_bytes() ==
+    128 * 16 + 128 + 256 + 64);
+static_assert(keys::ScryptParams::make(1024, 8, 16).has_value());
+static_assert(keys::ScryptParams::make(1000, 8, 16).error() ==
+    std::errc::invalid_argument);
+static_assert(!std::is_copy_constructible_v<keys::ScryptContext>);
+static_assert(std::is_nothrow_move_constructible_v<keys::ScryptContext>);
+static_assert(!std::is_copy_constructible_v<keys::HmacKey>);
+static_assert(std::is_nothrow_move_assignable_v<keys::HmacKey>);
+
+static int failures;
+
+#define CHECK(cond) do {						\
+	if (!(cond)) {							\
+		fprintf(stderr, "keys_test: %s:%d: %s\n", __FILE__,	\
+		    __LINE__, #cond);					\
+		failures++;						\
+	}								\
+} while (0)
+
+static std::span<const std::uint8_t>
+bytes(const char * s)
+{
+
+	return (std::span(reinterpret_cast<const std::uint8_t *>(s),
+	    strlen(s)));
+}
+
+/* derive must give the bytes crypto_scrypt does, call after call. */
+static void
+check_derive(void)
+{
+	const keys::ScryptParams params = keys::scrypt_params<1024, 8, 16>;
+	std::uint8_t expected[64], out[64];
+	const char * salts[] = { "NaCl", "", "SodiumChloride" };
+
+	auto context = keys::ScryptContext::create(params);
+	CHECK(context.has_value());
+	if (!context)
+		return;
+	CHECK(context->params() == params);
+
+	for (const char * salt : salts) {
+		CHECK(crypto_scrypt(bytes("password").data(), 8,
+		    bytes(salt).data(), strlen(salt), params.N, params.r,
+		    params.p, expected, sizeof(expected)) == 0);
+		CHECK(context->derive(bytes("password"), bytes(salt),
+		    out).has_value());
+		CHECK(memcmp(out, expected, sizeof(out)) == 0);
+	}
+
+	/* RFC 7914, section 12. */
+	static const std::uint8_t rfc[8] = {
+		0xfd, 0xba, 0xbe, 0x1c, 0x9d, 0x34, 0x72, 0x00
+	};
+	CHECK(context->derive(bytes("password"), bytes("NaCl"),
+	    out).has_value());
+	CHECK(memcmp(out, rfc, sizeof(rfc)) == 0);
+
+	CHECK(keys::ScryptContext::create({1000, 8, 16}).error() ==
+	    std::errc::invalid_argument);
+}
+
+/* pbkdf2 must give the bytes PBKDF2_SHA256 does, at every length. */
+static void
+check_pbkdf2(void)
+{
+	keys::HmacKey key(bytes("passwd"));
+	std::uint8_t expected[100], out[100];
+	std::size_t lens[] = { 1, 31, 32, 33, 64, 100 };
+	std::uint64_t iterations[] = { 1, 2, 1000 };
+
+	for (std::uint64_t c : iterations) {
+		for (std::size_t len : lens) {
+			PBKDF2_SHA256(bytes("passwd").data(), 6,
+			    bytes("salt").data(), 4, c, expected, len);
+			memset(out, 0, sizeof(out));
+			CHECK(key.pbkdf2(bytes("salt"), c,
+			    std::span(out, len)).has_value());
+			CHECK(memcmp(out, expected, len) == 0);
+		}
+	}
+
+	/* RFC 7914, section 11. */
+	static const std::uint8_t rfc[8] = {
+		0x55, 0xac, 0x04, 0x6e, 0x56, 0xe3, 0x08, 0x9f
+	};
+	CHECK(key.pbkdf2(bytes("salt"), 1, std::span(out, 64)).has_value());
+	CHECK(memcmp(out, rfc, sizeof(rfc)) == 0);
+
+	CHECK(key.pbkdf2(bytes("salt"), 0, out).error() ==
+	    std::errc::invalid_argument);
+}
+
+/* A moved-to object carries on; a moved-from context refuses to derive. */
+static void
+check_moves(void)
+{
+	std::uint8_t expected[32], out[32];
+
+	auto created = keys::ScryptContext::create(
+	    keys::scrypt_params<16, 1, 1>);
+	CHECK(created.has_value());
+	if (!created)
+		return;
+	CHECK(created->derive(bytes("pw"), bytes("salt"),
+	    expected).has_value());
+
+	keys::ScryptContext moved(std::move(*created));
+	CHECK(moved.derive(bytes("pw"), bytes("salt"), out).has_value());
+	CHECK(memcmp(out, expected, sizeof(out)) == 0);
+	CHECK(created->derive(bytes("pw"), bytes("salt"), out).error() ==
+	    std::errc::invalid_argument);
+
+	auto other = keys::ScryptContext::create(
+	    keys::scrypt_params<32, 1, 1>);
+	CHECK(other.has_value());
+	if (other) {
+		*other = std::move(moved);
+		CHECK(other->params() == (keys::scrypt_params<16, 1, 1>));
+		CHECK(other->derive(bytes("pw"), bytes("salt"),
+		    out).has_value());
+		CHECK(memcmp(out, expected, sizeof(out)) == 0);
+		CHECK(moved.derive(bytes("pw"), bytes("salt"), out).error() ==
+		    std::errc::invalid_argument);
+	}
+
+	keys::HmacKey key(bytes("key"));
+	key.mac(bytes("message"), std::span<std::uint8_t, 32>(expected));
+	keys::HmacKey moved_key(std::move(key));
+	moved_key.mac(bytes("message"), std::span<std::uint8_t, 32>(out));
+	CHECK(memcmp(out, expected, sizeof(out)) == 0);
+	keys::HmacKey assigned(bytes("other"));
+	assigned = std::move(moved_key);
+	assigned.mac(bytes("message"), std::span<std::uint8_t, 32>(out));
+	CHECK(memcmp(out, expected, sizeof(out)) == 0);
+}
+
+int
+main(void)
+{
+
+	check_derive();
+	check_pbkdf2();
+	check_moves();
+	if (failures != 0) {
+		fprintf(stderr, "keys_test: %d checks failed\n", failures);
+		return (1);
+	}
+	printf("keys_test: ok\n");
+	return (0);
+}
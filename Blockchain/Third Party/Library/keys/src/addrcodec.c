@@ -0,0 +1,578 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "keyhash.h"
+
+#include "addrcodec.h"
+
+static const char B58_ALPHABET[] =
+    "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+/* Digit values of Base58 characters, or -1. */
+static const int8_t B58_DIGITS[128] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1,  0,  1,  2,  3,  4,  5,  6,  7,  8, -1, -1, -1, -1, -1, -1,
+	-1,  9, 10, 11, 12, 13, 14, 15, 16, -1, 17, 18, 19, 20, 21, -1,
+	22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, -1, -1, -1, -1, -1,
+	-1, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, -1, 44, 45, 46,
+	47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, -1, -1, -1, -1, -1
+};
+
+/* Base58 is converted five digits at a time: 58^5 < 2^32. */
+#define B58_CHUNK	5
+#define B58_CHUNK_BASE	656356768U
+
+/* Longest Base58 string accepted, and limbs enough for its value. */
+#define B58_MAX_CHARS	(ADDRCODEC_MAX_STRING - 1)
+#define B58_LIMBS	((B58_MAX_CHARS * 6 + 31) / 32 + 1)
+
+static const char BECH32_CHARSET[] = "qpzry9x8gf2tvdw0s3jn54khce6mua7l";
+
+/* Values of Bech32 and CashAddr characters, lower case only, or -1. */
+static const int8_t BECH32_VALUES[128] = {
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+	 1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1
+};
+
+/*
+ * Generator terms of the Bech32 checksum for each value of the five bits
+ * shifted out of the top, so one step is a shift, an xor and a lookup.
+ */
+static const uint32_t BECH32_GEN[32] = {
+	0x00000000, 0x3b6a57b2, 0x26508e6d, 0x1d3ad9df,
+	0x1ea119fa, 0x25cb4e48, 0x38f19797, 0x039bc025,
+	0x3d4233dd, 0x0628646f, 0x1b12bdb0, 0x2078ea02,
+	0x23e32a27, 0x18897d95, 0x05b3a44a, 0x3ed9f3f8,
+	0x2a1462b3, 0x117e3501, 0x0c44ecde, 0x372ebb6c,
+	0x34b57b49, 0x0fdf2cfb, 0x12e5f524, 0x298fa296,
+	0x1756516e, 0x2c3c06dc, 0x3106df03, 0x0a6c88b1,
+	0x09f74894, 0x329d1f26, 0x2fa7c6f9, 0x14cd914b
+};
+
+/* The same for the 40-bit CashAddr checksum. */
+static const uint64_t CASHADDR_GEN[32] = {
+	0x0000000000, 0x98f2bc8e61, 0x79b76d99e2, 0xe145d11783,
+	0xf33e5fb3c4, 0x6bcce33da5, 0x8a89322a26, 0x127b8ea447,
+	0xae2eabe2a8, 0x36dc176cc9, 0xd799c67b4a, 0x4f6b7af52b,
+	0x5d10f4516c, 0xc5e248df0d, 0x24a799c88e, 0xbc552546ef,
+	0x1e4f43e470, 0x86bdff6a11, 0x67f82e7d92, 0xff0a92f3f3,
+	0xed711c57b4, 0x7583a0d9d5, 0x94c671ce56, 0x0c34cd4037,
+	0xb061e806d8, 0x28935488b9, 0xc9d6859f3a, 0x512439115b,
+	0x435fb7b51c, 0xdbad0b3b7d, 0x3ae8da2cfe, 0xa21a66a29f
+};
+
+#define BECH32_CONST	1
+#define BECH32M_CONST	0x2bc830a3
+#define BECH32_MAX_LEN	90
+
+/* Hash lengths for each CashAddr size code. */
+static const uint8_t CASHADDR_SIZES[8] = { 20, 24, 28, 32, 40, 48, 56, 64 };
+
+static inline uint32_t
+bech32_step(uint32_t c, uint8_t v)
+{
+
+	return (((c & 0x1ffffff) << 5) ^ v ^ BECH32_GEN[c >> 25]);
+}
+
+static inline uint64_t
+cashaddr_step(uint64_t c, uint8_t v)
+{
+
+	return (((c & 0x07ffffffffULL) << 5) ^ v ^ CASHADDR_GEN[c >> 35]);
+}
+
+static inline char
+lower(char ch)
+{
+
+	return ((ch >= 'A' && ch <= 'Z') ? (char)(ch + ('a' - 'A')) : ch);
+}
+
+/*
+ * Regroup the inbits-bit values in[0 .. inlen - 1] into outbits-bit values
+ * in out.  Without pad, leftover bits must be fewer than inbits and zero.
+ * Return the number of values written, or -1.
+ */
+static int
+convert_bits(const uint8_t * in, size_t inlen, int inbits, uint8_t * out,
+    size_t outlen, int outbits, int pad)
+{
+	uint32_t acc = 0, maxv = (1U << outbits) - 1;
+	size_t i, n = 0;
+	int bits = 0;
+
+	for (i = 0; i < inlen; i++) {
+		acc = ((acc << inbits) | in[i]) & 0xffffff;
+		bits += inbits;
+		while (bits >= outbits) {
+			bits -= outbits;
+			if (n == outlen)
+				return (-1);
+			out[n++] = (uint8_t)((acc >> bits) & maxv);
+		}
+	}
+	if (pad) {
+		if (bits > 0) {
+			if (n == outlen)
+				return (-1);
+			out[n++] = (uint8_t)((acc << (outbits - bits)) & maxv);
+		}
+	} else if (bits >= inbits || ((acc << (outbits - bits)) & maxv)) {
+		return (-1);
+	}
+	return ((int)n);
+}
+
+int
+base58_encode(const uint8_t * in, size_t len, char * out, size_t outlen)
+{
+	uint32_t L[B58_LIMBS];
+	char digits[B58_MAX_CHARS + B58_CHUNK];
+	uint64_t t;
+	uint32_t rem;
+	size_t zeros, nlimbs, ndigits = 0, i, j;
+
+	if (len > ADDRCODEC_MAX_PAYLOAD)
+		return (-1);
+	for (zeros = 0; zeros < len && in[zeros] == 0; zeros++)
+		continue;
+
+	/* The rest of in as a little-endian array of limbs. */
+	nlimbs = (len - zeros + 3) / 4;
+	memset(L, 0, sizeof(L));
+	for (i = 0; i < len - zeros; i++)
+		L[i / 4] |= (uint32_t)(in[len - 1 - i]) << (8 * (i % 4));
+
+	/* Divide by 58^5 until nothing is left, five digits per remainder. */
+	while (nlimbs > 0) {
+		rem = 0;
+		for (i = nlimbs; i > 0; i--) {
+			t = ((uint64_t)(rem) << 32) | L[i - 1];
+			L[i - 1] = (uint32_t)(t / B58_CHUNK_BASE);
+			rem = (uint32_t)(t % B58_CHUNK_BASE);
+		}
+		while (nlimbs > 0 && L[nlimbs - 1] == 0)
+			nlimbs--;
+		for (j = 0; j < B58_CHUNK; j++) {
+			digits[ndigits++] = B58_ALPHABET[rem % 58];
+			rem /= 58;
+		}
+	}
+
+	/* The last chunk is padded with zero digits; leading zeros are ones. */
+	while (ndigits > 0 && digits[ndigits - 1] == B58_ALPHABET[0])
+		ndigits--;
+	if (zeros + ndigits + 1 > outlen)
+		return (-1);
+	memset(out, B58_ALPHABET[0], zeros);
+	for (i = 0; i < ndigits; i++)
+		out[zeros + i] = digits[ndigits - 1 - i];
+	out[zeros + ndigits] = '\0';
+	return ((int)(zeros + ndigits));
+}
+
+int
+base58_decode(const char * str, uint8_t * out, size_t outlen)
+{
+	uint32_t L[B58_LIMBS];
+	uint64_t t;
+	uint32_t chunk, mul;
+	size_t len, zeros, nlimbs = 0, nbytes, i, j, k;
+	int d;
+
+	len = strlen(str);
+	if (len > B58_MAX_CHARS)
+		return (-1);
+	for (zeros = 0; zeros < len && str[zeros] == B58_ALPHABET[0]; zeros++)
+		continue;
+
+	/* Multiply in five digits at a time. */
+	for (i = zeros; i < len; i += k) {
+		chunk = 0;
+		mul = 1;
+		for (k = 0; k < B58_CHUNK && i + k < len; k++) {
+			if ((unsigned char)(str[i + k]) >= 128 ||
+			    (d = B58_DIGITS[(unsigned char)(str[i + k])]) < 0)
+				return (-1);
+			chunk = chunk * 58 + (uint32_t)(d);
+			mul *= 58;
+		}
+		t = chunk;
+		for (j = 0; j < nlimbs; j++) {
+			t += (uint64_t)(L[j]) * mul;
+			L[j] = (uint32_t)(t);
+			t >>= 32;
+		}
+		if (t != 0)
+			L[nlimbs++] = (uint32_t)(t);
+	}
+
+	/* Big-endian bytes of the value, after the leading zero bytes. */
+	nbytes = nlimbs * 4;
+	while (nbytes > 0 && ((L[(nbytes - 1) / 4] >> (8 * ((nbytes - 1) % 4)))
+	    & 0xff) == 0)
+		nbytes--;
+	if (zeros + nbytes > outlen)
+		return (-1);
+	memset(out, 0, zeros);
+	for (i = 0; i < nbytes; i++)
+		out[zeros + nbytes - 1 - i] =
+		    (uint8_t)(L[i / 4] >> (8 * (i % 4)));
+	return ((int)(zeros + nbytes));
+}
+
+int
+base58check_encode(const uint8_t * in, size_t len, char * out, size_t outlen)
+{
+	uint8_t buf[ADDRCODEC_MAX_PAYLOAD];
+	uint8_t digest[32];
+
+	if (len + 4 > sizeof(buf))
+		return (-1);
+	memcpy(buf, in, len);
+	sha256d(in, len, digest);
+	memcpy(&buf[len], digest, 4);
+	return (base58_encode(buf, len + 4, out, outlen));
+}
+
+int
+base58check_decode(const char * str, uint8_t * out, size_t outlen)
+{
+	uint8_t buf[ADDRCODEC_MAX_STRING];
+	uint8_t digest[32];
+	int n;
+
+	if ((n = base58_decode(str, buf, sizeof(buf))) <= 4 ||
+	    (size_t)(n - 4) > outlen)
+		return (-1);
+	sha256d(buf, (size_t)(n - 4), digest);
+	if (memcmp(&buf[n - 4], digest, 4) != 0)
+		return (-1);
+	memcpy(out, buf, (size_t)(n - 4));
+	return (n - 4);
+}
+
+/* Fold the human-readable part of a Bech32 string into a checksum. */
+static uint32_t
+bech32_hrp(const char * hrp, size_t hrplen)
+{
+	uint32_t c = 1;
+	size_t i;
+
+	for (i = 0; i < hrplen; i++)
+		c = bech32_step(c, (uint8_t)(lower(hrp[i]) >> 5));
+	c = bech32_step(c, 0);
+	for (i = 0; i < hrplen; i++)
+		c = bech32_step(c, (uint8_t)(lower(hrp[i]) & 31));
+	return (c);
+}
+
+int
+segwit_addr_encode(const char * hrp, int witver, const uint8_t * prog,
+    size_t proglen, char * out, size_t outlen)
+{
+	uint8_t data[1 + 64];
+	uint32_t c;
+	size_t hrplen = strlen(hrp), len, i;
+	int n;
+
+	if (witver < 0 || witver > 16 || proglen < 2 || proglen > 40 ||
+	    (witver == 0 && proglen != 20 && proglen != 32) || hrplen < 1)
+		return (-1);
+	data[0] = (uint8_t)(witver);
+	if ((n = convert_bits(prog, proglen, 8, &data[1], sizeof(data) - 1, 5,
+	    1)) < 0)
+		return (-1);
+	len = hrplen + 1 + 1 + (size_t)(n) + 6;
+	if (len > BECH32_MAX_LEN || len + 1 > outlen)
+		return (-1);
+
+	c = bech32_hrp(hrp, hrplen);
+	for (i = 0; i < hrplen; i++)
+		out[i] = lower(hrp[i]);
+	out[hrplen] = '1';
+	for (i = 0; i < 1 + (size_t)(n); i++) {
+		c = bech32_step(c, data[i]);
+		out[hrplen + 1 + i] = BECH32_CHARSET[data[i]];
+	}
+	for (i = 0; i < 6; i++)
+		c = bech32_step(c, 0);
+	c ^= (witver == 0) ? BECH32_CONST : BECH32M_CONST;
+	for (i = 0; i < 6; i++)
+		out[len - 6 + i] = BECH32_CHARSET[(c >> (5 * (5 - i))) & 31];
+	out[len] = '\0';
+	return ((int)(len));
+}
+
+int
+segwit_addr_decode(const char * hrp, const char * addr, int * witver,
+    uint8_t * prog, size_t proglen)
+{
+	uint8_t data[BECH32_MAX_LEN];
+	uint32_t c;
+	size_t len = strlen(addr), hrplen, ndata, i;
+	int upper = 0, lowerc = 0, n, v;
+	bech32_encoding encoding;
+
+	if (len > BECH32_MAX_LEN)
+		return (-1);
+	for (i = 0; i < len; i++) {
+		if (addr[i] < 33 || addr[i] > 126)
+			return (-1);
+		upper |= (addr[i] >= 'A' && addr[i] <= 'Z');
+		lowerc |= (addr[i] >= 'a' && addr[i] <= 'z');
+	}
+	if (upper && lowerc)
+		return (-1);
+
+	/* The separator is the last '1'; at least six checksum symbols. */
+	for (hrplen = len; hrplen > 0 && addr[hrplen - 1] != '1'; hrplen--)
+		continue;
+	if (hrplen-- < 2 || len - hrplen - 1 < 7 || hrplen != strlen(hrp))
+		return (-1);
+	for (i = 0; i < hrplen; i++)
+		if (lower(addr[i]) != lower(hrp[i]))
+			return (-1);
+
+	c = bech32_hrp(addr, hrplen);
+	ndata = len - hrplen - 1;
+	for (i = 0; i < ndata; i++) {
+		v = BECH32_VALUES[(unsigned char)(lower(addr[hrplen + 1 + i]))];
+		if (v < 0)
+			return (-1);
+		data[i] = (uint8_t)(v);
+		c = bech32_step(c, data[i]);
+	}
+	if (c == BECH32_CONST)
+		encoding = BECH32_ENCODING_BECH32;
+	else if (c == BECH32M_CONST)
+		encoding = BECH32_ENCODING_BECH32M;
+	else
+		return (-1);
+
+	/* Version 0 is Bech32; later versions are Bech32m. */
+	if (data[0] > 16 || (encoding == BECH32_ENCODING_BECH32) !=
+	    (data[0] == 0))
+		return (-1);
+	if ((n = convert_bits(&data[1], ndata - 7, 5, prog, proglen, 8, 0)) < 2 ||
+	    n > 40 || (data[0] == 0 && n != 20 && n != 32))
+		return (-1);
+	*witver = data[0];
+	return (n);
+}
+
+int
+cashaddr_encode(const char * prefix, cashaddr_type type, const uint8_t * hash,
+    size_t hashlen, char * out, size_t outlen)
+{
+	uint8_t payload[1 + 64];
+	uint8_t data[(8 * (1 + 64) + 4) / 5];
+	uint64_t c = 1;
+	size_t prefixlen = strlen(prefix), len, i;
+	int n, size;
+
+	for (size = 0; size < 8 && CASHADDR_SIZES[size] != hashlen; size++)
+		continue;
+	if (size == 8 || (type != CASHADDR_P2PKH && type != CASHADDR_P2SH))
+		return (-1);
+	payload[0] = (uint8_t)(((int)(type) << 3) | size);
+	memcpy(&payload[1], hash, hashlen);
+	if ((n = convert_bits(payload, 1 + hashlen, 8, data, sizeof(data), 5,
+	    1)) < 0)
+		return (-1);
+	len = prefixlen + 1 + (size_t)(n) + 8;
+	if (len + 1 > outlen)
+		return (-1);
+
+	for (i = 0; i < prefixlen; i++) {
+		out[i] = lower(prefix[i]);
+		c = cashaddr_step(c, (uint8_t)(prefix[i] & 31));
+	}
+	c = cashaddr_step(c, 0);
+	out[prefixlen] = ':';
+	for (i = 0; i < (size_t)(n); i++) {
+		c = cashaddr_step(c, data[i]);
+		out[prefixlen + 1 + i] = BECH32_CHARSET[data[i]];
+	}
+	for (i = 0; i < 8; i++)
+		c = cashaddr_step(c, 0);
+	c ^= 1;
+	for (i = 0; i < 8; i++)
+		out[len - 8 + i] = BECH32_CHARSET[(c >> (5 * (7 - i))) & 31];
+	out[len] = '\0';
+	return ((int)(len));
+}
+
+int
+cashaddr_decode(const char * prefix, const char * addr, cashaddr_type * type,
+    uint8_t * hash, size_t hashlen)
+{
+	uint8_t data[ADDRCODEC_MAX_STRING];
+	uint8_t payload[1 + 64];
+	uint64_t c = 1;
+	const char * sep = strchr(addr, ':');
+	const char * p;
+	size_t prefixlen = strlen(prefix), ndata, i;
+	int upper = 0, lowerc = 0, n, v;
+
+	for (p = addr; *p != '\0'; p++) {
+		upper |= (*p >= 'A' && *p <= 'Z');
+		lowerc |= (*p >= 'a' && *p <= 'z');
+	}
+	if (upper && lowerc)
+		return (-1);
+
+	/* The prefix may be left out, but must match if written. */
+	if (sep != NULL) {
+		if ((size_t)(sep - addr) != prefixlen)
+			return (-1);
+		for (i = 0; i < prefixlen; i++)
+			if (lower(addr[i]) != lower(prefix[i]))
+				return (-1);
+		addr = sep + 1;
+	}
+	ndata = strlen(addr);
+	if (ndata <= 8 || ndata > sizeof(data))
+		return (-1);
+
+	for (i = 0; i < prefixlen; i++)
+		c = cashaddr_step(c, (uint8_t)(prefix[i] & 31));
+	c = cashaddr_step(c, 0);
+	for (i = 0; i < ndata; i++) {
+		if ((unsigned char)(addr[i]) >= 128 ||
+		    (v = BECH32_VALUES[(unsigned char)(lower(addr[i]))]) < 0)
+			return (-1);
+		data[i] = (uint8_t)(v);
+		c = cashaddr_step(c, data[i]);
+	}
+	if ((c ^ 1) != 0)
+		return (-1);
+
+	if ((n = convert_bits(data, ndata - 8, 5, payload, sizeof(payload), 8,
+	    0)) < 1 || (payload[0] & 0x80) ||
+	    (size_t)(n - 1) != CASHADDR_SIZES[payload[0] & 7] ||
+	    (size_t)(n - 1) > hashlen)
+		return (-1);
+	if ((payload[0] >> 3) != CASHADDR_P2PKH &&
+	    (payload[0] >> 3) != CASHADDR_P2SH)
+		return (-1);
+	*type = (cashaddr_type)(payload[0] >> 3);
+	memcpy(hash, &payload[1], (size_t)(n - 1));
+	return (n - 1);
+}
+
+int
+cashaddr_to_legacy(const char * prefix, const char * addr, char * out,
+    size_t outlen)
+{
+	uint8_t payload[1 + 20];
+	cashaddr_type type;
+
+	if (cashaddr_decode(prefix, addr, &type, &payload[1], 20) != 20)
+		return (-1);
+	payload[0] = (type == CASHADDR_P2SH) ? ADDRCODEC_VERSION_P2SH :
+	    ADDRCODEC_VERSION_P2PKH;
+	return (base58check_encode(payload, sizeof(payload), out, outlen));
+}
+
+int
+legacy_to_cashaddr(const char * prefix, const char * addr, char * out,
+    size_t outlen)
+{
+	uint8_t payload[1 + 20];
+
+	if (base58check_decode(addr, payload, sizeof(payload)) != 21)
+		return (-1);
+	if (payload[0] == ADDRCODEC_VERSION_P2PKH)
+		return (cashaddr_encode(prefix, CASHADDR_P2PKH, &payload[1], 20,
+		    out, outlen));
+	if (payload[0] == ADDRCODEC_VERSION_P2SH)
+		return (cashaddr_encode(prefix, CASHADDR_P2SH, &payload[1], 20,
+		    out, outlen));
+	return (-1);
+}
+
+/* Payloads checksummed per sha256d_batch call in base58check_encode_batch. */
+#define CHECKSUM_BATCH	64
+
+size_t
+base58check_encode_batch(const uint8_t * in, size_t len, size_t n, char * out,
+    size_t stride)
+{
+	uint8_t digests[CHECKSUM_BATCH * 32];
+	uint8_t buf[ADDRCODEC_MAX_PAYLOAD];
+	size_t done = 0, i, j, m;
+
+	for (i = 0; i < n; i += m) {
+		m = (n - i < CHECKSUM_BATCH) ? n - i : CHECKSUM_BATCH;
+		if (len + 4 <= sizeof(buf))
+			sha256d_batch(&in[i * len], len, m, digests);
+		for (j = 0; j < m; j++) {
+			out[(i + j) * stride] = '\0';
+			if (len + 4 > sizeof(buf))
+				continue;
+			memcpy(buf, &in[(i + j) * len], len);
+			memcpy(&buf[len], &digests[j * 32], 4);
+			if (base58_encode(buf, len + 4, &out[(i + j) * stride],
+			    stride) >= 0)
+				done++;
+		}
+	}
+	return (done);
+}
+
+size_t
+base58check_decode_batch(const char * const * strs, size_t n, uint8_t * out,
+    size_t stride, int * lens)
+{
+	size_t done = 0, i;
+
+	for (i = 0; i < n; i++)
+		if ((lens[i] = base58check_decode(strs[i], &out[i * stride],
+		    stride)) >= 0)
+			done++;
+	return (done);
+}
+
+size_t
+cashaddr_to_legacy_batch(const char * prefix, const char * const * addrs,
+    size_t n, char * out, size_t stride)
+{
+	size_t done = 0, i;
+
+	for (i = 0; i < n; i++) {
+		if (cashaddr_to_legacy(prefix, addrs[i], &out[i * stride],
+		    stride) >= 0)
+			done++;
+		else if (stride > 0)
+			out[i * stride] = '\0';
+	}
+	return (done);
+}
+
+size_t
+legacy_to_cashaddr_batch(const char * prefix, const char * const * addrs,
+    size_t n, char * out, size_t stride)
+{
+	size_t done = 0, i;
+
+	for (i = 0; i < n; i++) {
+		if (legacy_to_cashaddr(prefix, addrs[i], &out[i * stride],
+		    stride) >= 0)
+			done++;
+		else if (stride > 0)
+			out[i * stride] = '\0';
+	}
+	return (done);
+}
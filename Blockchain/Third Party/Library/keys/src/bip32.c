@@ -0,0 +1,283 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/sha.h>
+
+#include "addrcodec.h"
+#include "eckey.h"
+#include "keyhash.h"
+#include "sysendian.h"
+
+#include "bip32.h"
+
+/* Length of a serialized node before Base58Check. */
+#define BIP32_SERIALIZED_LENGTH	78
+
+typedef struct {
+	SHA512_CTX ictx;
+	SHA512_CTX octx;
+} hmac_sha512_ctx;
+
+/* Set up HMAC-SHA512 with a key of at most one block. */
+static void
+hmac_sha512_init(hmac_sha512_ctx * ctx, const uint8_t * key, size_t keylen)
+{
+	uint8_t pad[SHA512_CBLOCK];
+	size_t i;
+
+	memset(pad, 0x36, sizeof(pad));
+	for (i = 0; i < keylen; i++)
+		pad[i] ^= key[i];
+	SHA512_Init(&ctx->ictx);
+	SHA512_Update(&ctx->ictx, pad, sizeof(pad));
+
+	memset(pad, 0x5c, sizeof(pad));
+	for (i = 0; i < keylen; i++)
+		pad[i] ^= key[i];
+	SHA512_Init(&ctx->octx);
+	SHA512_Update(&ctx->octx, pad, sizeof(pad));
+
+	memset(pad, 0, sizeof(pad));
+}
+
+/* HMAC of data under a key set up once: the context is left unchanged. */
+static void
+hmac_sha512(const hmac_sha512_ctx * key, const uint8_t * data, size_t len,
+    uint8_t out[64])
+{
+	hmac_sha512_ctx ctx = *key;
+	uint8_t ihash[64];
+
+	SHA512_Update(&ctx.ictx, data, len);
+	SHA512_Final(ihash, &ctx.ictx);
+	SHA512_Update(&ctx.octx, ihash, sizeof(ihash));
+	SHA512_Final(out, &ctx.octx);
+	memset(&ctx, 0, sizeof(ctx));
+}
+
+/* Fill in the fields a child takes from its parent. */
+static void
+child_init(const bip32_node * parent, uint32_t index, bip32_node * child)
+{
+	uint8_t id[20];
+
+	hash160_33(parent->pubkey, id);
+	memcpy(child->parent_fingerprint, id, 4);
+	child->depth = (uint8_t)(parent->depth + 1);
+	child->child = index;
+}
+
+int
+bip32_from_seed(const uint8_t * seed, size_t seedlen, bip32_node * node)
+{
+	static const uint8_t KEY[] = "Bitcoin seed";
+	hmac_sha512_ctx ctx;
+	uint8_t I[64];
+	int rc = -1;
+
+	if (seedlen < 16 || seedlen > 64)
+		return (-1);
+	hmac_sha512_init(&ctx, KEY, sizeof(KEY) - 1);
+	hmac_sha512(&ctx, seed, seedlen, I);
+
+	memset(node, 0, sizeof(*node));
+	memcpy(node->seckey, I, 32);
+	memcpy(node->chain_code, &I[32], 32);
+	if (eckey_pubkey_create(node->seckey, node->pubkey) == 0) {
+		node->has_seckey = 1;
+		rc = 0;
+	} else {
+		bip32_wipe(node);
+	}
+	memset(I, 0, sizeof(I));
+	return (rc);
+}
+
+int
+bip32_ckd(const bip32_node * parent, uint32_t index, bip32_node * child)
+{
+	hmac_sha512_ctx ctx;
+	uint8_t data[37], I[64];
+	bip32_node out;
+	int rc = -1;
+
+	if ((index & BIP32_HARDENED) && !parent->has_seckey)
+		return (-1);
+	if (parent->depth == UINT8_MAX)
+		return (-1);
+
+	/* Hardened children hash the secret key, others the public key. */
+	if (index & BIP32_HARDENED) {
+		data[0] = 0;
+		memcpy(&data[1], parent->seckey, 32);
+	} else {
+		memcpy(data, parent->pubkey, 33);
+	}
+	be32enc(&data[33], index);
+	hmac_sha512_init(&ctx, parent->chain_code, 32);
+	hmac_sha512(&ctx, data, sizeof(data), I);
+
+	memset(&out, 0, sizeof(out));
+	child_init(parent, index, &out);
+	memcpy(out.chain_code, &I[32], 32);
+	if (parent->has_seckey) {
+		memcpy(out.seckey, parent->seckey, 32);
+		if (eckey_seckey_tweak_add(out.seckey, I) ||
+		    eckey_pubkey_create(out.seckey, out.pubkey))
+			goto done;
+		out.has_seckey = 1;
+	} else if (eckey_pubkey_tweak_add(parent->pubkey, I, out.pubkey)) {
+		goto done;
+	}
+	*child = out;
+	rc = 0;
+
+done:
+	bip32_wipe(&out);
+	memset(data, 0, sizeof(data));
+	memset(I, 0, sizeof(I));
+	memset(&ctx, 0, sizeof(ctx));
+	return (rc);
+}
+
+int
+bip32_derive_path(const bip32_node * node, const uint32_t * path, size_t depth,
+    bip32_node * out)
+{
+	bip32_node cur = *node;
+	size_t i;
+
+	for (i = 0; i < depth; i++) {
+		if (bip32_ckd(&cur, path[i], &cur)) {
+			bip32_wipe(&cur);
+			return (-1);
+		}
+	}
+	*out = cur;
+	bip32_wipe(&cur);
+	return (0);
+}
+
+void
+bip32_neuter(bip32_node * node)
+{
+
+	memset(node->seckey, 0, sizeof(node->seckey));
+	node->has_seckey = 0;
+}
+
+void
+bip32_wipe(bip32_node * node)
+{
+	volatile uint8_t * p = (volatile uint8_t *)(node);
+	size_t i;
+
+	/* Through a volatile pointer, so the stores are not elided. */
+	for (i = 0; i < sizeof(*node); i++)
+		p[i] = 0;
+}
+
+int
+bip32_serialize(const bip32_node * node, int private, char * out,
+    size_t outlen)
+{
+	uint8_t buf[BIP32_SERIALIZED_LENGTH];
+	int rc;
+
+	private = private && node->has_seckey;
+	be32enc(&buf[0], private ? BIP32_VERSION_XPRV : BIP32_VERSION_XPUB);
+	buf[4] = node->depth;
+	memcpy(&buf[5], node->parent_fingerprint, 4);
+	be32enc(&buf[9], node->child);
+	memcpy(&buf[13], node->chain_code, 32);
+	if (private) {
+		buf[45] = 0;
+		memcpy(&buf[46], node->seckey, 32);
+	} else {
+		memcpy(&buf[45], node->pubkey, 33);
+	}
+	rc = base58check_encode(buf, sizeof(buf), out, outlen);
+	memset(buf, 0, sizeof(buf));
+	return (rc);
+}
+
+int
+bip32_parse(const char * str, bip32_node * node)
+{
+	uint8_t buf[BIP32_SERIALIZED_LENGTH];
+	bip32_node out;
+	uint32_t version;
+	int rc = -1;
+
+	if (base58check_decode(str, buf, sizeof(buf)) != sizeof(buf))
+		return (-1);
+	memset(&out, 0, sizeof(out));
+	version = be32dec(&buf[0]);
+	out.depth = buf[4];
+	memcpy(out.parent_fingerprint, &buf[5], 4);
+	out.child = be32dec(&buf[9]);
+	memcpy(out.chain_code, &buf[13], 32);
+
+	/* A master node has no parent and is child number 0. */
+	if (out.depth == 0 && (be32dec(&buf[5]) != 0 || out.child != 0))
+		goto done;
+	if (version == BIP32_VERSION_XPRV) {
+		if (buf[45] != 0)
+			goto done;
+		memcpy(out.seckey, &buf[46], 32);
+		if (eckey_pubkey_create(out.seckey, out.pubkey))
+			goto done;
+		out.has_seckey = 1;
+	} else if (version == BIP32_VERSION_XPUB) {
+		memcpy(out.pubkey, &buf[45], 33);
+		if (eckey_pubkey_verify(out.pubkey))
+			goto done;
+	} else {
+		goto done;
+	}
+	*node = out;
+	rc = 0;
+
+done:
+	bip32_wipe(&out);
+	memset(buf, 0, sizeof(buf));
+	return (rc);
+}
+
+size_t
+bip32_ckd_pub_batch(const bip32_node * parent, uint32_t first, size_t n,
+    uint8_t * pubkeys, uint8_t * hash160s, int * ok)
+{
+	hmac_sha512_ctx ctx;
+	uint8_t data[37], I[64];
+	uint8_t * tweaks;
+	size_t i, done;
+
+	if (n == 0)
+		return (0);
+	if ((first & BIP32_HARDENED) || n - 1 > (BIP32_HARDENED - 1) - first)
+		return ((size_t)(-1));
+	if ((tweaks = malloc(n * 32)) == NULL)
+		return ((size_t)(-1));
+
+	/* The chain code keys every child's HMAC; set it up once. */
+	hmac_sha512_init(&ctx, parent->chain_code, 32);
+	memcpy(data, parent->pubkey, 33);
+	for (i = 0; i < n; i++) {
+		be32enc(&data[33], first + (uint32_t)(i));
+		hmac_sha512(&ctx, data, sizeof(data), I);
+		memcpy(&tweaks[i * 32], I, 32);
+	}
+
+	done = eckey_pubkey_tweak_add_batch(parent->pubkey, tweaks, n, pubkeys,
+	    ok);
+	if (done != (size_t)(-1) && hash160s != NULL)
+		hash160_batch(pubkeys, 33, n, hash160s);
+
+	free(tweaks);
+	memset(&ctx, 0, sizeof(ctx));
+	return (done);
+}
@@ -40,13 +40,110 @@
 #include "sysendian.h"
 
 #include "crypto_scrypt.h"
+#include "crypto_scrypt_budget.h"
+#include "crypto_scrypt_numa.h"
+
+#if CRYPTO_SCRYPT_STATS
+#include <sys/resource.h>
+
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Clock readings at the start of a phase. */
+struct stats_mark {
+	uint64_t wall_ns;
+	uint64_t ticks;
+	uint64_t page_faults;
+};
+
+static crypto_scrypt_stats_callback stats_callback;
+static void * stats_cookie;
+
+static const char * const phase_names[CRYPTO_SCRYPT_PHASE_COUNT] = {
+	[CRYPTO_SCRYPT_PHASE_RESERVE] = "reserve",
+	[CRYPTO_SCRYPT_PHASE_ALLOC] = "alloc",
+	[CRYPTO_SCRYPT_PHASE_PBKDF2_IN] = "pbkdf2_in",
+	[CRYPTO_SCRYPT_PHASE_SMIX_FILL] = "smix_fill",
+	[CRYPTO_SCRYPT_PHASE_SMIX_MIX] = "smix_mix",
+	[CRYPTO_SCRYPT_PHASE_PBKDF2_OUT] = "pbkdf2_out",
+	[CRYPTO_SCRYPT_PHASE_FREE] = "free",
+};
+
+static void
+stats_read(struct stats_mark * m)
+{
+	struct timespec ts;
+	struct rusage ru;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	m->wall_ns = (uint64_t)(ts.tv_sec) * 1000000000 + (uint64_t)(ts.tv_nsec);
+#if defined(__x86_64__) || defined(__i386__)
+	m->ticks = __rdtsc();
+#elif defined(__aarch64__)
+	__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (m->ticks));
+#else
+	m->ticks = 0;
+#endif
+	if (getrusage(RUSAGE_SELF, &ru) == 0)
+		m->page_faults = (uint64_t)(ru.ru_minflt) + (uint64_t)(ru.ru_majflt);
+	else
+		m->page_faults = 0;
+}
+
+static void
+stats_begin(struct crypto_scrypt_stats * stats, struct stats_mark * m)
+{
+
+	if (stats != NULL)
+		stats_read(m);
+}
+
+/* Charge the time since m to phase; phases run more than once add up. */
+static void
+stats_end(struct crypto_scrypt_stats * stats, crypto_scrypt_phase phase,
+    const struct stats_mark * m)
+{
+	struct stats_mark now;
+
+	if (stats == NULL)
+		return;
+	stats_read(&now);
+	stats->phase[phase].wall_ns += now.wall_ns - m->wall_ns;
+	stats->phase[phase].ticks += now.ticks - m->ticks;
+	stats->phase[phase].page_faults += now.page_faults - m->page_faults;
+}
+
+#define STATS_MARK(m)			struct stats_mark m
+#define STATS_BEGIN(s, m)		stats_begin((s), &(m))
+#define STATS_END(s, phase, m)		stats_end((s), (phase), &(m))
+#else
+/* Compiled out; the stats pointers are always NULL. */
+#define STATS_MARK(m)
+#define STATS_BEGIN(s, m)		((void)(s))
+#define STATS_END(s, phase, m)		((void)(s))
+#endif
 
 static void blkcpy(void *, void *, size_t);
 static void blkxor(void *, void *, size_t);
 static void salsa20_8(uint32_t[16]);
 static void blockmix_salsa8(uint32_t *, uint32_t *, uint32_t *, size_t);
 static uint64_t integerify(void *, size_t);
-static void smix(uint8_t *, size_t, uint64_t, uint32_t *, uint32_t *);
+static void smix(uint8_t *, size_t, uint64_t, uint32_t *, uint32_t *,
+    struct crypto_scrypt_stats *);
+static void smix_tmto(uint8_t *, size_t, uint64_t, unsigned int, uint32_t *,
+    uint32_t *, struct crypto_scrypt_stats *);
+static int scrypt_check(uint64_t, uint32_t, uint32_t, size_t);
+static void scrypt_compute(const uint8_t *, size_t, const uint8_t *, size_t,
+    uint64_t, uint32_t, uint32_t, unsigned int, uint8_t *, uint32_t *,
+    uint32_t *, uint8_t *, size_t, struct crypto_scrypt_stats *);
+static int scrypt(const uint8_t *, size_t, const uint8_t *, size_t, uint64_t,
+    uint32_t, uint32_t, uint8_t *, size_t, crypto_scrypt_budget_policy,
+    uint32_t, struct crypto_scrypt_stats *);
+static int scrypt_run(const uint8_t *, size_t, const uint8_t *, size_t,
+    uint64_t, uint32_t, uint32_t, uint8_t *, size_t,
+    crypto_scrypt_budget_policy, uint32_t, struct crypto_scrypt_stats *);
 
 static void
 blkcpy(void * dest, void * src, size_t len)
@@ -163,15 +260,16 @@ integerify(void * B, size_t r)
 }
 
 /**
- * smix(B, r, N, V, XY):
+ * smix(B, r, N, V, XY, stats):
  * Compute B = SMix_r(B, N).  The input B must be 128r bytes in length;
  * the temporary storage V must be 128rN bytes in length; the temporary
  * storage XY must be 256r + 64 bytes in length.  The value N must be a
  * power of 2 greater than 1.  The arrays B, V, and XY must be aligned to a
- * multiple of 64 bytes.
+ * multiple of 64 bytes.  The two loops are timed into stats, if not NULL.
  */
 static void
-smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY)
+smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY,
+    struct crypto_scrypt_stats * stats)
 {
 	uint32_t * X = XY;
 	uint32_t * Y = &XY[32 * r];
@@ -179,12 +277,14 @@ smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY)
 	uint64_t i;
 	uint64_t j;
 	size_t k;
+	STATS_MARK(mark);
 
 	/* 1: X <-- B */
 	for (k = 0; k < 32 * r; k++)
 		X[k] = le32dec(&B[4 * k]);
 
 	/* 2: for i = 0 to N - 1 do */
+	STATS_BEGIN(stats, mark);
 	for (i = 0; i < N; i += 2) {
 		/* 3: V_i <-- X */
 		blkcpy(&V[i * (32 * r)], X, 128 * r);
@@ -198,8 +298,10 @@ smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY)
 		/* 4: X <-- H(X) */
 		blockmix_salsa8(Y, X, Z, r);
 	}
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_SMIX_FILL, mark);
 
 	/* 6: for i = 0 to N - 1 do */
+	STATS_BEGIN(stats, mark);
 	for (i = 0; i < N; i += 2) {
 		/* 7: j <-- Integerify(X) mod N */
 		j = integerify(X, r) & (N - 1);
@@ -215,6 +317,7 @@ smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY)
 		blkxor(Y, &V[j * (32 * r)], 128 * r);
 		blockmix_salsa8(Y, X, Z, r);
 	}
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_SMIX_MIX, mark);
 
 	/* 10: B' <-- X */
 	for (k = 0; k < 32 * r; k++)
@@ -222,39 +325,101 @@ smix(uint8_t * B, size_t r, uint64_t N, uint32_t * V, uint32_t * XY)
 }
 
 /**
- * crypto_scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen):
- * Compute scrypt(passwd[0 .. passwdlen - 1], salt[0 .. saltlen - 1], N, r,
- * p, buflen) and write the result into buf.  The parameters r, p, and buflen
- * must satisfy r * p < 2^30 and buflen <= (2^32 - 1) * 32.  The parameter N
- * must be a power of 2 greater than 1.
- *
- * Return 0 on success; or -1 on error.
+ * smix_tmto(B, r, N, shift, V, XY, stats):
+ * Compute B = SMix_r(B, N) as smix does, keeping only V_i for i a multiple
+ * of 2^shift, so that V need only be 128rN / 2^shift bytes in length.  The
+ * other V_j are recomputed from the nearest kept block below them when they
+ * are read.  The temporary storage XY must be 512r + 64 bytes in length.
  */
-int
-crypto_scrypt(const uint8_t * passwd, size_t passwdlen,
-    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
-    uint8_t * buf, size_t buflen)
+static void
+smix_tmto(uint8_t * B, size_t r, uint64_t N, unsigned int shift,
+    uint32_t * V, uint32_t * XY, struct crypto_scrypt_stats * stats)
+{
+	uint32_t * X = XY;
+	uint32_t * Y = &XY[32 * r];
+	uint32_t * T = &XY[64 * r];
+	uint32_t * U = &XY[96 * r];
+	uint32_t * Z = &XY[128 * r];
+	uint32_t * W;
+	uint64_t mask = ((uint64_t)(1) << shift) - 1;
+	uint64_t i;
+	uint64_t j;
+	uint64_t m;
+	size_t k;
+	STATS_MARK(mark);
+
+	/* 1: X <-- B */
+	for (k = 0; k < 32 * r; k++)
+		X[k] = le32dec(&B[4 * k]);
+
+	/* 2: for i = 0 to N - 1 do */
+	STATS_BEGIN(stats, mark);
+	for (i = 0; i < N; i++) {
+		/* 3: V_i <-- X, if kept */
+		if ((i & mask) == 0)
+			blkcpy(&V[(i >> shift) * (32 * r)], X, 128 * r);
+
+		/* 4: X <-- H(X) */
+		blockmix_salsa8(X, Y, Z, r);
+		W = X;
+		X = Y;
+		Y = W;
+	}
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_SMIX_FILL, mark);
+
+	/* 6: for i = 0 to N - 1 do */
+	STATS_BEGIN(stats, mark);
+	for (i = 0; i < N; i++) {
+		/* 7: j <-- Integerify(X) mod N */
+		j = integerify(X, r) & (N - 1);
+
+		/* V_j is H applied (j mod 2^shift) times to the kept block. */
+		blkcpy(T, &V[(j >> shift) * (32 * r)], 128 * r);
+		for (m = j & mask; m > 0; m--) {
+			blockmix_salsa8(T, U, Z, r);
+			W = T;
+			T = U;
+			U = W;
+		}
+
+		/* 8: X <-- H(X \xor V_j) */
+		blkxor(X, T, 128 * r);
+		blockmix_salsa8(X, Y, Z, r);
+		W = X;
+		X = Y;
+		Y = W;
+	}
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_SMIX_MIX, mark);
+
+	/* 10: B' <-- X */
+	for (k = 0; k < 32 * r; k++)
+		le32enc(&B[4 * k], X[k]);
+}
+
+/**
+ * scrypt_check(N, r, p, buflen):
+ * Return 0 if the parameters are valid for crypto_scrypt; or -1 and set
+ * errno.
+ */
+static int
+scrypt_check(uint64_t N, uint32_t r, uint32_t p, size_t buflen)
 {
-	void * B0, * V0, * XY0;
-	uint8_t * B;
-	uint32_t * V;
-	uint32_t * XY;
-	uint32_t i;
 
-	/* Sanity-check parameters. */
 #if SIZE_MAX > UINT32_MAX
 	if (buflen > (((uint64_t)(1) << 32) - 1) * 32) {
 		errno = EFBIG;
-		goto err0;
+		return (-1);
 	}
+#else
+	(void)buflen;
 #endif
 	if ((uint64_t)(r) * (uint64_t)(p) >= (1 << 30)) {
 		errno = EFBIG;
-		goto err0;
+		return (-1);
 	}
 	if (((N & (N - 1)) != 0) || (N < 2)) {
 		errno = EINVAL;
-		goto err0;
+		return (-1);
 	}
 	if ((r > SIZE_MAX / 128 / p) ||
 #if SIZE_MAX / 256 <= UINT32_MAX
@@ -262,77 +427,383 @@ crypto_scrypt(const uint8_t * passwd, size_t passwdlen,
 #endif
 	    (N > SIZE_MAX / 128 / r)) {
 		errno = ENOMEM;
-		goto err0;
+		return (-1);
+	}
+	return (0);
+}
+
+/**
+ * scrypt_compute(passwd, passwdlen, salt, saltlen, N, r, p, shift, B, V, XY,
+ *     buf, buflen, stats):
+ * Compute scrypt into buf, with B 128rp bytes in length and V and XY
+ * allocated as smix requires, or as smix_tmto requires if shift is not 0.
+ */
+static void
+scrypt_compute(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
+    unsigned int shift, uint8_t * B, uint32_t * V, uint32_t * XY,
+    uint8_t * buf, size_t buflen, struct crypto_scrypt_stats * stats)
+{
+	uint32_t i;
+	STATS_MARK(mark);
+
+	/* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
+	STATS_BEGIN(stats, mark);
+	PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, 1, B, p * 128 * r);
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_PBKDF2_IN, mark);
+
+	/* 2: for i = 0 to p - 1 do */
+	for (i = 0; i < p; i++) {
+		/* 3: B_i <-- MF(B_i, N) */
+		if (shift == 0)
+			smix(&B[i * 128 * r], r, N, V, XY, stats);
+		else
+			smix_tmto(&B[i * 128 * r], r, N, shift, V, XY, stats);
 	}
 
+	/* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
+	STATS_BEGIN(stats, mark);
+	PBKDF2_SHA256(passwd, passwdlen, B, p * 128 * r, 1, buf, buflen);
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_PBKDF2_OUT, mark);
+}
+
+/**
+ * scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen, policy,
+ *     timeout_ms, stats):
+ * Compute scrypt as crypto_scrypt does, reserving its memory from the budget
+ * under policy, and timing each phase into stats if it is not NULL.
+ */
+static int
+scrypt(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
+    uint8_t * buf, size_t buflen, crypto_scrypt_budget_policy policy,
+    uint32_t timeout_ms, struct crypto_scrypt_stats * stats)
+{
+	void * B0, * V0, * XY0;
+	uint8_t * B;
+	uint32_t * V;
+	uint32_t * XY;
+	uint64_t sizes[CRYPTO_SCRYPT_BUDGET_MAX_SHIFT + 1];
+	size_t nsizes, shift, Vlen, XYlen;
+	STATS_MARK(mark);
+
+	/* Sanity-check parameters. */
+	if (scrypt_check(N, r, p, buflen))
+		goto err0;
+
+	/*
+	 * Reserve memory: all of V, or with 2^shift times fewer blocks and
+	 * room in XY to recompute the others, for as long as 2^shift <= N.
+	 */
+	STATS_BEGIN(stats, mark);
+	for (nsizes = 0; nsizes <= CRYPTO_SCRYPT_BUDGET_MAX_SHIFT &&
+	    ((uint64_t)(1) << nsizes) <= N; nsizes++)
+		sizes[nsizes] = (uint64_t)(128) * r * (N >> nsizes) +
+		    (uint64_t)(128) * r * p +
+		    ((nsizes == 0) ? 256 * r + 64 : 512 * r + 64);
+	if (crypto_scrypt_budget_reserve(sizes, nsizes, policy, timeout_ms,
+	    &shift))
+		goto err0;
+	Vlen = 128 * r * (N >> shift);
+	XYlen = (shift == 0) ? 256 * r + 64 : 512 * r + 64;
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_RESERVE, mark);
+
 	/* Allocate memory. */
+	STATS_BEGIN(stats, mark);
 #ifdef HAVE_POSIX_MEMALIGN
 	if ((errno = posix_memalign(&B0, 64, 128 * r * p)) != 0)
-		goto err0;
-	B = (uint8_t *)(B0);
-	if ((errno = posix_memalign(&XY0, 64, 256 * r + 64)) != 0)
 		goto err1;
+	B = (uint8_t *)(B0);
+	if ((errno = posix_memalign(&XY0, 64, XYlen)) != 0)
+		goto err2;
 	XY = (uint32_t *)(XY0);
 #ifndef MAP_ANON
-	if ((errno = posix_memalign(&V0, 64, 128 * r * N)) != 0)
-		goto err2;
+	if ((errno = posix_memalign(&V0, 64, Vlen)) != 0)
+		goto err3;
 	V = (uint32_t *)(V0);
 #endif
 #else
 	if ((B0 = malloc(128 * r * p + 63)) == NULL)
-		goto err0;
-	B = (uint8_t *)(((uintptr_t)(B0) + 63) & ~ (uintptr_t)(63));
-	if ((XY0 = malloc(256 * r + 64 + 63)) == NULL)
 		goto err1;
+	B = (uint8_t *)(((uintptr_t)(B0) + 63) & ~ (uintptr_t)(63));
+	if ((XY0 = malloc(XYlen + 63)) == NULL)
+		goto err2;
 	XY = (uint32_t *)(((uintptr_t)(XY0) + 63) & ~ (uintptr_t)(63));
 #ifndef MAP_ANON
-	if ((V0 = malloc(128 * r * N + 63)) == NULL)
-		goto err2;
+	if ((V0 = malloc(Vlen + 63)) == NULL)
+		goto err3;
 	V = (uint32_t *)(((uintptr_t)(V0) + 63) & ~ (uintptr_t)(63));
 #endif
 #endif
 #ifdef MAP_ANON
-	if ((V0 = mmap(NULL, 128 * r * N, PROT_READ | PROT_WRITE,
+	if ((V0 = mmap(NULL, Vlen, PROT_READ | PROT_WRITE,
 #ifdef MAP_NOCORE
 	    MAP_ANON | MAP_PRIVATE | MAP_NOCORE,
 #else
 	    MAP_ANON | MAP_PRIVATE,
 #endif
 	    -1, 0)) == MAP_FAILED)
-		goto err2;
+		goto err3;
 	V = (uint32_t *)(V0);
-#endif
 
-	/* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
-	PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, 1, B, p * 128 * r);
-
-	/* 2: for i = 0 to p - 1 do */
-	for (i = 0; i < p; i++) {
-		/* 3: B_i <-- MF(B_i, N) */
-		smix(&B[i * 128 * r], r, N, V, XY);
-	}
+	/* Nothing is faulted in yet, so V can still go on the right node. */
+	crypto_scrypt_numa_place(V0, Vlen);
+#endif
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_ALLOC, mark);
 
-	/* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
-	PBKDF2_SHA256(passwd, passwdlen, B, p * 128 * r, 1, buf, buflen);
+	scrypt_compute(passwd, passwdlen, salt, saltlen, N, r, p,
+	    (unsigned int)shift, B, V, XY, buf, buflen, stats);
 
 	/* Free memory. */
+	STATS_BEGIN(stats, mark);
 #ifdef MAP_ANON
-	if (munmap(V0, 128 * r * N))
-		goto err2;
+	if (munmap(V0, Vlen))
+		goto err3;
 #else
 	free(V0);
 #endif
 	free(XY0);
 	free(B0);
+	crypto_scrypt_budget_release(sizes[shift]);
+	STATS_END(stats, CRYPTO_SCRYPT_PHASE_FREE, mark);
+
+#if CRYPTO_SCRYPT_STATS
+	if (stats != NULL) {
+		/* Each smix writes V once and reads a block of it N times. */
+		stats->v_bytes = Vlen;
+		stats->v_bytes_written = (uint64_t)(Vlen) * p;
+		stats->v_bytes_read = (uint64_t)(128) * r * N * p;
+		stats->v_shift = (uint32_t)shift;
+	}
+#endif
 
 	/* Success! */
 	return (0);
 
-err2:
+err3:
 	free(XY0);
-err1:
+err2:
 	free(B0);
+err1:
+	crypto_scrypt_budget_release(sizes[shift]);
 err0:
 	/* Failure! */
 	return (-1);
 }
+
+/**
+ * crypto_scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen):
+ * Compute scrypt(passwd[0 .. passwdlen - 1], salt[0 .. saltlen - 1], N, r,
+ * p, buflen) and write the result into buf.  The parameters r, p, and buflen
+ * must satisfy r * p < 2^30 and buflen <= (2^32 - 1) * 32.  The parameter N
+ * must be a power of 2 greater than 1.
+ *
+ * Return 0 on success; or -1 on error.
+ */
+int
+crypto_scrypt(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
+    uint8_t * buf, size_t buflen)
+{
+
+	return (scrypt_run(passwd, passwdlen, salt, saltlen, N, r, p, buf,
+	    buflen, CRYPTO_SCRYPT_BUDGET_DEFAULT, 0, NULL));
+}
+
+int
+crypto_scrypt_policy(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
+    uint8_t * buf, size_t buflen, crypto_scrypt_budget_policy policy,
+    uint32_t timeout_ms)
+{
+
+	return (scrypt_run(passwd, passwdlen, salt, saltlen, N, r, p, buf,
+	    buflen, policy, timeout_ms, NULL));
+}
+
+int
+crypto_scrypt_init_local(crypto_scrypt_local_t * local)
+{
+
+	local->base = NULL;
+	local->size = 0;
+	return (0);
+}
+
+int
+crypto_scrypt_free_local(crypto_scrypt_local_t * local)
+{
+
+	if (local->base == NULL)
+		return (0);
+#ifdef MAP_ANON
+	if (munmap(local->base, local->size))
+		return (-1);
+#else
+	free(local->base);
+#endif
+	crypto_scrypt_budget_release(local->size);
+	local->base = NULL;
+	local->size = 0;
+	return (0);
+}
+
+/* Bytes of V, B and XY for N, r and p, back to back; 0 if they overflow. */
+static size_t
+local_layout(uint64_t N, uint32_t r, uint32_t p, size_t * Vlen, size_t * Blen)
+{
+	size_t XYlen;
+
+	/* Each a multiple of 64 bytes. */
+	*Vlen = 128 * r * N;
+	*Blen = 128 * r * p;
+	XYlen = 256 * r + 64;
+	if (*Vlen > SIZE_MAX - *Blen - XYlen - 63)
+		return (0);
+	return (*Vlen + *Blen + XYlen);
+}
+
+int
+crypto_scrypt_reserve_local(crypto_scrypt_local_t * local, uint64_t N,
+    uint32_t r, uint32_t p)
+{
+	size_t Vlen, Blen, need, chosen;
+	uint64_t reserve;
+
+	if (scrypt_check(N, r, p, 0))
+		return (-1);
+	if ((need = local_layout(N, r, p, &Vlen, &Blen)) == 0) {
+		errno = ENOMEM;
+		return (-1);
+	}
+
+	/*
+	 * Grow the region if it is too small; it is never shrunk.  The budget
+	 * is charged for the region as long as it is held.
+	 */
+	if (local->size >= need)
+		return (0);
+	if (crypto_scrypt_free_local(local))
+		return (-1);
+	reserve = need;
+	if (crypto_scrypt_budget_reserve(&reserve, 1,
+	    CRYPTO_SCRYPT_BUDGET_DEFAULT, 0, &chosen))
+		return (-1);
+#ifdef MAP_ANON
+	if ((local->base = mmap(NULL, need, PROT_READ | PROT_WRITE,
+#ifdef MAP_NOCORE
+	    MAP_ANON | MAP_PRIVATE | MAP_NOCORE,
+#else
+	    MAP_ANON | MAP_PRIVATE,
+#endif
+	    -1, 0)) == MAP_FAILED) {
+		local->base = NULL;
+		crypto_scrypt_budget_release(need);
+		return (-1);
+	}
+	crypto_scrypt_numa_place(local->base, need);
+#else
+	if ((local->base = malloc(need + 63)) == NULL) {
+		crypto_scrypt_budget_release(need);
+		return (-1);
+	}
+#endif
+	local->size = need;
+	return (0);
+}
+
+int
+crypto_scrypt_r(crypto_scrypt_local_t * local, const uint8_t * passwd,
+    size_t passwdlen, const uint8_t * salt, size_t saltlen, uint64_t N,
+    uint32_t r, uint32_t p, uint8_t * buf, size_t buflen)
+{
+	size_t Vlen, Blen;
+	uint8_t * base;
+
+	if (scrypt_check(N, r, p, buflen))
+		return (-1);
+	if (crypto_scrypt_reserve_local(local, N, r, p))
+		return (-1);
+	(void)local_layout(N, r, p, &Vlen, &Blen);
+	base = (uint8_t *)(((uintptr_t)(local->base) + 63) & ~ (uintptr_t)(63));
+
+	scrypt_compute(passwd, passwdlen, salt, saltlen, N, r, p, 0,
+	    &base[Vlen], (uint32_t *)(base), (uint32_t *)(&base[Vlen + Blen]),
+	    buf, buflen, NULL);
+
+	/* Success! */
+	return (0);
+}
+
+/**
+ * scrypt_run(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen, policy,
+ *     timeout_ms, stats):
+ * Compute scrypt, filling in stats and reporting them to the stats callback
+ * if there is one.
+ */
+static int
+scrypt_run(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
+    uint8_t * buf, size_t buflen, crypto_scrypt_budget_policy policy,
+    uint32_t timeout_ms, struct crypto_scrypt_stats * stats)
+{
+#if CRYPTO_SCRYPT_STATS
+	struct crypto_scrypt_stats local;
+
+	/* Without a callback, nobody is reading: don't touch the clocks. */
+	if (stats == NULL && stats_callback != NULL)
+		stats = &local;
+
+	if (stats != NULL) {
+		memset(stats, 0, sizeof(*stats));
+		stats->N = N;
+		stats->r = r;
+		stats->p = p;
+	}
+
+	if (scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen,
+	    policy, timeout_ms, stats))
+		return (-1);
+
+	if (stats != NULL && stats_callback != NULL)
+		stats_callback(stats, stats_cookie);
+
+	/* Success! */
+	return (0);
+#else
+	return (scrypt(passwd, passwdlen, salt, saltlen, N, r, p, buf, buflen,
+	    policy, timeout_ms, stats));
+#endif
+}
+
+#if CRYPTO_SCRYPT_STATS
+
+int
+crypto_scrypt_stats(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, uint64_t N, uint32_t r, uint32_t p,
+    uint8_t * buf, size_t buflen, struct crypto_scrypt_stats * stats)
+{
+
+	return (scrypt_run(passwd, passwdlen, salt, saltlen, N, r, p, buf,
+	    buflen, CRYPTO_SCRYPT_BUDGET_DEFAULT, 0, stats));
+}
+
+void
+crypto_scrypt_set_stats_callback(crypto_scrypt_stats_callback callback,
+    void * cookie)
+{
+
+	stats_cookie = cookie;
+	stats_callback = callback;
+}
+
+const char *
+crypto_scrypt_phase_name(crypto_scrypt_phase phase)
+{
+
+	if (phase < 0 || phase >= CRYPTO_SCRYPT_PHASE_COUNT)
+		return ("unknown");
+	return (phase_names[phase]);
+}
+
+#endif /* CRYPTO_SCRYPT_STATS */
@@ -0,0 +1,160 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <sys/time.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "crypto_scrypt_budget.h"
+
+static struct {
+	pthread_mutex_t lock;
+	/* Signalled whenever memory is given back. */
+	pthread_cond_t released;
+	crypto_scrypt_budget_policy policy;
+	uint32_t timeout_ms;
+	struct crypto_scrypt_budget_usage usage;
+} budget = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.released = PTHREAD_COND_INITIALIZER,
+	.policy = CRYPTO_SCRYPT_BUDGET_WAIT,
+	.timeout_ms = CRYPTO_SCRYPT_BUDGET_FOREVER,
+};
+
+/* Wall clock, as pthread_cond_timedwait takes, in nanoseconds. */
+static uint64_t
+wall_ns(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((uint64_t)(tv.tv_sec) * 1000000000 +
+	    (uint64_t)(tv.tv_usec) * 1000);
+}
+
+/* Whether size fits next to what is in use, under budget.lock. */
+static int
+fits(uint64_t size)
+{
+
+	return (budget.usage.limit == 0 ||
+	    (budget.usage.in_use <= budget.usage.limit &&
+	    size <= budget.usage.limit - budget.usage.in_use));
+}
+
+void
+crypto_scrypt_budget_set(uint64_t limit, crypto_scrypt_budget_policy policy,
+    uint32_t timeout_ms)
+{
+
+	pthread_mutex_lock(&budget.lock);
+	budget.usage.limit = limit;
+	budget.policy = (policy == CRYPTO_SCRYPT_BUDGET_DEFAULT) ?
+	    CRYPTO_SCRYPT_BUDGET_WAIT : policy;
+	budget.timeout_ms = timeout_ms;
+	/* A raised limit may let waiters through. */
+	pthread_cond_broadcast(&budget.released);
+	pthread_mutex_unlock(&budget.lock);
+}
+
+void
+crypto_scrypt_budget_usage(struct crypto_scrypt_budget_usage * usage)
+{
+
+	pthread_mutex_lock(&budget.lock);
+	*usage = budget.usage;
+	pthread_mutex_unlock(&budget.lock);
+}
+
+int
+crypto_scrypt_budget_reserve(const uint64_t * sizes, size_t nsizes,
+    crypto_scrypt_budget_policy policy, uint32_t timeout_ms, size_t * chosen)
+{
+	struct timespec deadline;
+	uint64_t start = 0, end, waited;
+	size_t i;
+	int rc = 0;
+
+	pthread_mutex_lock(&budget.lock);
+	if (policy == CRYPTO_SCRYPT_BUDGET_DEFAULT) {
+		policy = budget.policy;
+		timeout_ms = budget.timeout_ms;
+	}
+	if (policy != CRYPTO_SCRYPT_BUDGET_DEGRADE)
+		nsizes = 1;
+
+	for (;;) {
+		for (i = 0; i < nsizes; i++)
+			if (fits(sizes[i]))
+				goto granted;
+
+		/* Waiting cannot help what would not fit in an empty budget. */
+		if (sizes[nsizes - 1] > budget.usage.limit) {
+			budget.usage.rejections++;
+			rc = ENOMEM;
+			break;
+		}
+		if (policy == CRYPTO_SCRYPT_BUDGET_FAIL) {
+			budget.usage.rejections++;
+			rc = EAGAIN;
+			break;
+		}
+
+		if (start == 0) {
+			start = wall_ns();
+			budget.usage.waits++;
+			end = start + (uint64_t)(timeout_ms) * 1000000;
+			deadline.tv_sec = (time_t)(end / 1000000000);
+			deadline.tv_nsec = (long)(end % 1000000000);
+		}
+		if (timeout_ms == CRYPTO_SCRYPT_BUDGET_FOREVER) {
+			pthread_cond_wait(&budget.released, &budget.lock);
+		} else if (pthread_cond_timedwait(&budget.released,
+		    &budget.lock, &deadline) == ETIMEDOUT) {
+			/* One last look: memory may have come back just now. */
+			for (i = 0; i < nsizes; i++)
+				if (fits(sizes[i]))
+					goto granted;
+			budget.usage.timeouts++;
+			rc = ETIMEDOUT;
+			break;
+		}
+	}
+
+	/* Refused. */
+	goto done;
+
+granted:
+	budget.usage.in_use += sizes[i];
+	if (budget.usage.in_use > budget.usage.peak)
+		budget.usage.peak = budget.usage.in_use;
+	budget.usage.reservations++;
+	if (i > 0)
+		budget.usage.degraded++;
+	*chosen = i;
+
+done:
+	if (start != 0) {
+		waited = wall_ns() - start;
+		budget.usage.wait_ns_total += waited;
+		if (waited > budget.usage.wait_ns_max)
+			budget.usage.wait_ns_max = waited;
+	}
+	pthread_mutex_unlock(&budget.lock);
+	if (rc != 0) {
+		errno = rc;
+		return (-1);
+	}
+	return (0);
+}
+
+void
+crypto_scrypt_budget_release(uint64_t size)
+{
+
+	pthread_mutex_lock(&budget.lock);
+	budget.usage.in_use -= size;
+	pthread_cond_broadcast(&budget.released);
+	pthread_mutex_unlock(&budget.lock);
+}
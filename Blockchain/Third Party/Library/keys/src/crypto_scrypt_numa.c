@@ -0,0 +1,228 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#include "crypto_scrypt_numa.h"
+
+/* Node V of this thread goes on, or -1 for wherever it is first touched. */
+static __thread int bound_node = -1;
+
+#ifdef __linux__
+
+#define NODE_PATH	"/sys/devices/system/node"
+
+/* set_mempolicy(2) modes, without depending on libnuma. */
+#define MPOL_PREFERRED	1
+
+/* Affinity of this thread before it was first bound. */
+static __thread cpu_set_t unbound_cpus;
+static __thread int unbound_saved;
+
+/**
+ * parse_cpulist(list, cpus, ncpus):
+ * Parse a sysfs CPU list such as "0-3,8-11", storing up to ncpus CPUs in
+ * cpus.  Return the number of CPUs in the list.
+ */
+static int
+parse_cpulist(const char * list, int * cpus, size_t ncpus)
+{
+	const char * p = list;
+	char * end;
+	long lo, hi, cpu;
+	int n = 0;
+
+	while (*p != '\0' && *p != '\n') {
+		lo = hi = strtol(p, &end, 10);
+		if (end == p)
+			return (-1);
+		p = end;
+		if (*p == '-') {
+			hi = strtol(p + 1, &end, 10);
+			if (end == p + 1 || hi < lo)
+				return (-1);
+			p = end;
+		}
+		for (cpu = lo; cpu <= hi; cpu++, n++)
+			if ((size_t)n < ncpus)
+				cpus[n] = (int)cpu;
+		if (*p == ',')
+			p++;
+	}
+	return (n);
+}
+
+int
+crypto_scrypt_numa_nodes(void)
+{
+	char path[64];
+	int n;
+
+	for (n = 0; ; n++) {
+		snprintf(path, sizeof(path), NODE_PATH "/node%d", n);
+		if (access(path, F_OK))
+			break;
+	}
+	return ((n > 0) ? n : 1);
+}
+
+int
+crypto_scrypt_numa_node_cpus(int node, int * cpus, size_t ncpus)
+{
+	char path[64];
+	char list[4096];
+	FILE * f;
+	long i, online;
+
+	snprintf(path, sizeof(path), NODE_PATH "/node%d/cpulist", node);
+	if ((f = fopen(path, "r")) == NULL) {
+		/* No sysfs: one node with every online CPU. */
+		if (node != 0 || (online = sysconf(_SC_NPROCESSORS_ONLN)) < 1) {
+			errno = EINVAL;
+			return (-1);
+		}
+		for (i = 0; i < online && (size_t)i < ncpus; i++)
+			cpus[i] = (int)i;
+		return ((int)online);
+	}
+	if (fgets(list, sizeof(list), f) == NULL) {
+		fclose(f);
+		errno = EIO;
+		return (-1);
+	}
+	fclose(f);
+	return (parse_cpulist(list, cpus, ncpus));
+}
+
+int
+crypto_scrypt_numa_bind(int node, int cpu)
+{
+	cpu_set_t set;
+	int * cpus;
+	int i, n;
+
+	if ((n = crypto_scrypt_numa_node_cpus(node, NULL, 0)) < 1)
+		return (-1);
+	if ((cpus = malloc((size_t)n * sizeof(int))) == NULL)
+		return (-1);
+	crypto_scrypt_numa_node_cpus(node, cpus, (size_t)n);
+
+	CPU_ZERO(&set);
+	for (i = 0; i < n; i++)
+		if (cpu < 0 || cpus[i] == cpu)
+			CPU_SET(cpus[i], &set);
+	free(cpus);
+	if (CPU_COUNT(&set) == 0) {
+		/* cpu is not on node. */
+		errno = EINVAL;
+		return (-1);
+	}
+
+	if (!unbound_saved) {
+		if (sched_getaffinity(0, sizeof(unbound_cpus), &unbound_cpus))
+			return (-1);
+		unbound_saved = 1;
+	}
+	if (sched_setaffinity(0, sizeof(set), &set))
+		return (-1);
+
+	bound_node = node;
+	return (0);
+}
+
+void
+crypto_scrypt_numa_unbind(void)
+{
+
+	if (unbound_saved) {
+		sched_setaffinity(0, sizeof(unbound_cpus), &unbound_cpus);
+		unbound_saved = 0;
+	}
+	bound_node = -1;
+}
+
+void
+crypto_scrypt_numa_place(void * addr, size_t len)
+{
+	unsigned long mask[4];
+	size_t bits = sizeof(mask) * 8;
+
+	if (bound_node < 0 || (size_t)bound_node >= bits)
+		return;
+
+	/*
+	 * Preferred rather than bound: if the node runs out of memory, a remote
+	 * V is slower but a failed derivation is worse.  Errors are ignored for
+	 * the same reason, and because V still follows the pinned thread.
+	 */
+	memset(mask, 0, sizeof(mask));
+	mask[bound_node / (sizeof(unsigned long) * 8)] |=
+	    1UL << (bound_node % (sizeof(unsigned long) * 8));
+	syscall(SYS_mbind, addr, len, MPOL_PREFERRED, mask, bits + 1, 0);
+}
+
+#else
+
+int
+crypto_scrypt_numa_nodes(void)
+{
+
+	return (1);
+}
+
+int
+crypto_scrypt_numa_node_cpus(int node, int * cpus, size_t ncpus)
+{
+	long i, online;
+
+	if (node != 0 || (online = sysconf(_SC_NPROCESSORS_ONLN)) < 1) {
+		errno = EINVAL;
+		return (-1);
+	}
+	for (i = 0; i < online && (size_t)i < ncpus; i++)
+		cpus[i] = (int)i;
+	return ((int)online);
+}
+
+int
+crypto_scrypt_numa_bind(int node, int cpu)
+{
+
+	/* There is no affinity to set; only check the arguments. */
+	if (node != 0 || cpu >= sysconf(_SC_NPROCESSORS_ONLN)) {
+		errno = EINVAL;
+		return (-1);
+	}
+	bound_node = node;
+	return (0);
+}
+
+void
+crypto_scrypt_numa_unbind(void)
+{
+
+	bound_node = -1;
+}
+
+void
+crypto_scrypt_numa_place(void * addr, size_t len)
+{
+
+	/* Uniform memory: first touch is all the placement there is. */
+	(void)addr;
+	(void)len;
+}
+
+#endif
@@ -0,0 +1,1105 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha256.h"
+#include "sysendian.h"
+
+#include "eckey.h"
+
+typedef unsigned __int128 u128;
+
+/* A field element mod p, fully reduced, as little-endian 64-bit limbs. */
+typedef struct {
+	uint64_t d[4];
+} fe;
+
+/* An affine point, never the point at infinity. */
+typedef struct {
+	fe x, y;
+} ge;
+
+/* A point in Jacobian coordinates: (x / z^2, y / z^3). */
+typedef struct {
+	fe x, y, z;
+	uint64_t infinity;
+} gej;
+
+static const fe FE_P = {{
+	0xFFFFFFFEFFFFFC2FULL, 0xFFFFFFFFFFFFFFFFULL,
+	0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL
+}};
+
+/* 2^256 mod p. */
+#define FE_C	0x1000003D1ULL
+
+/* p - 2 and (p + 1) / 4, the exponents of inversion and square roots. */
+static const uint64_t FE_INV_EXP[4] = {
+	0xFFFFFFFEFFFFFC2DULL, 0xFFFFFFFFFFFFFFFFULL,
+	0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL
+};
+static const uint64_t FE_SQRT_EXP[4] = {
+	0xFFFFFFFFBFFFFF0CULL, 0xFFFFFFFFFFFFFFFFULL,
+	0xFFFFFFFFFFFFFFFFULL, 0x3FFFFFFFFFFFFFFFULL
+};
+
+/* The group order. */
+static const uint64_t SC_N[4] = {
+	0xBFD25E8CD0364141ULL, 0xBAAEDCE6AF48A03BULL,
+	0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL
+};
+
+/* 2^256 - n, n - 2 and n / 2. */
+static const uint64_t SC_NC[3] = {
+	0x402DA1732FC9BEBFULL, 0x4551231950B75FC4ULL, 0x0000000000000001ULL
+};
+static const uint64_t SC_INV_EXP[4] = {
+	0xBFD25E8CD036413FULL, 0xBAAEDCE6AF48A03BULL,
+	0xFFFFFFFFFFFFFFFEULL, 0xFFFFFFFFFFFFFFFFULL
+};
+static const uint64_t SC_N_HALF[4] = {
+	0xDFE92F46681B20A0ULL, 0x5D576E7357A4501DULL,
+	0xFFFFFFFFFFFFFFFFULL, 0x7FFFFFFFFFFFFFFFULL
+};
+
+static const ge GENERATOR = {
+	{{ 0x59F2815B16F81798ULL, 0x029BFCDB2DCE28D9ULL,
+	   0x55A06295CE870B07ULL, 0x79BE667EF9DCBBACULL }},
+	{{ 0x9C47D08FFB10D4B8ULL, 0xFD17B448A6855419ULL,
+	   0x5DA4FBFC0E1108A8ULL, 0x483ADA7726A3C465ULL }}
+};
+
+/* Multiples of G: table[i][j - 1] = j * 16^i * G for j = 1 .. 15. */
+#define GEN_WINDOWS	64
+#define GEN_ENTRIES	15
+static ge gen_table[GEN_WINDOWS][GEN_ENTRIES];
+static pthread_once_t gen_table_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Store a - m in r if hi is set or a >= m, and a otherwise, without
+ * branching on either.
+ */
+static inline void
+limbs_reduce_once(uint64_t r[4], const uint64_t a[4], const uint64_t m[4],
+    uint64_t hi)
+{
+	uint64_t t[4], mask;
+	u128 acc;
+	uint64_t borrow = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		acc = (u128)(a[i]) - m[i] - borrow;
+		t[i] = (uint64_t)(acc);
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+	mask = -(hi | (borrow ^ 1));
+	for (i = 0; i < 4; i++)
+		r[i] = (t[i] & mask) | (a[i] & ~mask);
+}
+
+/* Compare a to m, little-endian limbs: -1, 0 or 1. */
+static int
+limbs_cmp(const uint64_t a[4], const uint64_t m[4])
+{
+	int i;
+
+	for (i = 3; i >= 0; i--) {
+		if (a[i] < m[i])
+			return (-1);
+		if (a[i] > m[i])
+			return (1);
+	}
+	return (0);
+}
+
+static inline void
+limbs_dec(uint64_t r[4], const uint8_t b[32])
+{
+
+	r[3] = be64dec(&b[0]);
+	r[2] = be64dec(&b[8]);
+	r[1] = be64dec(&b[16]);
+	r[0] = be64dec(&b[24]);
+}
+
+static inline void
+limbs_enc(uint8_t b[32], const uint64_t a[4])
+{
+
+	be64enc(&b[0], a[3]);
+	be64enc(&b[8], a[2]);
+	be64enc(&b[16], a[1]);
+	be64enc(&b[24], a[0]);
+}
+
+static inline void
+fe_set_int(fe * r, uint64_t v)
+{
+
+	r->d[0] = v;
+	r->d[1] = r->d[2] = r->d[3] = 0;
+}
+
+static inline uint64_t
+fe_is_zero(const fe * a)
+{
+
+	return ((a->d[0] | a->d[1] | a->d[2] | a->d[3]) == 0);
+}
+
+static inline int
+fe_equal(const fe * a, const fe * b)
+{
+
+	return (memcmp(a->d, b->d, sizeof(a->d)) == 0);
+}
+
+/* Replace r by a if flag, which is 0 or 1. */
+static inline void
+fe_cmov(fe * r, const fe * a, uint64_t flag)
+{
+	uint64_t mask = -flag;
+	int i;
+
+	for (i = 0; i < 4; i++)
+		r->d[i] = (a->d[i] & mask) | (r->d[i] & ~mask);
+}
+
+static inline void
+fe_add(fe * r, const fe * a, const fe * b)
+{
+	uint64_t t[4];
+	u128 acc = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		acc += (u128)(a->d[i]) + b->d[i];
+		t[i] = (uint64_t)(acc);
+		acc >>= 64;
+	}
+	limbs_reduce_once(r->d, t, FE_P.d, (uint64_t)(acc));
+}
+
+static inline void
+fe_sub(fe * r, const fe * a, const fe * b)
+{
+	uint64_t t[4], mask, borrow = 0;
+	u128 acc;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		acc = (u128)(a->d[i]) - b->d[i] - borrow;
+		t[i] = (uint64_t)(acc);
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+
+	/* Adding p back is subtracting 2^256 - p = FE_C, mod 2^256. */
+	mask = -borrow;
+	acc = (u128)(t[0]) - (FE_C & mask);
+	r->d[0] = (uint64_t)(acc);
+	borrow = (uint64_t)(acc >> 64) & 1;
+	for (i = 1; i < 4; i++) {
+		acc = (u128)(t[i]) - borrow;
+		r->d[i] = (uint64_t)(acc);
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+}
+
+static inline void
+fe_mul(fe * r, const fe * a, const fe * b)
+{
+	uint64_t t[8] = { 0 };
+	uint64_t s[4], carry;
+	u128 acc;
+	int i, j;
+
+	for (i = 0; i < 4; i++) {
+		carry = 0;
+		for (j = 0; j < 4; j++) {
+			acc = (u128)(a->d[i]) * b->d[j] + t[i + j] + carry;
+			t[i + j] = (uint64_t)(acc);
+			carry = (uint64_t)(acc >> 64);
+		}
+		t[i + 4] = carry;
+	}
+
+	/* Fold the high half in as hi * 2^256 = hi * FE_C. */
+	carry = 0;
+	for (i = 0; i < 4; i++) {
+		acc = (u128)(t[i + 4]) * FE_C + t[i] + carry;
+		s[i] = (uint64_t)(acc);
+		carry = (uint64_t)(acc >> 64);
+	}
+
+	/* Then the carry, below 2^34; a last carry out leaves s tiny. */
+	acc = (u128)(carry) * FE_C + s[0];
+	s[0] = (uint64_t)(acc);
+	for (i = 1; i < 4; i++) {
+		acc = (u128)(s[i]) + (uint64_t)(acc >> 64);
+		s[i] = (uint64_t)(acc);
+	}
+	acc = (u128)(s[0]) + ((uint64_t)(acc >> 64) * FE_C);
+	s[0] = (uint64_t)(acc);
+	s[1] += (uint64_t)(acc >> 64);
+
+	limbs_reduce_once(r->d, s, FE_P.d, 0);
+}
+
+static inline void
+fe_sqr(fe * r, const fe * a)
+{
+
+	fe_mul(r, a, a);
+}
+
+/* a^e, for a public exponent e. */
+static void
+fe_pow(fe * r, const fe * a, const uint64_t e[4])
+{
+	fe x, base = *a;
+	int i;
+
+	fe_set_int(&x, 1);
+	for (i = 255; i >= 0; i--) {
+		fe_sqr(&x, &x);
+		if ((e[i / 64] >> (i % 64)) & 1)
+			fe_mul(&x, &x, &base);
+	}
+	*r = x;
+}
+
+static void
+fe_inv(fe * r, const fe * a)
+{
+
+	fe_pow(r, a, FE_INV_EXP);
+}
+
+/* A square root of a, returning -1 if a is not a square. */
+static int
+fe_sqrt(fe * r, const fe * a)
+{
+	fe s, check;
+
+	fe_pow(&s, a, FE_SQRT_EXP);
+	fe_sqr(&check, &s);
+	if (!fe_equal(&check, a))
+		return (-1);
+	*r = s;
+	return (0);
+}
+
+/* Decode a big-endian field element, returning -1 if it is not below p. */
+static int
+fe_dec(fe * r, const uint8_t b[32])
+{
+
+	limbs_dec(r->d, b);
+	return (limbs_cmp(r->d, FE_P.d) < 0 ? 0 : -1);
+}
+
+static void
+gej_set_ge(gej * r, const ge * a)
+{
+
+	r->x = a->x;
+	r->y = a->y;
+	fe_set_int(&r->z, 1);
+	r->infinity = 0;
+}
+
+static void
+gej_double(gej * r, const gej * a)
+{
+	fe A, B, C, D, E, F, t;
+
+	/* dbl-2009-l; secp256k1 has no point of order two. */
+	r->infinity = a->infinity;
+	fe_sqr(&A, &a->x);
+	fe_sqr(&B, &a->y);
+	fe_sqr(&C, &B);
+	fe_add(&t, &a->x, &B);
+	fe_sqr(&t, &t);
+	fe_sub(&t, &t, &A);
+	fe_sub(&t, &t, &C);
+	fe_add(&D, &t, &t);
+	fe_add(&E, &A, &A);
+	fe_add(&E, &E, &A);
+	fe_sqr(&F, &E);
+	fe_mul(&r->z, &a->y, &a->z);
+	fe_add(&r->z, &r->z, &r->z);
+	fe_sub(&r->x, &F, &D);
+	fe_sub(&r->x, &r->x, &D);
+	fe_sub(&t, &D, &r->x);
+	fe_mul(&r->y, &E, &t);
+	fe_add(&C, &C, &C);
+	fe_add(&C, &C, &C);
+	fe_add(&C, &C, &C);
+	fe_sub(&r->y, &r->y, &C);
+}
+
+/*
+ * r = a + b by madd-2007-bl, for a not at infinity and a != +-b.  Shared by
+ * the general addition and the constant-time generator multiplication.
+ */
+static void
+gej_add_ge_unchecked(gej * r, const gej * a, const ge * b, fe * H, fe * R)
+{
+	fe Z1Z1, U2, S2, HH, I, J, V, t;
+
+	fe_sqr(&Z1Z1, &a->z);
+	fe_mul(&U2, &b->x, &Z1Z1);
+	fe_mul(&S2, &b->y, &a->z);
+	fe_mul(&S2, &S2, &Z1Z1);
+	fe_sub(H, &U2, &a->x);
+	fe_sub(R, &S2, &a->y);
+	fe_add(R, R, R);
+	fe_sqr(&HH, H);
+	fe_add(&I, &HH, &HH);
+	fe_add(&I, &I, &I);
+	fe_mul(&J, H, &I);
+	fe_mul(&V, &a->x, &I);
+
+	fe_sqr(&t, R);
+	fe_sub(&t, &t, &J);
+	fe_sub(&t, &t, &V);
+	fe_sub(&t, &t, &V);
+	fe_sub(&U2, &V, &t);
+	fe_mul(&U2, R, &U2);
+	fe_mul(&S2, &a->y, &J);
+	fe_add(&S2, &S2, &S2);
+	fe_sub(&r->y, &U2, &S2);
+	fe_add(&U2, &a->z, H);
+	fe_sqr(&U2, &U2);
+	fe_sub(&U2, &U2, &Z1Z1);
+	fe_sub(&r->z, &U2, &HH);
+	r->x = t;
+	r->infinity = 0;
+}
+
+static void
+gej_add_ge(gej * r, const gej * a, const ge * b)
+{
+	gej sum;
+	fe H, R;
+
+	if (a->infinity) {
+		gej_set_ge(r, b);
+		return;
+	}
+	gej_add_ge_unchecked(&sum, a, b, &H, &R);
+	if (fe_is_zero(&H)) {
+		/* a = b, or a = -b. */
+		if (fe_is_zero(&R)) {
+			gej_double(r, a);
+		} else {
+			memset(r, 0, sizeof(*r));
+			r->infinity = 1;
+		}
+		return;
+	}
+	*r = sum;
+}
+
+static void
+ge_set_gej_zinv(ge * r, const gej * a, const fe * zinv)
+{
+	fe zinv2, zinv3;
+
+	fe_sqr(&zinv2, zinv);
+	fe_mul(&zinv3, &zinv2, zinv);
+	fe_mul(&r->x, &a->x, &zinv2);
+	fe_mul(&r->y, &a->y, &zinv3);
+}
+
+static void
+ge_set_gej(ge * r, const gej * a)
+{
+	fe zinv;
+
+	fe_inv(&zinv, &a->z);
+	ge_set_gej_zinv(r, a, &zinv);
+}
+
+/*
+ * Convert the n points of a that are not at infinity to affine points in r
+ * with a single inversion; scratch holds n field elements.
+ */
+static void
+ge_set_gej_batch(ge * r, const gej * a, size_t n, fe * scratch)
+{
+	fe inv, zinv;
+	size_t i, last = n;
+
+	for (i = 0; i < n; i++) {
+		if (a[i].infinity)
+			continue;
+		if (last == n)
+			scratch[i] = a[i].z;
+		else
+			fe_mul(&scratch[i], &scratch[last], &a[i].z);
+		last = i;
+	}
+	if (last == n)
+		return;
+
+	fe_inv(&inv, &scratch[last]);
+	for (i = last + 1; i-- > 0;) {
+		if (a[i].infinity)
+			continue;
+		/* Find the previous point to peel its product off. */
+		size_t prev = i;
+		while (prev-- > 0 && a[prev].infinity)
+			continue;
+		if (prev == (size_t)(-1)) {
+			zinv = inv;
+		} else {
+			fe_mul(&zinv, &inv, &scratch[prev]);
+			fe_mul(&inv, &inv, &a[i].z);
+		}
+		ge_set_gej_zinv(&r[i], &a[i], &zinv);
+	}
+}
+
+static void
+gen_table_build(void)
+{
+	static gej jac[GEN_WINDOWS][GEN_ENTRIES];
+	static fe scratch[GEN_WINDOWS * GEN_ENTRIES];
+	ge base = GENERATOR;
+	gej next;
+	int i, j;
+
+	for (i = 0; i < GEN_WINDOWS; i++) {
+		gej_set_ge(&jac[i][0], &base);
+		for (j = 1; j < GEN_ENTRIES; j++)
+			gej_add_ge(&jac[i][j], &jac[i][j - 1], &base);
+		gej_add_ge(&next, &jac[i][GEN_ENTRIES - 1], &base);
+		ge_set_gej(&base, &next);
+	}
+	ge_set_gej_batch(&gen_table[0][0], &jac[0][0],
+	    GEN_WINDOWS * GEN_ENTRIES, scratch);
+}
+
+static const ge *
+gen_table_get(void)
+{
+
+	pthread_once(&gen_table_once, gen_table_build);
+	return (&gen_table[0][0]);
+}
+
+/* The i-th 4-bit window of a big-endian scalar, least significant first. */
+static inline unsigned int
+scalar_window(const uint8_t k[32], int i)
+{
+
+	return ((k[31 - i / 2] >> (4 * (i & 1))) & 0xf);
+}
+
+/*
+ * r = k * G for a secret k, 0 < k < n: every table entry of every window is
+ * read, and every window does an addition, whatever the digits of k.
+ */
+static void
+ecmult_gen_ct(gej * r, const uint8_t k[32])
+{
+	const ge * table = gen_table_get();
+	gej acc, sum, start;
+	ge entry;
+	fe H, R;
+	uint64_t acc_inf = 1, nonzero, j;
+	unsigned int w;
+	int i, e;
+
+	memset(&acc, 0, sizeof(acc));
+	for (i = 0; i < GEN_WINDOWS; i++) {
+		w = scalar_window(k, i);
+		entry = table[i * GEN_ENTRIES];
+		for (e = 1; e < GEN_ENTRIES; e++) {
+			j = (uint64_t)(e + 1);
+			fe_cmov(&entry.x, &table[i * GEN_ENTRIES + e].x, j == w);
+			fe_cmov(&entry.y, &table[i * GEN_ENTRIES + e].y, j == w);
+		}
+		nonzero = (w != 0);
+
+		/*
+		 * The partial sum is j * G for some j < 16^i and the entry is at
+		 * least 16^i * G, and their sum stays below k < n, so the two
+		 * points never coincide or cancel out.
+		 */
+		gej_add_ge_unchecked(&sum, &acc, &entry, &H, &R);
+		gej_set_ge(&start, &entry);
+		fe_cmov(&sum.x, &start.x, acc_inf);
+		fe_cmov(&sum.y, &start.y, acc_inf);
+		fe_cmov(&sum.z, &start.z, acc_inf);
+		fe_cmov(&acc.x, &sum.x, nonzero);
+		fe_cmov(&acc.y, &sum.y, nonzero);
+		fe_cmov(&acc.z, &sum.z, nonzero);
+		acc_inf &= nonzero ^ 1;
+	}
+	acc.infinity = acc_inf;
+	*r = acc;
+}
+
+/* r = r + k * G for a public k, which may be zero. */
+static void
+ecmult_gen_add_vartime(gej * r, const uint8_t k[32])
+{
+	const ge * table = gen_table_get();
+	unsigned int w;
+	int i;
+
+	for (i = 0; i < GEN_WINDOWS; i++)
+		if ((w = scalar_window(k, i)) != 0)
+			gej_add_ge(r, r, &table[i * GEN_ENTRIES + w - 1]);
+}
+
+/* r = k * G for a public k, which may be zero. */
+static void
+ecmult_gen_vartime(gej * r, const uint8_t k[32])
+{
+
+	memset(r, 0, sizeof(*r));
+	r->infinity = 1;
+	ecmult_gen_add_vartime(r, k);
+}
+
+/*
+ * r = k * a for a public k, which may be zero, by 4-bit windows over the
+ * multiples 1 .. 15 of a, made affine with one inversion.
+ */
+static void
+ecmult_vartime(gej * r, const ge * a, const uint8_t k[32])
+{
+	gej jac[GEN_ENTRIES];
+	ge table[GEN_ENTRIES];
+	fe scratch[GEN_ENTRIES];
+	gej acc;
+	unsigned int w;
+	int i, j;
+
+	gej_set_ge(&jac[0], a);
+	for (j = 1; j < GEN_ENTRIES; j++)
+		gej_add_ge(&jac[j], &jac[j - 1], a);
+	ge_set_gej_batch(table, jac, GEN_ENTRIES, scratch);
+
+	memset(&acc, 0, sizeof(acc));
+	acc.infinity = 1;
+	for (i = GEN_WINDOWS - 1; i >= 0; i--) {
+		if (!acc.infinity)
+			for (j = 0; j < 4; j++)
+				gej_double(&acc, &acc);
+		if ((w = scalar_window(k, i)) != 0)
+			gej_add_ge(&acc, &acc, &table[w - 1]);
+	}
+	*r = acc;
+}
+
+/* Whether k, big-endian, is below n; and non-zero too if nonzero. */
+static int
+scalar_check(const uint8_t k[32], int nonzero)
+{
+	uint64_t d[4];
+
+	limbs_dec(d, k);
+	if (limbs_cmp(d, SC_N) >= 0)
+		return (-1);
+	if (nonzero && (d[0] | d[1] | d[2] | d[3]) == 0)
+		return (-1);
+	return (0);
+}
+
+/* t = lo + hi * (2^256 - n), with lo and hi four limbs and t eight. */
+static void
+sc_fold(uint64_t t[8], const uint64_t lo[4], const uint64_t hi[4])
+{
+	uint64_t carry;
+	u128 acc;
+	int i, j, k;
+
+	memcpy(t, lo, 4 * sizeof(uint64_t));
+	memset(&t[4], 0, 4 * sizeof(uint64_t));
+	for (i = 0; i < 4; i++) {
+		carry = 0;
+		for (j = 0; j < 3; j++) {
+			acc = (u128)(hi[i]) * SC_NC[j] + t[i + j] + carry;
+			t[i + j] = (uint64_t)(acc);
+			carry = (uint64_t)(acc >> 64);
+		}
+		for (k = i + 3; k < 8; k++) {
+			acc = (u128)(t[k]) + carry;
+			t[k] = (uint64_t)(acc);
+			carry = (uint64_t)(acc >> 64);
+		}
+	}
+}
+
+/*
+ * r = a * b mod n.  Three folds of the high half take the 512-bit product
+ * below 2^259, then below 2^256 + 2^132, where one subtraction of n is
+ * enough; the work does not depend on the values.
+ */
+static void
+sc_mul(uint64_t r[4], const uint64_t a[4], const uint64_t b[4])
+{
+	uint64_t t[8] = { 0 }, u[8], carry;
+	u128 acc;
+	int i, j;
+
+	for (i = 0; i < 4; i++) {
+		carry = 0;
+		for (j = 0; j < 4; j++) {
+			acc = (u128)(a[i]) * b[j] + t[i + j] + carry;
+			t[i + j] = (uint64_t)(acc);
+			carry = (uint64_t)(acc >> 64);
+		}
+		t[i + 4] = carry;
+	}
+	sc_fold(u, t, &t[4]);
+	sc_fold(t, u, &u[4]);
+	sc_fold(u, t, &t[4]);
+	limbs_reduce_once(r, u, SC_N, u[4]);
+	memset(t, 0, sizeof(t));
+	memset(u, 0, sizeof(u));
+}
+
+static void
+sc_add(uint64_t r[4], const uint64_t a[4], const uint64_t b[4])
+{
+	uint64_t t[4];
+	u128 acc = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		acc += (u128)(a[i]) + b[i];
+		t[i] = (uint64_t)(acc);
+		acc >>= 64;
+	}
+	limbs_reduce_once(r, t, SC_N, (uint64_t)(acc));
+}
+
+/* r = n - a, for a public non-zero a. */
+static void
+sc_negate(uint64_t r[4], const uint64_t a[4])
+{
+	uint64_t borrow = 0;
+	u128 acc;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		acc = (u128)(SC_N[i]) - a[i] - borrow;
+		r[i] = (uint64_t)(acc);
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+}
+
+/* a^(n - 2); the exponent is fixed, so the work does not depend on a. */
+static void
+sc_inv(uint64_t r[4], const uint64_t a[4])
+{
+	uint64_t x[4] = { 1, 0, 0, 0 };
+	int i;
+
+	for (i = 255; i >= 0; i--) {
+		sc_mul(x, x, x);
+		if ((SC_INV_EXP[i / 64] >> (i % 64)) & 1)
+			sc_mul(x, x, a);
+	}
+	memcpy(r, x, sizeof(x));
+	memset(x, 0, sizeof(x));
+}
+
+static inline int
+sc_is_zero(const uint64_t a[4])
+{
+
+	return ((a[0] | a[1] | a[2] | a[3]) == 0);
+}
+
+/* Decode 32 big-endian bytes mod n, returning 1 if they were not below n. */
+static int
+sc_dec_reduce(uint64_t r[4], const uint8_t b[32])
+{
+	uint64_t t[4];
+	int overflow;
+
+	limbs_dec(t, b);
+	overflow = (limbs_cmp(t, SC_N) >= 0);
+	limbs_reduce_once(r, t, SC_N, 0);
+	return (overflow);
+}
+
+static void
+ge_compress(uint8_t out[33], const ge * a)
+{
+
+	out[0] = (uint8_t)(0x02 | (a->y.d[0] & 1));
+	limbs_enc(&out[1], a->x.d);
+}
+
+static int
+ge_decompress(ge * r, const uint8_t in[33])
+{
+	fe x3, seven;
+
+	if ((in[0] != 0x02 && in[0] != 0x03) || fe_dec(&r->x, &in[1]))
+		return (-1);
+	fe_sqr(&x3, &r->x);
+	fe_mul(&x3, &x3, &r->x);
+	fe_set_int(&seven, 7);
+	fe_add(&x3, &x3, &seven);
+	if (fe_sqrt(&r->y, &x3))
+		return (-1);
+	if ((r->y.d[0] & 1) != (uint64_t)(in[0] & 1)) {
+		fe zero;
+
+		fe_set_int(&zero, 0);
+		fe_sub(&r->y, &zero, &r->y);
+	}
+	return (0);
+}
+
+int
+eckey_seckey_verify(const uint8_t seckey[32])
+{
+
+	return (scalar_check(seckey, 1));
+}
+
+int
+eckey_pubkey_create(const uint8_t seckey[32], uint8_t pubkey[33])
+{
+	gej p;
+	ge a;
+
+	if (scalar_check(seckey, 1))
+		return (-1);
+	ecmult_gen_ct(&p, seckey);
+	ge_set_gej(&a, &p);
+	ge_compress(pubkey, &a);
+	memset(&p, 0, sizeof(p));
+	return (0);
+}
+
+int
+eckey_pubkey_verify(const uint8_t pubkey[33])
+{
+	ge a;
+
+	return (ge_decompress(&a, pubkey));
+}
+
+int
+eckey_pubkey_decompress(const uint8_t pubkey[33], uint8_t out[65])
+{
+	ge a;
+
+	if (ge_decompress(&a, pubkey))
+		return (-1);
+	out[0] = 0x04;
+	limbs_enc(&out[1], a.x.d);
+	limbs_enc(&out[33], a.y.d);
+	return (0);
+}
+
+int
+eckey_seckey_tweak_add(uint8_t seckey[32], const uint8_t tweak[32])
+{
+	uint64_t a[4], b[4];
+	int rc = -1;
+
+	if (scalar_check(seckey, 1) || scalar_check(tweak, 0))
+		return (-1);
+	limbs_dec(a, seckey);
+	limbs_dec(b, tweak);
+	sc_add(a, a, b);
+	if (!sc_is_zero(a)) {
+		limbs_enc(seckey, a);
+		rc = 0;
+	}
+	memset(a, 0, sizeof(a));
+	memset(b, 0, sizeof(b));
+	return (rc);
+}
+
+int
+eckey_pubkey_tweak_add(const uint8_t pubkey[33], const uint8_t tweak[32],
+    uint8_t out[33])
+{
+	gej p;
+	ge a;
+
+	if (ge_decompress(&a, pubkey) || scalar_check(tweak, 0))
+		return (-1);
+	ecmult_gen_vartime(&p, tweak);
+	gej_add_ge(&p, &p, &a);
+	if (p.infinity)
+		return (-1);
+	ge_set_gej(&a, &p);
+	ge_compress(out, &a);
+	return (0);
+}
+
+size_t
+eckey_pubkey_tweak_add_batch(const uint8_t pubkey[33], const uint8_t * tweaks,
+    size_t n, uint8_t * out, int * ok)
+{
+	gej * points;
+	ge * affine;
+	fe * scratch;
+	ge a;
+	size_t i, done = 0;
+
+	if (ge_decompress(&a, pubkey))
+		return ((size_t)(-1));
+	if (n == 0)
+		return (0);
+	points = malloc(n * sizeof(gej));
+	affine = malloc(n * sizeof(ge));
+	scratch = malloc(n * sizeof(fe));
+	if (points == NULL || affine == NULL || scratch == NULL) {
+		free(points);
+		free(affine);
+		free(scratch);
+		return ((size_t)(-1));
+	}
+
+	for (i = 0; i < n; i++) {
+		if (scalar_check(&tweaks[i * 32], 0)) {
+			memset(&points[i], 0, sizeof(gej));
+			points[i].infinity = 1;
+			continue;
+		}
+		ecmult_gen_vartime(&points[i], &tweaks[i * 32]);
+		gej_add_ge(&points[i], &points[i], &a);
+	}
+	ge_set_gej_batch(affine, points, n, scratch);
+	for (i = 0; i < n; i++) {
+		if (points[i].infinity) {
+			ok[i] = -1;
+			memset(&out[i * 33], 0, 33);
+		} else {
+			ok[i] = 0;
+			ge_compress(&out[i * 33], &affine[i]);
+			done++;
+		}
+	}
+
+	free(points);
+	free(affine);
+	free(scratch);
+	return (done);
+}
+
+void
+eckey_precompute(void)
+{
+
+	(void)gen_table_get();
+}
+
+/* One HMAC-SHA256 under key of the concatenation of up to four parts. */
+static void
+rfc6979_hmac(uint8_t out[32], const uint8_t key[32], const uint8_t * a,
+    size_t alen, const uint8_t * b, size_t blen, const uint8_t * c,
+    size_t clen)
+{
+	HMAC_SHA256_CTX ctx;
+
+	HMAC_SHA256_Init(&ctx, key, 32);
+	HMAC_SHA256_Update(&ctx, a, alen);
+	if (blen)
+		HMAC_SHA256_Update(&ctx, b, blen);
+	if (clen)
+		HMAC_SHA256_Update(&ctx, c, clen);
+	HMAC_SHA256_Final(out, &ctx);
+	memset(&ctx, 0, sizeof(ctx));
+}
+
+int
+eckey_sign_recoverable(const uint8_t seckey[32], const uint8_t hash[32],
+    uint8_t sig[64], int * recid)
+{
+	static const uint8_t ZERO = 0x00, ONE = 0x01;
+	uint8_t V[32], K[32], xh[64], nonce[32], rb[32];
+	uint64_t d[4], e[4], k[4], r[4], s[4];
+	gej R;
+	ge Ra;
+	int overflow, id, retry;
+
+	if (scalar_check(seckey, 1))
+		return (-1);
+	limbs_dec(d, seckey);
+	sc_dec_reduce(e, hash);
+
+	/* RFC 6979: K and V seeded from the key and the reduced hash. */
+	memcpy(&xh[0], seckey, 32);
+	limbs_enc(&xh[32], e);
+	memset(V, 0x01, sizeof(V));
+	memset(K, 0x00, sizeof(K));
+	rfc6979_hmac(K, K, V, 32, &ZERO, 1, xh, sizeof(xh));
+	rfc6979_hmac(V, K, V, 32, NULL, 0, NULL, 0);
+	rfc6979_hmac(K, K, V, 32, &ONE, 1, xh, sizeof(xh));
+	rfc6979_hmac(V, K, V, 32, NULL, 0, NULL, 0);
+
+	for (retry = 0;; retry = 1) {
+		if (retry) {
+			rfc6979_hmac(K, K, V, 32, &ZERO, 1, NULL, 0);
+			rfc6979_hmac(V, K, V, 32, NULL, 0, NULL, 0);
+		}
+		rfc6979_hmac(V, K, V, 32, NULL, 0, NULL, 0);
+		memcpy(nonce, V, 32);
+		if (scalar_check(nonce, 1))
+			continue;
+
+		ecmult_gen_ct(&R, nonce);
+		ge_set_gej(&Ra, &R);
+		limbs_enc(rb, Ra.x.d);
+		overflow = sc_dec_reduce(r, rb);
+		if (sc_is_zero(r))
+			continue;
+		id = (int)(Ra.y.d[0] & 1) | (overflow << 1);
+
+		/* s = k^-1 (e + r d). */
+		limbs_dec(k, nonce);
+		sc_mul(s, r, d);
+		sc_add(s, s, e);
+		sc_inv(k, k);
+		sc_mul(s, s, k);
+		if (sc_is_zero(s))
+			continue;
+
+		/* Keep s low; negating it reflects R, flipping its parity. */
+		if (limbs_cmp(s, SC_N_HALF) > 0) {
+			sc_negate(s, s);
+			id ^= 1;
+		}
+		break;
+	}
+
+	limbs_enc(&sig[0], r);
+	limbs_enc(&sig[32], s);
+	*recid = id;
+
+	memset(V, 0, sizeof(V));
+	memset(K, 0, sizeof(K));
+	memset(xh, 0, sizeof(xh));
+	memset(nonce, 0, sizeof(nonce));
+	memset(d, 0, sizeof(d));
+	memset(k, 0, sizeof(k));
+	memset(&R, 0, sizeof(R));
+	return (0);
+}
+
+/* Q = r^-1 (s R - e G), left in Jacobian form; -1 if sig is invalid. */
+static int
+recover_gej(gej * q, const uint8_t sig[64], int recid, const uint8_t hash[32])
+{
+	uint8_t Rc[33], u1b[32], u2b[32];
+	uint64_t r[4], s[4], e[4], rinv[4], x[4];
+	u128 acc = 0;
+	ge R;
+	int i;
+
+	if (recid < 0 || recid > 3)
+		return (-1);
+	if (scalar_check(&sig[0], 1) || scalar_check(&sig[32], 1))
+		return (-1);
+	limbs_dec(r, &sig[0]);
+	limbs_dec(s, &sig[32]);
+
+	/* The x coordinate of R is r, or r + n if that is still below p. */
+	for (i = 0; i < 4; i++) {
+		acc += (u128)(r[i]) + ((recid & 2) ? SC_N[i] : 0);
+		x[i] = (uint64_t)(acc);
+		acc >>= 64;
+	}
+	if (acc != 0 || limbs_cmp(x, FE_P.d) >= 0)
+		return (-1);
+	Rc[0] = (uint8_t)(0x02 | (recid & 1));
+	limbs_enc(&Rc[1], x);
+	if (ge_decompress(&R, Rc))
+		return (-1);
+
+	sc_dec_reduce(e, hash);
+	sc_inv(rinv, r);
+	sc_mul(e, e, rinv);
+	if (!sc_is_zero(e))
+		sc_negate(e, e);
+	sc_mul(s, s, rinv);
+	limbs_enc(u1b, e);
+	limbs_enc(u2b, s);
+
+	ecmult_vartime(q, &R, u2b);
+	ecmult_gen_add_vartime(q, u1b);
+	return (q->infinity ? -1 : 0);
+}
+
+int
+eckey_recover(const uint8_t sig[64], int recid, const uint8_t hash[32],
+    uint8_t pubkey[65])
+{
+	gej q;
+	ge a;
+
+	if (recover_gej(&q, sig, recid, hash))
+		return (-1);
+	ge_set_gej(&a, &q);
+	pubkey[0] = 0x04;
+	limbs_enc(&pubkey[1], a.x.d);
+	limbs_enc(&pubkey[33], a.y.d);
+	return (0);
+}
+
+size_t
+eckey_recover_batch(const uint8_t * sigs, const int * recids,
+    const uint8_t * hashes, size_t n, uint8_t * pubkeys, int * ok)
+{
+	gej * points;
+	ge * affine;
+	fe * scratch;
+	size_t i, done = 0;
+
+	if (n == 0)
+		return (0);
+	points = malloc(n * sizeof(gej));
+	affine = malloc(n * sizeof(ge));
+	scratch = malloc(n * sizeof(fe));
+	if (points == NULL || affine == NULL || scratch == NULL) {
+		free(points);
+		free(affine);
+		free(scratch);
+		return ((size_t)(-1));
+	}
+
+	for (i = 0; i < n; i++) {
+		if (recover_gej(&points[i], &sigs[i * 64], recids[i],
+		    &hashes[i * 32])) {
+			memset(&points[i], 0, sizeof(gej));
+			points[i].infinity = 1;
+		}
+	}
+	ge_set_gej_batch(affine, points, n, scratch);
+	for (i = 0; i < n; i++) {
+		if (points[i].infinity) {
+			ok[i] = -1;
+			memset(&pubkeys[i * 65], 0, 65);
+		} else {
+			ok[i] = 0;
+			pubkeys[i * 65] = 0x04;
+			limbs_enc(&pubkeys[i * 65 + 1], affine[i].x.d);
+			limbs_enc(&pubkeys[i * 65 + 33], affine[i].y.d);
+			done++;
+		}
+	}
+
+	free(points);
+	free(affine);
+	free(scratch);
+	return (done);
+}
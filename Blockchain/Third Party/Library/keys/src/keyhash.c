@@ -0,0 +1,439 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define HAVE_ARMV8_SHA256 1
+#include <arm_neon.h>
+#elif (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define HAVE_X86_SHA256 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#include "sysendian.h"
+
+#include "keyhash.h"
+
+static const uint32_t K256[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t H256[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+typedef void (*sha256_blocks_fn)(uint32_t [8], const uint8_t *, size_t);
+
+#define ROTR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+
+/* SHA-256 compression of nblocks 64-byte blocks, in portable C. */
+static void
+sha256_blocks_generic(uint32_t state[8], const uint8_t * data, size_t nblocks)
+{
+	uint32_t W[64];
+	uint32_t S[8];
+	uint32_t t0, t1;
+	int i;
+
+	for (; nblocks > 0; nblocks--, data += 64) {
+		for (i = 0; i < 16; i++)
+			W[i] = be32dec(&data[4 * i]);
+		for (i = 16; i < 64; i++)
+			W[i] = (ROTR(W[i - 2], 17) ^ ROTR(W[i - 2], 19) ^
+			    (W[i - 2] >> 10)) + W[i - 7] + (ROTR(W[i - 15], 7) ^
+			    ROTR(W[i - 15], 18) ^ (W[i - 15] >> 3)) + W[i - 16];
+
+		memcpy(S, state, sizeof(S));
+		for (i = 0; i < 64; i++) {
+			t0 = S[7] + (ROTR(S[4], 6) ^ ROTR(S[4], 11) ^
+			    ROTR(S[4], 25)) + ((S[4] & S[5]) ^ (~S[4] & S[6])) +
+			    K256[i] + W[i];
+			t1 = (ROTR(S[0], 2) ^ ROTR(S[0], 13) ^ ROTR(S[0], 22)) +
+			    ((S[0] & S[1]) ^ (S[0] & S[2]) ^ (S[1] & S[2]));
+			S[7] = S[6];
+			S[6] = S[5];
+			S[5] = S[4];
+			S[4] = S[3] + t0;
+			S[3] = S[2];
+			S[2] = S[1];
+			S[1] = S[0];
+			S[0] = t0 + t1;
+		}
+		for (i = 0; i < 8; i++)
+			state[i] += S[i];
+	}
+}
+
+#if defined(HAVE_ARMV8_SHA256)
+
+static void
+sha256_blocks_armv8(uint32_t state[8], const uint8_t * data, size_t nblocks)
+{
+	uint32x4_t S0, S1, S0_save, S1_save, W[4], T, tmp;
+	int i;
+
+	S0 = vld1q_u32(&state[0]);
+	S1 = vld1q_u32(&state[4]);
+	for (; nblocks > 0; nblocks--, data += 64) {
+		S0_save = S0;
+		S1_save = S1;
+		for (i = 0; i < 4; i++)
+			W[i] = vreinterpretq_u32_u8(vrev32q_u8(
+			    vld1q_u8(&data[16 * i])));
+
+		/* Four rounds per step; W[i + 4] replaces W[i] once used. */
+		for (i = 0; i < 16; i++) {
+			T = vaddq_u32(W[i & 3], vld1q_u32(&K256[4 * i]));
+			tmp = S0;
+			S0 = vsha256hq_u32(S0, S1, T);
+			S1 = vsha256h2q_u32(S1, tmp, T);
+			if (i < 12)
+				W[i & 3] = vsha256su1q_u32(vsha256su0q_u32(
+				    W[i & 3], W[(i + 1) & 3]), W[(i + 2) & 3],
+				    W[(i + 3) & 3]);
+		}
+
+		S0 = vaddq_u32(S0, S0_save);
+		S1 = vaddq_u32(S1, S1_save);
+	}
+	vst1q_u32(&state[0], S0);
+	vst1q_u32(&state[4], S1);
+}
+
+static sha256_blocks_fn
+sha256_resolve(void)
+{
+
+	return (sha256_blocks_armv8);
+}
+
+#elif defined(HAVE_X86_SHA256)
+
+__attribute__((target("sha,sse4.1")))
+static void
+sha256_blocks_shani(uint32_t state[8], const uint8_t * data, size_t nblocks)
+{
+	const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+	    0x0405060700010203ULL);
+	__m128i S0, S1, S0_save, S1_save, W[4], M, tmp;
+	int i;
+
+	/* The rounds work on (A, B, E, F) and (C, D, G, H). */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]),
+	    0xB1);
+	S1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]),
+	    0x1B);
+	S0 = _mm_alignr_epi8(tmp, S1, 8);
+	S1 = _mm_blend_epi16(S1, tmp, 0xF0);
+
+	for (; nblocks > 0; nblocks--, data += 64) {
+		S0_save = S0;
+		S1_save = S1;
+
+		/* Four rounds per step; W[i] is replaced by W[i + 4]. */
+		for (i = 0; i < 16; i++) {
+			if (i < 4)
+				W[i] = _mm_shuffle_epi8(_mm_loadu_si128(
+				    (const __m128i *)&data[16 * i]), MASK);
+			else
+				W[i & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(
+				    _mm_sha256msg1_epu32(W[i & 3],
+				    W[(i + 1) & 3]), _mm_alignr_epi8(
+				    W[(i + 3) & 3], W[(i + 2) & 3], 4)),
+				    W[(i + 3) & 3]);
+			M = _mm_add_epi32(W[i & 3],
+			    _mm_loadu_si128((const __m128i *)&K256[4 * i]));
+			S1 = _mm_sha256rnds2_epu32(S1, S0, M);
+			S0 = _mm_sha256rnds2_epu32(S0, S1,
+			    _mm_shuffle_epi32(M, 0x0E));
+		}
+
+		S0 = _mm_add_epi32(S0, S0_save);
+		S1 = _mm_add_epi32(S1, S1_save);
+	}
+
+	tmp = _mm_shuffle_epi32(S0, 0x1B);
+	S1 = _mm_shuffle_epi32(S1, 0xB1);
+	_mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, S1, 0xF0));
+	_mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(S1, tmp, 8));
+}
+
+static sha256_blocks_fn
+sha256_resolve(void)
+{
+	unsigned int a, b, c, d;
+
+	/* SHA extensions (leaf 7, EBX bit 29) with SSSE3 and SSE4.1. */
+	if (__get_cpuid(1, &a, &b, &c, &d) && (c & (1 << 9)) &&
+	    (c & (1 << 19)) && __get_cpuid_count(7, 0, &a, &b, &c, &d) &&
+	    (b & (1 << 29)))
+		return (sha256_blocks_shani);
+	return (sha256_blocks_generic);
+}
+
+#else
+
+static sha256_blocks_fn
+sha256_resolve(void)
+{
+
+	return (sha256_blocks_generic);
+}
+
+#endif
+
+/* Resolved on first use; racing threads store the same pointer. */
+static sha256_blocks_fn sha256_blocks_impl;
+
+static sha256_blocks_fn
+sha256_blocks(void)
+{
+	sha256_blocks_fn fn = sha256_blocks_impl;
+
+	if (fn == NULL)
+		sha256_blocks_impl = fn = sha256_resolve();
+	return (fn);
+}
+
+/* SHA-256 of in[0 .. len - 1], left as state words. */
+static inline void
+sha256_state(sha256_blocks_fn blocks, const uint8_t * in, size_t len,
+    uint32_t state[8])
+{
+	uint8_t tail[128];
+	size_t full = len / 64, rest = len % 64, tlen;
+
+	memcpy(state, H256, sizeof(H256));
+	if (full > 0)
+		blocks(state, in, full);
+
+	/* Padding takes one block if it fits after the data, else two. */
+	tlen = (rest < 56) ? 64 : 128;
+	memcpy(tail, &in[full * 64], rest);
+	tail[rest] = 0x80;
+	memset(&tail[rest + 1], 0, tlen - rest - 9);
+	be64enc(&tail[tlen - 8], (uint64_t)(len) << 3);
+	blocks(state, tail, tlen / 64);
+}
+
+/* SHA-256 of a 32-byte digest given as state words, in one compression. */
+static inline void
+sha256_of_state(sha256_blocks_fn blocks, const uint32_t in[8],
+    uint32_t state[8])
+{
+	uint8_t block[64];
+	int i;
+
+	for (i = 0; i < 8; i++)
+		be32enc(&block[4 * i], in[i]);
+	block[32] = 0x80;
+	memset(&block[33], 0, 23);
+	be64enc(&block[56], 256);
+	memcpy(state, H256, sizeof(H256));
+	blocks(state, block, 1);
+}
+
+/* RIPEMD-160 message word order and rotations, left line then right. */
+static const uint8_t RL[80] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	7, 4, 13, 1, 10, 6, 15, 3, 12, 0, 9, 5, 2, 14, 11, 8,
+	3, 10, 14, 4, 9, 15, 8, 1, 2, 7, 0, 6, 13, 11, 5, 12,
+	1, 9, 11, 10, 0, 8, 12, 4, 13, 3, 7, 15, 14, 5, 6, 2,
+	4, 0, 5, 9, 7, 12, 2, 10, 14, 1, 3, 8, 11, 6, 15, 13
+};
+static const uint8_t RR[80] = {
+	5, 14, 7, 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12,
+	6, 11, 3, 7, 0, 13, 5, 10, 14, 15, 8, 12, 4, 9, 1, 2,
+	15, 5, 1, 3, 7, 14, 6, 9, 11, 8, 12, 2, 10, 0, 4, 13,
+	8, 6, 4, 1, 3, 11, 15, 0, 5, 12, 2, 13, 9, 7, 10, 14,
+	12, 15, 10, 4, 1, 5, 8, 7, 6, 2, 13, 14, 0, 3, 9, 11
+};
+static const uint8_t SL[80] = {
+	11, 14, 15, 12, 5, 8, 7, 9, 11, 13, 14, 15, 6, 7, 9, 8,
+	7, 6, 8, 13, 11, 9, 7, 15, 7, 12, 15, 9, 11, 7, 13, 12,
+	11, 13, 6, 7, 14, 9, 13, 15, 14, 8, 13, 6, 5, 12, 7, 5,
+	11, 12, 14, 15, 14, 15, 9, 8, 9, 14, 5, 6, 8, 6, 5, 12,
+	9, 15, 5, 11, 6, 8, 13, 12, 5, 12, 13, 14, 11, 8, 5, 6
+};
+static const uint8_t SR[80] = {
+	8, 9, 9, 11, 13, 15, 15, 5, 7, 7, 8, 11, 14, 14, 12, 6,
+	9, 13, 15, 7, 12, 8, 9, 11, 7, 7, 12, 7, 6, 15, 13, 11,
+	9, 7, 15, 11, 8, 6, 6, 14, 12, 13, 5, 14, 13, 13, 7, 5,
+	15, 5, 8, 11, 14, 14, 6, 14, 6, 9, 12, 9, 12, 5, 15, 8,
+	8, 5, 12, 9, 12, 5, 14, 6, 8, 13, 6, 5, 15, 13, 11, 11
+};
+static const uint32_t KL[5] = {
+	0x00000000, 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xA953FD4E
+};
+static const uint32_t KR[5] = {
+	0x50A28BE6, 0x5C4DD124, 0x6D703EF3, 0x7A6D76E9, 0x00000000
+};
+
+static inline uint32_t
+ripemd_f(int j, uint32_t x, uint32_t y, uint32_t z)
+{
+
+	switch (j >> 4) {
+	case 0:
+		return (x ^ y ^ z);
+	case 1:
+		return ((x & y) | (~x & z));
+	case 2:
+		return ((x | ~y) ^ z);
+	case 3:
+		return ((x & z) | (y & ~z));
+	default:
+		return (x ^ (y | ~z));
+	}
+}
+
+/*
+ * RIPEMD-160 of a 32-byte digest given as SHA-256 state words: a single
+ * block, the digest followed by its padding.
+ */
+static void
+ripemd160_of_state(const uint32_t in[8], uint8_t out[20])
+{
+	static const uint32_t H[5] = {
+		0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+	};
+	uint32_t X[16];
+	uint32_t al, bl, cl, dl, el, ar, br, cr, dr, er, t;
+	int i, j;
+
+	/* The digest is big-endian bytes; RIPEMD reads little-endian words. */
+	for (i = 0; i < 8; i++)
+		X[i] = ((in[i] & 0xff) << 24) | ((in[i] & 0xff00) << 8) |
+		    ((in[i] >> 8) & 0xff00) | (in[i] >> 24);
+	X[8] = 0x80;
+	for (i = 9; i < 16; i++)
+		X[i] = 0;
+	X[14] = 256;
+
+	al = ar = H[0];
+	bl = br = H[1];
+	cl = cr = H[2];
+	dl = dr = H[3];
+	el = er = H[4];
+	for (j = 0; j < 80; j++) {
+		t = ROTL(al + ripemd_f(j, bl, cl, dl) + X[RL[j]] + KL[j >> 4],
+		    SL[j]) + el;
+		al = el;
+		el = dl;
+		dl = ROTL(cl, 10);
+		cl = bl;
+		bl = t;
+
+		t = ROTL(ar + ripemd_f(79 - j, br, cr, dr) + X[RR[j]] +
+		    KR[j >> 4], SR[j]) + er;
+		ar = er;
+		er = dr;
+		dr = ROTL(cr, 10);
+		cr = br;
+		br = t;
+	}
+
+	le32enc(&out[0], H[1] + cl + dr);
+	le32enc(&out[4], H[2] + dl + er);
+	le32enc(&out[8], H[3] + el + ar);
+	le32enc(&out[12], H[4] + al + br);
+	le32enc(&out[16], H[0] + bl + cr);
+}
+
+static inline void
+state_enc(const uint32_t state[8], uint8_t out[32])
+{
+	int i;
+
+	for (i = 0; i < 8; i++)
+		be32enc(&out[4 * i], state[i]);
+}
+
+void
+sha256d(const uint8_t * in, size_t len, uint8_t out[32])
+{
+	sha256_blocks_fn blocks = sha256_blocks();
+	uint32_t S[8], T[8];
+
+	sha256_state(blocks, in, len, S);
+	sha256_of_state(blocks, S, T);
+	state_enc(T, out);
+}
+
+void
+sha256d_32(const uint8_t in[32], uint8_t out[32])
+{
+
+	sha256d(in, 32, out);
+}
+
+void
+hash160(const uint8_t * in, size_t len, uint8_t out[20])
+{
+	uint32_t S[8];
+
+	sha256_state(sha256_blocks(), in, len, S);
+	ripemd160_of_state(S, out);
+}
+
+void
+hash160_33(const uint8_t in[33], uint8_t out[20])
+{
+
+	hash160(in, 33, out);
+}
+
+void
+hash160_65(const uint8_t in[65], uint8_t out[20])
+{
+
+	hash160(in, 65, out);
+}
+
+void
+sha256d_batch(const uint8_t * in, size_t len, size_t n, uint8_t * out)
+{
+	sha256_blocks_fn blocks = sha256_blocks();
+	uint32_t S[8], T[8];
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		sha256_state(blocks, &in[i * len], len, S);
+		sha256_of_state(blocks, S, T);
+		state_enc(T, &out[i * 32]);
+	}
+}
+
+void
+hash160_batch(const uint8_t * in, size_t len, size_t n, uint8_t * out)
+{
+	sha256_blocks_fn blocks = sha256_blocks();
+	uint32_t S[8];
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		sha256_state(blocks, &in[i * len], len, S);
+		ripemd160_of_state(S, &out[i * 20]);
+	}
+}
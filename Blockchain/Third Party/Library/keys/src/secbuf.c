@@ -0,0 +1,322 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <sys/mman.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "secbuf.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS	MAP_ANON
+#endif
+
+/* Size classes, in ascending order; the last is SECBUF_MAX_POOLED. */
+#define NCLASSES	4
+static const size_t class_size[NCLASSES] = { 64, 256, 1024, 4096 };
+
+/* Bytes mapped at once for a class, rounded up to whole pages. */
+#define SLAB_SIZE	(16 * 1024)
+
+/*
+ * Free buffers a thread keeps per class, and how many move at once between
+ * it and the pool when it runs out or has too many.
+ */
+#define CACHE_MAX	16
+#define CACHE_BATCH	8
+
+/* A free buffer, linked through its first bytes. */
+struct freebuf {
+	struct freebuf * next;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	struct freebuf * free[NCLASSES];
+	/* All but in_use and peak, which are counted without the lock. */
+	struct secbuf_usage usage;
+} pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static _Atomic uint64_t in_use;
+static _Atomic uint64_t peak;
+
+struct cache {
+	struct freebuf * free[NCLASSES];
+	unsigned count[NCLASSES];
+};
+
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+static __thread struct cache * thread_cache;
+
+/* A memset the compiler cannot see through, and so cannot elide. */
+static void * (* const volatile memset_ptr)(void *, int, size_t) = memset;
+
+void
+secbuf_wipe(void * buf, size_t len)
+{
+
+	(memset_ptr)(buf, 0, len);
+}
+
+/* Class of a len byte buffer, or -1 if none is large enough. */
+static int
+class_of(size_t len)
+{
+	int c;
+
+	for (c = 0; c < NCLASSES; c++) {
+		if (len <= class_size[c])
+			return (c);
+	}
+	return (-1);
+}
+
+/**
+ * map_secret(len, locked):
+ * Map len bytes of zeroed memory that stays out of core dumps and, if it can
+ * be, is locked into RAM.  Store whether it is locked in locked.  Return
+ * NULL if it cannot be mapped.
+ */
+static void *
+map_secret(size_t len, int * locked)
+{
+	void * p;
+
+	if ((p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)
+		return (NULL);
+#if defined(MADV_DONTDUMP)
+	(void)madvise(p, len, MADV_DONTDUMP);
+#elif defined(MADV_ZERO_WIRED_PAGES)
+	/* No core dumps to keep out of, but zero the pages once unwired. */
+	(void)madvise(p, len, MADV_ZERO_WIRED_PAGES);
+#endif
+	*locked = (mlock(p, len) == 0);
+	return (p);
+}
+
+/* Round len up to whole pages. */
+static size_t
+page_round(size_t len)
+{
+	size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+	return ((len + page - 1) / page * page);
+}
+
+/**
+ * pool_take(c, n, head):
+ * Move up to n free buffers of class c from the pool to the list head,
+ * mapping a slab first if the pool has none.  Return how many were moved,
+ * 0 only if no slab could be mapped.
+ */
+static unsigned
+pool_take(int c, unsigned n, struct freebuf ** head)
+{
+	struct freebuf * fb;
+	uint8_t * slab;
+	size_t len, off;
+	unsigned i;
+	int locked;
+
+	pthread_mutex_lock(&pool.lock);
+	if (pool.free[c] == NULL) {
+		len = page_round(SLAB_SIZE);
+		if ((slab = map_secret(len, &locked)) != NULL) {
+			pool.usage.mapped += len;
+			if (locked)
+				pool.usage.locked += len;
+			else
+				pool.usage.lock_failures++;
+			for (off = len; off >= class_size[c]; ) {
+				off -= class_size[c];
+				fb = (struct freebuf *)(slab + off);
+				fb->next = pool.free[c];
+				pool.free[c] = fb;
+			}
+		}
+	}
+	for (i = 0; i < n && (fb = pool.free[c]) != NULL; i++) {
+		pool.free[c] = fb->next;
+		fb->next = *head;
+		*head = fb;
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return (i);
+}
+
+/* Give the n buffers of class c listed from head back to the pool. */
+static void
+pool_give(int c, struct freebuf * head, unsigned n)
+{
+	struct freebuf * tail;
+
+	if (n == 0)
+		return;
+	for (tail = head; tail->next != NULL; tail = tail->next)
+		continue;
+	pthread_mutex_lock(&pool.lock);
+	tail->next = pool.free[c];
+	pool.free[c] = head;
+	pthread_mutex_unlock(&pool.lock);
+}
+
+/* Give every buffer cached by an exiting thread back to the pool. */
+static void
+cache_release(void * cookie)
+{
+	struct cache * cache = cookie;
+	int c;
+
+	for (c = 0; c < NCLASSES; c++)
+		pool_give(c, cache->free[c], cache->count[c]);
+	free(cache);
+	thread_cache = NULL;
+}
+
+static void
+cache_key_create(void)
+{
+
+	(void)pthread_key_create(&cache_key, cache_release);
+}
+
+/* The cache of the calling thread, or NULL if it cannot be allocated. */
+static struct cache *
+cache_get(void)
+{
+	struct cache * cache;
+
+	if ((cache = thread_cache) != NULL)
+		return (cache);
+	pthread_once(&cache_key_once, cache_key_create);
+	if ((cache = calloc(1, sizeof(struct cache))) == NULL)
+		return (NULL);
+	if (pthread_setspecific(cache_key, cache)) {
+		free(cache);
+		return (NULL);
+	}
+	thread_cache = cache;
+	return (cache);
+}
+
+static void
+count_taken(void)
+{
+	uint64_t n, p;
+
+	n = atomic_fetch_add_explicit(&in_use, 1, memory_order_relaxed) + 1;
+	p = atomic_load_explicit(&peak, memory_order_relaxed);
+	while (n > p && !atomic_compare_exchange_weak_explicit(&peak, &p, n,
+	    memory_order_relaxed, memory_order_relaxed))
+		continue;
+}
+
+int
+secbuf_get(struct secbuf * sb, size_t len)
+{
+	struct cache * cache;
+	struct freebuf * fb = NULL;
+	int c, locked;
+
+	sb->buf = NULL;
+	sb->len = 0;
+
+	/* Too large for the slabs: pages of its own. */
+	if ((c = class_of(len)) == -1) {
+		if ((sb->buf = map_secret(page_round(len), &locked)) == NULL)
+			goto err0;
+		pthread_mutex_lock(&pool.lock);
+		pool.usage.large++;
+		if (!locked)
+			pool.usage.lock_failures++;
+		pthread_mutex_unlock(&pool.lock);
+		goto done;
+	}
+
+	if ((cache = cache_get()) == NULL) {
+		if (pool_take(c, 1, &fb) == 0)
+			goto err0;
+	} else {
+		if (cache->free[c] == NULL)
+			cache->count[c] += pool_take(c, CACHE_BATCH,
+			    &cache->free[c]);
+		if ((fb = cache->free[c]) == NULL)
+			goto err0;
+		cache->free[c] = fb->next;
+		cache->count[c]--;
+	}
+	/* Free buffers are zero but for their link. */
+	fb->next = NULL;
+	sb->buf = (uint8_t *)fb;
+
+done:
+	sb->len = len;
+	count_taken();
+	return (0);
+
+err0:
+	errno = ENOMEM;
+	return (-1);
+}
+
+void
+secbuf_put(struct secbuf * sb)
+{
+	struct cache * cache;
+	struct freebuf * fb, * batch;
+	unsigned i;
+	int c;
+
+	if (sb->buf == NULL)
+		return;
+
+	if ((c = class_of(sb->len)) == -1) {
+		secbuf_wipe(sb->buf, sb->len);
+		(void)munlock(sb->buf, page_round(sb->len));
+		(void)munmap(sb->buf, page_round(sb->len));
+		goto done;
+	}
+
+	/* The whole class, so that the next owner gets it zeroed. */
+	secbuf_wipe(sb->buf, class_size[c]);
+	fb = (struct freebuf *)sb->buf;
+	if ((cache = cache_get()) == NULL) {
+		pool_give(c, fb, 1);
+		goto done;
+	}
+	fb->next = cache->free[c];
+	cache->free[c] = fb;
+	if (++cache->count[c] > CACHE_MAX) {
+		/* Keep the most recently used, hand back the rest of a batch. */
+		for (fb = cache->free[c], i = 1; i < CACHE_MAX - CACHE_BATCH; i++)
+			fb = fb->next;
+		batch = fb->next;
+		fb->next = NULL;
+		pool_give(c, batch, cache->count[c] - (CACHE_MAX - CACHE_BATCH));
+		cache->count[c] = CACHE_MAX - CACHE_BATCH;
+	}
+
+done:
+	atomic_fetch_sub_explicit(&in_use, 1, memory_order_relaxed);
+	sb->buf = NULL;
+	sb->len = 0;
+}
+
+void
+secbuf_usage(struct secbuf_usage * usage)
+{
+
+	pthread_mutex_lock(&pool.lock);
+	*usage = pool.usage;
+	pthread_mutex_unlock(&pool.lock);
+	usage->in_use = atomic_load_explicit(&in_use, memory_order_relaxed);
+	usage->peak = atomic_load_explicit(&peak, memory_order_relaxed);
+}
@@ -0,0 +1,183 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openssl/sha.h>
+
+#include "eckey.h"
+#include "keyhash.h"
+#include "sysendian.h"
+
+#include "signmsg.h"
+
+static const uint8_t SIGNMSG_PREFIX[] = "\030Bitcoin Signed Message:\n";
+
+/* Header byte bounds: 27 + recid, plus 4 for a compressed key. */
+#define SIGNMSG_HEADER_MIN	27
+#define SIGNMSG_HEADER_MAX	34
+
+void
+signmsg_hash(const uint8_t * msg, size_t len, uint8_t hash[32])
+{
+	SHA256_CTX ctx;
+	uint8_t varint[9];
+	size_t varintlen;
+
+	/* The message length as a Bitcoin CompactSize integer. */
+	if (len < 0xfd) {
+		varint[0] = (uint8_t)(len);
+		varintlen = 1;
+	} else if (len <= 0xffff) {
+		varint[0] = 0xfd;
+		varint[1] = (uint8_t)(len);
+		varint[2] = (uint8_t)(len >> 8);
+		varintlen = 3;
+	} else if (len <= 0xffffffff) {
+		varint[0] = 0xfe;
+		le32enc(&varint[1], (uint32_t)(len));
+		varintlen = 5;
+	} else {
+		varint[0] = 0xff;
+		le64enc(&varint[1], (uint64_t)(len));
+		varintlen = 9;
+	}
+
+	SHA256_Init(&ctx);
+	SHA256_Update(&ctx, SIGNMSG_PREFIX, sizeof(SIGNMSG_PREFIX) - 1);
+	SHA256_Update(&ctx, varint, varintlen);
+	SHA256_Update(&ctx, msg, len);
+	SHA256_Final(hash, &ctx);
+	SHA256_Init(&ctx);
+	SHA256_Update(&ctx, hash, 32);
+	SHA256_Final(hash, &ctx);
+}
+
+int
+signmsg_sign(const uint8_t seckey[32], int compressed, const uint8_t * msg,
+    size_t len, uint8_t sig[SIGNMSG_SIGLEN])
+{
+	uint8_t hash[32];
+	int recid;
+
+	signmsg_hash(msg, len, hash);
+	if (eckey_sign_recoverable(seckey, hash, &sig[1], &recid))
+		return (-1);
+	sig[0] = (uint8_t)(SIGNMSG_HEADER_MIN + recid + (compressed ? 4 : 0));
+	return (0);
+}
+
+/* Parse the header of sig, returning -1 if it is out of range. */
+static int
+signmsg_header(const uint8_t sig[SIGNMSG_SIGLEN], int * recid,
+    int * compressed)
+{
+
+	if (sig[0] < SIGNMSG_HEADER_MIN || sig[0] > SIGNMSG_HEADER_MAX)
+		return (-1);
+	*recid = (sig[0] - SIGNMSG_HEADER_MIN) & 3;
+	*compressed = ((sig[0] - SIGNMSG_HEADER_MIN) & 4) != 0;
+	return (0);
+}
+
+/* Write the hash160 of the uncompressed key pubkey, or of its compression. */
+static void
+signmsg_key_hash160(const uint8_t pubkey[65], int compressed,
+    uint8_t hash160[20])
+{
+	uint8_t c[33];
+
+	if (compressed) {
+		c[0] = (uint8_t)(0x02 | (pubkey[64] & 1));
+		memcpy(&c[1], &pubkey[1], 32);
+		hash160_33(c, hash160);
+	} else {
+		hash160_65(pubkey, hash160);
+	}
+}
+
+int
+signmsg_recover_hash160(const uint8_t sig[SIGNMSG_SIGLEN],
+    const uint8_t * msg, size_t len, uint8_t hash160[20])
+{
+	uint8_t hash[32], pubkey[65];
+	int recid, compressed;
+
+	if (signmsg_header(sig, &recid, &compressed))
+		return (-1);
+	signmsg_hash(msg, len, hash);
+	if (eckey_recover(&sig[1], recid, hash, pubkey))
+		return (-1);
+	signmsg_key_hash160(pubkey, compressed, hash160);
+	return (0);
+}
+
+int
+signmsg_verify(const uint8_t sig[SIGNMSG_SIGLEN], const uint8_t * msg,
+    size_t len, const uint8_t hash160[20])
+{
+	uint8_t recovered[20];
+
+	if (signmsg_recover_hash160(sig, msg, len, recovered))
+		return (-1);
+	return (memcmp(recovered, hash160, 20) == 0 ? 0 : -1);
+}
+
+size_t
+signmsg_verify_batch(const uint8_t * sigs, const uint8_t * const * msgs,
+    const size_t * lens, const uint8_t * hash160s, size_t n, int * ok)
+{
+	uint8_t * rs, * hashes, * pubkeys;
+	int * recids, * compressed;
+	uint8_t recovered[20];
+	size_t i, done = 0;
+
+	if (n == 0)
+		return (0);
+	rs = malloc(n * 64);
+	hashes = malloc(n * 32);
+	pubkeys = malloc(n * 65);
+	recids = malloc(n * sizeof(int));
+	compressed = malloc(n * sizeof(int));
+	if (rs == NULL || hashes == NULL || pubkeys == NULL ||
+	    recids == NULL || compressed == NULL)
+		goto err;
+
+	/* A bad header gets an invalid recovery id, so it fails to recover. */
+	for (i = 0; i < n; i++) {
+		if (signmsg_header(&sigs[i * SIGNMSG_SIGLEN], &recids[i],
+		    &compressed[i]))
+			recids[i] = -1;
+		memcpy(&rs[i * 64], &sigs[i * SIGNMSG_SIGLEN + 1], 64);
+		signmsg_hash(msgs[i], lens[i], &hashes[i * 32]);
+	}
+	if (eckey_recover_batch(rs, recids, hashes, n, pubkeys, ok) ==
+	    (size_t)(-1))
+		goto err;
+
+	for (i = 0; i < n; i++) {
+		if (ok[i])
+			continue;
+		signmsg_key_hash160(&pubkeys[i * 65], compressed[i], recovered);
+		if (memcmp(recovered, &hash160s[i * 20], 20) == 0)
+			done++;
+		else
+			ok[i] = -1;
+	}
+
+	free(rs);
+	free(hashes);
+	free(pubkeys);
+	free(recids);
+	free(compressed);
+	return (done);
+
+err:
+	free(rs);
+	free(hashes);
+	free(pubkeys);
+	free(recids);
+	free(compressed);
+	return ((size_t)(-1));
+}
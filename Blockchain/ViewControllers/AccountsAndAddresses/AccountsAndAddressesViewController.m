@@ -234,6 +234,25 @@
     }
 }
 
+- (uint64_t)balanceForRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    if (indexPath.section == 0) {
+        return [[WalletManager.sharedInstance.wallet getBalanceForAccount:(int)indexPath.row assetType:self.assetType] longLongValue];
+    }
+    if (self.assetType == LegacyAssetTypeBitcoin) {
+        return [[WalletManager.sharedInstance.wallet getLegacyAddressBalance:self.allKeys[indexPath.row] assetType:self.assetType] longLongValue];
+    }
+    return [WalletManager.sharedInstance.wallet getTotalBalanceForActiveLegacyAddresses:self.assetType];
+}
+
+- (BOOL)isArchivedRowAtIndexPath:(NSIndexPath *)indexPath
+{
+    if (indexPath.section == 0) {
+        return [WalletManager.sharedInstance.wallet isAccountArchived:(int)indexPath.row assetType:self.assetType];
+    }
+    return [WalletManager.sharedInstance.wallet isAddressArchived:self.allKeys[indexPath.row]];
+}
+
 - (UITableViewCell *)tableView:(UITableView *)tableView sectionZeroCellForRowAtIndexPath:(NSIndexPath *)indexPath {
     int accountIndex = (int) indexPath.row;
     NSString *accountLabelString = [WalletManager.sharedInstance.wallet getLabelForAccount:accountIndex assetType:self.assetType];
@@ -294,14 +313,14 @@
     cell.labelLabel.text = accountLabelString;
     cell.addressLabel.text = @"";
 
-    uint64_t balance = [[WalletManager.sharedInstance.wallet getBalanceForAccount:accountIndex assetType:self.assetType] longLongValue];
+    uint64_t balance = [self balanceForRowAtIndexPath:indexPath];
 
     // Selected cell color
     UIView *v = [[UIView alloc] initWithFrame:CGRectMake(0,0,cell.frame.size.width,cell.frame.size.height)];
     [v setBackgroundColor:UIColor.brandPrimary];
     [cell setSelectedBackgroundView:v];
 
-    if ([WalletManager.sharedInstance.wallet isAccountArchived:accountIndex assetType:self.assetType]) {
+    if ([self isArchivedRowAtIndexPath:indexPath]) {
         cell.balanceLabel.text = BC_STRING_ARCHIVED;
         cell.balanceLabel.textColor = UIColor.brandSecondary;
     } else {
@@ -375,13 +394,13 @@
 
     cell.addressLabel.text = self.assetType == LegacyAssetTypeBitcoin ? addr : nil;
 
-    uint64_t balance = self.assetType == LegacyAssetTypeBitcoin ? [[WalletManager.sharedInstance.wallet getLegacyAddressBalance:addr assetType:self.assetType] longLongValue] : [WalletManager.sharedInstance.wallet getTotalBalanceForActiveLegacyAddresses:self.assetType];
+    uint64_t balance = [self balanceForRowAtIndexPath:indexPath];
 
     UIView *v = [[UIView alloc] initWithFrame:CGRectMake(0,0,cell.frame.size.width,cell.frame.size.height)];
     [v setBackgroundColor:UIColor.brandPrimary];
     [cell setSelectedBackgroundView:v];
 
-    if ([WalletManager.sharedInstance.wallet isAddressArchived:addr]) {
+    if ([self isArchivedRowAtIndexPath:indexPath]) {
         cell.balanceLabel.text = BC_STRING_ARCHIVED;
         cell.balanceLabel.textColor = UIColor.brandSecondary;
     } else {
@@ -411,6 +430,31 @@
 - (void)toggleSymbol
 {
     BlockchainSettingsApp.shared.symbolLocal = !BlockchainSettingsApp.shared.symbolLocal;
+    [self reformatVisibleBalances];
+}
+
+// Re-formats the balances of the visible rows in a single call rather than reloading their cells.
+- (void)reformatVisibleBalances
+{
+    NSMutableArray<NSIndexPath *> *indexPaths = [NSMutableArray new];
+    NSMutableArray<NSNumber *> *balances = [NSMutableArray new];
+    for (NSIndexPath *indexPath in self.tableView.indexPathsForVisibleRows) {
+        if ([self isArchivedRowAtIndexPath:indexPath]) {
+            continue;
+        }
+        [indexPaths addObject:indexPath];
+        [balances addObject:@([self balanceForRowAtIndexPath:indexPath])];
+    }
+
+    BOOL symbolLocal = BlockchainSettingsApp.shared.symbolLocal;
+    NSArray<NSString *> *formattedBalances = self.assetType == LegacyAssetTypeBitcoin
+        ? [NSNumberFormatter formatMoneyValues:balances localCurrency:symbolLocal]
+        : [NSNumberFormatter formatBCHAmounts:balances includeSymbol:YES inLocalCurrency:symbolLocal];
+
+    [indexPaths enumerateObjectsUsingBlock:^(NSIndexPath *indexPath, NSUInteger index, BOOL *stop) {
+        ReceiveTableCell *cell = (ReceiveTableCell *)[self.tableView cellForRowAtIndexPath:indexPath];
+        cell.balanceLabel.text = formattedBalances[index];
+    }];
 }
 
 @end
@@ -50,6 +50,10 @@ extension Wallet: LegacyBitcoinCashWalletProtocol {
         guard isInitialized() else {
             return .failure(.uninitialized)
         }
+        // Bitcoin Cash accounts only receive to P2PKH, which is derived natively a window at a time.
+        if let address = derivedBitcoinCashReceiveAddress(forXPub: xpub) {
+            return .success(address)
+        }
         let function: String = "MyWalletPhone.bch.getReceivingAddressForAccountXPub(\"\(xpub)\")"
         guard let jsResult = context.evaluateScriptCheckIsOnMainQueue(function) else {
             return .failure(.jsReturnedNil)
@@ -161,6 +161,17 @@ extension Reactive where Base: WalletManager {
             .share()
     }
 
+    /// Reactive wrapper for delegate method `wallet(_:didFailToGetAccountInfoAndExchangeRates:)`
+    /// - Note: Method invoked with the account info and exchange rate parts that could not be fetched
+    var didFailToGetAccountInfoAndExchangeRates: Observable<WalletRefreshParts> {
+        base.rx.methodInvoked(#selector(WalletManager.wallet(_:didFailToGetAccountInfoAndExchangeRates:)))
+            .map { arg in
+                let rawValue = try castOrThrow(UInt.self, arg[1])
+                return WalletRefreshParts(rawValue: rawValue)
+            }
+            .share()
+    }
+
     // MARK: WalletBackupDelegate
 
     /// Reactive wrapper for delegate method `didBackupWallet`
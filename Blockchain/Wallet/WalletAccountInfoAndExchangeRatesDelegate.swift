@@ -7,4 +7,7 @@ import Foundation
 
     /// Method invoked after getting account info and exchange rates on startup
     func didGetAccountInfoAndExchangeRates()
+
+    /// Method invoked with the account info and exchange rate parts that could not be fetched
+    func didFailToGetAccountInfoAndExchangeRates(_ failedParts: WalletRefreshParts)
 }
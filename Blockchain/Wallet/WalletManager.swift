@@ -322,6 +322,12 @@ extension WalletManager: WalletDelegate {
         }
     }
 
+    func wallet(_ wallet: Wallet!, didFailToGetAccountInfoAndExchangeRates failedParts: WalletRefreshParts) {
+        DispatchQueue.main.async { [unowned self] in
+            self.accountInfoAndExchangeRatesDelegate?.didFailToGetAccountInfoAndExchangeRates(failedParts)
+        }
+    }
+
     // MARK: - Recovery
 
     func didRecoverWallet() {
@@ -0,0 +1,74 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import XCTest
+
+@testable import Blockchain
+
+class AddressCodecTests: XCTestCase {
+
+    private let pairs: [(legacy: String, cashAddr: String)] = [
+        ("1BpEi6DfDAUFd7GtittLSdBeYJvcoaVggu", "bitcoincash:qpm2qsznhks23z7629mms6s4cwef74vcwvy22gdx6a"),
+        ("1KXrWXciRDZUpQwQmuM1DbwsKDLYAYsVLR", "bitcoincash:qr95sy3j9xwd2ap32xkykttr4cvcu7as4y0qverfuy"),
+        ("3CWFddi6m4ndiGyKqzYvsFYagqDLPVMTzC", "bitcoincash:ppm2qsznhks23z7629mms6s4cwef74vcwvn0h829pq")
+    ]
+
+    func testCashAddrToLegacy() {
+        for pair in pairs {
+            XCTAssertEqual(convert(pair.cashAddr, cashaddr_to_legacy), pair.legacy)
+            XCTAssertEqual(convert(String(pair.cashAddr.dropFirst("bitcoincash:".count)), cashaddr_to_legacy), pair.legacy)
+            XCTAssertEqual(convert(pair.legacy, legacy_to_cashaddr), pair.cashAddr)
+        }
+    }
+
+    func testRejectsBadChecksum() {
+        XCTAssertNil(convert("bitcoincash:qpm2qsznhks23z7629mms6s4cwef74vcwvy22gdx6b", cashaddr_to_legacy))
+        XCTAssertNil(convert("1BpEi6DfDAUFd7GtittLSdBeYJvcoaVggv", legacy_to_cashaddr))
+    }
+
+    func testSegwitRoundTrip() {
+        let program: [UInt8] = [
+            0x75, 0x1e, 0x76, 0xe8, 0x19, 0x91, 0x96, 0xd4, 0x54, 0x94,
+            0x1c, 0x45, 0xd1, 0xb3, 0xa3, 0x23, 0xf1, 0x43, 0x3b, 0xd6
+        ]
+        var address = [CChar](repeating: 0, count: Int(ADDRCODEC_MAX_STRING))
+        XCTAssertGreaterThan(segwit_addr_encode("bc", 0, program, program.count, &address, address.count), 0)
+        XCTAssertEqual(String(cString: address), "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4")
+
+        var version: Int32 = -1
+        var decoded = [UInt8](repeating: 0, count: 40)
+        XCTAssertEqual(segwit_addr_decode("bc", "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4", &version, &decoded, decoded.count), 20)
+        XCTAssertEqual(version, 0)
+        XCTAssertEqual(Array(decoded.prefix(20)), program)
+    }
+
+    func testBatchConversion() {
+        let stride = Int(ADDRCODEC_MAX_STRING)
+        let inputs = pairs.map(\.cashAddr) + ["not an address"]
+        var output = [CChar](repeating: 0, count: inputs.count * stride)
+        let converted = withCStrings(inputs) { pointers in
+            cashaddr_to_legacy_batch("bitcoincash", pointers, inputs.count, &output, stride)
+        }
+        XCTAssertEqual(converted, pairs.count)
+        for (index, pair) in pairs.enumerated() {
+            XCTAssertEqual(String(cString: Array(output[index * stride..<(index + 1) * stride])), pair.legacy)
+        }
+        XCTAssertEqual(output[pairs.count * stride], 0)
+    }
+
+    private func convert(
+        _ address: String,
+        _ function: (UnsafePointer<CChar>, UnsafePointer<CChar>, UnsafeMutablePointer<CChar>, Int) -> Int32
+    ) -> String? {
+        var output = [CChar](repeating: 0, count: Int(ADDRCODEC_MAX_STRING))
+        guard function("bitcoincash", address, &output, output.count) >= 0 else {
+            return nil
+        }
+        return String(cString: output)
+    }
+
+    private func withCStrings<T>(_ strings: [String], _ body: ([UnsafePointer<CChar>?]) -> T) -> T {
+        let copies = strings.map { strdup($0) }
+        defer { copies.forEach { free($0) } }
+        return body(copies.map { UnsafePointer($0) })
+    }
+}
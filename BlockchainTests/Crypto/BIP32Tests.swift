@@ -0,0 +1,85 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import XCTest
+
+@testable import Blockchain
+
+/// Checks against test vector 1 of BIP32.
+class BIP32Tests: XCTestCase {
+
+    private let seed: [UInt8] = Array(0..<16)
+
+    private var master: bip32_node {
+        var node = bip32_node()
+        XCTAssertEqual(bip32_from_seed(seed, seed.count, &node), 0)
+        return node
+    }
+
+    func testMasterNode() {
+        var node = master
+        XCTAssertEqual(
+            serialize(&node, isPrivate: false),
+            "xpub661MyMwAqRbcFtXgS5sYJABqqG9YLmC4Q1Rdap9gSE8NqtwybGhePY2gZ29ESFjqJoCu1Rupje8YtGqsefD265TMg7usUDFdp6W1EGMcet8"
+        )
+        XCTAssertEqual(
+            serialize(&node, isPrivate: true),
+            "xprv9s21ZrQH143K3QTDL4LXw2F7HEK3wJUD2nW2nRk4stbPy6cq3jPPqjiChkVvvNKmPGJxWUtg6LnF5kejMRNNU3TGtRBeJgk33yuGBxrMPHi"
+        )
+    }
+
+    func testDerivePath() {
+        var node = master
+        let path: [UInt32] = [0 | BIP32_HARDENED, 1, 2 | BIP32_HARDENED, 2]
+        var child = bip32_node()
+        XCTAssertEqual(bip32_derive_path(&node, path, path.count, &child), 0)
+        XCTAssertEqual(
+            serialize(&child, isPrivate: false),
+            "xpub6FHa3pjLCk84BayeJxFW2SP4XRrFd1JYnxeLeU8EqN3vDfZmbqBqaGJAyiLjTAwm6ZLRQUMv1ZACTj37sR62cfN7fe5JnJ7dh8zL4fiyLHV"
+        )
+    }
+
+    func testParseRoundTrip() {
+        let xpub = "xpub68Gmy5EdvgibQVfPdqkBBCHxA5htiqg55crXYuXoQRKfDBFA1WEjWgP6LHhwBZeNK1VTsfTFUHCdrfp1bgwQ9xv5ski8PX9rL2dZXvgGDnw"
+        var node = bip32_node()
+        XCTAssertEqual(bip32_parse(xpub, &node), 0)
+        XCTAssertEqual(node.has_seckey, 0)
+        XCTAssertEqual(serialize(&node, isPrivate: false), xpub)
+
+        var child = bip32_node()
+        XCTAssertEqual(bip32_ckd(&node, BIP32_HARDENED, &child), -1)
+        XCTAssertEqual(bip32_parse(String(xpub.dropLast()) + "x", &node), -1)
+    }
+
+    func testPublicBatchMatchesPrivateDerivation() {
+        var node = master
+        var account = bip32_node()
+        XCTAssertEqual(bip32_ckd(&node, 0 | BIP32_HARDENED, &account), 0)
+        var neutered = account
+        bip32_neuter(&neutered)
+
+        let count = 20
+        var pubkeys = [UInt8](repeating: 0, count: count * 33)
+        var hashes = [UInt8](repeating: 0, count: count * 20)
+        var ok = [Int32](repeating: -1, count: count)
+        XCTAssertEqual(bip32_ckd_pub_batch(&neutered, 5, count, &pubkeys, &hashes, &ok), count)
+
+        for index in 0..<count {
+            var child = bip32_node()
+            XCTAssertEqual(bip32_ckd(&account, UInt32(5 + index), &child), 0)
+            XCTAssertEqual(ok[index], 0)
+            let pubkey = withUnsafeBytes(of: &child.pubkey) { Array($0) }
+            XCTAssertEqual(pubkey, Array(pubkeys[index * 33..<(index + 1) * 33]))
+            var hash = [UInt8](repeating: 0, count: 20)
+            hash160_33(pubkey, &hash)
+            XCTAssertEqual(hash, Array(hashes[index * 20..<(index + 1) * 20]))
+        }
+    }
+
+    private func serialize(_ node: inout bip32_node, isPrivate: Bool) -> String? {
+        var out = [CChar](repeating: 0, count: Int(ADDRCODEC_MAX_STRING))
+        guard bip32_serialize(&node, isPrivate ? 1 : 0, &out, out.count) > 0 else {
+            return nil
+        }
+        return String(cString: out)
+    }
+}
@@ -0,0 +1,52 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import XCTest
+
+@testable import Blockchain
+
+class KeyHashTests: XCTestCase {
+
+    /// The compressed public key of the secp256k1 generator point.
+    private let generator: [UInt8] = [
+        0x02, 0x79, 0xbe, 0x66, 0x7e, 0xf9, 0xdc, 0xbb, 0xac, 0x55, 0xa0, 0x62, 0x95, 0xce, 0x87, 0x0b, 0x07,
+        0x02, 0x9b, 0xfc, 0xdb, 0x2d, 0xce, 0x28, 0xd9, 0x59, 0xf2, 0x81, 0x5b, 0x16, 0xf8, 0x17, 0x98
+    ]
+
+    func testSHA256d() {
+        let input = Array("hello".utf8)
+        var out = [UInt8](repeating: 0, count: 32)
+        sha256d(input, input.count, &out)
+        XCTAssertEqual(hex(out), "9595c9df90075148eb06860365df33584b75bff782a510c6cd4883a419833d50")
+    }
+
+    func testHash160OfCompressedKey() {
+        var out = [UInt8](repeating: 0, count: 20)
+        hash160_33(generator, &out)
+        XCTAssertEqual(hex(out), "751e76e8199196d454941c45d1b3a323f1433bd6")
+    }
+
+    func testBatchesMatchSingleCalls() {
+        let count = 200
+        let length = 65
+        let input = (0..<count * length).map { UInt8(truncatingIfNeeded: $0 &* 31 &+ 7) }
+
+        var hashes = [UInt8](repeating: 0, count: count * 20)
+        hash160_batch(input, length, count, &hashes)
+        var digests = [UInt8](repeating: 0, count: count * 32)
+        sha256d_batch(input, length, count, &digests)
+
+        for index in 0..<count {
+            let item = Array(input[index * length..<(index + 1) * length])
+            var hash = [UInt8](repeating: 0, count: 20)
+            hash160_65(item, &hash)
+            XCTAssertEqual(hash, Array(hashes[index * 20..<(index + 1) * 20]))
+            var digest = [UInt8](repeating: 0, count: 32)
+            sha256d(item, length, &digest)
+            XCTAssertEqual(digest, Array(digests[index * 32..<(index + 1) * 32]))
+        }
+    }
+
+    private func hex(_ bytes: [UInt8]) -> String {
+        bytes.map { String(format: "%02x", $0) }.joined()
+    }
+}
@@ -0,0 +1,56 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import XCTest
+
+@testable import Blockchain
+
+class SecureBufferTests: XCTestCase {
+
+    private var inUse: UInt64 {
+        var usage = secbuf_usage()
+        secbuf_usage(&usage)
+        return usage.in_use
+    }
+
+    func testBuffersAreZeroedWhenTakenAgain() {
+        let before = inUse
+        for length in [0, 1, 64, 65, 1000, 4096, Int(SECBUF_MAX_POOLED) + 1, 20000] {
+            var buffer = secbuf()
+            XCTAssertEqual(secbuf_get(&buffer, length), 0)
+            XCTAssertEqual(buffer.len, length)
+            XCTAssertNotNil(buffer.buf)
+            let bytes = UnsafeMutableBufferPointer(start: buffer.buf, count: length)
+            XCTAssertTrue(bytes.allSatisfy { $0 == 0 })
+            bytes.initialize(repeating: 0xA5)
+            secbuf_put(&buffer)
+            XCTAssertNil(buffer.buf)
+
+            XCTAssertEqual(secbuf_get(&buffer, length), 0)
+            XCTAssertTrue(UnsafeMutableBufferPointer(start: buffer.buf, count: length).allSatisfy { $0 == 0 })
+            secbuf_put(&buffer)
+        }
+        XCTAssertEqual(inUse, before)
+    }
+
+    func testPutTwiceIsHarmless() {
+        var buffer = secbuf()
+        XCTAssertEqual(secbuf_get(&buffer, 32), 0)
+        secbuf_put(&buffer)
+        secbuf_put(&buffer)
+        XCTAssertEqual(buffer.len, 0)
+    }
+
+    func testConcurrentUseGivesEveryBufferBack() {
+        let before = inUse
+        DispatchQueue.concurrentPerform(iterations: 8) { thread in
+            for i in 0..<2000 {
+                var buffer = secbuf()
+                let length = (i * 37 + thread) % 5000
+                XCTAssertEqual(secbuf_get(&buffer, length), 0)
+                UnsafeMutableBufferPointer(start: buffer.buf, count: length).initialize(repeating: UInt8(thread))
+                secbuf_put(&buffer)
+            }
+        }
+        XCTAssertEqual(inUse, before)
+    }
+}
@@ -0,0 +1,90 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import XCTest
+
+@testable import Blockchain
+
+class SignedMessageTests: XCTestCase {
+
+    /// The secret key 1, whose public key is the generator.
+    private let secretKey: [UInt8] = Array(repeating: 0, count: 31) + [1]
+
+    func testDeterministicSignature() {
+        // The secp256k1 RFC 6979 vector for sha256("Satoshi Nakamoto").
+        let hash: [UInt8] = [
+            0xa0, 0xdc, 0x65, 0xff, 0xca, 0x79, 0x98, 0x73, 0xcb, 0xea, 0x0a, 0xc2, 0x74, 0x01, 0x5b, 0x95,
+            0x26, 0x50, 0x5d, 0xaa, 0xae, 0xd3, 0x85, 0x15, 0x54, 0x25, 0xf7, 0x33, 0x77, 0x04, 0x88, 0x3e
+        ]
+        var signature = [UInt8](repeating: 0, count: 64)
+        var recid: Int32 = -1
+        XCTAssertEqual(eckey_sign_recoverable(secretKey, hash, &signature, &recid), 0)
+        XCTAssertEqual(
+            hex(signature),
+            "934b1ea10a4b3c1757e2b0c017d0b6143ce3c9a7e6a4a49860d7a6ab210ee3d8"
+                + "2442ce9d2b916064108014783e923ec36b49743e2ffa1c4496f01a512aafd9e5"
+        )
+
+        var recovered = [UInt8](repeating: 0, count: 65)
+        XCTAssertEqual(eckey_recover(signature, recid, hash, &recovered), 0)
+        var compressed = [UInt8](repeating: 0, count: 33)
+        XCTAssertEqual(eckey_pubkey_create(secretKey, &compressed), 0)
+        var expected = [UInt8](repeating: 0, count: 65)
+        XCTAssertEqual(eckey_pubkey_decompress(compressed, &expected), 0)
+        XCTAssertEqual(recovered, expected)
+    }
+
+    func testSignAndVerify() {
+        let message = Array("metadata".utf8)
+        var signature = [UInt8](repeating: 0, count: Int(SIGNMSG_SIGLEN))
+        XCTAssertEqual(signmsg_sign(secretKey, 1, message, message.count, &signature), 0)
+
+        var keyHash = [UInt8](repeating: 0, count: 20)
+        XCTAssertEqual(signmsg_recover_hash160(signature, message, message.count, &keyHash), 0)
+        XCTAssertEqual(hex(keyHash), "751e76e8199196d454941c45d1b3a323f1433bd6")
+        XCTAssertEqual(signmsg_verify(signature, message, message.count, keyHash), 0)
+
+        let other = Array("metadatb".utf8)
+        XCTAssertEqual(signmsg_verify(signature, other, other.count, keyHash), -1)
+    }
+
+    func testBatchVerify() {
+        let messages = (0..<8).map { Array("message \($0)".utf8) }
+        var signatures = [UInt8]()
+        var keyHashes = [UInt8]()
+        for message in messages {
+            var signature = [UInt8](repeating: 0, count: Int(SIGNMSG_SIGLEN))
+            XCTAssertEqual(signmsg_sign(secretKey, 1, message, message.count, &signature), 0)
+            signatures += signature
+            var keyHash = [UInt8](repeating: 0, count: 20)
+            XCTAssertEqual(signmsg_recover_hash160(signature, message, message.count, &keyHash), 0)
+            keyHashes += keyHash
+        }
+        // Corrupt the third signature's s.
+        signatures[2 * Int(SIGNMSG_SIGLEN) + 40] ^= 1
+
+        var ok = [Int32](repeating: 0, count: messages.count)
+        let verified = messages.withPointers { pointers in
+            signmsg_verify_batch(signatures, pointers, messages.map(\.count), keyHashes, messages.count, &ok)
+        }
+        XCTAssertEqual(verified, messages.count - 1)
+        XCTAssertEqual(ok, [0, 0, -1, 0, 0, 0, 0, 0])
+    }
+
+    private func hex(_ bytes: [UInt8]) -> String {
+        bytes.map { String(format: "%02x", $0) }.joined()
+    }
+}
+
+extension Array where Element == [UInt8] {
+
+    /// Calls `body` with a pointer to each element's bytes, valid for the duration of the call.
+    fileprivate func withPointers<Result>(_ body: ([UnsafePointer<UInt8>?]) -> Result) -> Result {
+        let buffers = map { bytes -> UnsafeMutablePointer<UInt8> in
+            let buffer = UnsafeMutablePointer<UInt8>.allocate(capacity: Swift.max(bytes.count, 1))
+            buffer.initialize(from: bytes, count: bytes.count)
+            return buffer
+        }
+        defer { buffers.forEach { $0.deallocate() } }
+        return body(buffers.map { UnsafePointer($0) })
+    }
+}
@@ -15,4 +15,14 @@ class JSSourceTests: XCTestCase {
         let path = MainBundleProvider.mainBundle.path(forResource: "wallet-ios", ofType: "js")
         XCTAssertNotNil(path)
     }
+
+    func testWalletIOSBitcoinCashModuleIsPresent() {
+        let path = MainBundleProvider.mainBundle.path(forResource: "wallet-ios-bch", ofType: "js")
+        XCTAssertNotNil(path)
+    }
+
+    func testWalletIOSStellarModuleIsPresent() {
+        let path = MainBundleProvider.mainBundle.path(forResource: "wallet-ios-xlm", ofType: "js")
+        XCTAssertNotNil(path)
+    }
 }
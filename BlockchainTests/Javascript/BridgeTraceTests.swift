@@ -0,0 +1,70 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import JavaScriptCore
+import XCTest
+
+@testable import Blockchain
+
+class BridgeTraceTests: XCTestCase {
+
+    private var wasEnabled = false
+
+    override func setUp() {
+        super.setUp()
+        wasEnabled = BCBridgeTraceIsEnabled()
+        BCBridgeTraceSetEnabled(true)
+    }
+
+    override func tearDown() {
+        BCBridgeTraceSetEnabled(wasEnabled)
+        super.tearDown()
+    }
+
+    func testScriptSiteNames() {
+        XCTAssertEqual(site(forScript: "MyWalletPhone.getBalanceForAccount(3)"), site(forName: "MyWalletPhone.getBalanceForAccount"))
+        XCTAssertEqual(site(forScript: "MyWalletPhone.getBalanceForAccount(4)"), site(forName: "MyWalletPhone.getBalanceForAccount"))
+        XCTAssertEqual(
+            site(forScript: " JSON.stringify(MyWalletPhone.getLabels(0))"),
+            site(forName: "JSON.stringify(MyWalletPhone.getLabels")
+        )
+        XCTAssertNotEqual(site(forScript: "MyWallet.a()"), site(forScript: "MyWallet.b()"))
+    }
+
+    func testTracedEvaluationIsSummarized() throws {
+        let context = JSContext()!
+        context.evaluateScript("var bridgeTraceTests = { evaluate: function(x) { return x + 1; } };")
+        let script = "bridgeTraceTests.evaluate(41)"
+        XCTAssertEqual(context.tracedEvaluateScriptCheckIsOnMainQueue(script)?.toInt32(), 42)
+        XCTAssertEqual(context.tracedEvaluateScriptCheckIsOnMainQueue(script)?.toInt32(), 42)
+
+        let json = try XCTUnwrap(BridgeTraceReporter.summaryJSON())
+        let object = try JSONSerialization.jsonObject(with: Data(json.utf8)) as? [String: Any]
+        let sites = try XCTUnwrap(object?["sites"] as? [[String: Any]])
+        let entry = try XCTUnwrap(sites.first { $0["name"] as? String == "bridgeTraceTests.evaluate" })
+        XCTAssertEqual(entry["count"] as? Int, 2)
+        XCTAssertEqual(entry["bytes"] as? Int, 2 * script.utf8.count)
+        XCTAssertLessThanOrEqual(try XCTUnwrap(entry["p50_us"] as? Int), try XCTUnwrap(entry["max_us"] as? Int))
+    }
+
+    func testChromeTraceHasCompleteEvents() throws {
+        let site = self.site(forName: "BridgeTraceTests.chrome")
+        let start = BCBridgeTraceNow()
+        BCBridgeTraceRecord(site, start, start + 2_500, 7)
+
+        let json = try XCTUnwrap(BridgeTraceReporter.chromeTrace())
+        let object = try JSONSerialization.jsonObject(with: Data(json.utf8)) as? [String: Any]
+        let events = try XCTUnwrap(object?["traceEvents"] as? [[String: Any]])
+        let event = try XCTUnwrap(events.last { $0["name"] as? String == "BridgeTraceTests.chrome" })
+        XCTAssertEqual(event["ph"] as? String, "X")
+        XCTAssertEqual(event["dur"] as? Double, 2.5)
+        XCTAssertEqual((event["args"] as? [String: Any])?["bytes"] as? Int, 7)
+    }
+
+    private func site(forName name: String) -> BCBridgeTraceSite {
+        BCBridgeTraceSiteForName(name, name.utf8.count)
+    }
+
+    private func site(forScript script: String) -> BCBridgeTraceSite {
+        BCBridgeTraceSiteForScript(script, script.utf8.count)
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@testable import Blockchain
+import XCTest
+
+class WalletJSIntegrityTests: XCTestCase {
+
+    /// SHA-256 of "abc".
+    private let abcDigest = Data([
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+    ])
+
+    private var directory: URL!
+    private var fileURL: URL!
+    private var recordURL: URL!
+
+    override func setUp() {
+        super.setUp()
+        directory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        try! FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        fileURL = directory.appendingPathComponent("my-wallet.js")
+        recordURL = directory.appendingPathComponent("integrity.plist")
+        try! Data("abc".utf8).write(to: fileURL)
+    }
+
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: directory)
+        super.tearDown()
+    }
+
+    func testDigestIsRecordedAcrossInstances() {
+        let integrity = WalletJSIntegrity(recordURL: recordURL, appVersion: "1.0 (1)")
+        XCTAssertEqual(integrity.digestOfFile(at: fileURL), abcDigest)
+        XCTAssertEqual(integrity.digestOfFile(at: fileURL), abcDigest)
+        XCTAssertEqual(integrity.hashCount, 1)
+
+        let relaunched = WalletJSIntegrity(recordURL: recordURL, appVersion: "1.0 (1)")
+        XCTAssertTrue(relaunched.verifyFile(at: fileURL, pinnedDigest: abcDigest))
+        XCTAssertEqual(relaunched.hashCount, 0)
+    }
+
+    func testChangedFileOrAppVersionIsHashedAgain() {
+        let integrity = WalletJSIntegrity(recordURL: recordURL, appVersion: "1.0 (1)")
+        XCTAssertTrue(integrity.verifyFile(at: fileURL, pinnedDigest: abcDigest))
+
+        let updated = WalletJSIntegrity(recordURL: recordURL, appVersion: "1.0 (2)")
+        XCTAssertTrue(updated.verifyFile(at: fileURL, pinnedDigest: abcDigest))
+        XCTAssertEqual(updated.hashCount, 1)
+
+        try! Data("abd".utf8).write(to: fileURL)
+        XCTAssertFalse(updated.verifyFile(at: fileURL, pinnedDigest: abcDigest))
+        XCTAssertEqual(updated.hashCount, 2)
+    }
+
+    func testMissingFileFailsVerification() {
+        let integrity = WalletJSIntegrity(recordURL: recordURL, appVersion: "1.0 (1)")
+        XCTAssertFalse(integrity.verifyFile(at: directory.appendingPathComponent("missing.js"), pinnedDigest: abcDigest))
+    }
+
+    func testPinnedDigestIsReadFromChecksumFile() {
+        let checksumURL = directory.appendingPathComponent("my-wallet.js.sha256")
+        let line = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad  Submodules/My-Wallet-V3/dist/my-wallet.js\n"
+        try! Data(line.utf8).write(to: checksumURL)
+        XCTAssertEqual(WalletJSIntegrity.pinnedDigestFromChecksumFile(at: checksumURL), abcDigest)
+
+        try! Data("not a digest\n".utf8).write(to: checksumURL)
+        XCTAssertNil(WalletJSIntegrity.pinnedDigestFromChecksumFile(at: checksumURL))
+    }
+}
@@ -0,0 +1,115 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+import XCTest
+
+@testable import Blockchain
+
+class WalletJSTimerSchedulerTests: XCTestCase {
+
+    private var scheduler: WalletJSTimerScheduler!
+
+    override func setUp() {
+        super.setUp()
+        scheduler = WalletJSTimerScheduler(runLoop: RunLoop.main)
+    }
+
+    override func tearDown() {
+        scheduler.cancelAll()
+        scheduler = nil
+        super.tearDown()
+    }
+
+    func testScheduleDoesNotFireSynchronously() {
+        let fired = expectation(description: "Timer fires.")
+        var didFire = false
+        scheduler.schedule(after: 0, repeats: false) {
+            didFire = true
+            fired.fulfill()
+        }
+        XCTAssertFalse(didFire)
+        XCTAssertEqual(scheduler.count, 1)
+        waitForExpectations(timeout: 1)
+        XCTAssertEqual(scheduler.count, 0)
+    }
+
+    func testTimersFireInDeadlineThenSchedulingOrder() {
+        let fired = expectation(description: "Timers fire.")
+        fired.expectedFulfillmentCount = 4
+        var order: [Int] = []
+        scheduler.schedule(after: 0.05, repeats: false) { order.append(3); fired.fulfill() }
+        scheduler.schedule(after: 0, repeats: false) { order.append(0); fired.fulfill() }
+        scheduler.schedule(after: 0.01, repeats: false) { order.append(1); fired.fulfill() }
+        scheduler.schedule(after: 0.01, repeats: false) { order.append(2); fired.fulfill() }
+        waitForExpectations(timeout: 1)
+        XCTAssertEqual(order, [0, 1, 2, 3])
+    }
+
+    func testCancelPreventsFiring() {
+        let fired = expectation(description: "Remaining timer fires.")
+        let handle = scheduler.schedule(after: 0, repeats: false) {
+            XCTFail("Cancelled timer fired.")
+        }
+        scheduler.schedule(after: 0.02, repeats: false) {
+            fired.fulfill()
+        }
+        XCTAssertNotEqual(handle, 0)
+        scheduler.cancel(handle)
+        XCTAssertEqual(scheduler.count, 1)
+        waitForExpectations(timeout: 1)
+    }
+
+    func testStaleHandleDoesNotCancelNewTimer() {
+        let first = expectation(description: "First timer fires.")
+        let handle = scheduler.schedule(after: 0, repeats: false) {
+            first.fulfill()
+        }
+        wait(for: [first], timeout: 1)
+
+        let second = expectation(description: "Second timer fires.")
+        scheduler.schedule(after: 0, repeats: false) {
+            second.fulfill()
+        }
+        scheduler.cancel(handle)
+        wait(for: [second], timeout: 1)
+    }
+
+    func testIntervalRepeatsUntilClearedFromCallback() {
+        let fired = expectation(description: "Interval fires three times.")
+        fired.expectedFulfillmentCount = 3
+        var fireCount = 0
+        var handle: WalletJSTimerHandle = 0
+        handle = scheduler.schedule(after: 0.005, repeats: true) { [unowned self] in
+            fireCount += 1
+            fired.fulfill()
+            if fireCount == 3 {
+                self.scheduler.cancel(handle)
+            }
+        }
+        waitForExpectations(timeout: 1)
+        XCTAssertEqual(scheduler.count, 0)
+
+        let settled = expectation(description: "No further firing.")
+        DispatchQueue.main.asyncAfter(deadline: .now() + 0.05) {
+            settled.fulfill()
+        }
+        waitForExpectations(timeout: 1)
+        XCTAssertEqual(fireCount, 3)
+    }
+
+    func testCancelAll() {
+        for _ in 0..<10 {
+            scheduler.schedule(after: 0, repeats: false) {
+                XCTFail("Cancelled timer fired.")
+            }
+        }
+        XCTAssertEqual(scheduler.count, 10)
+        scheduler.cancelAll()
+        XCTAssertEqual(scheduler.count, 0)
+
+        let settled = expectation(description: "No timer fires.")
+        DispatchQueue.main.asyncAfter(deadline: .now() + 0.02) {
+            settled.fulfill()
+        }
+        waitForExpectations(timeout: 1)
+    }
+}
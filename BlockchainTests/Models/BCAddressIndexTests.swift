@@ -0,0 +1,77 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@testable import Blockchain
+import XCTest
+
+class BCAddressIndexTests: XCTestCase {
+
+    private var index: OpaquePointer!
+
+    private let address = "1BpEi6DfDAUFd7GtittLSdBeYJvcoaVggu"
+    private let scriptAddress = "3CWFddi6m4ndiGyKqzYvsFYagqDLPVMTzC"
+
+    override func setUp() {
+        super.setUp()
+        index = BCAddressIndexCreate(0)
+    }
+
+    override func tearDown() {
+        BCAddressIndexDestroy(index)
+        index = nil
+        super.tearDown()
+    }
+
+    private func lookup(_ address: String) -> (entry: BCAddressIndexEntry, label: String)? {
+        var entry = BCAddressIndexEntry()
+        var label = [CChar](repeating: 0, count: 64)
+        guard BCAddressIndexLookup(index, address, &entry, &label, label.count) else {
+            return nil
+        }
+        return (entry, String(cString: label))
+    }
+
+    func testPutAndLookup() {
+        XCTAssertTrue(BCAddressIndexPut(index, address, BCAddressIndexFlagWatchOnly.rawValue, 1234, "Savings"))
+        XCTAssertTrue(BCAddressIndexPut(index, scriptAddress, 0, 0, nil))
+        XCTAssertEqual(BCAddressIndexCount(index), 2)
+
+        let found = lookup(address)
+        XCTAssertEqual(found?.entry.flags, BCAddressIndexFlagWatchOnly.rawValue)
+        XCTAssertEqual(found?.entry.balance, 1234)
+        XCTAssertEqual(found?.label, "Savings")
+        XCTAssertEqual(lookup(scriptAddress)?.entry.labelLength, 0)
+        XCTAssertNil(lookup("1KXrWXciRDZUpQwQmuM1DbwsKDLYAYsVLR"))
+        XCTAssertNil(lookup("not an address"))
+    }
+
+    func testUpdates() {
+        XCTAssertTrue(BCAddressIndexPut(index, address, 0, 0, nil))
+        XCTAssertTrue(BCAddressIndexSetLabel(index, address, "Renamed"))
+        XCTAssertTrue(BCAddressIndexUpdateFlags(index, address, BCAddressIndexFlagArchived.rawValue, 0))
+        XCTAssertTrue(BCAddressIndexSetBalance(index, address, 42))
+
+        let found = lookup(address)
+        XCTAssertEqual(found?.label, "Renamed")
+        XCTAssertEqual(found?.entry.flags, BCAddressIndexFlagArchived.rawValue)
+        XCTAssertEqual(found?.entry.balance, 42)
+
+        XCTAssertTrue(BCAddressIndexUpdateFlags(index, address, 0, BCAddressIndexFlagArchived.rawValue))
+        XCTAssertEqual(lookup(address)?.entry.flags, 0)
+        XCTAssertFalse(BCAddressIndexSetLabel(index, scriptAddress, "Missing"))
+    }
+
+    func testLongLabelIsTruncatedButLengthIsKept() {
+        let label = String(repeating: "a", count: 100)
+        XCTAssertTrue(BCAddressIndexPut(index, address, 0, 0, label))
+        let found = lookup(address)
+        XCTAssertEqual(found?.entry.labelLength, 100)
+        XCTAssertEqual(found?.label, String(repeating: "a", count: 63))
+    }
+
+    func testRemoveAll() {
+        XCTAssertTrue(BCAddressIndexPut(index, address, 0, 0, nil))
+        BCAddressIndexRemoveAll(index)
+        XCTAssertEqual(BCAddressIndexCount(index), 0)
+        XCTAssertNil(lookup(address))
+    }
+}
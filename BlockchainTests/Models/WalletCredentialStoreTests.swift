@@ -0,0 +1,140 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@testable import Blockchain
+import XCTest
+
+private final class InMemoryCredentialBacking: NSObject, WalletCredentialBacking {
+
+    var items: [String: Data] = [:]
+    var failsLoads = false
+    var failsStores = false
+    private(set) var loads = 0
+    private(set) var stores: [(identifier: String, data: Data?)] = []
+
+    func loadData(forIdentifiers identifiers: Set<String>) -> [String: Data]? {
+        loads += 1
+        return failsLoads ? nil : items.filter { identifiers.contains($0.key) }
+    }
+
+    func store(_ data: Data?, forIdentifier identifier: String) -> Bool {
+        stores.append((identifier, data))
+        guard !failsStores else {
+            return false
+        }
+        items[identifier] = data
+        return true
+    }
+}
+
+class WalletCredentialStoreTests: XCTestCase {
+
+    private let identifiers: Set<String> = ["guid", "sharedKey", "pin"]
+
+    private var backing: InMemoryCredentialBacking!
+    private var store: WalletCredentialStore!
+
+    override func setUp() {
+        super.setUp()
+        backing = InMemoryCredentialBacking()
+        backing.items = ["guid": Data("a-guid".utf8), "pin": Data("1234".utf8), "other": Data("x".utf8)]
+        store = WalletCredentialStore(backing: backing, identifiers: identifiers, flushDelay: 60)
+    }
+
+    func testReadsAreServedFromOneLoad() {
+        XCTAssertEqual(store.data(forIdentifier: "guid"), Data("a-guid".utf8))
+        XCTAssertEqual(store.data(forIdentifier: "pin"), Data("1234".utf8))
+        XCTAssertNil(store.data(forIdentifier: "sharedKey"))
+        XCTAssertEqual(backing.loads, 1)
+        XCTAssertEqual(store.loadCount, 1)
+    }
+
+    func testWritesAreReadBackBeforeTheyAreFlushed() {
+        store.setData(Data("5678".utf8), forIdentifier: "pin")
+
+        XCTAssertEqual(store.data(forIdentifier: "pin"), Data("5678".utf8))
+        XCTAssertTrue(backing.stores.isEmpty)
+        XCTAssertEqual(backing.items["pin"], Data("1234".utf8))
+    }
+
+    func testWritesAreCoalescedIntoOneFlush() {
+        store.setData(Data("1".utf8), forIdentifier: "pin")
+        store.setData(Data("2".utf8), forIdentifier: "pin")
+        store.setData(Data("key".utf8), forIdentifier: "sharedKey")
+
+        XCTAssertTrue(store.flush())
+        XCTAssertEqual(backing.stores.count, 2)
+        XCTAssertEqual(backing.items["pin"], Data("2".utf8))
+        XCTAssertEqual(backing.items["sharedKey"], Data("key".utf8))
+
+        XCTAssertTrue(store.flush())
+        XCTAssertEqual(backing.stores.count, 2)
+    }
+
+    func testRemovalsAreSavedBeforeTheyReturn() {
+        store.setData(Data("key".utf8), forIdentifier: "sharedKey")
+        XCTAssertTrue(store.removeData(forIdentifier: "guid"))
+
+        XCTAssertNil(backing.items["guid"])
+        XCTAssertEqual(backing.items["sharedKey"], Data("key".utf8))
+        XCTAssertNil(store.data(forIdentifier: "guid"))
+
+        backing.failsStores = true
+        XCTAssertFalse(store.removeData(forIdentifier: "pin"))
+        XCTAssertNil(store.data(forIdentifier: "pin"))
+        backing.failsStores = false
+        XCTAssertTrue(store.flush())
+        XCTAssertNil(backing.items["pin"])
+    }
+
+    func testSettingTheSameValueWritesNothing() {
+        _ = store.data(forIdentifier: "pin")
+        store.setData(Data("1234".utf8), forIdentifier: "pin")
+
+        XCTAssertTrue(store.flush())
+        XCTAssertTrue(backing.stores.isEmpty)
+    }
+
+    func testPendingWritesAreFlushedAfterTheDelay() {
+        store = WalletCredentialStore(backing: backing, identifiers: identifiers, flushDelay: 0.05)
+        store.setData(Data("key".utf8), forIdentifier: "sharedKey")
+
+        let flushed = expectation(description: "flushed")
+        DispatchQueue.main.asyncAfter(deadline: .now() + 0.5) {
+            flushed.fulfill()
+        }
+        wait(for: [flushed], timeout: 2)
+        // Waits for the queue, so the delayed flush has run.
+        XCTAssertEqual(store.data(forIdentifier: "sharedKey"), Data("key".utf8))
+        XCTAssertEqual(backing.items["sharedKey"], Data("key".utf8))
+        XCTAssertEqual(store.storeCount, 1)
+    }
+
+    func testFailedWritesStayPending() {
+        backing.failsStores = true
+        store.setData(Data("key".utf8), forIdentifier: "sharedKey")
+        XCTAssertFalse(store.flush())
+
+        backing.failsStores = false
+        XCTAssertTrue(store.flush())
+        XCTAssertEqual(backing.items["sharedKey"], Data("key".utf8))
+        XCTAssertEqual(backing.stores.count, 2)
+    }
+
+    func testFailedLoadIsRetried() {
+        backing.failsLoads = true
+        XCTAssertNil(store.data(forIdentifier: "guid"))
+
+        backing.failsLoads = false
+        XCTAssertEqual(store.data(forIdentifier: "guid"), Data("a-guid".utf8))
+        XCTAssertEqual(backing.loads, 2)
+    }
+
+    func testReloadKeepsPendingWrites() {
+        store.setData(Data("5678".utf8), forIdentifier: "pin")
+        backing.items["guid"] = Data("another-guid".utf8)
+        store.reload()
+
+        XCTAssertEqual(store.data(forIdentifier: "guid"), Data("another-guid".utf8))
+        XCTAssertEqual(store.data(forIdentifier: "pin"), Data("5678".utf8))
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@testable import Blockchain
+import CommonCrypto
+import XCTest
+
+class WalletPayloadKeyCacheTests: XCTestCase {
+
+    private let password = "correct horse battery staple"
+    private let iterations: UInt32 = 5000
+
+    private var cache: WalletPayloadKeyCache!
+
+    override func setUp() {
+        super.setUp()
+        cache = WalletPayloadKeyCache()
+    }
+
+    private func expectedKey(password: String, salt: Data, iterations: UInt32) -> Data {
+        let passwordBytes = Array(password.utf8)
+        var key = [UInt8](repeating: 0, count: Int(WalletPayloadKeyLength))
+        let result = salt.withUnsafeBytes { saltBytes in
+            CCKeyDerivationPBKDF(
+                CCPBKDFAlgorithm(kCCPBKDF2),
+                passwordBytes.map { CChar(bitPattern: $0) }, passwordBytes.count,
+                saltBytes.bindMemory(to: UInt8.self).baseAddress, salt.count,
+                CCPseudoRandomAlgorithm(kCCPRFHmacAlgSHA1), iterations,
+                &key, key.count
+            )
+        }
+        XCTAssertEqual(result, Int32(kCCSuccess))
+        return Data(key)
+    }
+
+    private func take(password: String, iterations: UInt32) -> (salt: Data, key: Data) {
+        let saltAndKey = cache.takeKey(forPassword: password, iterations: iterations)!
+        XCTAssertEqual(saltAndKey.count, Int(WalletPayloadSaltLength + WalletPayloadKeyLength))
+        return (saltAndKey.prefix(Int(WalletPayloadSaltLength)), saltAndKey.suffix(Int(WalletPayloadKeyLength)))
+    }
+
+    func testKeysAreStretchedAheadWithFreshSalts() {
+        var salts = Set<Data>()
+        for _ in 0..<3 {
+            let (salt, key) = take(password: password, iterations: iterations)
+            XCTAssertEqual(key, expectedKey(password: password, salt: salt, iterations: iterations))
+            salts.insert(salt)
+        }
+        XCTAssertEqual(salts.count, 3)
+        XCTAssertEqual(cache.missCount, 1)
+        XCTAssertEqual(cache.hitCount, 2)
+    }
+
+    func testChangingPasswordOrIterationsDropsTheStock() {
+        _ = take(password: password, iterations: iterations)
+
+        let (salt, key) = take(password: "a new password", iterations: iterations)
+        XCTAssertEqual(key, expectedKey(password: "a new password", salt: salt, iterations: iterations))
+
+        let (otherSalt, otherKey) = take(password: "a new password", iterations: iterations * 2)
+        XCTAssertEqual(otherKey, expectedKey(password: "a new password", salt: otherSalt, iterations: iterations * 2))
+        XCTAssertEqual(cache.hitCount, 0)
+    }
+
+    func testInvalidateForgetsThePassword() {
+        _ = take(password: password, iterations: iterations)
+        cache.invalidate()
+        _ = take(password: password, iterations: iterations)
+        XCTAssertEqual(cache.missCount, 2)
+    }
+}
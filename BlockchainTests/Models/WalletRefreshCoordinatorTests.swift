@@ -0,0 +1,125 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@testable import Blockchain
+import XCTest
+
+class WalletRefreshCoordinatorTests: XCTestCase {
+
+    private var starts: [(id: UInt64, parts: WalletRefreshParts)] = []
+    private var coordinator: WalletRefreshCoordinator!
+
+    override func setUp() {
+        super.setUp()
+        starts = []
+        coordinator = WalletRefreshCoordinator { [unowned self] id, parts in
+            self.starts.append((id, parts))
+        }
+    }
+
+    func testRequestsForPartsInFlightJoinIt() {
+        var answers: [WalletRefreshParts] = []
+        coordinator.requestParts(.all) { answers.append($0) }
+        coordinator.requestParts([.accountInfo, .bitcoinRates]) { answers.append($0) }
+
+        XCTAssertEqual(starts.count, 1)
+        XCTAssertEqual(starts[0].parts, .all)
+
+        coordinator.finishRefresh(starts[0].id, failedParts: .bitcoinRates) {}
+
+        XCTAssertEqual(answers, [.bitcoinRates, .bitcoinRates])
+        XCTAssertEqual(coordinator.partsInFlight, [])
+    }
+
+    func testOtherRequestsAreMergedIntoOneFollowUp() {
+        var answers: [WalletRefreshParts] = []
+        coordinator.requestParts(.walletHistory) { answers.append($0) }
+        coordinator.requestParts(.accountInfo) { answers.append($0) }
+        coordinator.requestParts(.bitcoinCashRates) { answers.append($0) }
+
+        XCTAssertEqual(starts.count, 1)
+        coordinator.finishRefresh(starts[0].id, failedParts: []) {}
+
+        XCTAssertEqual(starts.count, 2)
+        XCTAssertEqual(starts[1].parts, [.accountInfo, .bitcoinCashRates])
+        XCTAssertEqual(answers, [[]])
+
+        coordinator.finishRefresh(starts[1].id, failedParts: .accountInfo) {}
+
+        XCTAssertEqual(answers, [[], .accountInfo, []])
+    }
+
+    func testRequestsMadeWhileApplyingAreAnsweredByTheRefresh() {
+        var answers: [WalletRefreshParts] = []
+        coordinator.requestParts(.all, completion: nil)
+        coordinator.finishRefresh(starts[0].id, failedParts: []) {
+            XCTAssertTrue(coordinator.isApplying)
+            coordinator.requestParts(.accountInfo) { answers.append($0) }
+        }
+
+        XCTAssertEqual(starts.count, 1)
+        XCTAssertEqual(answers, [[]])
+        XCTAssertFalse(coordinator.isApplying)
+    }
+
+    func testFinishingAnotherRefreshIsIgnored() {
+        var answered = false
+        coordinator.requestParts(.all) { _ in answered = true }
+        var applied = false
+        coordinator.finishRefresh(starts[0].id + 1, failedParts: []) { applied = true }
+
+        XCTAssertFalse(applied)
+        XCTAssertFalse(answered)
+        XCTAssertEqual(coordinator.partsInFlight, .all)
+    }
+
+    func testRefreshThatTimesOutFailsItsParts() {
+        coordinator.timeout = 0.01
+        var timeouts: [(id: UInt64, parts: WalletRefreshParts)] = []
+        coordinator.timedOut = { [unowned self] id, parts in
+            timeouts.append((id, parts))
+            self.coordinator.finishRefresh(id, failedParts: .walletHistory) {}
+        }
+        let answered = expectation(description: "answered")
+        coordinator.requestParts([.walletHistory, .accountInfo]) { failedParts in
+            XCTAssertEqual(failedParts, .walletHistory)
+            answered.fulfill()
+        }
+        waitForExpectations(timeout: 1)
+
+        XCTAssertEqual(timeouts.count, 1)
+        XCTAssertEqual(timeouts[0].id, starts[0].id)
+        XCTAssertEqual(timeouts[0].parts, [.walletHistory, .accountInfo])
+        XCTAssertEqual(coordinator.partsInFlight, [])
+    }
+
+    func testRefreshThatTimesOutUnhandledFailsEveryPart() {
+        coordinator.timeout = 0.01
+        let answered = expectation(description: "answered")
+        coordinator.requestParts(.all) { failedParts in
+            XCTAssertEqual(failedParts, .all)
+            answered.fulfill()
+        }
+        waitForExpectations(timeout: 1)
+
+        var applied = false
+        coordinator.finishRefresh(starts[0].id, failedParts: []) { applied = true }
+        XCTAssertFalse(applied)
+    }
+
+    func testCancelFailsEveryPendingRequest() {
+        var answers: [WalletRefreshParts] = []
+        coordinator.requestParts(.walletHistory) { answers.append($0) }
+        coordinator.requestParts(.bitcoinRates) { answers.append($0) }
+        coordinator.cancel()
+
+        XCTAssertEqual(answers, [.walletHistory, .bitcoinRates])
+
+        var applied = false
+        coordinator.finishRefresh(starts[0].id, failedParts: []) { applied = true }
+        XCTAssertFalse(applied)
+
+        coordinator.requestParts(.accountInfo, completion: nil)
+        XCTAssertEqual(starts.count, 2)
+        XCTAssertNotEqual(starts[1].id, starts[0].id)
+    }
+}
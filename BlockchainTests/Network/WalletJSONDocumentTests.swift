@@ -0,0 +1,93 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@testable import Blockchain
+import XCTest
+
+class WalletJSONDocumentTests: XCTestCase {
+
+    private let multiaddr = """
+    {
+        "wallet": { "final_balance": 123456789, "n_tx": 2 },
+        "addresses": [
+            { "address": "1BoatSLRHtKNngkdXEeobR76b53LETtpyT", "final_balance": 100000000, "label": "Savings \\"main\\"" },
+            { "address": "1dice8EMZmqKvrGE4Qc9bUFf9PX3xaYDp", "final_balance": 23456789, "label": "caf\\u00e9 \\ud83d\\ude00" }
+        ],
+        "txs": [
+            { "hash": "a1b2", "result": -5000, "double_spend": false, "block_height": null },
+            { "hash": "c3d4", "result": 250000, "double_spend": true, "fee": 0.5 }
+        ]
+    }
+    """
+
+    func testOnDemandAccess() throws {
+        let document = try XCTUnwrap(WalletJSONDocument(string: multiaddr))
+        let wallet = document.memberNamed("wallet", ofObject: document.root)
+
+        var balance: UInt64 = 0
+        XCTAssertTrue(BCJSONValueGetUInt64(document.memberNamed("final_balance", ofObject: wallet), &balance))
+        XCTAssertEqual(balance, 123_456_789)
+
+        let missing = document.memberNamed("missing", ofObject: document.root)
+        XCTAssertEqual(BCJSONValueGetType(missing), BCJSONTypeInvalid)
+
+        var hashes: [String] = []
+        let txs = document.memberNamed("txs", ofObject: document.root)
+        XCTAssertEqual(BCJSONValueGetCount(txs), 2)
+        XCTAssertTrue(document.enumerateValue(txs) { key, tx, _ in
+            XCTAssertNil(key)
+            hashes.append(document.string(for: document.memberNamed("hash", ofObject: tx)) ?? "")
+        })
+        XCTAssertEqual(hashes, ["a1b2", "c3d4"])
+    }
+
+    func testStringsAreUnescaped() throws {
+        let document = try XCTUnwrap(WalletJSONDocument(string: multiaddr))
+        let addresses = document.memberNamed("addresses", ofObject: document.root)
+        var labels: [String] = []
+        document.enumerateValue(addresses) { _, address, _ in
+            labels.append(document.string(for: document.memberNamed("label", ofObject: address)) ?? "")
+        }
+        XCTAssertEqual(labels, ["Savings \"main\"", "café 😀"])
+    }
+
+    func testObjectValueMatchesJSONSerialization() throws {
+        let document = try XCTUnwrap(WalletJSONDocument(string: multiaddr))
+        let object = try XCTUnwrap(document.objectValue as? NSDictionary)
+        let expected = try XCTUnwrap(
+            JSONSerialization.jsonObject(with: Data(multiaddr.utf8)) as? NSDictionary
+        )
+        XCTAssertEqual(object, expected)
+    }
+
+    func testMalformedInput() {
+        for json in ["", "   ", "{", "{}}", "[1, 2", "\"open", "{} {}", "1 2", "[}"] {
+            XCTAssertNil(WalletJSONDocument(string: json), json)
+        }
+        for json in ["[1,]", "{\"a\": 1,}", "{\"a\" 1}", "[01]", "[tru]"] {
+            XCTAssertNil(WalletJSONDocument(string: json)?.objectValue, json)
+        }
+    }
+
+    func testNumbers() throws {
+        let document = try XCTUnwrap(WalletJSONDocument(string: "[18446744073709551615, -9223372036854775808, 1.5e-4, 18446744073709551616]"))
+        var values: [BCJSONValue] = []
+        document.enumerateValue(document.root) { _, value, _ in values.append(value) }
+
+        var unsignedValue: UInt64 = 0
+        XCTAssertTrue(BCJSONValueGetUInt64(values[0], &unsignedValue))
+        XCTAssertEqual(unsignedValue, .max)
+
+        var signedValue: Int64 = 0
+        XCTAssertFalse(BCJSONValueGetInt64(values[0], &signedValue))
+        XCTAssertTrue(BCJSONValueGetInt64(values[1], &signedValue))
+        XCTAssertEqual(signedValue, .min)
+
+        var doubleValue: Double = 0
+        XCTAssertFalse(BCJSONValueGetUInt64(values[2], &unsignedValue))
+        XCTAssertTrue(BCJSONValueGetDouble(values[2], &doubleValue))
+        XCTAssertEqual(doubleValue, 1.5e-4)
+
+        XCTAssertFalse(BCJSONValueGetUInt64(values[3], &unsignedValue))
+        XCTAssertTrue(BCJSONValueGetDouble(values[3], &doubleValue))
+    }
+}
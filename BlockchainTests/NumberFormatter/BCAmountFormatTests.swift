@@ -0,0 +1,117 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+@testable import Blockchain
+import XCTest
+
+class BCAmountFormatTests: XCTestCase {
+
+    private func makeStyle(
+        decimalSeparator: String = ".",
+        groupingSeparator: String = ",",
+        primaryGroupingSize: UInt8 = 3,
+        secondaryGroupingSize: UInt8 = 0,
+        fractionDigits: ClosedRange<UInt8>,
+        prefix: String = "",
+        suffix: String = ""
+    ) -> BCAmountFormatStyle {
+        var style = BCAmountFormatStyle()
+        style.primaryGroupingSize = primaryGroupingSize
+        style.secondaryGroupingSize = secondaryGroupingSize
+        style.minimumFractionDigits = fractionDigits.lowerBound
+        style.maximumFractionDigits = fractionDigits.upperBound
+        set(&style.decimalSeparator, decimalSeparator)
+        set(&style.groupingSeparator, groupingSeparator)
+        set(&style.prefix, prefix)
+        set(&style.suffix, suffix)
+        return style
+    }
+
+    private func set<Field>(_ field: inout Field, _ value: String) {
+        withUnsafeMutableBytes(of: &field) { bytes in
+            let pointer = bytes.baseAddress!.assumingMemoryBound(to: CChar.self)
+            XCTAssertTrue(BCAmountFormatStyleSetString(pointer, bytes.count, value))
+        }
+    }
+
+    private func crypto(_ satoshi: UInt64, _ style: BCAmountFormatStyle) -> String {
+        var style = style
+        var buffer = [CChar](repeating: 0, count: Int(BC_AMOUNT_FORMAT_MAX_LENGTH))
+        XCTAssertGreaterThan(BCAmountFormatCrypto(satoshi, &style, &buffer, buffer.count), 0)
+        return String(cString: buffer)
+    }
+
+    private func fiat(_ satoshi: UInt64, rate: String, _ style: BCAmountFormatStyle) -> String {
+        var style = style
+        var amountRate = BCAmountRate()
+        XCTAssertTrue(BCAmountRateFromDecimalString(rate, &amountRate))
+        var buffer = [CChar](repeating: 0, count: Int(BC_AMOUNT_FORMAT_MAX_LENGTH))
+        XCTAssertGreaterThan(BCAmountFormatFiat(satoshi, amountRate, &style, &buffer, buffer.count), 0)
+        return String(cString: buffer)
+    }
+
+    func testCryptoAmounts() {
+        let style = makeStyle(fractionDigits: 0...8, suffix: " BTC")
+        XCTAssertEqual(crypto(0, style), "0 BTC")
+        XCTAssertEqual(crypto(1, style), "0.00000001 BTC")
+        XCTAssertEqual(crypto(100_000_000, style), "1 BTC")
+        XCTAssertEqual(crypto(12_345_000_000, style), "123.45 BTC")
+        XCTAssertEqual(crypto(123_456_789_012_345_678, style), "1,234,567,890.12345678 BTC")
+        XCTAssertEqual(crypto(UInt64.max, style), "184,467,440,737.09551615 BTC")
+    }
+
+    func testFiatAmountsAreRoundedDown() {
+        let style = makeStyle(fractionDigits: 2...2, prefix: "$")
+        XCTAssertEqual(fiat(0, rate: "43567.12", style), "$0.00")
+        XCTAssertEqual(fiat(100_000_000, rate: "43567.12", style), "$43,567.12")
+        XCTAssertEqual(fiat(99_999, rate: "43567.12", style), "$43.56")
+        XCTAssertEqual(fiat(123_456_789_012_345_678, rate: "43567.12", style), "$53,786,567,417,155.45")
+        XCTAssertEqual(fiat(1, rate: "0.00001", style), "$0.00")
+    }
+
+    func testLocaleRules() {
+        let indian = makeStyle(primaryGroupingSize: 3, secondaryGroupingSize: 2, fractionDigits: 2...2)
+        XCTAssertEqual(fiat(123_456_789_000_000, rate: "1", indian), "12,34,567.89")
+
+        let french = makeStyle(decimalSeparator: ",", groupingSeparator: "\u{202F}", fractionDigits: 0...8)
+        XCTAssertEqual(crypto(123_456_712_345_678, french), "1\u{202F}234\u{202F}567,12345678")
+
+        let ungrouped = makeStyle(primaryGroupingSize: 0, fractionDigits: 0...8)
+        XCTAssertEqual(crypto(123_456_712_345_678, ungrouped), "1234567.12345678")
+    }
+
+    func testRateParsing() {
+        var rate = BCAmountRate()
+        XCTAssertTrue(BCAmountRateFromDecimalString("43567.120", &rate))
+        XCTAssertEqual(rate.mantissa, 4_356_712)
+        XCTAssertEqual(rate.scale, 2)
+        XCTAssertFalse(BCAmountRateFromDecimalString("", &rate))
+        XCTAssertFalse(BCAmountRateFromDecimalString("1e5", &rate))
+        XCTAssertFalse(BCAmountRateFromDecimalString("1.2.3", &rate))
+        XCTAssertFalse(BCAmountRateFromDecimalString("12345678901234567890", &rate))
+    }
+
+    func testBulkFormatting() {
+        var style = makeStyle(fractionDigits: 0...8)
+        let amounts: [UInt64] = [0, 1, 100_000_000, 12_345_000_000]
+        var lengths = [Int](repeating: 0, count: amounts.count)
+        var buffer = [CChar](repeating: 0, count: amounts.count * Int(BC_AMOUNT_FORMAT_MAX_LENGTH))
+
+        let used = BCAmountFormatBulk(amounts, amounts.count, nil, &style, &buffer, buffer.count, &lengths)
+        XCTAssertGreaterThan(used, 0)
+
+        var strings: [String] = []
+        var offset = 0
+        for length in lengths {
+            strings.append(String(cString: Array(buffer[offset...(offset + length)])))
+            offset += length + 1
+        }
+        XCTAssertEqual(strings, ["0", "0.00000001", "1", "123.45"])
+        XCTAssertEqual(used, offset)
+    }
+
+    func testBufferTooSmall() {
+        var style = makeStyle(fractionDigits: 0...8)
+        var buffer = [CChar](repeating: 0, count: 4)
+        XCTAssertEqual(BCAmountFormatCrypto(123_456_789, &style, &buffer, buffer.count), 0)
+    }
+}
@@ -32,6 +32,7 @@ let package = Package(
         .target(
             name: "WalletPayloadKit",
             dependencies: [
+                .target(name: "WalletPayloadCrypto"),
                 .product(name: "ObservabilityKit", package: "Observability"),
                 .product(name: "Localization", package: "Localization"),
                 .product(name: "CommonCryptoKit", package: "CommonCrypto"),
@@ -42,6 +43,9 @@ let package = Package(
                 .product(name: "DIKit", package: "DIKit")
             ]
         ),
+        .target(
+            name: "WalletPayloadCrypto"
+        ),
         .target(
             name: "WalletPayloadDataKit",
             dependencies: [
@@ -63,6 +67,7 @@ let package = Package(
         .testTarget(
             name: "WalletPayloadKitTests",
             dependencies: [
+                .target(name: "WalletPayloadCrypto"),
                 .target(name: "WalletPayloadDataKit"),
                 .target(name: "WalletPayloadKit"),
                 .target(name: "WalletPayloadKitMock"),
@@ -0,0 +1,393 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+#define HAVE_ARMV8_AES 1
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#define HAVE_AESNI 1
+#include <wmmintrin.h>
+#include <emmintrin.h>
+#endif
+
+#include "aes.h"
+
+/* Blocks decrypted together, so the AES units pipeline independent blocks. */
+#define CBC_LANES 4
+
+static const uint8_t sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+#if !defined(HAVE_ARMV8_AES)
+static const uint8_t rsbox[256] = {
+	0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+	0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+	0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+	0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+	0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+	0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+	0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+	0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+	0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+	0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+	0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+	0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+	0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+	0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+	0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+	0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
+};
+#endif
+
+static inline uint8_t
+xtime(uint8_t x)
+{
+
+	return (uint8_t)((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+/* Multiply in GF(2^8). */
+static inline uint8_t
+gmul(uint8_t a, uint8_t b)
+{
+	uint8_t p = 0;
+
+	while (b) {
+		if (b & 1)
+			p ^= a;
+		a = xtime(a);
+		b >>= 1;
+	}
+	return (p);
+}
+
+static void
+inv_mix_columns(uint8_t s[16])
+{
+	uint8_t a, b, c, d;
+	int i;
+
+	for (i = 0; i < 16; i += 4) {
+		a = s[i];
+		b = s[i + 1];
+		c = s[i + 2];
+		d = s[i + 3];
+		s[i] = gmul(a, 14) ^ gmul(b, 11) ^ gmul(c, 13) ^ gmul(d, 9);
+		s[i + 1] = gmul(a, 9) ^ gmul(b, 14) ^ gmul(c, 11) ^ gmul(d, 13);
+		s[i + 2] = gmul(a, 13) ^ gmul(b, 9) ^ gmul(c, 14) ^ gmul(d, 11);
+		s[i + 3] = gmul(a, 11) ^ gmul(b, 13) ^ gmul(c, 9) ^ gmul(d, 14);
+	}
+}
+
+void
+AES256_Init(AES256_CTX * ctx, const uint8_t key[32])
+{
+	uint8_t * w = &ctx->ek[0][0];
+	uint8_t t[4], u;
+	uint8_t rcon = 1;
+	int i;
+
+	/* Expand the key into 60 words. */
+	memcpy(w, key, 32);
+	for (i = 8; i < 60; i++) {
+		memcpy(t, &w[4 * (i - 1)], 4);
+		if (i % 8 == 0) {
+			u = t[0];
+			t[0] = sbox[t[1]] ^ rcon;
+			t[1] = sbox[t[2]];
+			t[2] = sbox[t[3]];
+			t[3] = sbox[u];
+			rcon = xtime(rcon);
+		} else if (i % 8 == 4) {
+			t[0] = sbox[t[0]];
+			t[1] = sbox[t[1]];
+			t[2] = sbox[t[2]];
+			t[3] = sbox[t[3]];
+		}
+		w[4 * i] = w[4 * (i - 8)] ^ t[0];
+		w[4 * i + 1] = w[4 * (i - 8) + 1] ^ t[1];
+		w[4 * i + 2] = w[4 * (i - 8) + 2] ^ t[2];
+		w[4 * i + 3] = w[4 * (i - 8) + 3] ^ t[3];
+	}
+
+	/* The inverse cipher runs the rounds backwards, InvMixColumns folded in. */
+	memcpy(ctx->dk[0], ctx->ek[14], 16);
+	for (i = 1; i < 14; i++) {
+		memcpy(ctx->dk[i], ctx->ek[14 - i], 16);
+		inv_mix_columns(ctx->dk[i]);
+	}
+	memcpy(ctx->dk[14], ctx->ek[0], 16);
+
+	memset(t, 0, sizeof(t));
+}
+
+#if defined(HAVE_ARMV8_AES)
+
+static inline uint8x16_t
+encrypt_block(const AES256_CTX * ctx, uint8x16_t b)
+{
+	int r;
+
+	for (r = 0; r < 13; r++)
+		b = vaesmcq_u8(vaeseq_u8(b, vld1q_u8(ctx->ek[r])));
+	b = vaeseq_u8(b, vld1q_u8(ctx->ek[13]));
+	return (veorq_u8(b, vld1q_u8(ctx->ek[14])));
+}
+
+void
+AES256_CBC_Decrypt(const AES256_CTX * ctx, uint8_t iv[16], const uint8_t * in,
+    uint8_t * out, size_t nblocks)
+{
+	uint8x16_t dk[15];
+	uint8x16_t prev, c[CBC_LANES], b[CBC_LANES];
+	int r, l;
+
+	for (r = 0; r < 15; r++)
+		dk[r] = vld1q_u8(ctx->dk[r]);
+	prev = vld1q_u8(iv);
+
+	for (; nblocks >= CBC_LANES; nblocks -= CBC_LANES) {
+		for (l = 0; l < CBC_LANES; l++)
+			b[l] = c[l] = vld1q_u8(&in[16 * l]);
+		for (r = 0; r < 13; r++)
+			for (l = 0; l < CBC_LANES; l++)
+				b[l] = vaesimcq_u8(vaesdq_u8(b[l], dk[r]));
+		for (l = 0; l < CBC_LANES; l++) {
+			b[l] = veorq_u8(vaesdq_u8(b[l], dk[13]), dk[14]);
+			vst1q_u8(&out[16 * l], veorq_u8(b[l], prev));
+			prev = c[l];
+		}
+		in += 16 * CBC_LANES;
+		out += 16 * CBC_LANES;
+	}
+	for (; nblocks > 0; nblocks--) {
+		b[0] = c[0] = vld1q_u8(in);
+		for (r = 0; r < 13; r++)
+			b[0] = vaesimcq_u8(vaesdq_u8(b[0], dk[r]));
+		b[0] = veorq_u8(vaesdq_u8(b[0], dk[13]), dk[14]);
+		vst1q_u8(out, veorq_u8(b[0], prev));
+		prev = c[0];
+		in += 16;
+		out += 16;
+	}
+	vst1q_u8(iv, prev);
+}
+
+static void
+ofb_next(const AES256_CTX * ctx, uint8_t iv[16])
+{
+
+	vst1q_u8(iv, encrypt_block(ctx, vld1q_u8(iv)));
+}
+
+#else
+
+static inline void
+xor_block(uint8_t * out, const uint8_t * a, const uint8_t * b)
+{
+	int i;
+
+	for (i = 0; i < 16; i++)
+		out[i] = a[i] ^ b[i];
+}
+
+/* FIPS-197 byte-oriented rounds, used when there are no AES instructions. */
+static void
+encrypt_block_generic(const AES256_CTX * ctx, const uint8_t in[16],
+    uint8_t out[16])
+{
+	uint8_t s[16], t[16];
+	uint8_t a, b, c, d, e;
+	int r, i;
+
+	xor_block(s, in, ctx->ek[0]);
+	for (r = 1; r < 15; r++) {
+		/* SubBytes and ShiftRows. */
+		for (i = 0; i < 16; i++)
+			t[i] = sbox[s[(i + 4 * (i & 3)) & 15]];
+		if (r < 14) {
+			/* MixColumns. */
+			for (i = 0; i < 16; i += 4) {
+				a = t[i];
+				b = t[i + 1];
+				c = t[i + 2];
+				d = t[i + 3];
+				e = a ^ b ^ c ^ d;
+				t[i] ^= e ^ xtime(a ^ b);
+				t[i + 1] ^= e ^ xtime(b ^ c);
+				t[i + 2] ^= e ^ xtime(c ^ d);
+				t[i + 3] ^= e ^ xtime(d ^ a);
+			}
+		}
+		xor_block(s, t, ctx->ek[r]);
+	}
+	memcpy(out, s, 16);
+}
+
+static void
+decrypt_block_generic(const AES256_CTX * ctx, const uint8_t in[16],
+    uint8_t out[16])
+{
+	uint8_t s[16], t[16];
+	int r, i;
+
+	xor_block(s, in, ctx->ek[14]);
+	for (r = 13; r >= 0; r--) {
+		/* InvShiftRows and InvSubBytes. */
+		for (i = 0; i < 16; i++)
+			t[i] = rsbox[s[(i - 4 * (i & 3)) & 15]];
+		xor_block(s, t, ctx->ek[r]);
+		if (r > 0)
+			inv_mix_columns(s);
+	}
+	memcpy(out, s, 16);
+}
+
+#if defined(HAVE_AESNI)
+
+static int
+have_aesni(void)
+{
+	static int cached = -1;
+
+	if (cached < 0)
+		cached = __builtin_cpu_supports("aes") ? 1 : 0;
+	return (cached);
+}
+
+__attribute__((target("aes")))
+static void
+cbc_decrypt_aesni(const AES256_CTX * ctx, uint8_t iv[16], const uint8_t * in,
+    uint8_t * out, size_t nblocks)
+{
+	__m128i dk[15];
+	__m128i prev, c[CBC_LANES], b[CBC_LANES];
+	int r, l;
+
+	for (r = 0; r < 15; r++)
+		dk[r] = _mm_loadu_si128((const __m128i *)ctx->dk[r]);
+	prev = _mm_loadu_si128((const __m128i *)iv);
+
+	for (; nblocks >= CBC_LANES; nblocks -= CBC_LANES) {
+		for (l = 0; l < CBC_LANES; l++) {
+			c[l] = _mm_loadu_si128((const __m128i *)&in[16 * l]);
+			b[l] = _mm_xor_si128(c[l], dk[0]);
+		}
+		for (r = 1; r < 14; r++)
+			for (l = 0; l < CBC_LANES; l++)
+				b[l] = _mm_aesdec_si128(b[l], dk[r]);
+		for (l = 0; l < CBC_LANES; l++) {
+			b[l] = _mm_aesdeclast_si128(b[l], dk[14]);
+			_mm_storeu_si128((__m128i *)&out[16 * l],
+			    _mm_xor_si128(b[l], prev));
+			prev = c[l];
+		}
+		in += 16 * CBC_LANES;
+		out += 16 * CBC_LANES;
+	}
+	for (; nblocks > 0; nblocks--) {
+		c[0] = _mm_loadu_si128((const __m128i *)in);
+		b[0] = _mm_xor_si128(c[0], dk[0]);
+		for (r = 1; r < 14; r++)
+			b[0] = _mm_aesdec_si128(b[0], dk[r]);
+		b[0] = _mm_aesdeclast_si128(b[0], dk[14]);
+		_mm_storeu_si128((__m128i *)out, _mm_xor_si128(b[0], prev));
+		prev = c[0];
+		in += 16;
+		out += 16;
+	}
+	_mm_storeu_si128((__m128i *)iv, prev);
+}
+
+__attribute__((target("aes")))
+static void
+encrypt_block_aesni(const AES256_CTX * ctx, const uint8_t in[16],
+    uint8_t out[16])
+{
+	__m128i b;
+	int r;
+
+	b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)in),
+	    _mm_loadu_si128((const __m128i *)ctx->ek[0]));
+	for (r = 1; r < 14; r++)
+		b = _mm_aesenc_si128(b,
+		    _mm_loadu_si128((const __m128i *)ctx->ek[r]));
+	b = _mm_aesenclast_si128(b,
+	    _mm_loadu_si128((const __m128i *)ctx->ek[14]));
+	_mm_storeu_si128((__m128i *)out, b);
+}
+
+#endif /* HAVE_AESNI */
+
+void
+AES256_CBC_Decrypt(const AES256_CTX * ctx, uint8_t iv[16], const uint8_t * in,
+    uint8_t * out, size_t nblocks)
+{
+	uint8_t c[16];
+
+#if defined(HAVE_AESNI)
+	if (have_aesni()) {
+		cbc_decrypt_aesni(ctx, iv, in, out, nblocks);
+		return;
+	}
+#endif
+
+	for (; nblocks > 0; nblocks--) {
+		memcpy(c, in, 16);
+		decrypt_block_generic(ctx, c, out);
+		xor_block(out, out, iv);
+		memcpy(iv, c, 16);
+		in += 16;
+		out += 16;
+	}
+}
+
+static void
+ofb_next(const AES256_CTX * ctx, uint8_t iv[16])
+{
+
+#if defined(HAVE_AESNI)
+	if (have_aesni()) {
+		encrypt_block_aesni(ctx, iv, iv);
+		return;
+	}
+#endif
+	encrypt_block_generic(ctx, iv, iv);
+}
+
+#endif /* HAVE_ARMV8_AES */
+
+void
+AES256_OFB_Crypt(const AES256_CTX * ctx, uint8_t iv[16], const uint8_t * in,
+    uint8_t * out, size_t len)
+{
+	size_t i, n;
+
+	for (; len > 0; len -= n) {
+		ofb_next(ctx, iv);
+		n = (len < 16) ? len : 16;
+		for (i = 0; i < n; i++)
+			out[i] = in[i] ^ iv[i];
+		in += n;
+		out += n;
+	}
+}
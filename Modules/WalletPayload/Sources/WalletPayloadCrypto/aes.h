@@ -0,0 +1,34 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _WALLET_PAYLOAD_AES_H_
+#define _WALLET_PAYLOAD_AES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct AES256Context {
+	/* Encryption round keys. */
+	uint8_t ek[15][16];
+	/* Round keys of the equivalent inverse cipher, in the order used. */
+	uint8_t dk[15][16];
+} AES256_CTX;
+
+void	AES256_Init(AES256_CTX *, const uint8_t [32]);
+
+/**
+ * AES256_CBC_Decrypt(ctx, iv, in, out, nblocks):
+ * Decrypt nblocks blocks in CBC mode and leave the last ciphertext block in
+ * iv, so that a stream can be decrypted in chunks.  in and out may alias.
+ */
+void	AES256_CBC_Decrypt(const AES256_CTX *, uint8_t [16], const uint8_t *,
+    uint8_t *, size_t);
+
+/**
+ * AES256_OFB_Crypt(ctx, iv, in, out, len):
+ * XOR len bytes with the OFB keystream, leaving the feedback block in iv.
+ * Only the last chunk of a stream may have a partial block.
+ */
+void	AES256_OFB_Crypt(const AES256_CTX *, uint8_t [16], const uint8_t *,
+    uint8_t *, size_t);
+
+#endif /* !_WALLET_PAYLOAD_AES_H_ */
@@ -0,0 +1,81 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _PAYLOAD_CRYPTO_H_
+#define _PAYLOAD_CRYPTO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Status codes of payload_crypto_decrypt. */
+#define PAYLOAD_CRYPTO_OK		0
+#define PAYLOAD_CRYPTO_EDECODE		-1	/* Not base64, or shorter than the IV. */
+#define PAYLOAD_CRYPTO_EDECRYPT		-2	/* Bad ciphertext length, or not UTF-8. */
+#define PAYLOAD_CRYPTO_ESPACE		-3	/* The output buffer is too small. */
+
+/* AES-256 block modes and paddings used by the wallet payload versions. */
+typedef enum {
+	PAYLOAD_CRYPTO_CBC_ISO10126,
+	PAYLOAD_CRYPTO_OFB_NOPADDING,
+	PAYLOAD_CRYPTO_OFB_ISO78164
+} payload_crypto_mode;
+
+/**
+ * PBKDF2_SHA1(passwd, passwdlen, salt, saltlen, c, buf, dkLen):
+ * Compute PBKDF2(passwd, salt, c, dkLen) using HMAC-SHA1 as the PRF, and
+ * write the output to buf.  The value dkLen must be at most 20 * (2^32 - 1).
+ */
+void	PBKDF2_SHA1(const uint8_t *, size_t, const uint8_t *, size_t,
+    uint64_t, uint8_t *, size_t);
+
+/**
+ * PBKDF2_SHA1_checkpoints(passwd, passwdlen, salt, saltlen, c, nc, buf, dkLen):
+ * Compute PBKDF2(passwd, salt, c[i], dkLen) for each of the nc iteration
+ * counts in c, which must be sorted in ascending order, in a single run of
+ * c[nc - 1] iterations.  The key for c[i] is written to buf + i * dkLen.
+ */
+void	PBKDF2_SHA1_checkpoints(const uint8_t *, size_t, const uint8_t *,
+    size_t, const uint64_t *, size_t, uint8_t *, size_t);
+
+/**
+ * payload_crypto_decrypt_capacity(b64len):
+ * Return an output buffer size large enough for any payload of b64len
+ * base64 characters.
+ */
+size_t	payload_crypto_decrypt_capacity(size_t);
+
+/**
+ * payload_crypto_decrypt(b64, b64len, passwd, passwdlen, c, mode, buf,
+ *     buflen, outlen):
+ * Decrypt a base64 wallet payload: a 16-byte IV, which is also the PBKDF2
+ * salt, followed by the AES-256 ciphertext.  The key is PBKDF2-HMAC-SHA1 of
+ * passwd with c iterations.  The base64 is decoded a chunk at a time and
+ * decrypted straight into buf, which receives outlen bytes of validated
+ * UTF-8.  Padding is removed as CryptoSwift does, so that the results match
+ * AESCryptor byte for byte.
+ */
+int	payload_crypto_decrypt(const uint8_t *, size_t, const uint8_t *,
+    size_t, uint32_t, payload_crypto_mode, uint8_t *, size_t, size_t *);
+
+/**
+ * payload_crypto_salt(b64, b64len, salt):
+ * Decode the IV of a base64 payload, which is the salt of its key.
+ */
+int	payload_crypto_salt(const uint8_t *, size_t, uint8_t [16]);
+
+/**
+ * payload_crypto_decrypt_key(b64, b64len, key, mode, buf, buflen, outlen):
+ * Decrypt as payload_crypto_decrypt does, with a key already derived from
+ * the salt of the payload, e.g. by PBKDF2_SHA1_checkpoints.
+ */
+int	payload_crypto_decrypt_key(const uint8_t *, size_t, const uint8_t [32],
+    payload_crypto_mode, uint8_t *, size_t, size_t *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !_PAYLOAD_CRYPTO_H_ */
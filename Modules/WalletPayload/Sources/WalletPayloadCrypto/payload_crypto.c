@@ -0,0 +1,286 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "aes.h"
+#include "payload_crypto.h"
+
+/*
+ * Bytes decoded and decrypted per step.  Each chunk is decoded into the
+ * output buffer and decrypted in place while it is still in cache.
+ */
+#define CHUNK_LEN	4096
+
+/* Base64 digit values plus one, zero for anything else. */
+static const uint8_t b64_digits[256] = {
+	['A'] = 1, ['B'] = 2, ['C'] = 3, ['D'] = 4, ['E'] = 5, ['F'] = 6, ['G'] = 7, ['H'] = 8,
+	['I'] = 9, ['J'] = 10, ['K'] = 11, ['L'] = 12, ['M'] = 13, ['N'] = 14, ['O'] = 15, ['P'] = 16,
+	['Q'] = 17, ['R'] = 18, ['S'] = 19, ['T'] = 20, ['U'] = 21, ['V'] = 22, ['W'] = 23, ['X'] = 24,
+	['Y'] = 25, ['Z'] = 26, ['a'] = 27, ['b'] = 28, ['c'] = 29, ['d'] = 30, ['e'] = 31, ['f'] = 32,
+	['g'] = 33, ['h'] = 34, ['i'] = 35, ['j'] = 36, ['k'] = 37, ['l'] = 38, ['m'] = 39, ['n'] = 40,
+	['o'] = 41, ['p'] = 42, ['q'] = 43, ['r'] = 44, ['s'] = 45, ['t'] = 46, ['u'] = 47, ['v'] = 48,
+	['w'] = 49, ['x'] = 50, ['y'] = 51, ['z'] = 52, ['0'] = 53, ['1'] = 54, ['2'] = 55, ['3'] = 56,
+	['4'] = 57, ['5'] = 58, ['6'] = 59, ['7'] = 60, ['8'] = 61, ['9'] = 62, ['+'] = 63, ['/'] = 64,
+};
+
+/* Decodes base64 a few bytes at a time, in order. */
+struct b64_reader {
+	const uint8_t * p;
+	const uint8_t * last;
+	/* The last quad, its padding replaced with zero digits. */
+	uint8_t lastquad[4];
+	/* Bytes decoded from a quad but not read yet. */
+	uint8_t pend[3];
+	size_t npend;
+	/* Bytes left to read. */
+	size_t remaining;
+};
+
+static int
+b64_decode_quad(const uint8_t q[4], uint8_t out[3])
+{
+	uint32_t a = b64_digits[q[0]];
+	uint32_t b = b64_digits[q[1]];
+	uint32_t c = b64_digits[q[2]];
+	uint32_t d = b64_digits[q[3]];
+	uint32_t v;
+
+	if ((a == 0) | (b == 0) | (c == 0) | (d == 0))
+		return (-1);
+	v = ((a - 1) << 18) | ((b - 1) << 12) | ((c - 1) << 6) | (d - 1);
+	out[0] = (uint8_t)(v >> 16);
+	out[1] = (uint8_t)(v >> 8);
+	out[2] = (uint8_t)v;
+	return (0);
+}
+
+static int
+b64_reader_init(struct b64_reader * r, const uint8_t * b64, size_t len)
+{
+	size_t npad = 0;
+
+	/* Padded base64 without whitespace, as Data(base64Encoded:) takes. */
+	if (len == 0 || len % 4 != 0)
+		return (-1);
+	if (b64[len - 1] == '=')
+		npad = (b64[len - 2] == '=') ? 2 : 1;
+
+	r->p = b64;
+	r->last = &b64[len - 4];
+	memcpy(r->lastquad, r->last, 4);
+	if (npad > 0)
+		memset(&r->lastquad[4 - npad], 'A', npad);
+	r->npend = 0;
+	r->remaining = len / 4 * 3 - npad;
+	return (0);
+}
+
+/* Read the next len bytes, which must not be more than are left. */
+static int
+b64_read(struct b64_reader * r, uint8_t * out, size_t len)
+{
+	const uint8_t * q;
+
+	r->remaining -= len;
+	for (; len > 0 && r->npend > 0; len--, r->npend--)
+		*out++ = r->pend[3 - r->npend];
+
+	for (; len > 0; r->p += 4) {
+		q = (r->p == r->last) ? r->lastquad : r->p;
+		if (len >= 3) {
+			if (b64_decode_quad(q, out))
+				return (-1);
+			out += 3;
+			len -= 3;
+		} else {
+			if (b64_decode_quad(q, r->pend))
+				return (-1);
+			memcpy(out, r->pend, len);
+			r->npend = 3 - len;
+			len = 0;
+		}
+	}
+	return (0);
+}
+
+/* Strict UTF-8, as String(data:encoding:) requires. */
+static int
+utf8_valid(const uint8_t * s, size_t len)
+{
+	uint64_t w;
+	size_t i = 0, n;
+	uint8_t c, lo, hi;
+
+	while (i < len) {
+		/* Skip ASCII eight bytes at a time. */
+		if (len - i >= 8) {
+			memcpy(&w, &s[i], 8);
+			if ((w & 0x8080808080808080ULL) == 0) {
+				i += 8;
+				continue;
+			}
+		}
+		c = s[i++];
+		if (c < 0x80)
+			continue;
+
+		lo = 0x80;
+		hi = 0xBF;
+		if (c >= 0xC2 && c <= 0xDF) {
+			n = 1;
+		} else if (c >= 0xE0 && c <= 0xEF) {
+			n = 2;
+			if (c == 0xE0)
+				lo = 0xA0;	/* Overlong. */
+			else if (c == 0xED)
+				hi = 0x9F;	/* Surrogates. */
+		} else if (c >= 0xF0 && c <= 0xF4) {
+			n = 3;
+			if (c == 0xF0)
+				lo = 0x90;	/* Overlong. */
+			else if (c == 0xF4)
+				hi = 0x8F;	/* Above U+10FFFF. */
+		} else {
+			return (0);
+		}
+
+		if (len - i < n || s[i] < lo || s[i] > hi)
+			return (0);
+		for (i++, n--; n > 0; i++, n--)
+			if ((s[i] & 0xC0) != 0x80)
+				return (0);
+	}
+	return (1);
+}
+
+size_t
+payload_crypto_decrypt_capacity(size_t b64len)
+{
+
+	return (b64len / 4 * 3);
+}
+
+/* Start reading a payload, which begins with its IV. */
+static int
+read_iv(struct b64_reader * r, const uint8_t * b64, size_t b64len,
+    uint8_t iv[16])
+{
+
+	if (b64_reader_init(r, b64, b64len) || r->remaining < 16)
+		return (-1);
+	return (b64_read(r, iv, 16));
+}
+
+/* Decrypt the rest of a payload, whose IV has been read from r. */
+static int
+decrypt_stream(struct b64_reader * r, uint8_t iv[16], const uint8_t key[32],
+    payload_crypto_mode mode, uint8_t * buf, size_t buflen, size_t * outlen)
+{
+	AES256_CTX ctx;
+	size_t total, len, i, n;
+	int rc;
+
+	total = len = r->remaining;
+	if (len > buflen)
+		return (PAYLOAD_CRYPTO_ESPACE);
+	if (mode == PAYLOAD_CRYPTO_CBC_ISO10126 && len % 16 != 0)
+		return (PAYLOAD_CRYPTO_EDECRYPT);
+
+	AES256_Init(&ctx, key);
+	for (i = 0; i < len; i += n) {
+		n = (len - i < CHUNK_LEN) ? len - i : CHUNK_LEN;
+		if (b64_read(r, &buf[i], n)) {
+			rc = PAYLOAD_CRYPTO_EDECODE;
+			goto err;
+		}
+		if (mode == PAYLOAD_CRYPTO_CBC_ISO10126)
+			AES256_CBC_Decrypt(&ctx, iv, &buf[i], &buf[i], n / 16);
+		else
+			AES256_OFB_Crypt(&ctx, iv, &buf[i], &buf[i], n);
+	}
+
+	switch (mode) {
+	case PAYLOAD_CRYPTO_CBC_ISO10126:
+		/* The last byte counts the padding; ignored if out of range. */
+		if (len > 0 && buf[len - 1] != 0 && buf[len - 1] <= len)
+			len -= buf[len - 1];
+		break;
+	case PAYLOAD_CRYPTO_OFB_ISO78164:
+		/* Everything from the last 0x80 on is padding. */
+		for (i = len; i > 0; i--) {
+			if (buf[i - 1] == 0x80) {
+				len = i - 1;
+				break;
+			}
+		}
+		break;
+	case PAYLOAD_CRYPTO_OFB_NOPADDING:
+		break;
+	}
+
+	if (!utf8_valid(buf, len)) {
+		rc = PAYLOAD_CRYPTO_EDECRYPT;
+		goto err;
+	}
+
+	*outlen = len;
+	memset(&ctx, 0, sizeof(ctx));
+	return (PAYLOAD_CRYPTO_OK);
+
+err:
+	/* Don't leave a partial plaintext behind. */
+	memset(buf, 0, total);
+	memset(&ctx, 0, sizeof(ctx));
+	return (rc);
+}
+
+int
+payload_crypto_decrypt(const uint8_t * b64, size_t b64len,
+    const uint8_t * passwd, size_t passwdlen, uint32_t c,
+    payload_crypto_mode mode, uint8_t * buf, size_t buflen, size_t * outlen)
+{
+	struct b64_reader r;
+	uint8_t key[32];
+	uint8_t iv[16];
+	int rc;
+
+	/* The IV doubles as the salt, so it is decoded first. */
+	if (read_iv(&r, b64, b64len, iv))
+		return (PAYLOAD_CRYPTO_EDECODE);
+
+	PBKDF2_SHA1(passwd, passwdlen, iv, 16, c, key, 32);
+	rc = decrypt_stream(&r, iv, key, mode, buf, buflen, outlen);
+
+	memset(key, 0, sizeof(key));
+	memset(iv, 0, sizeof(iv));
+	return (rc);
+}
+
+int
+payload_crypto_salt(const uint8_t * b64, size_t b64len, uint8_t salt[16])
+{
+	struct b64_reader r;
+
+	if (read_iv(&r, b64, b64len, salt))
+		return (PAYLOAD_CRYPTO_EDECODE);
+	return (PAYLOAD_CRYPTO_OK);
+}
+
+int
+payload_crypto_decrypt_key(const uint8_t * b64, size_t b64len,
+    const uint8_t key[32], payload_crypto_mode mode, uint8_t * buf,
+    size_t buflen, size_t * outlen)
+{
+	struct b64_reader r;
+	uint8_t iv[16];
+	int rc;
+
+	if (read_iv(&r, b64, b64len, iv))
+		return (PAYLOAD_CRYPTO_EDECODE);
+
+	rc = decrypt_stream(&r, iv, key, mode, buf, buflen, outlen);
+
+	memset(iv, 0, sizeof(iv));
+	return (rc);
+}
@@ -0,0 +1,311 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define HAVE_ARMV8_SHA1 1
+#include <arm_neon.h>
+#endif
+
+#include "payload_crypto.h"
+#include "sha1.h"
+
+static inline uint32_t
+be32dec(const void * pp)
+{
+	const uint8_t * p = pp;
+
+	return ((uint32_t)(p[3]) + ((uint32_t)(p[2]) << 8) +
+	    ((uint32_t)(p[1]) << 16) + ((uint32_t)(p[0]) << 24));
+}
+
+static inline void
+be32enc(void * pp, uint32_t x)
+{
+	uint8_t * p = pp;
+
+	p[3] = x & 0xff;
+	p[2] = (x >> 8) & 0xff;
+	p[1] = (x >> 16) & 0xff;
+	p[0] = (x >> 24) & 0xff;
+}
+
+#ifdef HAVE_ARMV8_SHA1
+
+void
+SHA1_Transform(uint32_t state[5], const uint32_t block[16])
+{
+	static const uint32_t K[4] = {
+		0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
+	};
+	uint32x4_t W[4];
+	uint32x4_t abcd, abcd0, wk;
+	uint32_t e, e0, e1;
+	int i;
+
+	abcd0 = abcd = vld1q_u32(&state[0]);
+	e0 = e = state[4];
+	for (i = 0; i < 4; i++)
+		W[i] = vld1q_u32(&block[4 * i]);
+
+	/* Each step is four rounds; rounds 0-19 choose, 40-59 majority. */
+	for (i = 0; i < 20; i++) {
+		wk = vaddq_u32(W[i % 4], vdupq_n_u32(K[i / 5]));
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		if (i < 5)
+			abcd = vsha1cq_u32(abcd, e, wk);
+		else if (i >= 10 && i < 15)
+			abcd = vsha1mq_u32(abcd, e, wk);
+		else
+			abcd = vsha1pq_u32(abcd, e, wk);
+		e = e1;
+
+		/* W[4n + 16 .. 4n + 19] replaces W[4n .. 4n + 3]. */
+		if (i < 16)
+			W[i % 4] = vsha1su1q_u32(vsha1su0q_u32(W[i % 4],
+			    W[(i + 1) % 4], W[(i + 2) % 4]), W[(i + 3) % 4]);
+	}
+
+	vst1q_u32(&state[0], vaddq_u32(abcd, abcd0));
+	state[4] = e + e0;
+}
+
+#else
+
+#define ROTL(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+
+void
+SHA1_Transform(uint32_t state[5], const uint32_t block[16])
+{
+	uint32_t W[16];
+	uint32_t a, b, c, d, e, f, k, t;
+	int i;
+
+	memcpy(W, block, sizeof(W));
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+
+	for (i = 0; i < 80; i++) {
+		if (i >= 16) {
+			t = W[(i + 13) & 15] ^ W[(i + 8) & 15] ^
+			    W[(i + 2) & 15] ^ W[i & 15];
+			W[i & 15] = ROTL(t, 1);
+		}
+		if (i < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		t = ROTL(a, 5) + f + e + k + W[i & 15];
+		e = d;
+		d = c;
+		c = ROTL(b, 30);
+		b = a;
+		a = t;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+#endif
+
+/* Compress a 64-byte block of the message. */
+static void
+SHA1_TransformBytes(uint32_t state[5], const uint8_t block[64])
+{
+	uint32_t W[16];
+	int i;
+
+	for (i = 0; i < 16; i++)
+		W[i] = be32dec(&block[4 * i]);
+	SHA1_Transform(state, W);
+}
+
+void
+SHA1_Init(SHA1_CTX * ctx)
+{
+
+	ctx->state[0] = 0x67452301;
+	ctx->state[1] = 0xEFCDAB89;
+	ctx->state[2] = 0x98BADCFE;
+	ctx->state[3] = 0x10325476;
+	ctx->state[4] = 0xC3D2E1F0;
+	ctx->count = 0;
+}
+
+void
+SHA1_Update(SHA1_CTX * ctx, const void * in, size_t len)
+{
+	const uint8_t * src = in;
+	size_t r = ctx->count & 63;
+	size_t n;
+
+	ctx->count += len;
+
+	/* Fill the partial block first. */
+	if (r != 0) {
+		n = 64 - r;
+		if (len < n) {
+			memcpy(&ctx->buf[r], src, len);
+			return;
+		}
+		memcpy(&ctx->buf[r], src, n);
+		SHA1_TransformBytes(ctx->state, ctx->buf);
+		src += n;
+		len -= n;
+	}
+
+	for (; len >= 64; src += 64, len -= 64)
+		SHA1_TransformBytes(ctx->state, src);
+
+	memcpy(ctx->buf, src, len);
+}
+
+void
+SHA1_Final(uint8_t digest[20], SHA1_CTX * ctx)
+{
+	static const uint8_t PAD[64] = { 0x80 };
+	uint8_t len[8];
+	size_t r = ctx->count & 63;
+	int i;
+
+	be32enc(&len[0], (uint32_t)(ctx->count >> 29));
+	be32enc(&len[4], (uint32_t)(ctx->count << 3));
+	SHA1_Update(ctx, PAD, (r < 56) ? 56 - r : 120 - r);
+	SHA1_Update(ctx, len, 8);
+
+	for (i = 0; i < 5; i++)
+		be32enc(&digest[4 * i], ctx->state[i]);
+
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+/**
+ * PBKDF2_SHA1_checkpoints(passwd, passwdlen, salt, saltlen, c, nc, buf, dkLen):
+ * Unlike PBKDF2_SHA256 in the keys library, the HMAC pads are absorbed once:
+ * every iteration restarts from the inner and outer midstates and costs two
+ * compressions of a preformatted block instead of four.
+ */
+void
+PBKDF2_SHA1_checkpoints(const uint8_t * passwd, size_t passwdlen,
+    const uint8_t * salt, size_t saltlen, const uint64_t * c, size_t nc,
+    uint8_t * buf, size_t dkLen)
+{
+	SHA1_CTX ictx, octx, hctx;
+	uint8_t pad[64];
+	uint8_t khash[20];
+	uint8_t ivec[4];
+	uint8_t U1[20];
+	uint32_t block[16];
+	uint32_t U[5], T[5], S[5];
+	uint64_t j;
+	size_t i, n, clen;
+	int k;
+
+	/* If passwdlen > 64, the key is really SHA1(passwd). */
+	if (passwdlen > 64) {
+		SHA1_Init(&hctx);
+		SHA1_Update(&hctx, passwd, passwdlen);
+		SHA1_Final(khash, &hctx);
+		passwd = khash;
+		passwdlen = 20;
+	}
+
+	/* Midstates after the inner and outer key pads. */
+	SHA1_Init(&ictx);
+	memset(pad, 0x36, 64);
+	for (i = 0; i < passwdlen; i++)
+		pad[i] ^= passwd[i];
+	SHA1_Update(&ictx, pad, 64);
+
+	SHA1_Init(&octx);
+	memset(pad, 0x5c, 64);
+	for (i = 0; i < passwdlen; i++)
+		pad[i] ^= passwd[i];
+	SHA1_Update(&octx, pad, 64);
+
+	/* A 20-byte message after a 64-byte pad, padded once for all. */
+	memset(block, 0, sizeof(block));
+	block[5] = 0x80000000;
+	block[15] = (64 + 20) * 8;
+
+	for (i = 0; i * 20 < dkLen; i++) {
+		/* Compute U_1 = PRF(P, S || INT(i + 1)). */
+		be32enc(ivec, (uint32_t)(i + 1));
+		memcpy(&hctx, &ictx, sizeof(SHA1_CTX));
+		SHA1_Update(&hctx, salt, saltlen);
+		SHA1_Update(&hctx, ivec, 4);
+		SHA1_Final(U1, &hctx);
+		memcpy(&hctx, &octx, sizeof(SHA1_CTX));
+		SHA1_Update(&hctx, U1, 20);
+		SHA1_Final(U1, &hctx);
+
+		for (k = 0; k < 5; k++)
+			T[k] = U[k] = be32dec(&U1[4 * k]);
+
+		/* T after j iterations is the key for a count of j. */
+		clen = dkLen - i * 20;
+		if (clen > 20)
+			clen = 20;
+		for (j = 1, n = 0; ; j++) {
+			if (j > 1) {
+				/* U_j = H(opad || H(ipad || U_{j-1})). */
+				memcpy(block, U, sizeof(U));
+				memcpy(S, ictx.state, sizeof(S));
+				SHA1_Transform(S, block);
+				memcpy(block, S, sizeof(S));
+				memcpy(U, octx.state, sizeof(U));
+				SHA1_Transform(U, block);
+
+				for (k = 0; k < 5; k++)
+					T[k] ^= U[k];
+			}
+
+			/* Copy as many bytes as necessary into each key due. */
+			for (; n < nc && c[n] <= j; n++) {
+				for (k = 0; k < 5; k++)
+					be32enc(&U1[4 * k], T[k]);
+				memcpy(&buf[n * dkLen + i * 20], U1, clen);
+			}
+			if (n == nc)
+				break;
+		}
+	}
+
+	/* Clean the key material off the stack. */
+	memset(&ictx, 0, sizeof(SHA1_CTX));
+	memset(&octx, 0, sizeof(SHA1_CTX));
+	memset(pad, 0, sizeof(pad));
+	memset(khash, 0, sizeof(khash));
+	memset(U1, 0, sizeof(U1));
+	memset(block, 0, sizeof(block));
+	memset(U, 0, sizeof(U));
+	memset(T, 0, sizeof(T));
+	memset(S, 0, sizeof(S));
+}
+
+void
+PBKDF2_SHA1(const uint8_t * passwd, size_t passwdlen, const uint8_t * salt,
+    size_t saltlen, uint64_t c, uint8_t * buf, size_t dkLen)
+{
+
+	PBKDF2_SHA1_checkpoints(passwd, passwdlen, salt, saltlen, &c, 1, buf,
+	    dkLen);
+}
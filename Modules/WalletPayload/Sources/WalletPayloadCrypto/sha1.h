@@ -0,0 +1,26 @@
+// Copyright © Blockchain Luxembourg S.A. All rights reserved.
+
+#ifndef _WALLET_PAYLOAD_SHA1_H_
+#define _WALLET_PAYLOAD_SHA1_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct SHA1Context {
+	uint32_t state[5];
+	uint64_t count;
+	uint8_t buf[64];
+} SHA1_CTX;
+
+void	SHA1_Init(SHA1_CTX *);
+void	SHA1_Update(SHA1_CTX *, const void *, size_t);
+void	SHA1_Final(uint8_t [20], SHA1_CTX *);
+
+/**
+ * SHA1_Transform(state, block):
+ * Compress one block, given as sixteen big-endian words already decoded to
+ * host order.  Uses the ARMv8 SHA1 instructions when they are available.
+ */
+void	SHA1_Transform(uint32_t [5], const uint32_t [16]);
+
+#endif /* !_WALLET_PAYLOAD_SHA1_H_ */
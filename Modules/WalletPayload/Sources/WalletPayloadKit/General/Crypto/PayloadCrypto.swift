@@ -3,6 +3,7 @@
 import CommonCryptoKit
 import DIKit
 import Foundation
+import WalletPayloadCrypto
 
 public enum PayloadCryptoError: Error, Equatable {
     case unknown
@@ -119,6 +120,15 @@ final class PayloadCrypto: PayloadCryptoAPI {
             fatalError("Invalid iteration count")
         }
 
+        if let mode = options.payloadCryptoMode {
+            return decryptNatively(
+                data: dataBase64String,
+                with: key,
+                pbkdf2Iterations: iterations,
+                mode: mode
+            )
+        }
+
         guard let data = Data(base64Encoded: dataBase64String) else {
             return .failure(.decodingFailed)
         }
@@ -221,6 +231,56 @@ final class PayloadCrypto: PayloadCryptoAPI {
         .replaceError(with: .decryptionFailed)
     }
 
+    /// Decodes, stretches the key and decrypts in a single native pass.
+    private func decryptNatively(
+        data dataBase64String: String,
+        with key: String,
+        pbkdf2Iterations iterations: UInt32,
+        mode: payload_crypto_mode
+    ) -> Result<String, PayloadCryptoError> {
+        var password = key
+        return decryptNatively(data: dataBase64String) { payload, buffer, length in
+            password.withUTF8 { password in
+                payload_crypto_decrypt(
+                    payload.baseAddress,
+                    payload.count,
+                    password.baseAddress,
+                    password.count,
+                    iterations,
+                    mode,
+                    buffer.baseAddress,
+                    buffer.count,
+                    &length
+                )
+            }
+        }
+    }
+
+    /// Runs a native decryption of `dataBase64String`, which writes the plaintext straight into
+    /// the storage of the returned string.
+    private func decryptNatively(
+        data dataBase64String: String,
+        decrypt: (UnsafeBufferPointer<UInt8>, UnsafeMutableBufferPointer<UInt8>, inout Int) -> Int32
+    ) -> Result<String, PayloadCryptoError> {
+        var payload = dataBase64String
+        let capacity = payload_crypto_decrypt_capacity(payload.utf8.count)
+        return Result {
+            try payload.withUTF8 { payload in
+                try String(unsafeUninitializedCapacity: max(capacity, 1)) { buffer in
+                    var length = 0
+                    let status = decrypt(payload, buffer, &length)
+                    guard status == PAYLOAD_CRYPTO_OK else {
+                        throw PayloadCryptoError(payloadCryptoStatus: status)
+                    }
+                    return length
+                }
+            }
+        }
+        .mapError { error in
+            error as? PayloadCryptoError ?? .unknown
+        }
+    }
+
     private func decryptWalletSync(data: String, password: String) -> Result<String, PayloadCryptoError> {
         PayloadDecoder().decode(wrapper: data)
             .replaceError(with: .decodingFailed)
@@ -270,56 +330,79 @@ final class PayloadCrypto: PayloadCryptoAPI {
 
     private func decryptV1(wallet: WalletV1Data) -> Result<String, PayloadCryptoError> {
 
-        /// `V1`: `CBC`, `ISO10126`, `10` iterations
-        func CBC_ISO10126_10Iterations(_ data: String, _ password: String) -> Result<String, PayloadCryptoError> {
-            decrypt(data: data, with: password, pbkdf2Iterations: 10)
-        }
+        /// `V1` schemes, in the order they are tried:
+        /// - `CBC`, `ISO10126`, `10` iterations
+        /// - `OFB`, no padding, `1` iteration
+        /// - `OFB`, `ISO7816`, `1` iteration. `ISO/IEC 9797-1` Padding method `2` is the same as `ISO/IEC 7816-4:2005`
+        /// - `CBC`, `ISO10126`, `1` iteration
+        let schemes: [(iterations: UInt64, mode: payload_crypto_mode)] = [
+            (10, PAYLOAD_CRYPTO_CBC_ISO10126),
+            (1, PAYLOAD_CRYPTO_OFB_NOPADDING),
+            (1, PAYLOAD_CRYPTO_OFB_ISO78164),
+            (1, PAYLOAD_CRYPTO_CBC_ISO10126)
+        ]
 
-        /// `V1`: OFB, nopad, 1 iteration
-        func OFB_NoPading_1Iterations(_ data: String, _ password: String) -> Result<String, PayloadCryptoError> {
-            decrypt(
-                data: data,
-                with: password,
-                pbkdf2Iterations: 1,
-                options: AESOptions(
-                    blockMode: .OFB,
-                    padding: .noPadding
-                )
-            )
+        var payload = wallet.payload
+        payload.makeContiguousUTF8()
+        var salt = [UInt8](repeating: 0, count: Constants.saltBytes)
+        let saltStatus = payload.withUTF8 { payload in
+            payload_crypto_salt(payload.baseAddress, payload.count, &salt)
+        }
+        guard saltStatus == PAYLOAD_CRYPTO_OK else {
+            return .failure(.failedToDecryptV1Payload)
         }
 
-        /// `V1`: `OFB`, `ISO7816`, `1` iteration
-        /// `ISO/IEC 9797-1` Padding method `2` is the same as `ISO/IEC 7816-4:2005`
-        func OFB_ISO78164_1Iterations(_ data: String, _ password: String) -> Result<String, PayloadCryptoError> {
-            decrypt(
-                data: data,
-                with: password,
-                pbkdf2Iterations: 1,
-                options: AESOptions(
-                    blockMode: .OFB,
-                    padding: .iso78164
-                )
+        // A single PBKDF2 run derives the key of every iteration count.
+        let checkpoints: [UInt64] = [1, 10]
+        let keyLength = Int(Constants.keyBitLen / 8)
+        var keys = [UInt8](repeating: 0, count: checkpoints.count * keyLength)
+        var password = wallet.password
+        password.withUTF8 { password in
+            PBKDF2_SHA1_checkpoints(
+                password.baseAddress,
+                password.count,
+                salt,
+                salt.count,
+                checkpoints,
+                checkpoints.count,
+                &keys,
+                keyLength
             )
         }
 
-        /// `V1`: `CBC`, `ISO10126`, `1` iterations
-        func CBC_ISO10126_1Iterations(_ data: String, _ password: String) -> Result<String, PayloadCryptoError> {
-            decrypt(data: data, with: password, pbkdf2Iterations: 1)
+        // Every scheme is tried at once, the first to succeed in order wins.
+        var results = [Result<String, PayloadCryptoError>](
+            repeating: .failure(.failedToDecryptV1Payload),
+            count: schemes.count
+        )
+        results.withUnsafeMutableBufferPointer { results in
+            keys.withUnsafeBufferPointer { keys in
+                DispatchQueue.concurrentPerform(iterations: schemes.count) { index in
+                    let scheme = schemes[index]
+                    let key = keys.baseAddress! + checkpoints.firstIndex(of: scheme.iterations)! * keyLength
+                    results[index] = decryptNatively(data: payload) { payload, buffer, length in
+                        payload_crypto_decrypt_key(
+                            payload.baseAddress,
+                            payload.count,
+                            key,
+                            scheme.mode,
+                            buffer.baseAddress,
+                            buffer.count,
+                            &length
+                        )
+                    }
+                }
+            }
+        }
+        keys.withUnsafeMutableBufferPointer { keys in
+            keys.assign(repeating: 0)
         }
 
-        let functions = [
-            CBC_ISO10126_10Iterations,
-            OFB_NoPading_1Iterations,
-            OFB_ISO78164_1Iterations,
-            CBC_ISO10126_1Iterations
-        ]
-
-        for function in functions {
-            if case .success(let decrypted) = function(wallet.payload, wallet.password) {
-                return .success(decrypted)
+        for result in results {
+            if case .success = result {
+                return result
             }
         }
-
         return .failure(.failedToDecryptV1Payload)
     }
 
@@ -327,3 +410,34 @@ final class PayloadCrypto: PayloadCryptoAPI {
         (0..<count).map { _ in UInt8.random(in: 0...UInt8.max) }
     }
 }
+
+extension AESOptions {
+
+    /// The native decryption mode, for the combinations wallet payloads use.
+    fileprivate var payloadCryptoMode: payload_crypto_mode? {
+        switch (blockMode, padding) {
+        case (.CBC, .iso10126):
+            return PAYLOAD_CRYPTO_CBC_ISO10126
+        case (.OFB, .noPadding):
+            return PAYLOAD_CRYPTO_OFB_NOPADDING
+        case (.OFB, .iso78164):
+            return PAYLOAD_CRYPTO_OFB_ISO78164
+        default:
+            return nil
+        }
+    }
+}
+
+extension PayloadCryptoError {
+
+    fileprivate init(payloadCryptoStatus status: Int32) {
+        switch status {
+        case PAYLOAD_CRYPTO_EDECODE:
+            self = .decodingFailed
+        case PAYLOAD_CRYPTO_EDECRYPT:
+            self = .decryptionFailed
+        default:
+            self = .unknown
+        }
+    }
+}
@@ -1,6 +1,7 @@
 // Copyright © Blockchain Luxembourg S.A. All rights reserved.
 
 @testable import WalletPayloadKit
+import WalletPayloadCrypto
 import XCTest
 
 class PayloadCryptoTests: XCTestCase {
@@ -56,4 +57,92 @@ class PayloadCryptoTests: XCTestCase {
             .get()
         XCTAssertEqual(message, decrypted)
     }
+
+    func test_decrypt_matchesCryptorForEveryPayloadMode() throws {
+        let message = "{\"guid\":\"6253e902-ce79-4027-bdc4-af51ed970eb5\",\"label\":\"caf\u{e9} \u{1F600}\"}"
+        let password = "testpassword"
+        let iterations: UInt32 = 5000
+        let iv = Data((0..<16).map { UInt8($0) })
+        var key = [UInt8](repeating: 0, count: 32)
+        PBKDF2_SHA1(Array(password.utf8), password.utf8.count, Array(iv), iv.count, UInt64(iterations), &key, key.count)
+
+        let cryptor = AESCryptor()
+        let allOptions = [
+            AESOptions.default,
+            AESOptions(blockMode: .OFB, padding: .noPadding),
+            AESOptions(blockMode: .OFB, padding: .iso78164)
+        ]
+        for options in allOptions {
+            let encrypted = try cryptor
+                .encrypt(data: Data(message.utf8), with: Data(key), iv: iv, options: options)
+                .get()
+            let payload = (iv + Data(encrypted)).base64EncodedString()
+            let decrypted = try subject
+                .decrypt(data: payload, with: password, pbkdf2Iterations: iterations, options: options)
+                .get()
+            XCTAssertEqual(decrypted, message)
+        }
+    }
+
+    func test_decrypt_failures() throws {
+        let encrypted = try subject
+            .encrypt(data: "155 is a bad number", with: "1714", pbkdf2Iterations: 11)
+            .get()
+        XCTAssertEqual(
+            subject.decrypt(data: encrypted, with: "1715", pbkdf2Iterations: 11),
+            .failure(.decryptionFailed)
+        )
+        XCTAssertEqual(
+            subject.decrypt(data: String(encrypted.dropFirst()), with: "1714", pbkdf2Iterations: 11),
+            .failure(.decodingFailed)
+        )
+        XCTAssertEqual(
+            subject.decrypt(data: "AAAA", with: "1714", pbkdf2Iterations: 11),
+            .failure(.decodingFailed)
+        )
+    }
+
+    func test_pbkdf2SHA1() {
+        // RFC 6070
+        var key = [UInt8](repeating: 0, count: 25)
+        let password = Array("passwordPASSWORDpassword".utf8)
+        let salt = Array("saltSALTsaltSALTsaltSALTsaltSALTsalt".utf8)
+        PBKDF2_SHA1(password, password.count, salt, salt.count, 4096, &key, key.count)
+        XCTAssertEqual(key.map { String(format: "%02x", $0) }.joined(), "3d2eec4fe41c849b80c8d83662c0e44a8b291a964cf2f07038")
+    }
+
+    func test_pbkdf2SHA1Checkpoints_matchSeparateDerivations() {
+        let password = Array("testpassword".utf8)
+        let salt = Array("0123456789abcdef".utf8)
+        let checkpoints: [UInt64] = [1, 1, 10, 5000]
+        var keys = [UInt8](repeating: 0, count: 32 * checkpoints.count)
+        PBKDF2_SHA1_checkpoints(password, password.count, salt, salt.count, checkpoints, checkpoints.count, &keys, 32)
+        for (index, iterations) in checkpoints.enumerated() {
+            var key = [UInt8](repeating: 0, count: 32)
+            PBKDF2_SHA1(password, password.count, salt, salt.count, iterations, &key, key.count)
+            XCTAssertEqual(Array(keys[(32 * index)..<(32 * index + 32)]), key, "\(iterations) iterations")
+        }
+    }
+
+    func test_decryptWallet_v1_OFB() throws {
+        let message = "{\"guid\":\"6253e902-ce79-4027-bdc4-af51ed970eb5\"}"
+        let password = "testpassword"
+        let iv = Data((0..<16).map { UInt8(255 - $0) })
+        var key = [UInt8](repeating: 0, count: 32)
+        PBKDF2_SHA1(Array(password.utf8), password.utf8.count, Array(iv), iv.count, 1, &key, key.count)
+        let encrypted = try AESCryptor()
+            .encrypt(
+                data: Data(message.utf8),
+                with: Data(key),
+                iv: iv,
+                options: AESOptions(blockMode: .OFB, padding: .iso78164)
+            )
+            .get()
+        let payload = (iv + Data(encrypted)).base64EncodedString()
+
+        let decrypted = try subject
+            .decryptWallet(encryptedWalletData: payload, password: password)
+            .get()
+        XCTAssertEqual(decrypted, message)
+    }
 }